@@ -1380,6 +1380,45 @@ heap_getnextslot(TableScanDesc sscan, ScanDirection direction, TupleTableSlot *s
 	return true;
 }
 
+/*
+ *	heap_getnextbatch	- fetch up to nslots tuples at once
+ *
+ * This is like calling heap_getnextslot repeatedly, except that each slot
+ * gets its own copy of the tuple header, so that all the tuples remain valid
+ * at the same time.  Returns the number of slots filled, which is less than
+ * nslots only at the end of the scan.
+ */
+int
+heap_getnextbatch(TableScanDesc sscan, ScanDirection direction,
+				  TupleTableSlot **slots, int nslots)
+{
+	HeapScanDesc scan = (HeapScanDesc) sscan;
+	int			ntuples = 0;
+
+	while (ntuples < nslots)
+	{
+		BufferHeapTupleTableSlot *bslot;
+
+		if (sscan->rs_flags & SO_ALLOW_PAGEMODE)
+			heapgettup_pagemode(scan, direction, sscan->rs_nkeys, sscan->rs_key);
+		else
+			heapgettup(scan, direction, sscan->rs_nkeys, sscan->rs_key);
+
+		if (scan->rs_ctup.t_data == NULL)
+			break;
+
+		pgstat_count_heap_getnext(scan->rs_base.rs_rd);
+
+		Assert(TTS_IS_BUFFERTUPLE(slots[ntuples]));
+		bslot = (BufferHeapTupleTableSlot *) slots[ntuples++];
+		bslot->base.tupdata = scan->rs_ctup;
+		ExecStoreBufferHeapTuple(&bslot->base.tupdata, &bslot->base.base,
+								 scan->rs_cbuf);
+	}
+
+	return ntuples;
+}
+
 /*
  *	heap_fetch		- retrieve tuple with given tid
  *
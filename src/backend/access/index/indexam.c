@@ -20,6 +20,7 @@
  *		index_insert	- insert an index tuple into a relation
  *		index_markpos	- mark a scan position
  *		index_restrpos	- restore a scan position
+ *		index_rescan_to_key - reposition a scan at a key
  *		index_parallelscan_estimate - estimate shared memory for parallel scan
  *		index_parallelscan_initialize - initialize parallel scan
  *		index_parallelrescan  - (re)start a parallel scan of an index
@@ -383,6 +384,34 @@ index_restrpos(IndexScanDesc scan)
 	scan->indexRelation->rd_indam->amrestrpos(scan);
 }
 
+/* ----------------
+ *		index_rescan_to_key  - reposition a forward scan at a key
+ *
+ * skipkey is a >= scan key on the first index column.  After a successful
+ * call, the next tuple returned is the first one satisfying the scan keys
+ * whose first column is at least the key value.  Only use this to move the
+ * scan forward.  Returns false if the index AM can't reposition this scan;
+ * it then continues from where it was.
+ * ----------------
+ */
+bool
+index_rescan_to_key(IndexScanDesc scan, ScanKey skipkey)
+{
+	SCAN_CHECKS;
+
+	if (scan->indexRelation->rd_indam->amrescantokey == NULL)
+		return false;
+
+	/* release resources (like buffer pins) from table accesses */
+	if (scan->xs_heapfetch)
+		table_index_fetch_reset(scan->xs_heapfetch);
+
+	scan->kill_prior_tuple = false; /* for safety */
+	scan->xs_heap_continue = false;
+
+	return scan->indexRelation->rd_indam->amrescantokey(scan, skipkey);
+}
+
 /*
  * index_parallelscan_estimate - estimate shared memory for parallel scan
  *
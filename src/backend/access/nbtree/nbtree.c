@@ -148,6 +148,7 @@ bthandler(PG_FUNCTION_ARGS)
 	amroutine->amendscan = btendscan;
 	amroutine->ammarkpos = btmarkpos;
 	amroutine->amrestrpos = btrestrpos;
+	amroutine->amrescantokey = btrescantokey;
 	amroutine->amestimateparallelscan = btestimateparallelscan;
 	amroutine->aminitparallelscan = btinitparallelscan;
 	amroutine->amparallelrescan = btparallelrescan;
@@ -378,6 +379,9 @@ btbeginscan(Relation rel, int nkeys, int norderbys)
 	so->killedItems = NULL;		/* until needed */
 	so->numKilled = 0;
 
+	so->skipKeyValid = false;
+	so->hintBlkno = InvalidBlockNumber;
+
 	/*
 	 * We don't know yet whether the scan will be index-only, so we do not
 	 * allocate the tuple workspace arrays until btrescan.  However, we set up
@@ -413,6 +417,7 @@ btrescan(IndexScanDesc scan, ScanKey scankey, int nscankeys,
 
 	so->markItemIndex = -1;
 	so->arrayKeyCount = 0;
+	so->skipKeyValid = false;
 	BTScanPosUnpinIfPinned(so->markPos);
 	BTScanPosInvalidate(so->markPos);
 
@@ -574,6 +579,69 @@ btrestrpos(IndexScanDesc scan)
 	}
 }
 
+/*
+ *	btrescantokey() -- reposition a forward scan at a key
+ *
+ * The next tuple returned will be the first one satisfying the scan keys
+ * whose first column is >= skipkey's argument.  The caller must only use this
+ * to move the scan forward.  Returns false, without touching the scan, if
+ * this scan cannot be repositioned.
+ */
+bool
+btrescantokey(IndexScanDesc scan, ScanKey skipkey)
+{
+	Relation	rel = scan->indexRelation;
+	BTScanOpaque so = (BTScanOpaque) scan->opaque;
+
+	Assert(skipkey->sk_attno == 1);
+	Assert(skipkey->sk_strategy == BTGreaterEqualStrategyNumber);
+
+	/*
+	 * Array keys advance in lockstep with the scan position, and parallel
+	 * scans share the position with other backends, so leave those alone.
+	 * A forward scan of a DESC column would need a <= key instead.
+	 */
+	if (so->numArrayKeys != 0 || scan->parallel_scan != NULL ||
+		(rel->rd_indoption[0] & INDOPTION_DESC) != 0)
+		return false;
+
+	if (BTScanPosIsValid(so->currPos))
+	{
+		/*
+		 * Keep a mark on the current page, as _bt_steppage would when leaving
+		 * the page.
+		 */
+		if (so->markItemIndex >= 0)
+		{
+			/* bump pin on current buffer for assignment to mark buffer */
+			if (BTScanPosIsPinned(so->currPos))
+				IncrBufferRefCount(so->currPos.buf);
+			memcpy(&so->markPos, &so->currPos,
+				   offsetof(BTScanPosData, items[1]) +
+				   so->currPos.lastItem * sizeof(BTScanPosItem));
+			if (so->markTuples)
+				memcpy(so->markTuples, so->currTuples,
+					   so->currPos.nextTupleOffset);
+			so->markPos.itemIndex = so->markItemIndex;
+			so->markItemIndex = -1;
+		}
+
+		/* Before leaving current page, deal with any killed items */
+		if (so->numKilled > 0)
+			_bt_killitems(scan);
+		so->hintBlkno = so->currPos.currPage;
+		BTScanPosUnpinIfPinned(so->currPos);
+		BTScanPosInvalidate(so->currPos);
+	}
+
+	/* _bt_first will find the key on the next btgettuple call */
+	memcpy(&so->skipKey, skipkey, sizeof(ScanKeyData));
+	so->skipKey.sk_flags |= rel->rd_indoption[0] << SK_BT_INDOPTION_SHIFT;
+	so->skipKeyValid = true;
+
+	return true;
+}
+
 /*
  * btestimateparallelscan -- estimate storage for BTParallelScanDescData
  */
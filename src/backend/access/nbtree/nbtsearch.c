@@ -25,6 +25,8 @@
 
 
 static void _bt_drop_lock_and_maybe_pin(IndexScanDesc scan, BTScanPos sp);
+static Buffer _bt_search_from_leaf(Relation rel, BTScanInsert key,
+								   BlockNumber blkno, Snapshot snapshot);
 static OffsetNumber _bt_binsrch(Relation rel, BTScanInsert key, Buffer buf);
 static int	_bt_binsrch_posting(BTScanInsert key, Page page,
 								OffsetNumber offnum);
@@ -324,6 +326,58 @@ _bt_moveright(Relation rel,
 	return buf;
 }
 
+/*
+ *	_bt_search_from_leaf() -- find the leaf page for a key, starting from a
+ *							  leaf page we visited before.
+ *
+ * If the first data item of the given leaf page is < the scankey (<= when
+ * nextkey is true), nothing to the left of the page can be of interest, so
+ * moving right as far as necessary lands us on the same leaf page that
+ * _bt_search would.  That holds even if the page has been split, or deleted
+ * and recycled as a leaf somewhere else in the index since we saw it.
+ *
+ * Returns the leaf page, pinned and read-locked, or InvalidBuffer if the
+ * caller must descend from the root after all.
+ */
+static Buffer
+_bt_search_from_leaf(Relation rel, BTScanInsert key, BlockNumber blkno,
+					 Snapshot snapshot)
+{
+	Buffer		buf;
+	Page		page;
+	BTPageOpaque opaque;
+	int32		result;
+
+	buf = ReadBuffer(rel, blkno);
+	LockBuffer(buf, BT_READ);
+	page = BufferGetPage(buf);
+	TestForOldSnapshot(snapshot, rel, page);
+
+	/* the page may have been recycled for anything, so check it carefully */
+	if (PageIsNew(page) ||
+		PageGetSpecialSize(page) != MAXALIGN(sizeof(BTPageOpaqueData)))
+	{
+		_bt_relbuf(rel, buf);
+		return InvalidBuffer;
+	}
+	opaque = (BTPageOpaque) PageGetSpecialPointer(page);
+	if (!P_ISLEAF(opaque) || P_IGNORE(opaque) ||
+		P_FIRSTDATAKEY(opaque) > PageGetMaxOffsetNumber(page))
+	{
+		_bt_relbuf(rel, buf);
+		return InvalidBuffer;
+	}
+
+	result = _bt_compare(rel, key, page, P_FIRSTDATAKEY(opaque));
+	if (result < 0 || (result == 0 && !key->nextkey))
+	{
+		_bt_relbuf(rel, buf);
+		return InvalidBuffer;
+	}
+
+	return _bt_moveright(rel, key, buf, false, NULL, BT_READ, snapshot);
+}
+
 /*
  *	_bt_binsrch() -- Do a binary search for a key on a particular page.
  *
@@ -869,11 +923,16 @@ _bt_first(IndexScanDesc scan, ScanDirection dir)
 	StrategyNumber strat_total;
 	BTScanPosItem *currItem;
 	BlockNumber blkno;
+	bool		useSkipKey;
 
 	Assert(!BTScanPosIsValid(so->currPos));
 
 	pgstat_count_index_scan(rel);
 
+	/* A boundary key from btrescantokey() is good for one descent only */
+	useSkipKey = so->skipKeyValid && ScanDirectionIsForward(dir);
+	so->skipKeyValid = false;
+
 	/*
 	 * Examine the scan keys and eliminate any redundant keys; also mark the
 	 * keys that must be matched to continue the scan.
@@ -955,10 +1014,20 @@ _bt_first(IndexScanDesc scan, ScanDirection dir)
 	 *
 	 * The selected scan keys (at most one per index column) are remembered by
 	 * storing their addresses into the local startKeys[] array.
+	 *
+	 * If btrescantokey() has given us a >= key on the first column, we start
+	 * there and ignore the scan keys for positioning.  They are all still
+	 * checked by _bt_checkkeys(), which also ends the scan correctly if an
+	 * equality key on the first column can no longer be satisfied.
 	 *----------
 	 */
 	strat_total = BTEqualStrategyNumber;
-	if (so->numberOfKeys > 0)
+	if (useSkipKey)
+	{
+		startKeys[keysCount++] = &so->skipKey;
+		strat_total = BTGreaterEqualStrategyNumber;
+	}
+	else if (so->numberOfKeys > 0)
 	{
 		AttrNumber	curattr;
 		ScanKey		chosen;
@@ -1351,11 +1420,26 @@ _bt_first(IndexScanDesc scan, ScanDirection dir)
 	/*
 	 * Use the manufactured insertion scan key to descend the tree and
 	 * position ourselves on the target leaf page.
+	 *
+	 * If we're told that the scan moves forward through the index from one
+	 * rescan to the next, or we're repositioning it ourselves, first try to
+	 * get there from the leaf page we started on last time.  When the keys
+	 * are close together that saves a descent from the root.
 	 */
-	stack = _bt_search(rel, &inskey, &buf, BT_READ, scan->xs_snapshot);
+	buf = InvalidBuffer;
+	if ((useSkipKey || scan->xs_ordered_rescans) &&
+		BlockNumberIsValid(so->hintBlkno) &&
+		ScanDirectionIsForward(dir) && scan->parallel_scan == NULL)
+		buf = _bt_search_from_leaf(rel, &inskey, so->hintBlkno,
+								   scan->xs_snapshot);
 
-	/* don't need to keep the stack around... */
-	_bt_freestack(stack);
+	if (!BufferIsValid(buf))
+	{
+		stack = _bt_search(rel, &inskey, &buf, BT_READ, scan->xs_snapshot);
+
+		/* don't need to keep the stack around... */
+		_bt_freestack(stack);
+	}
 
 	if (!BufferIsValid(buf))
 	{
@@ -1378,6 +1462,8 @@ _bt_first(IndexScanDesc scan, ScanDirection dir)
 		PredicateLockPage(rel, BufferGetBlockNumber(buf),
 						  scan->xs_snapshot);
 
+	so->hintBlkno = BufferGetBlockNumber(buf);
+
 	_bt_initialize_more_data(so, dir);
 
 	/* position to the precise item on the page */
@@ -68,6 +68,8 @@ static void ExplainNode(PlanState *planstate, List *ancestors,
 						ExplainState *es);
 static void show_plan_tlist(PlanState *planstate, List *ancestors,
 							ExplainState *es);
+static void show_common_exprs(PlanState *planstate, List *ancestors,
+							  ExplainState *es);
 static void show_expression(Node *node, const char *qlabel,
 							PlanState *planstate, List *ancestors,
 							bool useprefix, ExplainState *es);
@@ -80,10 +82,14 @@ static void show_scan_qual(List *qual, const char *qlabel,
 static void show_upper_qual(List *qual, const char *qlabel,
 							PlanState *planstate, List *ancestors,
 							ExplainState *es);
+static void show_incremental_sort_keys(IncrementalSortState *incrsortstate,
+									   List *ancestors, ExplainState *es);
 static void show_sort_keys(SortState *sortstate, List *ancestors,
 						   ExplainState *es);
 static void show_merge_append_keys(MergeAppendState *mstate, List *ancestors,
 								   ExplainState *es);
+static void show_redistribute_keys(RedistributeState *rstate, List *ancestors,
+								   ExplainState *es);
 static void show_agg_keys(AggState *astate, List *ancestors,
 						  ExplainState *es);
 static void show_grouping_sets(PlanState *planstate, Agg *agg,
@@ -103,7 +109,13 @@ static void show_sortorder_options(StringInfo buf, Node *sortexpr,
 static void show_tablesample(TableSampleClause *tsc, PlanState *planstate,
 							 List *ancestors, ExplainState *es);
 static void show_sort_info(SortState *sortstate, ExplainState *es);
+static void show_incremental_sort_info(IncrementalSortState *incrsortstate,
+									   ExplainState *es);
+static void show_incremental_sort_group_info(IncrementalSortInfo *info,
+											 ExplainState *es);
 static void show_hash_info(HashState *hashstate, ExplainState *es);
+static void show_resultcache_info(ResultCacheState *rcstate, List *ancestors,
+								  ExplainState *es);
 static void show_hashagg_info(AggState *hashstate, ExplainState *es);
 static void show_tidbitmap_info(BitmapHeapScanState *planstate,
 								ExplainState *es);
@@ -840,6 +852,13 @@ ExplainPrintJIT(ExplainState *es, int jit_flags, JitInstrumentation *ji)
 						 "Expressions", jit_flags & PGJIT_EXPR ? "true" : "false",
 						 "Deforming", jit_flags & PGJIT_DEFORM ? "true" : "false");
 
+		if (es->analyze && ji->deform_cache_hits + ji->deform_cache_misses > 0)
+		{
+			ExplainIndentText(es);
+			appendStringInfo(es->str, "Deform Cache: hits=%zu misses=%zu\n",
+							 ji->deform_cache_hits, ji->deform_cache_misses);
+		}
+
 		if (es->analyze && es->timing)
 		{
 			ExplainIndentText(es);
@@ -865,6 +884,14 @@ ExplainPrintJIT(ExplainState *es, int jit_flags, JitInstrumentation *ji)
 		ExplainPropertyBool("Deforming", jit_flags & PGJIT_DEFORM, es);
 		ExplainCloseGroup("Options", "Options", true, es);
 
+		if (es->analyze)
+		{
+			ExplainPropertyInteger("Deform Cache Hits", NULL,
+								   ji->deform_cache_hits, es);
+			ExplainPropertyInteger("Deform Cache Misses", NULL,
+								   ji->deform_cache_misses, es);
+		}
+
 		if (es->analyze && es->timing)
 		{
 			ExplainOpenGroup("Timing", "Timing", true, es);
@@ -1165,6 +1192,9 @@ ExplainNode(PlanState *planstate, List *ancestors,
 		case T_GatherMerge:
 			pname = sname = "Gather Merge";
 			break;
+		case T_Redistribute:
+			pname = sname = "Redistribute";
+			break;
 		case T_IndexScan:
 			pname = sname = "Index Scan";
 			break;
@@ -1237,9 +1267,15 @@ ExplainNode(PlanState *planstate, List *ancestors,
 		case T_Material:
 			pname = sname = "Materialize";
 			break;
+		case T_ResultCache:
+			pname = sname = "Result Cache";
+			break;
 		case T_Sort:
 			pname = sname = "Sort";
 			break;
+		case T_IncrementalSort:
+			pname = sname = "Incremental Sort";
+			break;
 		case T_Group:
 			pname = sname = "Group";
 			break;
@@ -1344,6 +1380,8 @@ ExplainNode(PlanState *planstate, List *ancestors,
 		}
 		if (plan->parallel_aware)
 			appendStringInfoString(es->str, "Parallel ");
+		if (plan->async_capable)
+			appendStringInfoString(es->str, "Async ");
 		appendStringInfoString(es->str, pname);
 		es->indent++;
 	}
@@ -1363,6 +1401,7 @@ ExplainNode(PlanState *planstate, List *ancestors,
 		if (custom_name)
 			ExplainPropertyText("Custom Plan Provider", custom_name, es);
 		ExplainPropertyBool("Parallel Aware", plan->parallel_aware, es);
+		ExplainPropertyBool("Async Capable", plan->async_capable, es);
 	}
 
 	switch (nodeTag(plan))
@@ -1632,9 +1671,12 @@ ExplainNode(PlanState *planstate, List *ancestors,
 		}
 	}
 
-	/* target list */
+	/* target list, and subexpressions it shares with the qual */
 	if (es->verbose)
+	{
 		show_plan_tlist(planstate, ancestors, es);
+		show_common_exprs(planstate, ancestors, es);
+	}
 
 	/* unique join */
 	switch (nodeTag(plan))
@@ -1668,6 +1710,9 @@ ExplainNode(PlanState *planstate, List *ancestors,
 			if (plan->qual)
 				show_instrumentation_count("Rows Removed by Filter", 1,
 										   planstate, es);
+			if (((ScanState *) planstate)->ss_RuntimeFilter)
+				show_instrumentation_count("Rows Removed by Runtime Filter", 3,
+										   planstate, es);
 			break;
 		case T_IndexOnlyScan:
 			show_scan_qual(((IndexOnlyScan *) plan)->indexqual,
@@ -1699,6 +1744,9 @@ ExplainNode(PlanState *planstate, List *ancestors,
 			if (plan->qual)
 				show_instrumentation_count("Rows Removed by Filter", 1,
 										   planstate, es);
+			if (((ScanState *) planstate)->ss_RuntimeFilter)
+				show_instrumentation_count("Rows Removed by Runtime Filter", 3,
+										   planstate, es);
 			if (es->analyze)
 				show_tidbitmap_info((BitmapHeapScanState *) planstate, es);
 			break;
@@ -1717,6 +1765,9 @@ ExplainNode(PlanState *planstate, List *ancestors,
 			if (plan->qual)
 				show_instrumentation_count("Rows Removed by Filter", 1,
 										   planstate, es);
+			if (((ScanState *) planstate)->ss_RuntimeFilter)
+				show_instrumentation_count("Rows Removed by Runtime Filter", 3,
+										   planstate, es);
 			break;
 		case T_Gather:
 			{
@@ -1822,6 +1873,9 @@ ExplainNode(PlanState *planstate, List *ancestors,
 				if (plan->qual)
 					show_instrumentation_count("Rows Removed by Filter", 1,
 											   planstate, es);
+				if (((ScanState *) planstate)->ss_RuntimeFilter)
+					show_instrumentation_count("Rows Removed by Runtime Filter",
+											   3, planstate, es);
 			}
 			break;
 		case T_ForeignScan:
@@ -1844,6 +1898,9 @@ ExplainNode(PlanState *planstate, List *ancestors,
 			}
 			break;
 		case T_NestLoop:
+			if (((NestLoop *) plan)->batchSize > 0)
+				ExplainPropertyInteger("Outer Batch Size", NULL,
+									   ((NestLoop *) plan)->batchSize, es);
 			show_upper_qual(((NestLoop *) plan)->join.joinqual,
 							"Join Filter", planstate, ancestors, es);
 			if (((NestLoop *) plan)->join.joinqual)
@@ -1895,14 +1952,28 @@ ExplainNode(PlanState *planstate, List *ancestors,
 				show_instrumentation_count("Rows Removed by Filter", 1,
 										   planstate, es);
 			break;
+		case T_WindowAgg:
+			show_upper_qual(((WindowAgg *) plan)->runCondition,
+							"Run Condition", planstate, ancestors, es);
+			break;
 		case T_Sort:
 			show_sort_keys(castNode(SortState, planstate), ancestors, es);
 			show_sort_info(castNode(SortState, planstate), es);
 			break;
+		case T_IncrementalSort:
+			show_incremental_sort_keys(castNode(IncrementalSortState, planstate),
+									   ancestors, es);
+			show_incremental_sort_info(castNode(IncrementalSortState, planstate),
+									   es);
+			break;
 		case T_MergeAppend:
 			show_merge_append_keys(castNode(MergeAppendState, planstate),
 								   ancestors, es);
 			break;
+		case T_Redistribute:
+			show_redistribute_keys(castNode(RedistributeState, planstate),
+								   ancestors, es);
+			break;
 		case T_Result:
 			show_upper_qual((List *) ((Result *) plan)->resconstantqual,
 							"One-Time Filter", planstate, ancestors, es);
@@ -1918,6 +1989,10 @@ ExplainNode(PlanState *planstate, List *ancestors,
 		case T_Hash:
 			show_hash_info(castNode(HashState, planstate), es);
 			break;
+		case T_ResultCache:
+			show_resultcache_info(castNode(ResultCacheState, planstate),
+								  ancestors, es);
+			break;
 		default:
 			break;
 	}
@@ -2146,6 +2221,41 @@ show_plan_tlist(PlanState *planstate, List *ancestors, ExplainState *es)
 	ExplainPropertyList("Output", result, es);
 }
 
+/*
+ * Show the subexpressions of the qual and target list that are computed
+ * only once per row (see ExecInitCommonExpr)
+ */
+static void
+show_common_exprs(PlanState *planstate, List *ancestors, ExplainState *es)
+{
+	CommonExprs *common = planstate->ps_CommonExprs;
+	List	   *context;
+	List	   *result = NIL;
+	bool		useprefix;
+
+	if (common == NULL)
+		return;
+
+	/* Set up deparsing context */
+	context = set_deparse_context_plan(es->deparse_cxt,
+									   planstate->plan,
+									   ancestors);
+	useprefix = list_length(es->rtable) > 1;
+
+	/* Those compiled just once aren't actually shared */
+	for (int i = 0; i < common->ncommon; i++)
+	{
+		if (common->common[i].nuses < 2)
+			continue;
+		result = lappend(result,
+						 deparse_expression((Node *) common->common[i].expr,
+											context, useprefix, false));
+	}
+
+	if (result != NIL)
+		ExplainPropertyList("Common Subexpressions", result, es);
+}
+
 /*
  * Show a generic expression
  */
@@ -2219,7 +2329,7 @@ show_upper_qual(List *qual, const char *qlabel,
 }
 
 /*
- * Show the sort keys for a Sort node.
+ * Show the sort keys for a Sort node, and its late-materialized columns.
  */
 static void
 show_sort_keys(SortState *sortstate, List *ancestors, ExplainState *es)
@@ -2231,6 +2341,47 @@ show_sort_keys(SortState *sortstate, List *ancestors, ExplainState *es)
 						 plan->sortOperators, plan->collations,
 						 plan->nullsFirst,
 						 ancestors, es);
+	if (plan->lateRelid != 0)
+		show_sort_group_keys((PlanState *) sortstate, "Late Materialized",
+							 plan->numLateCols, plan->lateColIdx,
+							 NULL, NULL, NULL,
+							 ancestors, es);
+}
+
+/*
+ * Show the sort keys for an IncrementalSort node, followed by the leading
+ * keys that the input is already sorted by.
+ */
+static void
+show_incremental_sort_keys(IncrementalSortState *incrsortstate,
+						   List *ancestors, ExplainState *es)
+{
+	IncrementalSort *plan = (IncrementalSort *) incrsortstate->ss.ps.plan;
+
+	show_sort_group_keys((PlanState *) incrsortstate, "Sort Key",
+						 plan->sort.numCols, plan->sort.sortColIdx,
+						 plan->sort.sortOperators, plan->sort.collations,
+						 plan->sort.nullsFirst,
+						 ancestors, es);
+	show_sort_group_keys((PlanState *) incrsortstate, "Presorted Key",
+						 plan->nPresortedCols, plan->sort.sortColIdx,
+						 NULL, NULL, NULL,
+						 ancestors, es);
+}
+
+/*
+ * Show the hash keys for a Redistribute node.
+ */
+static void
+show_redistribute_keys(RedistributeState *rstate, List *ancestors,
+					   ExplainState *es)
+{
+	Redistribute *plan = (Redistribute *) rstate->ps.plan;
+
+	show_sort_group_keys((PlanState *) rstate, "Hash Key",
+						 plan->numCols, plan->hashColIdx,
+						 NULL, NULL, NULL,
+						 ancestors, es);
 }
 
 /*
@@ -2668,6 +2819,97 @@ show_sort_info(SortState *sortstate, ExplainState *es)
 	}
 }
 
+/*
+ * Show the statistics accumulated over the groups sorted by one process
+ * executing an IncrementalSort node.
+ */
+static void
+show_incremental_sort_group_info(IncrementalSortInfo *info, ExplainState *es)
+{
+	List	   *methodNames = NIL;
+	const char *spaceType;
+	long		avgSpaceUsed;
+	int			m;
+
+	for (m = SORT_TYPE_TOP_N_HEAPSORT; m <= SORT_TYPE_EXTERNAL_MERGE; m++)
+	{
+		if (info->sortMethods & (1 << m))
+			methodNames = lappend(methodNames,
+								  unconstify(char *, tuplesort_method_name(m)));
+	}
+	spaceType = tuplesort_space_type_name(info->maxSpaceType);
+	avgSpaceUsed = info->totalSpaceUsed / info->groupCount;
+
+	if (es->format == EXPLAIN_FORMAT_TEXT)
+	{
+		ListCell   *lc;
+		bool		first = true;
+
+		ExplainIndentText(es);
+		appendStringInfo(es->str, "Sort Groups: " INT64_FORMAT "  Sort Method",
+						 info->groupCount);
+		if (list_length(methodNames) > 1)
+			appendStringInfoChar(es->str, 's');
+		appendStringInfoString(es->str, ": ");
+		foreach(lc, methodNames)
+		{
+			if (!first)
+				appendStringInfoString(es->str, ", ");
+			appendStringInfoString(es->str, (const char *) lfirst(lc));
+			first = false;
+		}
+		appendStringInfo(es->str, "  Average %s: %ldkB  Peak %s: %ldkB\n",
+						 spaceType, avgSpaceUsed,
+						 spaceType, info->maxSpaceUsed);
+	}
+	else
+	{
+		ExplainPropertyInteger("Sort Groups", NULL, info->groupCount, es);
+		ExplainPropertyList("Sort Methods Used", methodNames, es);
+		ExplainPropertyInteger("Average Sort Space Used", "kB",
+							   avgSpaceUsed, es);
+		ExplainPropertyInteger("Peak Sort Space Used", "kB",
+							   info->maxSpaceUsed, es);
+		ExplainPropertyText("Sort Space Type", spaceType, es);
+	}
+}
+
+/*
+ * If it's EXPLAIN ANALYZE, show tuplesort stats for an incremental sort node
+ */
+static void
+show_incremental_sort_info(IncrementalSortState *incrsortstate,
+						   ExplainState *es)
+{
+	if (!es->analyze)
+		return;
+
+	if (incrsortstate->incsort_info.groupCount > 0)
+		show_incremental_sort_group_info(&incrsortstate->incsort_info, es);
+
+	/* See show_sort_info() for why we don't check es->hide_workers here */
+	if (incrsortstate->shared_info != NULL)
+	{
+		int			n;
+
+		for (n = 0; n < incrsortstate->shared_info->num_workers; n++)
+		{
+			IncrementalSortInfo *info = &incrsortstate->shared_info->sinfo[n];
+
+			if (info->groupCount == 0)
+				continue;		/* ignore any unfilled slots */
+
+			if (es->workers_state)
+				ExplainOpenWorker(n, es);
+
+			show_incremental_sort_group_info(info, es);
+
+			if (es->workers_state)
+				ExplainCloseWorker(n, es);
+		}
+	}
+}
+
 /*
  * Show information on hash buckets/batches.
  */
@@ -2771,6 +3013,129 @@ show_hash_info(HashState *hashstate, ExplainState *es)
 	}
 }
 
+/*
+ * Show the cache key of a ResultCache node, and if it's EXPLAIN ANALYZE, the
+ * cache hit and miss statistics of each process that ran it.
+ */
+static void
+show_resultcache_info(ResultCacheState *rcstate, List *ancestors,
+					  ExplainState *es)
+{
+	Plan	   *plan = ((PlanState *) rcstate)->plan;
+	ListCell   *lc;
+	List	   *context;
+	StringInfoData keystr;
+	char	   *separator = "";
+	bool		useprefix;
+	int64		memPeakKb;
+
+	initStringInfo(&keystr);
+
+	/*
+	 * It's hard to imagine having a result cache with fewer than 2 RTEs, but
+	 * let's just keep the same useprefix logic as elsewhere in this file.
+	 */
+	useprefix = list_length(es->rtable) > 1 || es->verbose;
+
+	/* Set up deparsing context */
+	context = set_deparse_context_plan(es->deparse_cxt,
+									   plan,
+									   ancestors);
+
+	foreach(lc, ((ResultCache *) plan)->param_exprs)
+	{
+		Node	   *expr = (Node *) lfirst(lc);
+
+		appendStringInfoString(&keystr, separator);
+
+		appendStringInfoString(&keystr, deparse_expression(expr, context,
+														   useprefix, false));
+		separator = ", ";
+	}
+
+	ExplainPropertyText("Cache Key", keystr.data, es);
+
+	pfree(keystr.data);
+
+	if (!es->analyze)
+		return;
+
+	/*
+	 * mem_peak is only meaningful once we've actually looked something up,
+	 * which means at least one cache miss.
+	 */
+	if (rcstate->stats.cache_misses > 0)
+	{
+		memPeakKb = (rcstate->stats.mem_peak + 1023) / 1024;
+
+		if (es->format != EXPLAIN_FORMAT_TEXT)
+		{
+			ExplainPropertyInteger("Cache Hits", NULL, rcstate->stats.cache_hits, es);
+			ExplainPropertyInteger("Cache Misses", NULL, rcstate->stats.cache_misses, es);
+			ExplainPropertyInteger("Cache Evictions", NULL, rcstate->stats.cache_evictions, es);
+			ExplainPropertyInteger("Cache Overflows", NULL, rcstate->stats.cache_overflows, es);
+			ExplainPropertyInteger("Peak Memory Usage", "kB", memPeakKb, es);
+		}
+		else
+		{
+			ExplainIndentText(es);
+			appendStringInfo(es->str,
+							 "Hits: " UINT64_FORMAT "  Misses: " UINT64_FORMAT "  Evictions: " UINT64_FORMAT "  Overflows: " UINT64_FORMAT "  Memory Usage: " INT64_FORMAT "kB\n",
+							 rcstate->stats.cache_hits,
+							 rcstate->stats.cache_misses,
+							 rcstate->stats.cache_evictions,
+							 rcstate->stats.cache_overflows,
+							 memPeakKb);
+		}
+	}
+
+	if (rcstate->shared_info == NULL)
+		return;
+
+	/* Show details from parallel workers */
+	for (int n = 0; n < rcstate->shared_info->num_workers; n++)
+	{
+		ResultCacheInstrumentation *si;
+
+		si = &rcstate->shared_info->sinstrument[n];
+
+		/* Skip workers that didn't do any work */
+		if (si->cache_misses == 0)
+			continue;
+
+		if (es->workers_state)
+			ExplainOpenWorker(n, es);
+
+		memPeakKb = (si->mem_peak + 1023) / 1024;
+
+		if (es->format == EXPLAIN_FORMAT_TEXT)
+		{
+			ExplainIndentText(es);
+			appendStringInfo(es->str,
+							 "Hits: " UINT64_FORMAT "  Misses: " UINT64_FORMAT "  Evictions: " UINT64_FORMAT "  Overflows: " UINT64_FORMAT "  Memory Usage: " INT64_FORMAT "kB\n",
+							 si->cache_hits, si->cache_misses,
+							 si->cache_evictions, si->cache_overflows,
+							 memPeakKb);
+		}
+		else
+		{
+			ExplainPropertyInteger("Cache Hits", NULL,
+								   si->cache_hits, es);
+			ExplainPropertyInteger("Cache Misses", NULL,
+								   si->cache_misses, es);
+			ExplainPropertyInteger("Cache Evictions", NULL,
+								   si->cache_evictions, es);
+			ExplainPropertyInteger("Cache Overflows", NULL,
+								   si->cache_overflows, es);
+			ExplainPropertyInteger("Peak Memory Usage", "kB", memPeakKb,
+								   es);
+		}
+
+		if (es->workers_state)
+			ExplainCloseWorker(n, es);
+	}
+}
+
 /*
  * Show information on hash aggregate memory usage and batches.
  */
@@ -2849,7 +3214,9 @@ show_instrumentation_count(const char *qlabel, int which,
 	if (!es->analyze || !planstate->instrument)
 		return;
 
-	if (which == 2)
+	if (which == 3)
+		nfiltered = planstate->instrument->nfiltered3;
+	else if (which == 2)
 		nfiltered = planstate->instrument->nfiltered2;
 	else
 		nfiltered = planstate->instrument->nfiltered1;
@@ -0,0 +1,604 @@
+/*-------------------------------------------------------------------------
+ *
+ * execBatch.c
+ *	  Support for passing tuples between executor nodes in batches.
+ *
+ * Normally, every tuple travels through ExecProcNode() on its own, and the
+ * per-call overhead of the node dispatch, the scan access method and the
+ * qual evaluation machinery is a large fraction of the cost of simple
+ * scan-filter-aggregate queries.  A node may therefore additionally offer an
+ * ExecProcNodeBatch method, which returns up to executor_batch_size tuples
+ * at a time in a TupleBatch.  Parent nodes that know how to consume batches
+ * use it in preference to ExecProcNode(); all others are unaffected.
+ *
+ * The producer also evaluates its quals over the whole batch.  Clauses of
+ * the form "Var op Const" are evaluated column-wise: the column is first
+ * gathered from all still-selected tuples, and then compared with the
+ * constant in a tight loop.  For the common built-in comparison operators
+ * on fixed-width types that's done by a comparison kernel, which may use
+ * SIMD instructions (see execBatchKernels.c); otherwise the operator's
+ * function is called directly.  Other clauses are evaluated row by row.
+ * Either way, each step narrows the batch's selection vector, so later
+ * clauses are only evaluated for tuples that passed the earlier ones, just
+ * as with ExecQual().
+ *
+ * Portions Copyright (c) 1996-2020, PostgreSQL Global Development Group
+ * Portions Copyright (c) 1994, Regents of the University of California
+ *
+ *
+ * IDENTIFICATION
+ *	  src/backend/executor/execBatch.c
+ *
+ *-------------------------------------------------------------------------
+ */
+#include "postgres.h"
+
+#include <math.h>
+
+#include "catalog/objectaccess.h"
+#include "catalog/pg_proc.h"
+#include "catalog/pg_type.h"
+#include "executor/execBatch.h"
+#include "executor/executor.h"
+#include "miscadmin.h"
+#include "nodes/nodeFuncs.h"
+#include "optimizer/clauses.h"
+#include "port/pg_bitutils.h"
+#include "utils/acl.h"
+#include "utils/fmgroids.h"
+#include "utils/lsyscache.h"
+
+/* GUC parameter: maximum number of tuples per batch, 0 disables batching */
+int			executor_batch_size = 1024;
+
+/*
+ * Operator functions that can be evaluated by a comparison kernel, with the
+ * comparison they perform and the type of each argument.
+ */
+typedef struct BatchKernelOperator
+{
+	Oid			funcid;
+	BatchCompareOp cmp;
+	BatchKernelInput left;
+	BatchKernelInput right;
+} BatchKernelOperator;
+
+#define BATCH_KERNEL_OPERATOR_OIDS(eq, ne, lt, le, gt, ge, left, right) \
+	{eq, BATCH_CMP_EQ, left, right}, \
+	{ne, BATCH_CMP_NE, left, right}, \
+	{lt, BATCH_CMP_LT, left, right}, \
+	{le, BATCH_CMP_LE, left, right}, \
+	{gt, BATCH_CMP_GT, left, right}, \
+	{ge, BATCH_CMP_GE, left, right}
+
+#define BATCH_KERNEL_OPERATORS(prefix, left, right) \
+	BATCH_KERNEL_OPERATOR_OIDS(F_##prefix##EQ, F_##prefix##NE, \
+							   F_##prefix##LT, F_##prefix##LE, \
+							   F_##prefix##GT, F_##prefix##GE, left, right)
+
+static const BatchKernelOperator batch_kernel_operators[] =
+{
+	BATCH_KERNEL_OPERATORS(INT2, BATCH_KERNEL_INT16, BATCH_KERNEL_INT16),
+	BATCH_KERNEL_OPERATORS(INT4, BATCH_KERNEL_INT32, BATCH_KERNEL_INT32),
+	BATCH_KERNEL_OPERATORS(INT8, BATCH_KERNEL_INT64, BATCH_KERNEL_INT64),
+	BATCH_KERNEL_OPERATORS(INT24, BATCH_KERNEL_INT16, BATCH_KERNEL_INT32),
+	BATCH_KERNEL_OPERATORS(INT42, BATCH_KERNEL_INT32, BATCH_KERNEL_INT16),
+	BATCH_KERNEL_OPERATORS(INT28, BATCH_KERNEL_INT16, BATCH_KERNEL_INT64),
+	BATCH_KERNEL_OPERATORS(INT82, BATCH_KERNEL_INT64, BATCH_KERNEL_INT16),
+	BATCH_KERNEL_OPERATORS(INT48, BATCH_KERNEL_INT32, BATCH_KERNEL_INT64),
+	BATCH_KERNEL_OPERATORS(INT84, BATCH_KERNEL_INT64, BATCH_KERNEL_INT32),
+	BATCH_KERNEL_OPERATORS(DATE_, BATCH_KERNEL_INT32, BATCH_KERNEL_INT32),
+
+	BATCH_KERNEL_OPERATORS(TIMESTAMP_, BATCH_KERNEL_INT64, BATCH_KERNEL_INT64),
+	BATCH_KERNEL_OPERATOR_OIDS(TIMESTAMP_EQ_PROC_OID, TIMESTAMP_NE_PROC_OID,
+							   TIMESTAMP_LT_PROC_OID, TIMESTAMP_LE_PROC_OID,
+							   TIMESTAMP_GT_PROC_OID, TIMESTAMP_GE_PROC_OID,
+							   BATCH_KERNEL_INT64, BATCH_KERNEL_INT64),
+	BATCH_KERNEL_OPERATORS(FLOAT8, BATCH_KERNEL_FLOAT8, BATCH_KERNEL_FLOAT8)
+};
+
+static bool batch_qual_columnar_clause(Expr *clause, Var **var, Const **con,
+									   int *argno);
+static void batch_qual_init_columnar(BatchQualStep *step, OpExpr *op,
+									 Var *var, Const *con, int argno);
+static void batch_qual_init_kernel(BatchQualStep *step, Oid funcid,
+								   Const *con, int argno);
+static int	batch_qual_kernel(BatchQualStep *step, TupleBatch *batch,
+							  int nselected);
+static int	batch_qual_columnar(BatchQualStep *step, TupleBatch *batch,
+								int nselected, ExprContext *econtext);
+static int	batch_qual_rows(ExprState *rowqual, TupleBatch *batch,
+							int nselected, ExprContext *econtext);
+
+
+/*
+ * ExecCreateBatch
+ *		Create a batch of up to maxtuples tuples of the given type.
+ *
+ * The slots are registered in the executor's tuple table, so that any
+ * buffer pins they hold are released at executor shutdown.
+ */
+TupleBatch *
+ExecCreateBatch(EState *estate, TupleDesc tupdesc,
+				const TupleTableSlotOps *tts_ops, int maxtuples)
+{
+	MemoryContext oldcontext;
+	TupleBatch *batch;
+	int			i;
+
+	Assert(maxtuples > 0);
+
+	oldcontext = MemoryContextSwitchTo(estate->es_query_cxt);
+
+	batch = (TupleBatch *) palloc0(sizeof(TupleBatch));
+	batch->maxtuples = maxtuples;
+	batch->slots = (TupleTableSlot **)
+		palloc(sizeof(TupleTableSlot *) * maxtuples);
+	batch->sel = (int *) palloc(sizeof(int) * maxtuples);
+	batch->colvalues = (Datum *) palloc(sizeof(Datum) * maxtuples);
+	batch->colisnull = (bool *) palloc(sizeof(bool) * maxtuples);
+	batch->colint64 = (int64 *) palloc(sizeof(int64) * maxtuples);
+	batch->colfloat8 = (float8 *) palloc(sizeof(float8) * maxtuples);
+	batch->matches = (uint64 *)
+		palloc(sizeof(uint64) * BATCH_MATCH_WORDS(maxtuples));
+
+	for (i = 0; i < maxtuples; i++)
+		batch->slots[i] = ExecAllocTableSlot(&estate->es_tupleTable,
+											 tupdesc, tts_ops);
+
+	MemoryContextSwitchTo(oldcontext);
+
+	return batch;
+}
+
+/*
+ * ExecClearBatch
+ *		Clear all tuples from a batch, releasing any resources they hold.
+ */
+void
+ExecClearBatch(TupleBatch *batch)
+{
+	int			i;
+
+	for (i = 0; i < batch->ntuples; i++)
+		ExecClearTuple(batch->slots[i]);
+	batch->ntuples = 0;
+	batch->nselected = 0;
+}
+
+/*
+ * ExecInitBatchQual
+ *		Prepare an implicit-AND qual list for evaluation over batches.
+ *
+ * 'rowqual' is the result of ExecInitQual() on the same list, which the
+ * caller needs anyway for the row-at-a-time code path.  If none of the
+ * clauses can be evaluated column-wise we just use that for every tuple.
+ * Otherwise the list is split into columnar steps and row-at-a-time steps
+ * for the remaining runs of clauses, preserving the original clause order.
+ * We don't do that if the qual contains subplans, as they must be
+ * initialized only once.
+ *
+ * Returns NULL if there is no qual.
+ */
+BatchQualState *
+ExecInitBatchQual(List *qual, ExprState *rowqual, PlanState *parent)
+{
+	BatchQualState *bqstate;
+	bool		have_columnar = false;
+	List	   *pending = NIL;
+	ListCell   *lc;
+
+	if (qual == NIL)
+		return NULL;
+
+	bqstate = (BatchQualState *) palloc0(sizeof(BatchQualState));
+	bqstate->steps = (BatchQualStep *)
+		palloc0(sizeof(BatchQualStep) * list_length(qual));
+
+	if (!contain_subplans((Node *) qual))
+	{
+		foreach(lc, qual)
+		{
+			Var		   *var;
+			Const	   *con;
+			int			argno;
+
+			if (batch_qual_columnar_clause((Expr *) lfirst(lc),
+										   &var, &con, &argno))
+			{
+				have_columnar = true;
+				break;
+			}
+		}
+	}
+
+	if (!have_columnar)
+	{
+		bqstate->nsteps = 1;
+		bqstate->steps[0].rowqual = rowqual;
+		return bqstate;
+	}
+
+	foreach(lc, qual)
+	{
+		Expr	   *clause = (Expr *) lfirst(lc);
+		Var		   *var;
+		Const	   *con;
+		int			argno;
+
+		if (!batch_qual_columnar_clause(clause, &var, &con, &argno))
+		{
+			pending = lappend(pending, clause);
+			continue;
+		}
+
+		if (pending != NIL)
+		{
+			bqstate->steps[bqstate->nsteps++].rowqual =
+				ExecInitQual(pending, parent);
+			pending = NIL;
+		}
+
+		batch_qual_init_columnar(&bqstate->steps[bqstate->nsteps++],
+								 (OpExpr *) clause, var, con, argno);
+		bqstate->maxattnum = Max(bqstate->maxattnum, var->varattno);
+	}
+
+	if (pending != NIL)
+		bqstate->steps[bqstate->nsteps++].rowqual =
+			ExecInitQual(pending, parent);
+
+	return bqstate;
+}
+
+/*
+ * Can the clause be evaluated column-wise?  That requires a strict, boolean
+ * operator comparing a user column of the scan tuple with a constant.  On
+ * success, the Var and the Const are returned, along with the argument
+ * position of the Var.
+ */
+static bool
+batch_qual_columnar_clause(Expr *clause, Var **var, Const **con, int *argno)
+{
+	OpExpr	   *op;
+	Node	   *leftop;
+	Node	   *rightop;
+
+	if (!IsA(clause, OpExpr))
+		return false;
+	op = (OpExpr *) clause;
+
+	if (list_length(op->args) != 2 || op->opretset ||
+		op->opresulttype != BOOLOID)
+		return false;
+
+	leftop = linitial(op->args);
+	rightop = lsecond(op->args);
+
+	if (IsA(leftop, Var) && IsA(rightop, Const))
+	{
+		*var = (Var *) leftop;
+		*con = (Const *) rightop;
+		*argno = 0;
+	}
+	else if (IsA(leftop, Const) && IsA(rightop, Var))
+	{
+		*var = (Var *) rightop;
+		*con = (Const *) leftop;
+		*argno = 1;
+	}
+	else
+		return false;
+
+	/* only plain columns of the scan tuple */
+	if ((*var)->varno == INNER_VAR || (*var)->varno == OUTER_VAR ||
+		(*var)->varattno <= 0)
+		return false;
+
+	set_opfuncid(op);
+	return func_strict(op->opfuncid);
+}
+
+/*
+ * Set up a columnar step, doing the same checks as ExecInitFunc().
+ */
+static void
+batch_qual_init_columnar(BatchQualStep *step, OpExpr *op, Var *var,
+						 Const *con, int argno)
+{
+	AclResult	aclresult;
+	FmgrInfo   *flinfo;
+
+	aclresult = pg_proc_aclcheck(op->opfuncid, GetUserId(), ACL_EXECUTE);
+	if (aclresult != ACLCHECK_OK)
+		aclcheck_error(aclresult, OBJECT_FUNCTION,
+					   get_func_name(op->opfuncid));
+	InvokeFunctionExecuteHook(op->opfuncid);
+
+	flinfo = (FmgrInfo *) palloc0(sizeof(FmgrInfo));
+	fmgr_info(op->opfuncid, flinfo);
+	fmgr_info_set_expr((Node *) op, flinfo);
+
+	step->fcinfo = (FunctionCallInfo) palloc0(SizeForFunctionCallInfo(2));
+	InitFunctionCallInfoData(*step->fcinfo, flinfo, 2, op->inputcollid,
+							 NULL, NULL);
+
+	step->attnum = var->varattno;
+	step->argno = argno;
+	step->constisnull = con->constisnull;
+	step->fcinfo->args[1 - argno].value = con->constvalue;
+	step->fcinfo->args[1 - argno].isnull = con->constisnull;
+	step->fcinfo->args[argno].isnull = false;
+
+	if (!con->constisnull)
+		batch_qual_init_kernel(step, op->opfuncid, con, argno);
+}
+
+/*
+ * Use a comparison kernel for the step, if the operator is one we know.
+ */
+static void
+batch_qual_init_kernel(BatchQualStep *step, Oid funcid, Const *con,
+					   int argno)
+{
+	const BatchKernelOperator *kop = NULL;
+	BatchKernelInput constinput;
+	int			i;
+
+	for (i = 0; i < lengthof(batch_kernel_operators); i++)
+	{
+		if (batch_kernel_operators[i].funcid == funcid)
+		{
+			kop = &batch_kernel_operators[i];
+			break;
+		}
+	}
+	if (kop == NULL)
+		return;
+
+	/* kernels compute "column op constant", so commute if need be */
+	if (argno == 0)
+	{
+		step->kernel = kop->left;
+		constinput = kop->right;
+		step->cmp = kop->cmp;
+	}
+	else
+	{
+		step->kernel = kop->right;
+		constinput = kop->left;
+		switch (kop->cmp)
+		{
+			case BATCH_CMP_LT:
+				step->cmp = BATCH_CMP_GT;
+				break;
+			case BATCH_CMP_LE:
+				step->cmp = BATCH_CMP_GE;
+				break;
+			case BATCH_CMP_GT:
+				step->cmp = BATCH_CMP_LT;
+				break;
+			case BATCH_CMP_GE:
+				step->cmp = BATCH_CMP_LE;
+				break;
+			default:
+				step->cmp = kop->cmp;
+				break;
+		}
+	}
+
+	switch (constinput)
+	{
+		case BATCH_KERNEL_INT16:
+			step->constint64 = DatumGetInt16(con->constvalue);
+			break;
+		case BATCH_KERNEL_INT32:
+			step->constint64 = DatumGetInt32(con->constvalue);
+			break;
+		case BATCH_KERNEL_INT64:
+			step->constint64 = DatumGetInt64(con->constvalue);
+			break;
+		case BATCH_KERNEL_FLOAT8:
+			step->constfloat8 = DatumGetFloat8(con->constvalue);
+			/* the kernels can't deal with a NaN constant */
+			if (isnan(step->constfloat8))
+				step->kernel = BATCH_KERNEL_NONE;
+			break;
+		case BATCH_KERNEL_NONE:
+			Assert(false);
+			break;
+	}
+}
+
+/*
+ * ExecBatchQual
+ *		Evaluate a batch qual over all tuples in the batch, and set the
+ *		batch's selection vector to those that pass.
+ *
+ * A NULL bqstate selects all tuples.
+ */
+void
+ExecBatchQual(BatchQualState *bqstate, TupleBatch *batch,
+			  ExprContext *econtext)
+{
+	int			nselected = batch->ntuples;
+	MemoryContext oldcontext;
+	int			i;
+
+	for (i = 0; i < nselected; i++)
+		batch->sel[i] = i;
+
+	if (bqstate == NULL)
+	{
+		batch->nselected = nselected;
+		return;
+	}
+
+	/* deform everything the columnar steps need in one go */
+	if (bqstate->maxattnum > 0)
+	{
+		for (i = 0; i < nselected; i++)
+			slot_getsomeattrs(batch->slots[i], bqstate->maxattnum);
+	}
+
+	oldcontext = MemoryContextSwitchTo(econtext->ecxt_per_tuple_memory);
+
+	for (i = 0; i < bqstate->nsteps && nselected > 0; i++)
+	{
+		BatchQualStep *step = &bqstate->steps[i];
+
+		if (step->attnum > 0 && step->kernel != BATCH_KERNEL_NONE)
+			nselected = batch_qual_kernel(step, batch, nselected);
+		else if (step->attnum > 0)
+			nselected = batch_qual_columnar(step, batch, nselected, econtext);
+		else
+			nselected = batch_qual_rows(step->rowqual, batch, nselected,
+										econtext);
+	}
+
+	MemoryContextSwitchTo(oldcontext);
+
+	batch->nselected = nselected;
+}
+
+/*
+ * Evaluate a columnar step for the first nselected entries of the selection
+ * vector, compacting it in place.  Returns the number of tuples that pass.
+ */
+static int
+batch_qual_columnar(BatchQualStep *step, TupleBatch *batch, int nselected,
+					ExprContext *econtext)
+{
+	FunctionCallInfo fcinfo = step->fcinfo;
+	int			attoff = step->attnum - 1;
+	int			nkeep = 0;
+	int			i;
+
+	/* strict operator with a NULL constant can't return true */
+	if (step->constisnull)
+		return 0;
+
+	for (i = 0; i < nselected; i++)
+	{
+		TupleTableSlot *slot = batch->slots[batch->sel[i]];
+
+		batch->colvalues[i] = slot->tts_values[attoff];
+		batch->colisnull[i] = slot->tts_isnull[attoff];
+	}
+
+	for (i = 0; i < nselected; i++)
+	{
+		Datum		result;
+
+		/* strict operator returns NULL for a NULL input */
+		if (batch->colisnull[i])
+			continue;
+
+		fcinfo->args[step->argno].value = batch->colvalues[i];
+		fcinfo->isnull = false;
+		result = FunctionCallInvoke(fcinfo);
+
+		if (!fcinfo->isnull && DatumGetBool(result))
+			batch->sel[nkeep++] = batch->sel[i];
+
+		ResetExprContext(econtext);
+	}
+
+	return nkeep;
+}
+
+/*
+ * Evaluate a columnar step using a comparison kernel.  Works like
+ * batch_qual_columnar, except that the column is widened to int64 or float8
+ * while gathering it, and the comparisons are done all at once.
+ */
+static int
+batch_qual_kernel(BatchQualStep *step, TupleBatch *batch, int nselected)
+{
+	int			attoff = step->attnum - 1;
+	int			nkeep = 0;
+	int			i;
+	int			w;
+
+	if (step->constisnull)
+		return 0;
+
+	/* gather the column; don't look at the Datum of a NULL */
+#define GATHER(dest, getdatum) \
+	for (i = 0; i < nselected; i++) \
+	{ \
+		TupleTableSlot *slot = batch->slots[batch->sel[i]]; \
+\
+		batch->colisnull[i] = slot->tts_isnull[attoff]; \
+		dest[i] = batch->colisnull[i] ? 0 : getdatum(slot->tts_values[attoff]); \
+	}
+
+	switch (step->kernel)
+	{
+		case BATCH_KERNEL_INT16:
+			GATHER(batch->colint64, DatumGetInt16);
+			break;
+		case BATCH_KERNEL_INT32:
+			GATHER(batch->colint64, DatumGetInt32);
+			break;
+		case BATCH_KERNEL_INT64:
+			GATHER(batch->colint64, DatumGetInt64);
+			break;
+		case BATCH_KERNEL_FLOAT8:
+			GATHER(batch->colfloat8, DatumGetFloat8);
+			break;
+		case BATCH_KERNEL_NONE:
+			Assert(false);
+			break;
+	}
+
+#undef GATHER
+
+	if (step->kernel == BATCH_KERNEL_FLOAT8)
+		ExecBatchCompareFloat8(step->cmp, batch->colfloat8, nselected,
+							   step->constfloat8, batch->matches);
+	else
+		ExecBatchCompareInt64(step->cmp, batch->colint64, nselected,
+							  step->constint64, batch->matches);
+
+	/* keep the matching non-NULL tuples, in order */
+	for (w = 0; w < BATCH_MATCH_WORDS(nselected); w++)
+	{
+		uint64		bits = batch->matches[w];
+
+		while (bits != 0)
+		{
+			i = w * 64 + pg_rightmost_one_pos64(bits);
+			bits &= bits - 1;
+
+			if (!batch->colisnull[i])
+				batch->sel[nkeep++] = batch->sel[i];
+		}
+	}
+
+	return nkeep;
+}
+
+/*
+ * Evaluate an ordinary qual for each selected tuple, compacting the
+ * selection vector in place.  Returns the number of tuples that pass.
+ */
+static int
+batch_qual_rows(ExprState *rowqual, TupleBatch *batch, int nselected,
+				ExprContext *econtext)
+{
+	int			nkeep = 0;
+	int			i;
+
+	for (i = 0; i < nselected; i++)
+	{
+		econtext->ecxt_scantuple = batch->slots[batch->sel[i]];
+
+		if (ExecQual(rowqual, econtext))
+			batch->sel[nkeep++] = batch->sel[i];
+
+		ResetExprContext(econtext);
+	}
+
+	return nkeep;
+}
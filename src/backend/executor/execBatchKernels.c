@@ -0,0 +1,157 @@
+/*-------------------------------------------------------------------------
+ *
+ * execBatchKernels.c
+ *	  Plain C comparison kernels for batch qual evaluation, and runtime
+ *	  selection of the best available implementation.
+ *
+ * Portions Copyright (c) 1996-2020, PostgreSQL Global Development Group
+ * Portions Copyright (c) 1994, Regents of the University of California
+ *
+ *
+ * IDENTIFICATION
+ *	  src/backend/executor/execBatchKernels.c
+ *
+ *-------------------------------------------------------------------------
+ */
+#include "postgres.h"
+
+#ifdef USE_SSE42_CRC32C_WITH_RUNTIME_CHECK
+#ifdef HAVE__GET_CPUID
+#include <cpuid.h>
+#endif
+#ifdef HAVE__CPUID
+#include <intrin.h>
+#endif
+#endif
+
+#include "executor/execBatchKernels.h"
+#include "utils/float.h"
+
+/*
+ * Set the bit for each value that satisfies "value cmp constval".  Written
+ * so that the compiler can unroll and vectorize the loop.
+ */
+#define COMPARE_LOOP(cmp) \
+	for (i = 0; i < nvalues; i++) \
+		matches[i / 64] |= (uint64) (cmp(values[i], constval)) << (i % 64)
+
+#define INT_EQ(a, b)	((a) == (b))
+#define INT_NE(a, b)	((a) != (b))
+#define INT_LT(a, b)	((a) < (b))
+#define INT_LE(a, b)	((a) <= (b))
+#define INT_GT(a, b)	((a) > (b))
+#define INT_GE(a, b)	((a) >= (b))
+
+void
+ExecBatchCompareInt64_scalar(BatchCompareOp op, const int64 *values,
+							 int nvalues, int64 constval, uint64 *matches)
+{
+	int			i;
+
+	memset(matches, 0, BATCH_MATCH_WORDS(nvalues) * sizeof(uint64));
+
+	switch (op)
+	{
+		case BATCH_CMP_EQ:
+			COMPARE_LOOP(INT_EQ);
+			break;
+		case BATCH_CMP_NE:
+			COMPARE_LOOP(INT_NE);
+			break;
+		case BATCH_CMP_LT:
+			COMPARE_LOOP(INT_LT);
+			break;
+		case BATCH_CMP_LE:
+			COMPARE_LOOP(INT_LE);
+			break;
+		case BATCH_CMP_GT:
+			COMPARE_LOOP(INT_GT);
+			break;
+		case BATCH_CMP_GE:
+			COMPARE_LOOP(INT_GE);
+			break;
+	}
+}
+
+void
+ExecBatchCompareFloat8_scalar(BatchCompareOp op, const float8 *values,
+							  int nvalues, float8 constval, uint64 *matches)
+{
+	int			i;
+
+	memset(matches, 0, BATCH_MATCH_WORDS(nvalues) * sizeof(uint64));
+
+	switch (op)
+	{
+		case BATCH_CMP_EQ:
+			COMPARE_LOOP(float8_eq);
+			break;
+		case BATCH_CMP_NE:
+			COMPARE_LOOP(float8_ne);
+			break;
+		case BATCH_CMP_LT:
+			COMPARE_LOOP(float8_lt);
+			break;
+		case BATCH_CMP_LE:
+			COMPARE_LOOP(float8_le);
+			break;
+		case BATCH_CMP_GT:
+			COMPARE_LOOP(float8_gt);
+			break;
+		case BATCH_CMP_GE:
+			COMPARE_LOOP(float8_ge);
+			break;
+	}
+}
+
+#ifdef USE_SSE42_BATCH_KERNELS_WITH_RUNTIME_CHECK
+
+/* see pg_crc32c_sse42_choose.c */
+static bool
+batch_kernels_sse42_available(void)
+{
+	unsigned int exx[4] = {0, 0, 0, 0};
+
+#if defined(HAVE__GET_CPUID)
+	__get_cpuid(1, &exx[0], &exx[1], &exx[2], &exx[3]);
+#elif defined(HAVE__CPUID)
+	__cpuid(exx, 1);
+#else
+#error cpuid instruction not available
+#endif
+
+	return (exx[2] & (1 << 20)) != 0;	/* SSE 4.2 */
+}
+
+/*
+ * These get called on the first call. They replace the function pointer
+ * so that subsequent calls are routed directly to the chosen implementation.
+ */
+static void
+ExecBatchCompareInt64_choose(BatchCompareOp op, const int64 *values,
+							 int nvalues, int64 constval, uint64 *matches)
+{
+	if (batch_kernels_sse42_available())
+		ExecBatchCompareInt64 = ExecBatchCompareInt64_sse42;
+	else
+		ExecBatchCompareInt64 = ExecBatchCompareInt64_scalar;
+
+	ExecBatchCompareInt64(op, values, nvalues, constval, matches);
+}
+
+static void
+ExecBatchCompareFloat8_choose(BatchCompareOp op, const float8 *values,
+							  int nvalues, float8 constval, uint64 *matches)
+{
+	if (batch_kernels_sse42_available())
+		ExecBatchCompareFloat8 = ExecBatchCompareFloat8_sse42;
+	else
+		ExecBatchCompareFloat8 = ExecBatchCompareFloat8_scalar;
+
+	ExecBatchCompareFloat8(op, values, nvalues, constval, matches);
+}
+
+BatchCompareInt64Fn ExecBatchCompareInt64 = ExecBatchCompareInt64_choose;
+BatchCompareFloat8Fn ExecBatchCompareFloat8 = ExecBatchCompareFloat8_choose;
+
+#endif							/* USE_SSE42_BATCH_KERNELS_WITH_RUNTIME_CHECK */
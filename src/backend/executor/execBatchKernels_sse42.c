@@ -0,0 +1,173 @@
+/*-------------------------------------------------------------------------
+ *
+ * execBatchKernels_sse42.c
+ *	  Comparison kernels for batch qual evaluation using SSE 4.2
+ *	  instructions.
+ *
+ * Portions Copyright (c) 1996-2020, PostgreSQL Global Development Group
+ * Portions Copyright (c) 1994, Regents of the University of California
+ *
+ *
+ * IDENTIFICATION
+ *	  src/backend/executor/execBatchKernels_sse42.c
+ *
+ *-------------------------------------------------------------------------
+ */
+#include "postgres.h"
+
+#include <nmmintrin.h>
+
+#include "executor/execBatchKernels.h"
+#include "utils/float.h"
+
+/*
+ * Compare two values per iteration.  'cmp' must produce all-ones in the
+ * lanes that satisfy the comparison; 'invert' flips the result, for the
+ * comparisons that have no instruction of their own.  As i is always even,
+ * the two result bits never straddle a bitmap word.
+ *
+ * NB: We do unaligned loads here, as the value arrays are only guaranteed
+ * to be MAXALIGN'd.
+ */
+#define SSE42_LOOP(cmp, invert) \
+	for (; i + 2 <= nvalues; i += 2) \
+	{ \
+		int			bits; \
+\
+		v = LOAD(&values[i]); \
+		bits = MOVEMASK(cmp) ^ (invert); \
+		matches[i / 64] |= (uint64) bits << (i % 64); \
+	}
+
+static inline bool
+int64_compare(BatchCompareOp op, int64 val1, int64 val2)
+{
+	switch (op)
+	{
+		case BATCH_CMP_EQ:
+			return val1 == val2;
+		case BATCH_CMP_NE:
+			return val1 != val2;
+		case BATCH_CMP_LT:
+			return val1 < val2;
+		case BATCH_CMP_LE:
+			return val1 <= val2;
+		case BATCH_CMP_GT:
+			return val1 > val2;
+		case BATCH_CMP_GE:
+			return val1 >= val2;
+	}
+	return false;				/* keep compiler quiet */
+}
+
+static inline bool
+float8_compare(BatchCompareOp op, float8 val1, float8 val2)
+{
+	switch (op)
+	{
+		case BATCH_CMP_EQ:
+			return float8_eq(val1, val2);
+		case BATCH_CMP_NE:
+			return float8_ne(val1, val2);
+		case BATCH_CMP_LT:
+			return float8_lt(val1, val2);
+		case BATCH_CMP_LE:
+			return float8_le(val1, val2);
+		case BATCH_CMP_GT:
+			return float8_gt(val1, val2);
+		case BATCH_CMP_GE:
+			return float8_ge(val1, val2);
+	}
+	return false;				/* keep compiler quiet */
+}
+
+#define LOAD(p)			_mm_loadu_si128((const __m128i *) (p))
+#define MOVEMASK(x)		_mm_movemask_pd(_mm_castsi128_pd(x))
+
+void
+ExecBatchCompareInt64_sse42(BatchCompareOp op, const int64 *values,
+							int nvalues, int64 constval, uint64 *matches)
+{
+	__m128i		c = _mm_set1_epi64x(constval);
+	__m128i		v;
+	int			i = 0;
+
+	memset(matches, 0, BATCH_MATCH_WORDS(nvalues) * sizeof(uint64));
+
+	switch (op)
+	{
+		case BATCH_CMP_EQ:
+			SSE42_LOOP(_mm_cmpeq_epi64(v, c), 0);
+			break;
+		case BATCH_CMP_NE:
+			SSE42_LOOP(_mm_cmpeq_epi64(v, c), 3);
+			break;
+		case BATCH_CMP_LT:
+			SSE42_LOOP(_mm_cmpgt_epi64(c, v), 0);
+			break;
+		case BATCH_CMP_LE:
+			SSE42_LOOP(_mm_cmpgt_epi64(v, c), 3);
+			break;
+		case BATCH_CMP_GT:
+			SSE42_LOOP(_mm_cmpgt_epi64(v, c), 0);
+			break;
+		case BATCH_CMP_GE:
+			SSE42_LOOP(_mm_cmpgt_epi64(c, v), 3);
+			break;
+	}
+
+	/* handle the odd value at the end, if any */
+	for (; i < nvalues; i++)
+		matches[i / 64] |=
+			(uint64) int64_compare(op, values[i], constval) << (i % 64);
+}
+
+#undef LOAD
+#undef MOVEMASK
+
+#define LOAD(p)			_mm_loadu_pd(p)
+#define MOVEMASK(x)		_mm_movemask_pd(x)
+
+/*
+ * The unordered "not less than" and "not less or equal" comparisons are true
+ * for NaN inputs, and the ordered ones false, which gives us the float8
+ * comparison semantics as long as the constant isn't a NaN.
+ */
+void
+ExecBatchCompareFloat8_sse42(BatchCompareOp op, const float8 *values,
+							 int nvalues, float8 constval, uint64 *matches)
+{
+	__m128d		c = _mm_set1_pd(constval);
+	__m128d		v;
+	int			i = 0;
+
+	Assert(!isnan(constval));
+
+	memset(matches, 0, BATCH_MATCH_WORDS(nvalues) * sizeof(uint64));
+
+	switch (op)
+	{
+		case BATCH_CMP_EQ:
+			SSE42_LOOP(_mm_cmpeq_pd(v, c), 0);
+			break;
+		case BATCH_CMP_NE:
+			SSE42_LOOP(_mm_cmpneq_pd(v, c), 0);
+			break;
+		case BATCH_CMP_LT:
+			SSE42_LOOP(_mm_cmplt_pd(v, c), 0);
+			break;
+		case BATCH_CMP_LE:
+			SSE42_LOOP(_mm_cmple_pd(v, c), 0);
+			break;
+		case BATCH_CMP_GT:
+			SSE42_LOOP(_mm_cmpnle_pd(v, c), 0);
+			break;
+		case BATCH_CMP_GE:
+			SSE42_LOOP(_mm_cmpnlt_pd(v, c), 0);
+			break;
+	}
+
+	for (; i < nvalues; i++)
+		matches[i / 64] |=
+			(uint64) float8_compare(op, values[i], constval) << (i % 64);
+}
@@ -32,6 +32,7 @@
 
 #include "access/nbtree.h"
 #include "catalog/objectaccess.h"
+#include "catalog/pg_proc.h"
 #include "catalog/pg_type.h"
 #include "executor/execExpr.h"
 #include "executor/nodeSubplan.h"
@@ -40,12 +41,14 @@
 #include "miscadmin.h"
 #include "nodes/makefuncs.h"
 #include "nodes/nodeFuncs.h"
+#include "optimizer/clauses.h"
 #include "optimizer/optimizer.h"
 #include "pgstat.h"
 #include "utils/acl.h"
 #include "utils/array.h"
 #include "utils/builtins.h"
 #include "utils/datum.h"
+#include "utils/fmgroids.h"
 #include "utils/lsyscache.h"
 #include "utils/typcache.h"
 
@@ -55,17 +58,97 @@ typedef struct LastAttnumInfo
 	AttrNumber	last_inner;
 	AttrNumber	last_outer;
 	AttrNumber	last_scan;
+	/* attributes referenced from each slot */
+	Bitmapset  *needed_inner;
+	Bitmapset  *needed_outer;
+	Bitmapset  *needed_scan;
 } LastAttnumInfo;
 
+/*
+ * Built-in operator functions the interpreter evaluates itself, with the
+ * opcode to use and the operation it's to perform.
+ */
+typedef struct BuiltinFunc
+{
+	Oid			funcid;
+	ExprEvalOp	opcode;
+	ExprBuiltinOp builtin;
+} BuiltinFunc;
+
+#define BUILTIN_CMP_FUNC_OIDS(eq, ne, lt, le, gt, ge, opcode) \
+	{eq, opcode, EEO_BUILTIN_EQ}, \
+	{ne, opcode, EEO_BUILTIN_NE}, \
+	{lt, opcode, EEO_BUILTIN_LT}, \
+	{le, opcode, EEO_BUILTIN_LE}, \
+	{gt, opcode, EEO_BUILTIN_GT}, \
+	{ge, opcode, EEO_BUILTIN_GE}
+
+#define BUILTIN_CMP_FUNCS(prefix, opcode) \
+	BUILTIN_CMP_FUNC_OIDS(F_##prefix##EQ, F_##prefix##NE, \
+						  F_##prefix##LT, F_##prefix##LE, \
+						  F_##prefix##GT, F_##prefix##GE, opcode)
+
+static const BuiltinFunc builtin_funcs[] =
+{
+	/* int2 Datums are sign-extended, so they compare fine as int4 */
+	BUILTIN_CMP_FUNCS(INT2, EEOP_FUNCEXPR_INT4_CMP),
+	BUILTIN_CMP_FUNCS(INT4, EEOP_FUNCEXPR_INT4_CMP),
+	BUILTIN_CMP_FUNCS(INT24, EEOP_FUNCEXPR_INT4_CMP),
+	BUILTIN_CMP_FUNCS(INT42, EEOP_FUNCEXPR_INT4_CMP),
+	BUILTIN_CMP_FUNCS(INT8, EEOP_FUNCEXPR_INT8_CMP),
+	BUILTIN_CMP_FUNCS(DATE_, EEOP_FUNCEXPR_INT4_CMP),
+	BUILTIN_CMP_FUNCS(TIMESTAMP_, EEOP_FUNCEXPR_INT8_CMP),
+	BUILTIN_CMP_FUNC_OIDS(TIMESTAMP_EQ_PROC_OID, TIMESTAMP_NE_PROC_OID,
+						  TIMESTAMP_LT_PROC_OID, TIMESTAMP_LE_PROC_OID,
+						  TIMESTAMP_GT_PROC_OID, TIMESTAMP_GE_PROC_OID,
+						  EEOP_FUNCEXPR_INT8_CMP),
+	BUILTIN_CMP_FUNCS(FLOAT8, EEOP_FUNCEXPR_FLOAT8_CMP),
+	BUILTIN_CMP_FUNCS(BOOL, EEOP_FUNCEXPR_BOOL_CMP),
+	{F_INT4PL, EEOP_FUNCEXPR_INT4_ARITH, EEO_BUILTIN_PL},
+	{F_INT4MI, EEOP_FUNCEXPR_INT4_ARITH, EEO_BUILTIN_MI},
+	{F_INT4MUL, EEOP_FUNCEXPR_INT4_ARITH, EEO_BUILTIN_MUL},
+	{F_INT8PL, EEOP_FUNCEXPR_INT8_ARITH, EEO_BUILTIN_PL},
+	{F_INT8MI, EEOP_FUNCEXPR_INT8_ARITH, EEO_BUILTIN_MI},
+	{F_INT8MUL, EEOP_FUNCEXPR_INT8_ARITH, EEO_BUILTIN_MUL},
+	{F_FLOAT8PL, EEOP_FUNCEXPR_FLOAT8_ARITH, EEO_BUILTIN_PL},
+	{F_FLOAT8MI, EEOP_FUNCEXPR_FLOAT8_ARITH, EEO_BUILTIN_MI},
+	{F_FLOAT8MUL, EEOP_FUNCEXPR_FLOAT8_ARITH, EEO_BUILTIN_MUL},
+	{F_FLOAT8DIV, EEOP_FUNCEXPR_FLOAT8_ARITH, EEO_BUILTIN_DIV}
+};
+
+typedef struct CommonExprCandidate
+{
+	Expr	   *expr;
+	int			noccurs;		/* number of occurrences */
+	int			nmaximal;		/* ... not within another common one */
+} CommonExprCandidate;
+
+typedef struct FindCommonExprsContext
+{
+	List	   *candidates;		/* list of CommonExprCandidate */
+	bool		maximal;		/* counting nmaximal, rather than noccurs? */
+} FindCommonExprsContext;
+
 static void ExecReadyExpr(ExprState *state);
 static void ExecInitExprRec(Expr *node, ExprState *state,
 							Datum *resv, bool *resnull);
 static void ExecInitFunc(ExprEvalStep *scratch, Expr *node, List *args,
 						 Oid funcid, Oid inputcollid,
 						 ExprState *state);
+static CommonExprs *ExecGetCommonExprs(PlanState *parent, List *exprs);
+static CommonExprs *ExecFindCommonExprs(Plan *plan);
+static bool find_common_exprs_walker(Node *node,
+									 FindCommonExprsContext *context);
+static bool is_common_expr_candidate(Node *node);
+static bool contain_context_dependent_walker(Node *node, void *context);
+static bool ExecInitCommonExpr(Expr *node, ExprState *state,
+							   Datum *resv, bool *resnull);
+static void ExecInitBuiltinFunc(ExprEvalStep *scratch, Oid funcid);
 static void ExecInitExprSlots(ExprState *state, Node *node);
 static void ExecPushExprSlots(ExprState *state, LastAttnumInfo *info);
 static bool get_last_attnums_walker(Node *node, LastAttnumInfo *info);
+static void ExecComputeSparseDeform(ExprState *state, ExprEvalStep *op,
+									Bitmapset *needed);
 static bool ExecComputeSlotInfo(ExprState *state, ExprEvalStep *op);
 static void ExecInitWholeRowVar(ExprEvalStep *scratch, Var *variable,
 								ExprState *state);
@@ -230,6 +313,18 @@ ExecInitQual(List *qual, PlanState *parent)
 	/* Insert EEOP_*_FETCHSOME steps as needed */
 	ExecInitExprSlots(state, (Node *) qual);
 
+	/*
+	 * If the qual shares subexpressions with the projection, the values
+	 * computed for the previous row have to be forgotten first.
+	 */
+	state->common = ExecGetCommonExprs(parent, qual);
+	if (state->common != NULL)
+	{
+		scratch.opcode = EEOP_COMMON_RESET;
+		scratch.d.common_expr.common = state->common;
+		ExprEvalPushStep(state, &scratch);
+	}
+
 	/*
 	 * ExecQual() needs to return false for an expression returning NULL. That
 	 * allows us to short-circuit the evaluation the first time a NULL is
@@ -374,6 +469,9 @@ ExecBuildProjectionInfo(List *targetList,
 	/* Insert EEOP_*_FETCHSOME steps as needed */
 	ExecInitExprSlots(state, (Node *) targetList);
 
+	/* Share subexpressions with the qual, and among the columns */
+	state->common = ExecGetCommonExprs(parent, targetList);
+
 	/* Now compile each tlist column */
 	foreach(lc, targetList)
 	{
@@ -469,6 +567,17 @@ ExecBuildProjectionInfo(List *targetList,
 		}
 	}
 
+	/*
+	 * Forget the values of the common subexpressions, in case the next row
+	 * doesn't go through the qual.
+	 */
+	if (state->common != NULL)
+	{
+		scratch.opcode = EEOP_COMMON_RESET;
+		scratch.d.common_expr.common = state->common;
+		ExprEvalPushStep(state, &scratch);
+	}
+
 	scratch.opcode = EEOP_DONE;
 	ExprEvalPushStep(state, &scratch);
 
@@ -656,6 +765,10 @@ ExecInitExprRec(Expr *node, ExprState *state,
 	scratch.resvalue = resv;
 	scratch.resnull = resnull;
 
+	/* Reuse the value of a common subexpression, if it is one */
+	if (ExecInitCommonExpr(node, state, resv, resnull))
+		return;
+
 	/* cases should be ordered as they are in enum NodeTag */
 	switch (nodeTag(node))
 	{
@@ -2115,6 +2228,217 @@ ExecInitExprRec(Expr *node, ExprState *state,
 	}
 }
 
+/*
+ * Return the common subexpressions to use when compiling exprs, or NULL.
+ *
+ * Only the qual and the target list of a plan node share the values of
+ * their subexpressions, as these are evaluated for the same row of the
+ * node's expression context: first the qual, then, if that passes, the
+ * projection.  The common subexpressions are determined when the first of
+ * the two is compiled.
+ */
+static CommonExprs *
+ExecGetCommonExprs(PlanState *parent, List *exprs)
+{
+	if (parent == NULL || parent->plan == NULL || exprs == NIL)
+		return NULL;
+	if (exprs != parent->plan->qual && exprs != parent->plan->targetlist)
+		return NULL;
+
+	if (parent->ps_CommonExprs == NULL)
+		parent->ps_CommonExprs = ExecFindCommonExprs(parent->plan);
+
+	if (parent->ps_CommonExprs->ncommon == 0)
+		return NULL;
+	return parent->ps_CommonExprs;
+}
+
+/*
+ * Find the subexpressions occurring more than once in the qual and target
+ * list of plan.  Of nested ones, only the outermost is of interest.
+ */
+static CommonExprs *
+ExecFindCommonExprs(Plan *plan)
+{
+	FindCommonExprsContext context;
+	CommonExprs *common;
+	ListCell   *lc;
+
+	/* first count all occurrences of every candidate */
+	context.candidates = NIL;
+	context.maximal = false;
+	find_common_exprs_walker((Node *) plan->qual, &context);
+	find_common_exprs_walker((Node *) plan->targetlist, &context);
+
+	/* then count again, skipping those within another common one */
+	context.maximal = true;
+	find_common_exprs_walker((Node *) plan->qual, &context);
+	find_common_exprs_walker((Node *) plan->targetlist, &context);
+
+	common = (CommonExprs *) palloc0(sizeof(CommonExprs));
+	common->common = (CommonExpr *)
+		palloc0(sizeof(CommonExpr) * list_length(context.candidates));
+	/* must differ from the generation of values never computed */
+	common->generation = 1;
+
+	foreach(lc, context.candidates)
+	{
+		CommonExprCandidate *cand = (CommonExprCandidate *) lfirst(lc);
+
+		if (cand->nmaximal > 1)
+			common->common[common->ncommon++].expr = cand->expr;
+	}
+
+	list_free_deep(context.candidates);
+
+	return common;
+}
+
+static bool
+find_common_exprs_walker(Node *node, FindCommonExprsContext *context)
+{
+	if (node == NULL)
+		return false;
+
+	/*
+	 * The arguments of these are not evaluated as part of the expression they
+	 * appear in.
+	 */
+	if (IsA(node, Aggref) || IsA(node, WindowFunc) ||
+		IsA(node, GroupingFunc) || IsA(node, SubPlan) ||
+		IsA(node, AlternativeSubPlan))
+		return false;
+
+	if (is_common_expr_candidate(node))
+	{
+		CommonExprCandidate *cand = NULL;
+		ListCell   *lc;
+
+		foreach(lc, context->candidates)
+		{
+			CommonExprCandidate *c = (CommonExprCandidate *) lfirst(lc);
+
+			if (equal(node, c->expr))
+			{
+				cand = c;
+				break;
+			}
+		}
+
+		if (!context->maximal)
+		{
+			if (cand == NULL)
+			{
+				cand = (CommonExprCandidate *)
+					palloc0(sizeof(CommonExprCandidate));
+				cand->expr = (Expr *) node;
+				context->candidates = lappend(context->candidates, cand);
+			}
+			cand->noccurs++;
+		}
+		else if (cand->noccurs > 1)
+		{
+			cand->nmaximal++;
+			return false;
+		}
+	}
+
+	return expression_tree_walker(node, find_common_exprs_walker,
+								  (void *) context);
+}
+
+/*
+ * Can node be computed once per row and shared by all its occurrences?
+ *
+ * Only function and operator calls are worth it.  Their value must not
+ * change within the row, and must depend on the row at all, else there's
+ * little point.  Expressions whose value depends on where they appear, like
+ * those referencing the value tested by a CASE, don't qualify either.
+ */
+static bool
+is_common_expr_candidate(Node *node)
+{
+	if (!IsA(node, FuncExpr) && !IsA(node, OpExpr))
+		return false;
+
+	return !expression_returns_set(node) &&
+		!contain_volatile_functions(node) &&
+		!contain_subplans(node) &&
+		contain_var_clause(node) &&
+		!contain_context_dependent_walker(node, NULL);
+}
+
+static bool
+contain_context_dependent_walker(Node *node, void *context)
+{
+	if (node == NULL)
+		return false;
+	if (IsA(node, CaseTestExpr) || IsA(node, CoerceToDomainValue))
+		return true;
+	return expression_tree_walker(node, contain_context_dependent_walker,
+								  context);
+}
+
+/*
+ * If node is a common subexpression of the qual and projection the
+ * expression being compiled belongs to, emit steps to share its value with
+ * the other occurrences, and return true.
+ *
+ * Each occurrence first checks whether the value has already been computed
+ * for the current row.  Only if not, it computes the value as usual, and
+ * remembers it.
+ */
+static bool
+ExecInitCommonExpr(Expr *node, ExprState *state, Datum *resv, bool *resnull)
+{
+	CommonExprs *common = state->common;
+	CommonExpr *cexpr = NULL;
+	ExprEvalStep scratch = {0};
+	Expr	   *save_common_node;
+	int			fetchstep;
+
+	/* quick exit for everything that can't be a common subexpression */
+	if (common == NULL || node == state->common_node ||
+		!(IsA(node, FuncExpr) || IsA(node, OpExpr)))
+		return false;
+
+	for (int i = 0; i < common->ncommon; i++)
+	{
+		if (equal(node, common->common[i].expr))
+		{
+			cexpr = &common->common[i];
+			break;
+		}
+	}
+	if (cexpr == NULL)
+		return false;
+
+	scratch.opcode = EEOP_COMMON_FETCH;
+	scratch.resvalue = resv;
+	scratch.resnull = resnull;
+	scratch.d.common_expr.common = common;
+	scratch.d.common_expr.cexpr = cexpr;
+	scratch.d.common_expr.jumpdone = -1;	/* adjust later */
+	ExprEvalPushStep(state, &scratch);
+	fetchstep = state->steps_len - 1;
+
+	/* compute the value, without ending up here again */
+	save_common_node = state->common_node;
+	state->common_node = node;
+	ExecInitExprRec(node, state, resv, resnull);
+	state->common_node = save_common_node;
+
+	scratch.opcode = EEOP_COMMON_STORE;
+	scratch.d.common_expr.typlen = get_typlen(exprType((Node *) node));
+	ExprEvalPushStep(state, &scratch);
+
+	state->steps[fetchstep].d.common_expr.jumpdone = state->steps_len;
+
+	cexpr->nuses++;
+
+	return true;
+}
+
 /*
  * Add another expression evaluation step to ExprState->steps.
  *
@@ -2246,6 +2570,32 @@ ExecInitFunc(ExprEvalStep *scratch, Expr *node, List *args, Oid funcid,
 		else
 			scratch->opcode = EEOP_FUNCEXPR_FUSAGE;
 	}
+
+	/* Skip the function call for some hot built-in operators */
+	if (scratch->opcode == EEOP_FUNCEXPR_STRICT && nargs == 2)
+		ExecInitBuiltinFunc(scratch, funcid);
+}
+
+/*
+ * If funcid is one of the built-in functions in builtin_funcs[], set up
+ * *scratch to have the interpreter perform the operation itself.  The
+ * function call info stays as set up by ExecInitFunc(), so the step can
+ * still be treated as EEOP_FUNCEXPR_STRICT, and the function can be called
+ * after all to report an overflow.
+ */
+static void
+ExecInitBuiltinFunc(ExprEvalStep *scratch, Oid funcid)
+{
+	for (int i = 0; i < lengthof(builtin_funcs); i++)
+	{
+		if (builtin_funcs[i].funcid == funcid)
+		{
+			Assert(scratch->d.func.finfo->fn_strict);
+			scratch->opcode = builtin_funcs[i].opcode;
+			scratch->d.func.builtin = builtin_funcs[i].builtin;
+			return;
+		}
+	}
 }
 
 /*
@@ -2287,7 +2637,10 @@ ExecPushExprSlots(ExprState *state, LastAttnumInfo *info)
 		scratch.d.fetch.kind = NULL;
 		scratch.d.fetch.known_desc = NULL;
 		if (ExecComputeSlotInfo(state, &scratch))
+		{
+			ExecComputeSparseDeform(state, &scratch, info->needed_inner);
 			ExprEvalPushStep(state, &scratch);
+		}
 	}
 	if (info->last_outer > 0)
 	{
@@ -2297,7 +2650,10 @@ ExecPushExprSlots(ExprState *state, LastAttnumInfo *info)
 		scratch.d.fetch.kind = NULL;
 		scratch.d.fetch.known_desc = NULL;
 		if (ExecComputeSlotInfo(state, &scratch))
+		{
+			ExecComputeSparseDeform(state, &scratch, info->needed_outer);
 			ExprEvalPushStep(state, &scratch);
+		}
 	}
 	if (info->last_scan > 0)
 	{
@@ -2307,7 +2663,10 @@ ExecPushExprSlots(ExprState *state, LastAttnumInfo *info)
 		scratch.d.fetch.kind = NULL;
 		scratch.d.fetch.known_desc = NULL;
 		if (ExecComputeSlotInfo(state, &scratch))
+		{
+			ExecComputeSparseDeform(state, &scratch, info->needed_scan);
 			ExprEvalPushStep(state, &scratch);
+		}
 	}
 }
 
@@ -2328,16 +2687,25 @@ get_last_attnums_walker(Node *node, LastAttnumInfo *info)
 		{
 			case INNER_VAR:
 				info->last_inner = Max(info->last_inner, attnum);
+				if (attnum > 0)
+					info->needed_inner =
+						bms_add_member(info->needed_inner, attnum);
 				break;
 
 			case OUTER_VAR:
 				info->last_outer = Max(info->last_outer, attnum);
+				if (attnum > 0)
+					info->needed_outer =
+						bms_add_member(info->needed_outer, attnum);
 				break;
 
 				/* INDEX_VAR is handled by default case */
 
 			default:
 				info->last_scan = Max(info->last_scan, attnum);
+				if (attnum > 0)
+					info->needed_scan =
+						bms_add_member(info->needed_scan, attnum);
 				break;
 		}
 		return false;
@@ -2359,6 +2727,37 @@ get_last_attnums_walker(Node *node, LastAttnumInfo *info)
 								  (void *) info);
 }
 
+/*
+ * Decide whether the EEOP_*_FETCHSOME step op only needs to extract the
+ * attributes in needed, rather than all of them up to last_var.
+ *
+ * Skipping an attribute saves storing it, and where offsets are cached even
+ * looking at it.  But a sparse fetch leaves the slot's tts_nvalid alone, so
+ * the next expression evaluated on the same tuple has to walk it again.  So
+ * only do that when at most half of the attributes up to last_var are
+ * referenced.
+ */
+static void
+ExecComputeSparseDeform(ExprState *state, ExprEvalStep *op, Bitmapset *needed)
+{
+	bits8	   *bits;
+	int			attnum;
+
+	op->d.fetch.needed = NULL;
+
+	if (bms_num_members(needed) * 2 > op->d.fetch.last_var)
+		return;
+
+	/* same layout as a tuple's null bitmap, with attnums starting at 0 */
+	bits = palloc0(BITMAPLEN(op->d.fetch.last_var));
+	attnum = -1;
+	while ((attnum = bms_next_member(needed, attnum)) >= 0)
+		bits[(attnum - 1) >> 3] |= 1 << ((attnum - 1) & 0x07);
+
+	op->d.fetch.needed = bits;
+	state->flags |= EEO_FLAG_SPARSE_DEFORM;
+}
+
 /*
  * Compute additional information for EEOP_*_FETCHSOME ops.
  *
@@ -3074,7 +3473,8 @@ ExecBuildAggTrans(AggState *aggstate, AggStatePerPhase phase,
 			ListCell   *arg;
 
 			/*
-			 * Normal transition function without ORDER BY / DISTINCT.
+			 * Normal transition function without ORDER BY / DISTINCT, or
+			 * with a DISTINCT that's checked by ExecBuildAggTransCall().
 			 */
 			strictargs = trans_fcinfo->args + 1;
 
@@ -3239,6 +3639,7 @@ ExecBuildAggTransCall(ExprState *state, AggState *aggstate,
 {
 	ExprContext *aggcontext;
 	int adjust_jumpnull = -1;
+	int			adjust_jumpdistinct = -1;
 
 	if (ishash)
 		aggcontext = aggstate->hashcontext;
@@ -3256,6 +3657,26 @@ ExecBuildAggTransCall(ExprState *state, AggState *aggstate,
 		adjust_jumpnull = state->steps_len - 1;
 	}
 
+	/*
+	 * A DISTINCT aggregate in a hashed Agg remembers the inputs seen by each
+	 * group in a hash table; skip the transition function for duplicates.
+	 */
+	if (ishash && pertrans->distincttable != NULL)
+	{
+		scratch->opcode = EEOP_AGG_HASHED_DISTINCT;
+		scratch->d.agg_trans.pertrans = pertrans;
+		scratch->d.agg_trans.setno = setno;
+		scratch->d.agg_trans.setoff = setoff;
+		scratch->d.agg_trans.transno = transno;
+		scratch->d.agg_trans.aggcontext = aggcontext;
+		ExprEvalPushStep(state, scratch);
+
+		scratch->opcode = EEOP_JUMP_IF_NOT_TRUE;
+		scratch->d.jump.jumpdone = -1;	/* adjust later */
+		ExprEvalPushStep(state, scratch);
+		adjust_jumpdistinct = state->steps_len - 1;
+	}
+
 	/*
 	 * Determine appropriate transition implementation.
 	 *
@@ -3333,6 +3754,16 @@ ExecBuildAggTransCall(ExprState *state, AggState *aggstate,
 		Assert(as->d.agg_plain_pergroup_nullcheck.jumpnull == -1);
 		as->d.agg_plain_pergroup_nullcheck.jumpnull = state->steps_len;
 	}
+
+	/* fix up jumpdone of the DISTINCT check */
+	if (adjust_jumpdistinct != -1)
+	{
+		ExprEvalStep *as = &state->steps[adjust_jumpdistinct];
+
+		Assert(as->opcode == EEOP_JUMP_IF_NOT_TRUE);
+		Assert(as->d.jump.jumpdone == -1);
+		as->d.jump.jumpdone = state->steps_len;
+	}
 }
 
 /*
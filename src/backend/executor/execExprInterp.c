@@ -59,6 +59,7 @@
 #include "access/heaptoast.h"
 #include "catalog/pg_type.h"
 #include "commands/sequence.h"
+#include "common/int.h"
 #include "executor/execExpr.h"
 #include "executor/nodeSubplan.h"
 #include "funcapi.h"
@@ -71,6 +72,7 @@
 #include "utils/date.h"
 #include "utils/datum.h"
 #include "utils/expandedrecord.h"
+#include "utils/float.h"
 #include "utils/lsyscache.h"
 #include "utils/memutils.h"
 #include "utils/timestamp.h"
@@ -137,6 +139,16 @@ static ExprEvalOpLookup reverse_dispatch_table[EEOP_LAST];
 		EEO_DISPATCH(); \
 	} while (0)
 
+/*
+ * Has a FETCHSOME step extracted the attnum'th (0-based) attribute of slot?
+ * A sparse fetch extracts it without advancing tts_nvalid, so with one of
+ * those in the expression only the range can be checked.
+ */
+#define EEO_VAR_FETCHED(state, slot, attnum) \
+	((attnum) >= 0 && \
+	 ((attnum) < (slot)->tts_nvalid || \
+	  ((state)->flags & EEO_FLAG_SPARSE_DEFORM) != 0))
+
 
 static Datum ExecInterpExpr(ExprState *state, ExprContext *econtext, bool *isnull);
 static void ExecInitInterpreter(void);
@@ -167,6 +179,19 @@ static Datum ExecJustAssignOuterVarVirt(ExprState *state, ExprContext *econtext,
 static Datum ExecJustAssignScanVarVirt(ExprState *state, ExprContext *econtext, bool *isnull);
 
 /* execution helper functions */
+static pg_attribute_always_inline bool builtin_cmp(ExprBuiltinOp builtin,
+												   int cmp);
+static pg_attribute_always_inline bool builtin_float8_cmp(ExprBuiltinOp builtin,
+														  float8 l, float8 r);
+static pg_attribute_always_inline bool builtin_int4_arith(ExprBuiltinOp builtin,
+														  int32 l, int32 r,
+														  int32 *result);
+static pg_attribute_always_inline bool builtin_int8_arith(ExprBuiltinOp builtin,
+														  int64 l, int64 r,
+														  int64 *result);
+static pg_attribute_always_inline float8 builtin_float8_arith(ExprBuiltinOp builtin,
+															  float8 l, float8 r);
+
 static pg_attribute_always_inline void
 ExecAggPlainTransByVal(AggState *aggstate, AggStatePerTrans pertrans,
 					   AggStatePerGroup pergroup,
@@ -262,8 +287,11 @@ ExecReadyInterpretedExpr(ExprState *state)
 			state->evalfunc_private = (void *) ExecJustAssignScanVar;
 			return;
 		}
+		/* built-in operator steps still have their function call set up */
 		else if (step0 == EEOP_CASE_TESTVAL &&
-				 step1 == EEOP_FUNCEXPR_STRICT &&
+				 (step1 == EEOP_FUNCEXPR_STRICT ||
+				  (step1 >= EEOP_FUNCEXPR_INT4_CMP &&
+				   step1 <= EEOP_FUNCEXPR_FLOAT8_ARITH)) &&
 				 state->steps[0].d.casetest.value)
 		{
 			state->evalfunc_private = (void *) ExecJustApplyFuncToCase;
@@ -375,6 +403,13 @@ ExecInterpExpr(ExprState *state, ExprContext *econtext, bool *isnull)
 		&&CASE_EEOP_FUNCEXPR_STRICT,
 		&&CASE_EEOP_FUNCEXPR_FUSAGE,
 		&&CASE_EEOP_FUNCEXPR_STRICT_FUSAGE,
+		&&CASE_EEOP_FUNCEXPR_INT4_CMP,
+		&&CASE_EEOP_FUNCEXPR_INT8_CMP,
+		&&CASE_EEOP_FUNCEXPR_FLOAT8_CMP,
+		&&CASE_EEOP_FUNCEXPR_BOOL_CMP,
+		&&CASE_EEOP_FUNCEXPR_INT4_ARITH,
+		&&CASE_EEOP_FUNCEXPR_INT8_ARITH,
+		&&CASE_EEOP_FUNCEXPR_FLOAT8_ARITH,
 		&&CASE_EEOP_BOOL_AND_STEP_FIRST,
 		&&CASE_EEOP_BOOL_AND_STEP,
 		&&CASE_EEOP_BOOL_AND_STEP_LAST,
@@ -431,11 +466,15 @@ ExecInterpExpr(ExprState *state, ExprContext *econtext, bool *isnull)
 		&&CASE_EEOP_WINDOW_FUNC,
 		&&CASE_EEOP_SUBPLAN,
 		&&CASE_EEOP_ALTERNATIVE_SUBPLAN,
+		&&CASE_EEOP_COMMON_RESET,
+		&&CASE_EEOP_COMMON_FETCH,
+		&&CASE_EEOP_COMMON_STORE,
 		&&CASE_EEOP_AGG_STRICT_DESERIALIZE,
 		&&CASE_EEOP_AGG_DESERIALIZE,
 		&&CASE_EEOP_AGG_STRICT_INPUT_CHECK_ARGS,
 		&&CASE_EEOP_AGG_STRICT_INPUT_CHECK_NULLS,
 		&&CASE_EEOP_AGG_PLAIN_PERGROUP_NULLCHECK,
+		&&CASE_EEOP_AGG_HASHED_DISTINCT,
 		&&CASE_EEOP_AGG_PLAIN_TRANS_INIT_STRICT_BYVAL,
 		&&CASE_EEOP_AGG_PLAIN_TRANS_STRICT_BYVAL,
 		&&CASE_EEOP_AGG_PLAIN_TRANS_BYVAL,
@@ -478,7 +517,11 @@ ExecInterpExpr(ExprState *state, ExprContext *econtext, bool *isnull)
 		{
 			CheckOpSlotCompatibility(op, innerslot);
 
-			slot_getsomeattrs(innerslot, op->d.fetch.last_var);
+			if (op->d.fetch.needed)
+				slot_getsparseattrs(innerslot, op->d.fetch.last_var,
+									op->d.fetch.needed);
+			else
+				slot_getsomeattrs(innerslot, op->d.fetch.last_var);
 
 			EEO_NEXT();
 		}
@@ -487,7 +530,11 @@ ExecInterpExpr(ExprState *state, ExprContext *econtext, bool *isnull)
 		{
 			CheckOpSlotCompatibility(op, outerslot);
 
-			slot_getsomeattrs(outerslot, op->d.fetch.last_var);
+			if (op->d.fetch.needed)
+				slot_getsparseattrs(outerslot, op->d.fetch.last_var,
+									op->d.fetch.needed);
+			else
+				slot_getsomeattrs(outerslot, op->d.fetch.last_var);
 
 			EEO_NEXT();
 		}
@@ -496,7 +543,11 @@ ExecInterpExpr(ExprState *state, ExprContext *econtext, bool *isnull)
 		{
 			CheckOpSlotCompatibility(op, scanslot);
 
-			slot_getsomeattrs(scanslot, op->d.fetch.last_var);
+			if (op->d.fetch.needed)
+				slot_getsparseattrs(scanslot, op->d.fetch.last_var,
+									op->d.fetch.needed);
+			else
+				slot_getsomeattrs(scanslot, op->d.fetch.last_var);
 
 			EEO_NEXT();
 		}
@@ -511,7 +562,7 @@ ExecInterpExpr(ExprState *state, ExprContext *econtext, bool *isnull)
 			 * directly out of the slot's decomposed-data arrays.  But let's
 			 * have an Assert to check that that did happen.
 			 */
-			Assert(attnum >= 0 && attnum < innerslot->tts_nvalid);
+			Assert(EEO_VAR_FETCHED(state, innerslot, attnum));
 			*op->resvalue = innerslot->tts_values[attnum];
 			*op->resnull = innerslot->tts_isnull[attnum];
 
@@ -524,7 +575,7 @@ ExecInterpExpr(ExprState *state, ExprContext *econtext, bool *isnull)
 
 			/* See EEOP_INNER_VAR comments */
 
-			Assert(attnum >= 0 && attnum < outerslot->tts_nvalid);
+			Assert(EEO_VAR_FETCHED(state, outerslot, attnum));
 			*op->resvalue = outerslot->tts_values[attnum];
 			*op->resnull = outerslot->tts_isnull[attnum];
 
@@ -537,7 +588,7 @@ ExecInterpExpr(ExprState *state, ExprContext *econtext, bool *isnull)
 
 			/* See EEOP_INNER_VAR comments */
 
-			Assert(attnum >= 0 && attnum < scanslot->tts_nvalid);
+			Assert(EEO_VAR_FETCHED(state, scanslot, attnum));
 			*op->resvalue = scanslot->tts_values[attnum];
 			*op->resnull = scanslot->tts_isnull[attnum];
 
@@ -579,7 +630,7 @@ ExecInterpExpr(ExprState *state, ExprContext *econtext, bool *isnull)
 			 * We do not need CheckVarSlotCompatibility here; that was taken
 			 * care of at compilation time.  But see EEOP_INNER_VAR comments.
 			 */
-			Assert(attnum >= 0 && attnum < innerslot->tts_nvalid);
+			Assert(EEO_VAR_FETCHED(state, innerslot, attnum));
 			resultslot->tts_values[resultnum] = innerslot->tts_values[attnum];
 			resultslot->tts_isnull[resultnum] = innerslot->tts_isnull[attnum];
 
@@ -595,7 +646,7 @@ ExecInterpExpr(ExprState *state, ExprContext *econtext, bool *isnull)
 			 * We do not need CheckVarSlotCompatibility here; that was taken
 			 * care of at compilation time.  But see EEOP_INNER_VAR comments.
 			 */
-			Assert(attnum >= 0 && attnum < outerslot->tts_nvalid);
+			Assert(EEO_VAR_FETCHED(state, outerslot, attnum));
 			resultslot->tts_values[resultnum] = outerslot->tts_values[attnum];
 			resultslot->tts_isnull[resultnum] = outerslot->tts_isnull[attnum];
 
@@ -611,7 +662,7 @@ ExecInterpExpr(ExprState *state, ExprContext *econtext, bool *isnull)
 			 * We do not need CheckVarSlotCompatibility here; that was taken
 			 * care of at compilation time.  But see EEOP_INNER_VAR comments.
 			 */
-			Assert(attnum >= 0 && attnum < scanslot->tts_nvalid);
+			Assert(EEO_VAR_FETCHED(state, scanslot, attnum));
 			resultslot->tts_values[resultnum] = scanslot->tts_values[attnum];
 			resultslot->tts_isnull[resultnum] = scanslot->tts_isnull[attnum];
 
@@ -719,6 +770,167 @@ ExecInterpExpr(ExprState *state, ExprContext *econtext, bool *isnull)
 			EEO_NEXT();
 		}
 
+		/*
+		 * Built-in strict operators on two arguments, computed right here
+		 * rather than by calling the operator's function.  On overflow, the
+		 * function is called after all, to report the error.
+		 */
+		EEO_CASE(EEOP_FUNCEXPR_INT4_CMP)
+		{
+			NullableDatum *args = op->d.func.fcinfo_data->args;
+
+			if (args[0].isnull || args[1].isnull)
+				*op->resnull = true;
+			else
+			{
+				int32		l = DatumGetInt32(args[0].value);
+				int32		r = DatumGetInt32(args[1].value);
+
+				*op->resvalue = BoolGetDatum(builtin_cmp(op->d.func.builtin,
+														 (l > r) - (l < r)));
+				*op->resnull = false;
+			}
+
+			EEO_NEXT();
+		}
+
+		EEO_CASE(EEOP_FUNCEXPR_INT8_CMP)
+		{
+			NullableDatum *args = op->d.func.fcinfo_data->args;
+
+			if (args[0].isnull || args[1].isnull)
+				*op->resnull = true;
+			else
+			{
+				int64		l = DatumGetInt64(args[0].value);
+				int64		r = DatumGetInt64(args[1].value);
+
+				*op->resvalue = BoolGetDatum(builtin_cmp(op->d.func.builtin,
+														 (l > r) - (l < r)));
+				*op->resnull = false;
+			}
+
+			EEO_NEXT();
+		}
+
+		EEO_CASE(EEOP_FUNCEXPR_FLOAT8_CMP)
+		{
+			NullableDatum *args = op->d.func.fcinfo_data->args;
+
+			if (args[0].isnull || args[1].isnull)
+				*op->resnull = true;
+			else
+			{
+				*op->resvalue =
+					BoolGetDatum(builtin_float8_cmp(op->d.func.builtin,
+													DatumGetFloat8(args[0].value),
+													DatumGetFloat8(args[1].value)));
+				*op->resnull = false;
+			}
+
+			EEO_NEXT();
+		}
+
+		EEO_CASE(EEOP_FUNCEXPR_BOOL_CMP)
+		{
+			NullableDatum *args = op->d.func.fcinfo_data->args;
+
+			if (args[0].isnull || args[1].isnull)
+				*op->resnull = true;
+			else
+			{
+				int			l = DatumGetBool(args[0].value);
+				int			r = DatumGetBool(args[1].value);
+
+				*op->resvalue = BoolGetDatum(builtin_cmp(op->d.func.builtin,
+														 l - r));
+				*op->resnull = false;
+			}
+
+			EEO_NEXT();
+		}
+
+		EEO_CASE(EEOP_FUNCEXPR_INT4_ARITH)
+		{
+			FunctionCallInfo fcinfo = op->d.func.fcinfo_data;
+			NullableDatum *args = fcinfo->args;
+			int32		result;
+
+			if (args[0].isnull || args[1].isnull)
+				*op->resnull = true;
+			else if (likely(!builtin_int4_arith(op->d.func.builtin,
+												DatumGetInt32(args[0].value),
+												DatumGetInt32(args[1].value),
+												&result)))
+			{
+				*op->resvalue = Int32GetDatum(result);
+				*op->resnull = false;
+			}
+			else
+			{
+				Datum		d;
+
+				/* reports the overflow */
+				fcinfo->isnull = false;
+				d = op->d.func.fn_addr(fcinfo);
+				*op->resvalue = d;
+				*op->resnull = fcinfo->isnull;
+			}
+
+			EEO_NEXT();
+		}
+
+		EEO_CASE(EEOP_FUNCEXPR_INT8_ARITH)
+		{
+			FunctionCallInfo fcinfo = op->d.func.fcinfo_data;
+			NullableDatum *args = fcinfo->args;
+			int64		result;
+
+			if (args[0].isnull || args[1].isnull)
+				*op->resnull = true;
+			else if (likely(!builtin_int8_arith(op->d.func.builtin,
+												DatumGetInt64(args[0].value),
+												DatumGetInt64(args[1].value),
+												&result)))
+			{
+				*op->resvalue = Int64GetDatum(result);
+				*op->resnull = false;
+			}
+			else
+			{
+				Datum		d;
+
+				/* reports the overflow */
+				fcinfo->isnull = false;
+				d = op->d.func.fn_addr(fcinfo);
+				*op->resvalue = d;
+				*op->resnull = fcinfo->isnull;
+			}
+
+			EEO_NEXT();
+		}
+
+		EEO_CASE(EEOP_FUNCEXPR_FLOAT8_ARITH)
+		{
+			NullableDatum *args = op->d.func.fcinfo_data->args;
+
+			if (args[0].isnull || args[1].isnull)
+				*op->resnull = true;
+			else
+			{
+				float8		d;
+
+				/* these check for overflow themselves */
+				d = builtin_float8_arith(op->d.func.builtin,
+										 DatumGetFloat8(args[0].value),
+										 DatumGetFloat8(args[1].value));
+				*op->resvalue = Float8GetDatum(d);
+				*op->resnull = false;
+			}
+
+			EEO_NEXT();
+		}
+
 		/*
 		 * If any of its clauses is FALSE, an AND's result is FALSE regardless
 		 * of the states of the rest of the clauses, so we can stop evaluating
@@ -1543,6 +1755,35 @@ ExecInterpExpr(ExprState *state, ExprContext *econtext, bool *isnull)
 			EEO_NEXT();
 		}
 
+		EEO_CASE(EEOP_COMMON_RESET)
+		{
+			/* invalidate the values computed for the previous row */
+			op->d.common_expr.common->generation++;
+
+			EEO_NEXT();
+		}
+
+		EEO_CASE(EEOP_COMMON_FETCH)
+		{
+			CommonExpr *cexpr = op->d.common_expr.cexpr;
+
+			if (cexpr->generation == op->d.common_expr.common->generation)
+			{
+				*op->resvalue = cexpr->value;
+				*op->resnull = cexpr->isnull;
+				EEO_JUMP(op->d.common_expr.jumpdone);
+			}
+
+			EEO_NEXT();
+		}
+
+		EEO_CASE(EEOP_COMMON_STORE)
+		{
+			ExecEvalCommonExprStore(state, op);
+
+			EEO_NEXT();
+		}
+
 		/* evaluate a strict aggregate deserialization function */
 		EEO_CASE(EEOP_AGG_STRICT_DESERIALIZE)
 		{
@@ -1620,6 +1861,18 @@ ExecInterpExpr(ExprState *state, ExprContext *econtext, bool *isnull)
 			EEO_NEXT();
 		}
 
+		/*
+		 * Check whether the input of a DISTINCT aggregate is new for the
+		 * current group, in hashed aggregation.
+		 */
+		EEO_CASE(EEOP_AGG_HASHED_DISTINCT)
+		{
+			/* too complex for an inline implementation */
+			ExecEvalAggHashedDistinct(state, op, econtext);
+
+			EEO_NEXT();
+		}
+
 		/*
 		 * Different types of aggregate transition functions are implemented
 		 * as different types of steps, to avoid incurring unnecessary
@@ -3887,6 +4140,25 @@ ExecEvalAlternativeSubPlan(ExprState *state, ExprEvalStep *op, ExprContext *econ
 	*op->resvalue = ExecAlternativeSubPlan(asstate, econtext, op->resnull);
 }
 
+/*
+ * Remember the value of a common subexpression for the current row.
+ *
+ * As the value is going to be used more than once, a read/write expanded
+ * object must not be handed to the first consumer, which might modify it.
+ */
+void
+ExecEvalCommonExprStore(ExprState *state, ExprEvalStep *op)
+{
+	CommonExpr *cexpr = op->d.common_expr.cexpr;
+
+	if (op->d.common_expr.typlen == -1 && !*op->resnull)
+		*op->resvalue = MakeExpandedObjectReadOnlyInternal(*op->resvalue);
+
+	cexpr->value = *op->resvalue;
+	cexpr->isnull = *op->resnull;
+	cexpr->generation = op->d.common_expr.common->generation;
+}
+
 /*
  * Evaluate a wholerow Var expression.
  *
@@ -4243,6 +4515,50 @@ ExecEvalAggOrderedTransTuple(ExprState *state, ExprEvalStep *op,
 	tuplesort_puttupleslot(pertrans->sortstates[setno], pertrans->sortslot);
 }
 
+/*
+ * Look up the input of a DISTINCT aggregate, together with the grouping
+ * columns of the current group, in the aggregate's hash table of values seen
+ * so far.  The result is true if the combination wasn't seen before, meaning
+ * that the transition function has to be called.
+ */
+void
+ExecEvalAggHashedDistinct(ExprState *state, ExprEvalStep *op,
+						  ExprContext *econtext)
+{
+	AggState   *aggstate = castNode(AggState, state->parent);
+	AggStatePerTrans pertrans = op->d.agg_trans.pertrans;
+	AggStatePerHash perhash = &aggstate->perhash[op->d.agg_trans.setno];
+	TupleTableSlot *hashslot = perhash->hashslot;
+	TupleTableSlot *slot = pertrans->distinctslot;
+	NullableDatum *args = pertrans->transfn_fcinfo->args;
+	int			numGroupCols = perhash->numCols;
+	bool		isnew;
+	int			i;
+
+	ExecClearTuple(slot);
+
+	/* the grouping columns come first in the hash slot */
+	for (i = 0; i < numGroupCols; i++)
+	{
+		slot->tts_values[i] = hashslot->tts_values[i];
+		slot->tts_isnull[i] = hashslot->tts_isnull[i];
+	}
+
+	/* the aggregated values have been evaluated into the transfn's args */
+	for (i = 0; i < pertrans->numInputs; i++)
+	{
+		slot->tts_values[numGroupCols + i] = args[i + 1].value;
+		slot->tts_isnull[numGroupCols + i] = args[i + 1].isnull;
+	}
+
+	ExecStoreVirtualTuple(slot);
+
+	LookupTupleHashEntry(pertrans->distincttable, slot, &isnew);
+
+	*op->resvalue = BoolGetDatum(isnew);
+	*op->resnull = false;
+}
+
 /* implementation of transition function invocation for byval types */
 static pg_attribute_always_inline void
 ExecAggPlainTransByVal(AggState *aggstate, AggStatePerTrans pertrans,
@@ -4329,3 +4645,105 @@ ExecAggPlainTransByRef(AggState *aggstate, AggStatePerTrans pertrans,
 
 	MemoryContextSwitchTo(oldContext);
 }
+
+/*
+ * Does a comparison whose outcome is cmp (<0, 0, >0) satisfy the built-in
+ * comparison operator?
+ */
+static pg_attribute_always_inline bool
+builtin_cmp(ExprBuiltinOp builtin, int cmp)
+{
+	switch (builtin)
+	{
+		case EEO_BUILTIN_EQ:
+			return cmp == 0;
+		case EEO_BUILTIN_NE:
+			return cmp != 0;
+		case EEO_BUILTIN_LT:
+			return cmp < 0;
+		case EEO_BUILTIN_LE:
+			return cmp <= 0;
+		case EEO_BUILTIN_GT:
+			return cmp > 0;
+		case EEO_BUILTIN_GE:
+			return cmp >= 0;
+		default:
+			pg_unreachable();
+	}
+}
+
+/* float8 comparison, with the NaN semantics of float8eq() and friends */
+static pg_attribute_always_inline bool
+builtin_float8_cmp(ExprBuiltinOp builtin, float8 l, float8 r)
+{
+	switch (builtin)
+	{
+		case EEO_BUILTIN_EQ:
+			return float8_eq(l, r);
+		case EEO_BUILTIN_NE:
+			return float8_ne(l, r);
+		case EEO_BUILTIN_LT:
+			return float8_lt(l, r);
+		case EEO_BUILTIN_LE:
+			return float8_le(l, r);
+		case EEO_BUILTIN_GT:
+			return float8_gt(l, r);
+		case EEO_BUILTIN_GE:
+			return float8_ge(l, r);
+		default:
+			pg_unreachable();
+	}
+}
+
+/* int4 arithmetic, returning true on overflow */
+static pg_attribute_always_inline bool
+builtin_int4_arith(ExprBuiltinOp builtin, int32 l, int32 r, int32 *result)
+{
+	switch (builtin)
+	{
+		case EEO_BUILTIN_PL:
+			return pg_add_s32_overflow(l, r, result);
+		case EEO_BUILTIN_MI:
+			return pg_sub_s32_overflow(l, r, result);
+		case EEO_BUILTIN_MUL:
+			return pg_mul_s32_overflow(l, r, result);
+		default:
+			pg_unreachable();
+	}
+}
+
+/* int8 arithmetic, returning true on overflow */
+static pg_attribute_always_inline bool
+builtin_int8_arith(ExprBuiltinOp builtin, int64 l, int64 r, int64 *result)
+{
+	switch (builtin)
+	{
+		case EEO_BUILTIN_PL:
+			return pg_add_s64_overflow(l, r, result);
+		case EEO_BUILTIN_MI:
+			return pg_sub_s64_overflow(l, r, result);
+		case EEO_BUILTIN_MUL:
+			return pg_mul_s64_overflow(l, r, result);
+		default:
+			pg_unreachable();
+	}
+}
+
+/* float8 arithmetic, erroring out on overflow as float8pl() and friends */
+static pg_attribute_always_inline float8
+builtin_float8_arith(ExprBuiltinOp builtin, float8 l, float8 r)
+{
+	switch (builtin)
+	{
+		case EEO_BUILTIN_PL:
+			return float8_pl(l, r);
+		case EEO_BUILTIN_MI:
+			return float8_mi(l, r);
+		case EEO_BUILTIN_MUL:
+			return float8_mul(l, r);
+		case EEO_BUILTIN_DIV:
+			return float8_div(l, r);
+		default:
+			pg_unreachable();
+	}
+}
@@ -991,6 +991,141 @@ slot_deform_heap_tuple(TupleTableSlot *slot, HeapTuple tuple, uint32 *offp,
 		slot->tts_flags &= ~TTS_FLAG_SLOW;
 }
 
+/* is attnum's bit set in the bitmap of needed attributes? */
+#define slot_att_needed(attnum, needed) \
+	(((needed)[(attnum) >> 3] & (1 << ((attnum) & 0x07))) != 0)
+
+/*
+ * slot_deform_heap_tuple_sparse
+ *		Like slot_deform_heap_tuple, but only extract the attributes whose
+ *		bit is set in needed into the slot's Datum/isnull arrays.
+ *
+ *		The offsets of the needed attributes still have to be found by
+ *		walking the tuple, but as long as the offset of the next needed
+ *		attribute is cached, and no attribute before it is NULL, the
+ *		attributes in between are skipped without being looked at.  Since
+ *		the skipped attributes are not extracted, slot->tts_nvalid and the
+ *		saved offset are left alone: they keep describing the prefix of
+ *		attributes that has been extracted by slot_deform_heap_tuple.
+ */
+static pg_attribute_always_inline void
+slot_deform_heap_tuple_sparse(TupleTableSlot *slot, HeapTuple tuple,
+							  uint32 *offp, int natts, const bits8 *needed)
+{
+	TupleDesc	tupleDesc = slot->tts_tupleDescriptor;
+	Datum	   *values = slot->tts_values;
+	bool	   *isnull = slot->tts_isnull;
+	HeapTupleHeader tup = tuple->t_data;
+	bool		hasnulls = HeapTupleHasNulls(tuple);
+	int			attnum;
+	int			nextcheck = 0;	/* don't look for a skip before this */
+	char	   *tp;				/* ptr to tuple data */
+	uint32		off;			/* offset in tuple data */
+	bits8	   *bp = tup->t_bits;	/* ptr to null bitmap in tuple */
+	bool		slow;			/* can we use/set attcacheoff? */
+
+	/* We can only fetch as many attributes as the tuple has. */
+	natts = Min(HeapTupleHeaderGetNatts(tuple->t_data), natts);
+
+	/* Start where slot_deform_heap_tuple left off */
+	attnum = slot->tts_nvalid;
+	if (attnum == 0)
+	{
+		off = 0;
+		slow = false;
+	}
+	else
+	{
+		off = *offp;
+		slow = TTS_SLOW(slot);
+	}
+
+	tp = (char *) tup + tup->t_hoff;
+
+	for (; attnum < natts; attnum++)
+	{
+		Form_pg_attribute thisatt = TupleDescAttr(tupleDesc, attnum);
+		bool		wanted = slot_att_needed(attnum, needed);
+
+		if (!wanted && attnum >= nextcheck)
+		{
+			int			next;
+			bool		gapnulls = false;
+
+			/* find the next needed attribute */
+			for (next = attnum; next < natts; next++)
+			{
+				if (slot_att_needed(next, needed))
+					break;
+				if (hasnulls && att_isnull(next, bp))
+					gapnulls = true;
+			}
+
+			/* nothing left to extract */
+			if (next >= natts)
+				break;
+
+			/*
+			 * If its offset is cached and still usable, jump right to it.
+			 * Otherwise walk the gap, without checking again on the way.
+			 */
+			if (!slow && !gapnulls &&
+				TupleDescAttr(tupleDesc, next)->attcacheoff >= 0)
+			{
+				attnum = next - 1;
+				continue;
+			}
+			nextcheck = next;
+		}
+
+		if (hasnulls && att_isnull(attnum, bp))
+		{
+			if (wanted)
+			{
+				values[attnum] = (Datum) 0;
+				isnull[attnum] = true;
+			}
+			slow = true;		/* can't use attcacheoff anymore */
+			continue;
+		}
+
+		if (!slow && thisatt->attcacheoff >= 0)
+			off = thisatt->attcacheoff;
+		else if (thisatt->attlen == -1)
+		{
+			/* see slot_deform_heap_tuple */
+			if (!slow &&
+				off == att_align_nominal(off, thisatt->attalign))
+				thisatt->attcacheoff = off;
+			else
+			{
+				off = att_align_pointer(off, thisatt->attalign, -1,
+										tp + off);
+				slow = true;
+			}
+		}
+		else
+		{
+			/* not varlena, so safe to use att_align_nominal */
+			off = att_align_nominal(off, thisatt->attalign);
+
+			if (!slow)
+				thisatt->attcacheoff = off;
+		}
+
+		if (wanted)
+		{
+			isnull[attnum] = false;
+			values[attnum] = fetchatt(thisatt, tp + off);
+		}
+
+		off = att_addlength_pointer(off, thisatt->attlen, tp + off);
+
+		if (thisatt->attlen <= 0)
+			slow = true;		/* can't use attcacheoff anymore */
+	}
+}
+
 
 const TupleTableSlotOps TTSOpsVirtual = {
 	.base_slot_size = sizeof(VirtualTupleTableSlot),
@@ -1892,6 +2027,61 @@ slot_getsomeattrs_int(TupleTableSlot *slot, int attnum)
 	}
 }
 
+/*
+ * slot_getsparseattrs_int - workhorse for slot_getsparseattrs()
+ */
+void
+slot_getsparseattrs_int(TupleTableSlot *slot, int attnum, const bits8 *needed)
+{
+	HeapTuple	tuple;
+	uint32	   *offp;
+	int			natts;
+
+	/* Check for caller errors */
+	Assert(slot->tts_nvalid < attnum);	/* checked in slot_getsparseattrs */
+	Assert(attnum > 0);
+
+	if (unlikely(attnum > slot->tts_tupleDescriptor->natts))
+		elog(ERROR, "invalid attribute number %d", attnum);
+
+	/*
+	 * Only the slot types storing a heap or minimal tuple can skip
+	 * attributes, others extract them all the usual way.
+	 */
+	if (slot->tts_ops == &TTSOpsHeapTuple ||
+		slot->tts_ops == &TTSOpsBufferHeapTuple)
+	{
+		HeapTupleTableSlot *hslot = (HeapTupleTableSlot *) slot;
+
+		tuple = hslot->tuple;
+		offp = &hslot->off;
+	}
+	else if (slot->tts_ops == &TTSOpsMinimalTuple)
+	{
+		MinimalTupleTableSlot *mslot = (MinimalTupleTableSlot *) slot;
+
+		tuple = mslot->tuple;
+		offp = &mslot->off;
+	}
+	else
+	{
+		slot_getsomeattrs_int(slot, attnum);
+		return;
+	}
+
+	Assert(!TTS_EMPTY(slot));
+
+	slot_deform_heap_tuple_sparse(slot, tuple, offp, attnum, needed);
+
+	/*
+	 * If the underlying tuple doesn't have enough attributes, tuple
+	 * descriptor must have the missing attributes.
+	 */
+	natts = HeapTupleHeaderGetNatts(tuple->t_data);
+	if (unlikely(natts < attnum))
+		slot_getmissingattrs(slot, Max(natts, slot->tts_nvalid), attnum);
+}
+
 /* ----------------------------------------------------------------
  *		ExecTypeFromTL
  *
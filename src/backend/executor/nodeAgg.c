@@ -38,6 +38,15 @@
  *	  is not supported in these cases, since we couldn't ensure global
  *	  ordering or distinctness of the inputs.
  *
+ *	  In hashed aggregation, a DISTINCT aggregate (without ORDER BY) instead
+ *	  remembers the input values seen by each group in a hashtable keyed by
+ *	  the grouping columns and the input values, and applies transfunc only
+ *	  to values not seen before.  The entries of that hashtable are accounted
+ *	  and discarded together with the groups, so spilling works as usual.
+ *	  Since the values arrive in no particular order, the planner allows
+ *	  this only for aggregates having a combinefunc, which must not care
+ *	  about the input order anyway.  ORDER BY aggregates are never hashed.
+ *
  *	  If transfunc is marked "strict" in pg_proc and initcond is NULL,
  *	  then the first non-NULL input_value is assigned directly to transvalue,
  *	  and transfunc isn't applied until the second non-NULL input_value.
@@ -217,6 +226,22 @@
  *	  imposing a limit on the number of groups separately from the amount of
  *	  memory consumed.
  *
+ *	  Parallel Hash Aggregation
+ *
+ *	  A parallel-aware AGG_HASHED node aggregates its whole input without a
+ *	  separate Finalize step.  Every participant first hashes the tuples it
+ *	  reads from its partial outer plan and writes them to one of a number of
+ *	  shared partitions (SharedTuplestores in a SharedFileSet), chosen by the
+ *	  high bits of the hash value.  When all participants have finished
+ *	  partitioning, they claim partitions one at a time and aggregate each one
+ *	  in a private hash table, exactly as if it were a batch of spilled
+ *	  tuples: every group lives in exactly one partition, so the groups
+ *	  emitted by different participants never overlap.  A partition that
+ *	  doesn't fit in work_mem is spilled to the participant's own tapes in the
+ *	  usual way.  This needs neither combine nor serialization functions, and
+ *	  the final aggregation is spread over all participants instead of being
+ *	  done by the leader alone.
+ *
  *    Transition / Combine function invocation:
  *
  *    For performance reasons transition functions, including combine
@@ -244,15 +269,20 @@
 #include "catalog/pg_aggregate.h"
 #include "catalog/pg_proc.h"
 #include "catalog/pg_type.h"
+#include "executor/execBatch.h"
 #include "executor/execExpr.h"
 #include "executor/executor.h"
 #include "executor/nodeAgg.h"
+#include "jit/jit.h"
 #include "miscadmin.h"
 #include "nodes/makefuncs.h"
 #include "nodes/nodeFuncs.h"
 #include "optimizer/optimizer.h"
 #include "parser/parse_agg.h"
 #include "parser/parse_coerce.h"
+#include "pgstat.h"
+#include "storage/barrier.h"
+#include "storage/sharedfileset.h"
 #include "utils/acl.h"
 #include "utils/builtins.h"
 #include "utils/datum.h"
@@ -261,6 +291,7 @@
 #include "utils/logtape.h"
 #include "utils/lsyscache.h"
 #include "utils/memutils.h"
+#include "utils/sharedtuplestore.h"
 #include "utils/syscache.h"
 #include "utils/tuplesort.h"
 
@@ -353,11 +384,48 @@ typedef struct HashAggBatch
 	LogicalTapeSet	*tapeset;		/* borrowed reference to tape set */
 	int				 input_tapenum;	/* input partition tape */
 	int64			 input_tuples;	/* number of tuples in this batch */
+	SharedTuplestoreAccessor *shared_input;	/* shared partition to read
+											 * instead of a tape, if any */
 } HashAggBatch;
 
+/*
+ * Shared state for a parallel-aware hash aggregation, stored in the DSM
+ * segment under the node's plan_node_id.  It is followed by npartitions
+ * SharedTuplestores, each taking sts_size bytes, starting sts_offset bytes
+ * from the beginning of the struct.
+ *
+ * Participants attach to the barrier while it is in PHA_PHASE_PARTITIONING
+ * to write their share of the input into the partitions; a participant that
+ * arrives later has nothing to contribute, because all of the partial input
+ * has been consumed by then.  In PHA_PHASE_AGGREGATING, participants claim
+ * partitions using next_partition.
+ */
+typedef struct ParallelHashAggState
+{
+	SharedFileSet fileset;		/* space for the partition files */
+	Barrier		barrier;		/* synchronizes the end of partitioning */
+	int			nparticipants;	/* leader plus planned workers */
+	int			npartitions;	/* number of shared partitions */
+	int			log2_npartitions;	/* hash bits used to choose partition */
+	Size		sts_offset;		/* offset of the first SharedTuplestore */
+	Size		sts_size;		/* space for each SharedTuplestore */
+	pg_atomic_uint32 next_partition;	/* next partition to aggregate */
+	pg_atomic_uint64 ntuples[FLEXIBLE_ARRAY_MEMBER];	/* tuples written to
+														 * each partition */
+} ParallelHashAggState;
+
+#define PHA_PHASE_PARTITIONING		0
+#define PHA_PHASE_AGGREGATING		1
+
+#define PHA_PARTITION(pstate, partno) \
+	((SharedTuplestore *) ((char *) (pstate) + (pstate)->sts_offset + \
+						   (partno) * (pstate)->sts_size))
+
 static void select_current_set(AggState *aggstate, int setno, bool is_hash);
 static void initialize_phase(AggState *aggstate, int newphase);
 static TupleTableSlot *fetch_input_tuple(AggState *aggstate);
+static TupleTableSlot *fetch_input_batch_tuple(AggState *aggstate);
+static void agg_pipeline_consume_input(AggState *aggstate);
 static void initialize_aggregates(AggState *aggstate,
 								  AggStatePerGroup *pergroups,
 								  int numReset);
@@ -391,6 +459,9 @@ static Bitmapset *find_unaggregated_cols(AggState *aggstate);
 static bool find_unaggregated_cols_walker(Node *node, Bitmapset **colnos);
 static void build_hash_tables(AggState *aggstate);
 static void build_hash_table(AggState *aggstate, int setno, long nbuckets);
+static void build_distinct_hash_table(AggState *aggstate,
+									  AggStatePerTrans pertrans);
+static void reset_distinct_hash_tables(AggState *aggstate);
 static void hashagg_recompile_expressions(AggState *aggstate, bool minslot,
 										  bool nullcheck);
 static long hash_choose_num_buckets(double hashentrysize,
@@ -413,6 +484,14 @@ static void hash_agg_enter_spill_mode(AggState *aggstate);
 static void hash_agg_update_metrics(AggState *aggstate, bool from_tape,
 									int npartitions);
 static void hashagg_finish_initial_spills(AggState *aggstate);
+static void agg_fill_hash_table_parallel(AggState *aggstate);
+static HashAggBatch *agg_claim_shared_partition(AggState *aggstate);
+static void agg_detach_shared_hash(AggState *aggstate);
+static Size agg_shared_hash_size(AggState *aggstate, int nparticipants,
+								 int *npartitions, int *log2_npartitions);
+static void agg_shared_hash_initialize(AggState *aggstate,
+									   ParallelHashAggState *pstate,
+									   int nparticipants);
 static void hashagg_reset_spill_state(AggState *aggstate);
 static HashAggBatch *hashagg_batch_new(LogicalTapeSet *tapeset,
 									   int input_tapenum, int setno,
@@ -556,6 +635,8 @@ fetch_input_tuple(AggState *aggstate)
 			return NULL;
 		slot = aggstate->sort_slot;
 	}
+	else if (outerPlanState(aggstate)->ExecProcNodeBatch != NULL)
+		slot = fetch_input_batch_tuple(aggstate);
 	else
 		slot = ExecProcNode(outerPlanState(aggstate));
 
@@ -565,6 +646,82 @@ fetch_input_tuple(AggState *aggstate)
 	return slot;
 }
 
+/*
+ * Fetch the next tuple from an outer plan that supports the batch protocol,
+ * getting a new batch whenever the current one is used up.  This saves the
+ * per-tuple trip through the outer plan's ExecProcNode and qual evaluation.
+ */
+static TupleTableSlot *
+fetch_input_batch_tuple(AggState *aggstate)
+{
+	TupleBatch *batch = aggstate->input_batch;
+
+	if (batch == NULL || aggstate->input_batch_pos >= batch->nselected)
+	{
+		batch = ExecProcNodeBatch(outerPlanState(aggstate));
+		aggstate->input_batch = batch;
+		aggstate->input_batch_pos = 0;
+		if (batch == NULL)
+			return NULL;
+	}
+
+	return batch->slots[batch->sel[aggstate->input_batch_pos++]];
+}
+
+/*
+ * Advance the aggregates over all remaining input, using the JIT compiled
+ * input pipeline.  The outer plan must support the batch protocol, and the
+ * caller must have set up everything advance_aggregates() would need, apart
+ * from the outer tuple.
+ */
+static void
+agg_pipeline_consume_input(AggState *aggstate)
+{
+	TupleBatch *batch = aggstate->input_batch;
+
+	Assert(aggstate->input_pipeline != NULL);
+
+	for (;;)
+	{
+		if (batch == NULL || aggstate->input_batch_pos >= batch->nselected)
+		{
+			batch = ExecProcNodeBatch(outerPlanState(aggstate));
+			aggstate->input_batch = batch;
+			aggstate->input_batch_pos = 0;
+			if (batch == NULL)
+				break;
+		}
+
+		aggstate->input_pipeline(aggstate, batch->slots, batch->sel,
+								 aggstate->input_batch_pos,
+								 batch->nselected);
+		aggstate->input_batch_pos = batch->nselected;
+	}
+}
+
+/*
+ * Helpers for the JIT compiled input pipeline.
+ *
+ * ExecAggPipelineLookup() finds or creates the hash table entries for the
+ * tuple in tmpcontext->ecxt_outertuple, and returns the transition
+ * expression to evaluate for it.  That changes if the lookup made the hash
+ * table start spilling; the pipeline then calls ExecAggPipelineAdvance()
+ * instead of its compiled copy of the transition expression.
+ */
+ExprState *
+ExecAggPipelineLookup(AggState *aggstate)
+{
+	lookup_hash_entries(aggstate);
+
+	return aggstate->phase->evaltrans;
+}
+
+void
+ExecAggPipelineAdvance(AggState *aggstate)
+{
+	advance_aggregates(aggstate);
+}
+
 /*
  * (Re)Initialize an individual aggregate.
  *
@@ -1456,6 +1613,8 @@ build_hash_tables(AggState *aggstate)
 		build_hash_table(aggstate, setno, nbuckets);
 	}
 
+	reset_distinct_hash_tables(aggstate);
+
 	aggstate->hash_ngroups_current = 0;
 }
 
@@ -1498,6 +1657,110 @@ build_hash_table(AggState *aggstate, int setno, long nbuckets)
 		DO_AGGSPLIT_SKIPFINAL(aggstate->aggsplit));
 }
 
+/*
+ * Build the hashtable that eliminates duplicate inputs of a DISTINCT
+ * aggregate in hashed aggregation.
+ *
+ * The key of the table consists of the grouping columns followed by the
+ * aggregate's inputs, so a single table serves all groups.  Its entries live
+ * in the same memory context as the groups, so they count against the memory
+ * limit, and they are discarded together with the groups when the hashtable
+ * is reset, e.g. before processing a spilled batch.
+ */
+static void
+build_distinct_hash_table(AggState *aggstate, AggStatePerTrans pertrans)
+{
+	AggStatePerHash perhash = &aggstate->perhash[0];
+	Aggref	   *aggref = pertrans->aggref;
+	TupleDesc	hashdesc = perhash->hashslot->tts_tupleDescriptor;
+	TupleDesc	inputdesc = ExecTypeFromTL(aggref->args);
+	int			numGroupCols = perhash->numCols;
+	int			numInputs = pertrans->numInputs;
+	int			numKeyCols = numGroupCols + list_length(aggref->aggdistinct);
+	TupleDesc	desc;
+	AttrNumber *keyColIdx;
+	Oid		   *eqOperators;
+	Oid		   *collations;
+	Oid		   *eqfuncoids;
+	FmgrInfo   *hashfunctions;
+	ListCell   *lc;
+	int			i;
+
+	/* the planner only allows this with a single grouping set */
+	Assert(aggstate->aggstrategy == AGG_HASHED);
+	Assert(aggstate->num_hashes == 1);
+	Assert(numInputs == pertrans->numTransInputs);
+
+	desc = CreateTemplateTupleDesc(numGroupCols + numInputs);
+	for (i = 0; i < numGroupCols; i++)
+		TupleDescCopyEntry(desc, i + 1, hashdesc, i + 1);
+	for (i = 0; i < numInputs; i++)
+		TupleDescCopyEntry(desc, numGroupCols + i + 1, inputdesc, i + 1);
+
+	keyColIdx = (AttrNumber *) palloc(numKeyCols * sizeof(AttrNumber));
+	eqOperators = (Oid *) palloc(numKeyCols * sizeof(Oid));
+	collations = (Oid *) palloc(numKeyCols * sizeof(Oid));
+
+	for (i = 0; i < numGroupCols; i++)
+	{
+		keyColIdx[i] = perhash->hashGrpColIdxHash[i];
+		eqOperators[i] = perhash->aggnode->grpOperators[i];
+		collations[i] = perhash->aggnode->grpCollations[i];
+	}
+	foreach(lc, aggref->aggdistinct)
+	{
+		SortGroupClause *sortcl = (SortGroupClause *) lfirst(lc);
+		TargetEntry *tle = get_sortgroupclause_tle(sortcl, aggref->args);
+
+		/* the planner should have made sure of this */
+		Assert(OidIsValid(sortcl->eqop) && sortcl->hashable);
+
+		keyColIdx[i] = numGroupCols + tle->resno;
+		eqOperators[i] = sortcl->eqop;
+		collations[i] = exprCollation((Node *) tle->expr);
+		i++;
+	}
+	Assert(i == numKeyCols);
+
+	execTuplesHashPrepare(numKeyCols, eqOperators,
+						  &eqfuncoids, &hashfunctions);
+
+	pertrans->distinctslot =
+		ExecInitExtraTupleSlot(aggstate->ss.ps.state, desc, &TTSOpsVirtual);
+	pertrans->distincttable = BuildTupleHashTableExt(
+		&aggstate->ss.ps,
+		desc,
+		numKeyCols,
+		keyColIdx,
+		eqfuncoids,
+		hashfunctions,
+		collations,
+		HASHAGG_MIN_BUCKETS,
+		0,
+		aggstate->hash_metacxt,
+		aggstate->hashcontext->ecxt_per_tuple_memory,
+		aggstate->tmpcontext->ecxt_per_tuple_memory,
+		false);
+}
+
+/*
+ * Forget the inputs seen so far by DISTINCT aggregates.  Must be done
+ * whenever the groups themselves are forgotten.
+ */
+static void
+reset_distinct_hash_tables(AggState *aggstate)
+{
+	int			transno;
+
+	for (transno = 0; transno < aggstate->numtrans; transno++)
+	{
+		AggStatePerTrans pertrans = &aggstate->pertrans[transno];
+
+		if (pertrans->distincttable != NULL)
+			ResetTupleHashTable(pertrans->distincttable);
+	}
+}
+
 /*
  * Compute columns that actually need to be stored in hashtable entries.  The
  * incoming tuples from the child plan node will contain grouping columns,
@@ -2111,7 +2374,12 @@ ExecAgg(PlanState *pstate)
 		{
 			case AGG_HASHED:
 				if (!node->table_filled)
-					agg_fill_hash_table(node);
+				{
+					if (node->shared_hash != NULL)
+						agg_fill_hash_table_parallel(node);
+					else
+						agg_fill_hash_table(node);
+				}
 				/* FALLTHROUGH */
 			case AGG_MIXED:
 				result = agg_retrieve_hash_table(node);
@@ -2398,7 +2666,18 @@ agg_retrieve_direct(AggState *aggstate)
 					/* Reset per-input-tuple context after each tuple */
 					ResetExprContext(tmpcontext);
 
-					outerslot = fetch_input_tuple(aggstate);
+					/*
+					 * Without grouping, all remaining input belongs to this
+					 * group, so the compiled input pipeline can take it from
+					 * here.
+					 */
+					if (aggstate->input_pipeline != NULL)
+					{
+						agg_pipeline_consume_input(aggstate);
+						outerslot = NULL;
+					}
+					else
+						outerslot = fetch_input_tuple(aggstate);
 					if (TupIsNull(outerslot))
 					{
 						/* no more outer-plan tuples available */
@@ -2488,26 +2767,31 @@ agg_fill_hash_table(AggState *aggstate)
 	 * Process each outer-plan tuple, and then fetch the next one, until we
 	 * exhaust the outer plan.
 	 */
-	for (;;)
+	if (aggstate->input_pipeline != NULL)
+		agg_pipeline_consume_input(aggstate);
+	else
 	{
-		outerslot = fetch_input_tuple(aggstate);
-		if (TupIsNull(outerslot))
-			break;
+		for (;;)
+		{
+			outerslot = fetch_input_tuple(aggstate);
+			if (TupIsNull(outerslot))
+				break;
 
-		/* set up for lookup_hash_entries and advance_aggregates */
-		tmpcontext->ecxt_outertuple = outerslot;
+			/* set up for lookup_hash_entries and advance_aggregates */
+			tmpcontext->ecxt_outertuple = outerslot;
 
-		/* Find or build hashtable entries */
-		lookup_hash_entries(aggstate);
+			/* Find or build hashtable entries */
+			lookup_hash_entries(aggstate);
 
-		/* Advance the aggregates (or combine functions) */
-		advance_aggregates(aggstate);
+			/* Advance the aggregates (or combine functions) */
+			advance_aggregates(aggstate);
 
-		/*
-		 * Reset per-input-tuple context after each tuple, but note that the
-		 * hash lookups do this too
-		 */
-		ResetExprContext(aggstate->tmpcontext);
+			/*
+			 * Reset per-input-tuple context after each tuple, but note that
+			 * the hash lookups do this too
+			 */
+			ResetExprContext(aggstate->tmpcontext);
+		}
 	}
 
 	/* finalize spills, if any */
@@ -2520,6 +2804,217 @@ agg_fill_hash_table(AggState *aggstate)
 						   &aggstate->perhash[0].hashiter);
 }
 
+/*
+ * ExecAgg for parallel-aware hashed case: partition input
+ *
+ * Write the tuples of this participant's share of the input to the shared
+ * partitions, and wait for the other participants to do the same.  Nothing
+ * is aggregated yet; the hash table is left empty, so that
+ * agg_refill_hash_table() will go on to claim the partitions one at a time.
+ */
+static void
+agg_fill_hash_table_parallel(AggState *aggstate)
+{
+	ParallelHashAggState *pstate = aggstate->shared_hash;
+	AggStatePerHash perhash = &aggstate->perhash[0];
+	ExprContext *tmpcontext = aggstate->tmpcontext;
+
+	Assert(aggstate->num_hashes == 1);
+	Assert(!aggstate->shared_attached);
+
+	aggstate->shared_attached = true;
+	if (BarrierAttach(&pstate->barrier) == PHA_PHASE_PARTITIONING)
+	{
+		int			shift = 32 - pstate->log2_npartitions;
+		uint64	   *ntuples;
+		int			i;
+
+		ntuples = palloc0(sizeof(uint64) * pstate->npartitions);
+
+		select_current_set(aggstate, 0, true);
+		for (;;)
+		{
+			TupleTableSlot *outerslot;
+			MinimalTuple tuple;
+			bool		shouldFree;
+			uint32		hash;
+			int			partno;
+
+			outerslot = fetch_input_tuple(aggstate);
+			if (TupIsNull(outerslot))
+				break;
+
+			tmpcontext->ecxt_outertuple = outerslot;
+			prepare_hash_slot(aggstate);
+			hash = TupleHashTableHash(perhash->hashtable, perhash->hashslot);
+
+			/* the high bits choose the partition, as for a spill */
+			partno = pstate->log2_npartitions > 0 ? hash >> shift : 0;
+
+			tuple = ExecFetchSlotMinimalTuple(outerslot, &shouldFree);
+			sts_puttuple(aggstate->shared_partitions[partno], &hash, tuple);
+			if (shouldFree)
+				pfree(tuple);
+			ntuples[partno]++;
+
+			ResetExprContext(tmpcontext);
+		}
+
+		for (i = 0; i < pstate->npartitions; i++)
+		{
+			sts_end_write(aggstate->shared_partitions[i]);
+			if (ntuples[i] > 0)
+				pg_atomic_fetch_add_u64(&pstate->ntuples[i], ntuples[i]);
+		}
+		pfree(ntuples);
+
+		/*
+		 * No participant emits any groups before this point, so waiting here
+		 * can't deadlock against a Gather node that isn't reading from us.
+		 */
+		BarrierArriveAndWait(&pstate->barrier,
+							 WAIT_EVENT_HASHAGG_PARTITIONING);
+	}
+	Assert(BarrierPhase(&pstate->barrier) == PHA_PHASE_AGGREGATING);
+
+	/*
+	 * The input has been written to disk, so the hash table can't be reused
+	 * on rescan.  Tapes are only set up if a partition itself has to spill.
+	 */
+	aggstate->hash_ever_spilled = true;
+
+	aggstate->table_filled = true;
+	/* the hash table is empty, so this just ends the first pass */
+	select_current_set(aggstate, 0, true);
+	ResetTupleHashIterator(perhash->hashtable, &perhash->hashiter);
+}
+
+/*
+ * Claim the next non-empty shared partition, returning a batch to read it, or
+ * NULL if all partitions have been claimed.
+ */
+static HashAggBatch *
+agg_claim_shared_partition(AggState *aggstate)
+{
+	ParallelHashAggState *pstate = aggstate->shared_hash;
+
+	for (;;)
+	{
+		uint32		partno;
+		uint64		ntuples;
+		HashAggBatch *batch;
+
+		partno = pg_atomic_fetch_add_u32(&pstate->next_partition, 1);
+		if (partno >= pstate->npartitions)
+		{
+			agg_detach_shared_hash(aggstate);
+			return NULL;
+		}
+
+		ntuples = pg_atomic_read_u64(&pstate->ntuples[partno]);
+		if (ntuples == 0)
+			continue;
+
+		batch = hashagg_batch_new(NULL, -1, 0, ntuples,
+								  pstate->log2_npartitions);
+		batch->shared_input = aggstate->shared_partitions[partno];
+		aggstate->hash_batches_used++;
+
+		return batch;
+	}
+}
+
+/*
+ * Stop participating in the parallel hash aggregation.  Nobody waits on the
+ * barrier after partitioning has finished, so this is only tidiness.
+ */
+static void
+agg_detach_shared_hash(AggState *aggstate)
+{
+	if (aggstate->shared_attached)
+	{
+		BarrierDetach(&aggstate->shared_hash->barrier);
+		aggstate->shared_attached = false;
+	}
+}
+
+/*
+ * Compute the size of the shared state for a parallel hash aggregation, and
+ * the number of partitions to divide the input into.
+ *
+ * We want enough partitions for each of them to be aggregated in work_mem,
+ * as when choosing spill partitions, but also a few per participant, so that
+ * the work can be spread evenly even if some groups are much larger than
+ * others.
+ */
+static Size
+agg_shared_hash_size(AggState *aggstate, int nparticipants,
+					 int *npartitions, int *log2_npartitions)
+{
+	Agg		   *aggnode = (Agg *) aggstate->ss.ps.plan;
+	int			partition_bits;
+	int			nparts;
+	Size		size;
+
+	nparts = hash_choose_num_partitions(aggnode->numGroups,
+										aggstate->hashentrysize, 0,
+										&partition_bits);
+	while (nparts < HASHAGG_MIN_PARTITIONS * nparticipants &&
+		   nparts < HASHAGG_MAX_PARTITIONS)
+	{
+		nparts <<= 1;
+		partition_bits++;
+	}
+
+	if (npartitions != NULL)
+		*npartitions = nparts;
+	if (log2_npartitions != NULL)
+		*log2_npartitions = partition_bits;
+
+	size = MAXALIGN(offsetof(ParallelHashAggState, ntuples) +
+					sizeof(pg_atomic_uint64) * nparts);
+	size = add_size(size, mul_size(nparts,
+								   MAXALIGN(sts_estimate(nparticipants))));
+
+	return size;
+}
+
+/*
+ * Set up the shared state for a parallel hash aggregation, whose
+ * npartitions and log2_npartitions have already been set, and create the
+ * leader's accessors for the partitions.  The shared file set must already
+ * be initialized.
+ */
+static void
+agg_shared_hash_initialize(AggState *aggstate, ParallelHashAggState *pstate,
+						   int nparticipants)
+{
+	int			plan_node_id = aggstate->ss.ps.plan->plan_node_id;
+	int			i;
+
+	pstate->nparticipants = nparticipants;
+	pstate->sts_offset = MAXALIGN(offsetof(ParallelHashAggState, ntuples) +
+								  sizeof(pg_atomic_uint64) *
+								  pstate->npartitions);
+	pstate->sts_size = MAXALIGN(sts_estimate(nparticipants));
+	pg_atomic_init_u32(&pstate->next_partition, 0);
+	BarrierInit(&pstate->barrier, 0);
+
+	aggstate->shared_partitions =
+		palloc(sizeof(SharedTuplestoreAccessor *) * pstate->npartitions);
+	for (i = 0; i < pstate->npartitions; i++)
+	{
+		char		name[MAXPGPATH];
+
+		pg_atomic_init_u64(&pstate->ntuples[i], 0);
+		snprintf(name, sizeof(name), "hashagg.%d.%d", plan_node_id, i);
+		aggstate->shared_partitions[i] =
+			sts_initialize(PHA_PARTITION(pstate, i), nparticipants,
+						   0, sizeof(uint32), SHARED_TUPLESTORE_SINGLE_PASS,
+						   &pstate->fileset, name);
+	}
+}
+
 /*
  * If any data was spilled during hash aggregation, reset the hash table and
  * reprocess one batch of spilled data. After reprocessing a batch, the hash
@@ -2541,12 +3036,21 @@ agg_refill_hash_table(AggState *aggstate)
 	uint64			 ngroups_estimate;
 	bool			 spill_initialized = false;
 
-	if (aggstate->hash_batches == NIL)
+	if (aggstate->hash_batches != NIL)
+	{
+		batch = linitial(aggstate->hash_batches);
+		aggstate->hash_batches = list_delete_first(aggstate->hash_batches);
+	}
+	else if (aggstate->shared_hash != NULL)
+	{
+		/* our own spilled batches are done; take a shared partition */
+		batch = agg_claim_shared_partition(aggstate);
+		if (batch == NULL)
+			return false;
+	}
+	else
 		return false;
 
-	batch = linitial(aggstate->hash_batches);
-	aggstate->hash_batches = list_delete_first(aggstate->hash_batches);
-
 	/*
 	 * Estimate the number of groups for this batch as the total number of
 	 * tuples in its input file. Although that's a worst case, it's not bad
@@ -2570,6 +3074,7 @@ agg_refill_hash_table(AggState *aggstate)
 	ReScanExprContext(aggstate->hashcontext);
 	for (int setno = 0; setno < aggstate->num_hashes; setno++)
 		ResetTupleHashTable(aggstate->perhash[setno].hashtable);
+	reset_distinct_hash_tables(aggstate);
 
 	aggstate->hash_ngroups_current = 0;
 
@@ -2596,8 +3101,11 @@ agg_refill_hash_table(AggState *aggstate)
 	 */
 	hashagg_recompile_expressions(aggstate, true, true);
 
-	LogicalTapeRewindForRead(tapeinfo->tapeset, batch->input_tapenum,
-							 HASHAGG_READ_BUFFER_SIZE);
+	if (batch->shared_input != NULL)
+		sts_begin_parallel_scan(batch->shared_input);
+	else
+		LogicalTapeRewindForRead(tapeinfo->tapeset, batch->input_tapenum,
+								 HASHAGG_READ_BUFFER_SIZE);
 	for (;;) {
 		TupleTableSlot	*slot = aggstate->hash_spill_slot;
 		MinimalTuple	 tuple;
@@ -2610,7 +3118,8 @@ agg_refill_hash_table(AggState *aggstate)
 		if (tuple == NULL)
 			break;
 
-		ExecStoreMinimalTuple(tuple, slot, true);
+		/* tuples read from a shared partition belong to the accessor */
+		ExecStoreMinimalTuple(tuple, slot, batch->shared_input == NULL);
 		aggstate->tmpcontext->ecxt_outertuple = slot;
 
 		prepare_hash_slot(aggstate);
@@ -2631,6 +3140,12 @@ agg_refill_hash_table(AggState *aggstate)
 				 * that we don't assign tapes that will never be used.
 				 */
 				spill_initialized = true;
+				if (tapeinfo == NULL)
+				{
+					/* first spill of a shared partition */
+					hashagg_tapeinfo_init(aggstate);
+					tapeinfo = aggstate->hash_tapeinfo;
+				}
 				hashagg_spill_init(&spill, tapeinfo, batch->used_bits,
 					   ngroups_estimate, aggstate->hashentrysize);
 			}
@@ -2645,7 +3160,10 @@ agg_refill_hash_table(AggState *aggstate)
 		ResetExprContext(aggstate->tmpcontext);
 	}
 
-	hashagg_tapeinfo_release(tapeinfo, batch->input_tapenum);
+	if (batch->shared_input != NULL)
+		sts_end_parallel_scan(batch->shared_input);
+	else
+		hashagg_tapeinfo_release(tapeinfo, batch->input_tapenum);
 
 	/* change back to phase 0 */
 	aggstate->current_phase = 0;
@@ -2980,6 +3498,10 @@ hashagg_batch_read(HashAggBatch *batch, uint32 *hashp)
 	size_t			nread;
 	uint32			hash;
 
+	/* the hash value is stored as the shared tuplestore's meta-data */
+	if (batch->shared_input != NULL)
+		return sts_parallel_scan_next(batch->shared_input, hashp);
+
 	nread = LogicalTapeRead(tapeset, tapenum, &hash, sizeof(uint32));
 	if (nread == 0)
 		return NULL;
@@ -3980,6 +4502,29 @@ ExecInitAgg(Agg *node, EState *estate, int eflags)
 		phase->evaltrans_cache[0][0] = phase->evaltrans;
 	}
 
+	/*
+	 * If the input comes in batches and there's a single transition
+	 * expression to evaluate for each input tuple, let the JIT provider
+	 * compile the whole input loop, so that the transition expression (and
+	 * the tuple deforming in it) can be inlined into it.  Grouping sets,
+	 * sorted input and parallel hash aggregation are left alone.
+	 */
+	if (outerPlanState(aggstate)->ExecProcNodeBatch != NULL &&
+		aggstate->maxsets <= 1 && !node->plan.parallel_aware)
+	{
+		ExprState  *evaltrans = NULL;
+
+		if (node->aggstrategy == AGG_PLAIN && aggstate->numphases == 2 &&
+			aggstate->phases[1].numsets == 0)
+			evaltrans = aggstate->phases[1].evaltrans;
+		else if (node->aggstrategy == AGG_HASHED &&
+				 aggstate->num_hashes == 1)
+			evaltrans = aggstate->phases[0].evaltrans;
+
+		if (evaltrans != NULL)
+			jit_compile_agg_pipeline(aggstate, evaltrans);
+	}
+
 	return aggstate;
 }
 
@@ -4187,6 +4732,13 @@ build_pertrans_for_aggref(AggStatePerTrans pertrans,
 		sortlist = NIL;
 		numSortCols = numDistinctCols = 0;
 	}
+	else if (aggref->aggdistinct && aggstate->aggstrategy == AGG_HASHED)
+	{
+		/* duplicates are eliminated by hashing, see below */
+		Assert(aggref->aggorder == NIL);
+		sortlist = NIL;
+		numSortCols = numDistinctCols = 0;
+	}
 	else if (aggref->aggdistinct)
 	{
 		sortlist = aggref->aggdistinct;
@@ -4219,8 +4771,8 @@ build_pertrans_for_aggref(AggStatePerTrans pertrans,
 	if (numSortCols > 0)
 	{
 		/*
-		 * We don't implement DISTINCT or ORDER BY aggs in the HASHED case
-		 * (yet)
+		 * We don't implement ORDER BY aggs in the HASHED case (yet), and
+		 * DISTINCT is done by hashing there
 		 */
 		Assert(aggstate->aggstrategy != AGG_HASHED && aggstate->aggstrategy != AGG_MIXED);
 
@@ -4267,7 +4819,7 @@ build_pertrans_for_aggref(AggStatePerTrans pertrans,
 		Assert(i == numSortCols);
 	}
 
-	if (aggref->aggdistinct)
+	if (numDistinctCols > 0)
 	{
 		Oid		   *ops;
 
@@ -4293,6 +4845,8 @@ build_pertrans_for_aggref(AggStatePerTrans pertrans,
 									   &aggstate->ss.ps);
 		pfree(ops);
 	}
+	else if (aggref->aggdistinct)
+		build_distinct_hash_table(aggstate, pertrans);
 
 	pertrans->sortstates = (Tuplesortstate **)
 		palloc0(sizeof(Tuplesortstate *) * numGroupingSets);
@@ -4598,6 +5152,8 @@ ExecReScanAgg(AggState *node)
 	if (node->aggstrategy == AGG_HASHED || node->aggstrategy == AGG_MIXED)
 	{
 		hashagg_reset_spill_state(node);
+		if (node->shared_hash != NULL)
+			agg_detach_shared_hash(node);
 
 		node->hash_ever_spilled = false;
 		node->hash_spill_mode = false;
@@ -4630,10 +5186,120 @@ ExecReScanAgg(AggState *node)
 		node->projected_set = -1;
 	}
 
+	/* forget about any partially consumed batch */
+	node->input_batch = NULL;
+
 	if (outerPlan->chgParam == NULL)
 		ExecReScan(outerPlan);
 }
 
+/* ----------------------------------------------------------------
+ *						Parallel Query Support
+ * ----------------------------------------------------------------
+ */
+
+/* ----------------------------------------------------------------
+ *		ExecAggEstimate
+ *
+ *		Estimate space required for the shared state of a
+ *		parallel-aware hash aggregation.
+ * ----------------------------------------------------------------
+ */
+void
+ExecAggEstimate(AggState *node, ParallelContext *pcxt)
+{
+	Size		size;
+
+	size = agg_shared_hash_size(node, pcxt->nworkers + 1, NULL, NULL);
+	shm_toc_estimate_chunk(&pcxt->estimator, size);
+	shm_toc_estimate_keys(&pcxt->estimator, 1);
+}
+
+/* ----------------------------------------------------------------
+ *		ExecAggInitializeDSM
+ *
+ *		Set up the shared partitions of a parallel-aware hash
+ *		aggregation.
+ * ----------------------------------------------------------------
+ */
+void
+ExecAggInitializeDSM(AggState *node, ParallelContext *pcxt)
+{
+	int			plan_node_id = node->ss.ps.plan->plan_node_id;
+	int			nparticipants = pcxt->nworkers + 1;
+	ParallelHashAggState *pstate;
+	int			npartitions;
+	int			log2_npartitions;
+	Size		size;
+
+	/*
+	 * Without a real DSM segment there are no workers and no shared file
+	 * set, so just aggregate the whole input in the leader.
+	 */
+	if (pcxt->seg == NULL)
+		return;
+
+	Assert(node->aggstrategy == AGG_HASHED);
+
+	size = agg_shared_hash_size(node, nparticipants,
+								&npartitions, &log2_npartitions);
+	pstate = shm_toc_allocate(pcxt->toc, size);
+	shm_toc_insert(pcxt->toc, plan_node_id, pstate);
+
+	pstate->npartitions = npartitions;
+	pstate->log2_npartitions = log2_npartitions;
+	SharedFileSetInit(&pstate->fileset, pcxt->seg);
+	agg_shared_hash_initialize(node, pstate, nparticipants);
+
+	node->shared_hash = pstate;
+}
+
+/* ----------------------------------------------------------------
+ *		ExecAggReInitializeDSM
+ *
+ *		Reset shared state before beginning a fresh scan.
+ * ----------------------------------------------------------------
+ */
+void
+ExecAggReInitializeDSM(AggState *node, ParallelContext *pcxt)
+{
+	ParallelHashAggState *pstate = node->shared_hash;
+
+	if (pstate == NULL)
+		return;
+
+	/* Clear the partition files, and start partitioning all over again. */
+	SharedFileSetDeleteAll(&pstate->fileset);
+	pfree(node->shared_partitions);
+	agg_shared_hash_initialize(node, pstate, pstate->nparticipants);
+}
+
+/* ----------------------------------------------------------------
+ *		ExecAggInitializeWorker
+ *
+ *		Attach a worker to the shared partitions.
+ * ----------------------------------------------------------------
+ */
+void
+ExecAggInitializeWorker(AggState *node, ParallelWorkerContext *pwcxt)
+{
+	int			plan_node_id = node->ss.ps.plan->plan_node_id;
+	ParallelHashAggState *pstate =
+	shm_toc_lookup(pwcxt->toc, plan_node_id, false);
+	int			i;
+
+	SharedFileSetAttach(&pstate->fileset, pwcxt->seg);
+
+	node->shared_partitions =
+		palloc(sizeof(SharedTuplestoreAccessor *) * pstate->npartitions);
+	for (i = 0; i < pstate->npartitions; i++)
+		node->shared_partitions[i] =
+			sts_attach(PHA_PARTITION(pstate, i), ParallelWorkerNumber + 1,
+					   &pstate->fileset);
+
+	node->shared_hash = pstate;
+}
+
 
 /***********************************************************************
  * API exposed to aggregate functions
@@ -186,6 +186,8 @@ ExecGather(PlanState *pstate)
 			LaunchParallelWorkers(pcxt);
 			/* We save # workers launched for the benefit of EXPLAIN */
 			node->nworkers_launched = pcxt->nworkers_launched;
+			/* Tell nodes that exchange rows among the workers, too */
+			ExecParallelWorkersLaunched(node->pei);
 
 			/* Set up tuple queue readers to read the results. */
 			if (pcxt->nworkers_launched > 0)
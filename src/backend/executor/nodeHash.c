@@ -34,6 +34,7 @@
 #include "executor/hashjoin.h"
 #include "executor/nodeHash.h"
 #include "executor/nodeHashjoin.h"
+#include "lib/bloomfilter.h"
 #include "miscadmin.h"
 #include "pgstat.h"
 #include "port/atomics.h"
@@ -43,6 +44,14 @@
 #include "utils/memutils.h"
 #include "utils/syscache.h"
 
+/*
+ * A runtime filter that removes less than 1/HASH_RUNTIME_FILTER_MIN_REMOVED
+ * of the first HASH_RUNTIME_FILTER_SAMPLE tuples checked isn't worth its
+ * cost, so we stop checking it after that.
+ */
+#define HASH_RUNTIME_FILTER_SAMPLE		4096
+#define HASH_RUNTIME_FILTER_MIN_REMOVED	10
+
 static void ExecHashIncreaseNumBatches(HashJoinTable hashtable);
 static void ExecHashIncreaseNumBuckets(HashJoinTable hashtable);
 static void ExecParallelHashIncreaseNumBatches(HashJoinTable hashtable);
@@ -142,6 +151,7 @@ MultiExecPrivateHash(HashState *node)
 	HashJoinTable hashtable;
 	TupleTableSlot *slot;
 	ExprContext *econtext;
+	HashRuntimeFilter *rf;
 	uint32		hashvalue;
 
 	/*
@@ -156,6 +166,20 @@ MultiExecPrivateHash(HashState *node)
 	hashkeys = node->hashkeys;
 	econtext = node->ps.ps_ExprContext;
 
+	/*
+	 * If the parent hash join set up a runtime filter for its outer side,
+	 * we fill it in as we go.
+	 */
+	rf = node->runtime_filter;
+	if (rf != NULL && !rf->disabled)
+	{
+		Assert(rf->filter == NULL);
+		rf->filter = bloom_create((int64) Max(outerNode->plan->plan_rows, 1.0),
+								  work_mem, 0);
+	}
+	else
+		rf = NULL;
+
 	/*
 	 * Get all tuples from the node below the Hash node and insert into the
 	 * hash table (or temp files).
@@ -173,6 +197,10 @@ MultiExecPrivateHash(HashState *node)
 		{
 			int			bucketNumber;
 
+			if (rf != NULL)
+				bloom_add_element(rf->filter, (unsigned char *) &hashvalue,
+								  sizeof(hashvalue));
+
 			bucketNumber = ExecHashGetSkewBucket(hashtable, hashvalue);
 			if (bucketNumber != INVALID_SKEW_BUCKET_NO)
 			{
@@ -366,6 +394,7 @@ ExecInitHash(Hash *node, EState *estate, int eflags)
 	hashstate->ps.ExecProcNode = ExecHash;
 	hashstate->hashtable = NULL;
 	hashstate->hashkeys = NIL;	/* will be set by parent HashJoin */
+	hashstate->runtime_filter = NULL;	/* may be set by parent HashJoin */
 
 	/*
 	 * Miscellaneous initialization
@@ -1709,6 +1738,7 @@ retry:
 		/* Store the hash value in the HashJoinTuple header. */
 		hashTuple->hashvalue = hashvalue;
 		memcpy(HJTUPLE_MINTUPLE(hashTuple), tuple, tuple->t_len);
+		HeapTupleHeaderClearMatch(HJTUPLE_MINTUPLE(hashTuple));
 
 		/* Push it onto the front of the bucket's list */
 		ExecParallelHashPushTuple(&hashtable->buckets.shared[bucketno],
@@ -1869,6 +1899,101 @@ ExecHashGetHashValue(HashJoinTable hashtable,
 	return true;
 }
 
+/*
+ * ExecHashRuntimeFilterRejects
+ *		Check a tuple of the scan on the outer side of a hash join against
+ *		the join's runtime filter
+ *
+ * Returns true if the tuple certainly has no join partner.  The hash value
+ * is computed from the scan tuple's attributes exactly the way
+ * ExecHashGetHashValue() computes it from the outer hash keys.
+ *
+ * The filter is only ever set up for joins that don't have to return
+ * unmatched outer tuples, so a NULL key that can't match anything lets us
+ * reject the tuple too.
+ */
+bool
+ExecHashRuntimeFilterRejects(HashRuntimeFilter *rf, TupleTableSlot *slot,
+							 ExprContext *econtext)
+{
+	uint32		hashkey = 0;
+	bool		rejected = false;
+	MemoryContext oldContext;
+	int			i;
+
+	if (rf->filter == NULL || rf->disabled)
+		return false;
+
+	oldContext = MemoryContextSwitchTo(econtext->ecxt_per_tuple_memory);
+
+	for (i = 0; i < rf->nkeys; i++)
+	{
+		Datum		keyval;
+		bool		isNull;
+
+		/* rotate hashkey left 1 bit at each step */
+		hashkey = (hashkey << 1) | ((hashkey & 0x80000000) ? 1 : 0);
+
+		keyval = slot_getattr(slot, rf->keyattnos[i], &isNull);
+		if (isNull)
+		{
+			if (rf->hashStrict[i])
+			{
+				rejected = true;
+				break;
+			}
+			/* else, leave hashkey unmodified, equivalent to hashcode 0 */
+		}
+		else
+		{
+			uint32		hkey;
+
+			hkey = DatumGetUInt32(FunctionCall1Coll(&rf->hashfunctions[i],
+													rf->collations[i],
+													keyval));
+			hashkey ^= hkey;
+		}
+	}
+
+	MemoryContextSwitchTo(oldContext);
+
+	if (!rejected)
+		rejected = bloom_lacks_element(rf->filter, (unsigned char *) &hashkey,
+									   sizeof(hashkey));
+
+	rf->nchecked++;
+	if (rejected)
+		rf->nremoved++;
+
+	/* Give up on the filter if it doesn't seem to be paying for itself */
+	if (rf->nchecked == HASH_RUNTIME_FILTER_SAMPLE &&
+		rf->nremoved < rf->nchecked / HASH_RUNTIME_FILTER_MIN_REMOVED)
+		rf->disabled = true;
+
+	return rejected;
+}
+
+/*
+ * ExecHashResetRuntimeFilter
+ *		Discard the contents of a runtime filter when the hash table is
+ *		rebuilt
+ *
+ * A join whose hash table has to be rebuilt on rescan is likely to be
+ * rescanned many times, and allocating and clearing a new Bloom filter
+ * every time would cost more than the filter is likely to save, so we
+ * just stop using the filter in that case.
+ */
+void
+ExecHashResetRuntimeFilter(HashRuntimeFilter *rf)
+{
+	if (rf->filter != NULL)
+	{
+		bloom_free(rf->filter);
+		rf->filter = NULL;
+	}
+	rf->disabled = true;
+}
+
 /*
  * ExecHashGetBucketAndBatch
  *		Determine the bucket number and batch number for a hash value
@@ -2036,6 +2161,58 @@ ExecParallelScanHashBucket(HashJoinState *hjstate,
 	return false;
 }
 
+/*
+ * ExecHashPrefetchBuckets
+ *		prefetch the buckets that a group of outer tuples is about to probe
+ *
+ * When the hash table is much larger than the CPU caches, probing it for
+ * one outer tuple at a time stalls first on loading the bucket header and
+ * then again on loading the first tuple in the bucket's chain.  Given the
+ * hash values of several outer tuples, we instead start loading all of
+ * their bucket headers, and only then go back to start loading the first
+ * tuple of each chain, by which time the headers have usually arrived.
+ * The misses then overlap with each other, and the caller's subsequent
+ * ExecScanHashBucket or ExecParallelScanHashBucket calls mostly hit cache.
+ *
+ * Hash values that belong to a later batch are skipped.  Those that belong
+ * to a skew bucket are not distinguished; prefetching their regular bucket
+ * too is harmless.  bucketnos is workspace of at least nvalues entries.
+ */
+void
+ExecHashPrefetchBuckets(HashJoinTable hashtable, const uint32 *hashvalues,
+						int *bucketnos, int nvalues)
+{
+	int			i;
+
+	for (i = 0; i < nvalues; i++)
+	{
+		int			batchno;
+
+		ExecHashGetBucketAndBatch(hashtable, hashvalues[i],
+								  &bucketnos[i], &batchno);
+		if (batchno != hashtable->curbatch)
+			bucketnos[i] = -1;
+		else if (hashtable->parallel_state)
+			pg_prefetch_mem(&hashtable->buckets.shared[bucketnos[i]]);
+		else
+			pg_prefetch_mem(&hashtable->buckets.unshared[bucketnos[i]]);
+	}
+
+	for (i = 0; i < nvalues; i++)
+	{
+		HashJoinTuple hashTuple;
+
+		if (bucketnos[i] < 0)
+			continue;
+		if (hashtable->parallel_state)
+			hashTuple = ExecParallelHashFirstTuple(hashtable, bucketnos[i]);
+		else
+			hashTuple = hashtable->buckets.unshared[bucketnos[i]];
+		if (hashTuple != NULL)
+			pg_prefetch_mem(hashTuple);
+	}
+}
+
 /*
  * ExecPrepHashTableForUnmatched
  *		set up for a series of ExecScanHashTableForUnmatched calls
@@ -2056,6 +2233,69 @@ ExecPrepHashTableForUnmatched(HashJoinState *hjstate)
 	hjstate->hj_CurTuple = NULL;
 }
 
+/*
+ * ExecParallelPrepHashTableForUnmatched
+ *		set up for a series of ExecParallelScanHashTableForUnmatched calls,
+ *		if this process is to scan for unmatched tuples in the current batch
+ *
+ * Returns true if so.  Otherwise this process has detached from the batch,
+ * and should move on to another.
+ */
+bool
+ExecParallelPrepHashTableForUnmatched(HashJoinState *hjstate)
+{
+	HashJoinTable hashtable = hjstate->hj_HashTable;
+	int			curbatch = hashtable->curbatch;
+	ParallelHashJoinBatch *batch = hashtable->batches[curbatch].shared;
+
+	Assert(BarrierPhase(&batch->batch_barrier) == PHJ_BATCH_PROBING);
+
+	/*
+	 * We can't wait for the other participants to finish probing, because
+	 * they might be blocked trying to emit tuples to us, or to a process
+	 * that's waiting for us.  Instead, all but the last participant to finish
+	 * probing detach, and the last one, which therefore sees the complete set
+	 * of match bits, scans the batch's hash table alone.  Those that detach
+	 * can go on to help with other batches.
+	 */
+	if (!BarrierArriveAndDetachExceptLast(&batch->batch_barrier))
+	{
+		/* This process considers the batch to be done. */
+		hashtable->batches[curbatch].done = true;
+
+		/* Make sure any temporary files are closed. */
+		sts_end_parallel_scan(hashtable->batches[curbatch].inner_tuples);
+		sts_end_parallel_scan(hashtable->batches[curbatch].outer_tuples);
+
+		/* See ExecHashTableDetachBatch. */
+		hashtable->spacePeak =
+			Max(hashtable->spacePeak,
+				batch->size + sizeof(dsa_pointer_atomic) * hashtable->nbuckets);
+		hashtable->curbatch = -1;
+		return false;
+	}
+
+	/* Now we are alone with this batch. */
+	Assert(BarrierPhase(&batch->batch_barrier) == PHJ_BATCH_SCANNING);
+
+	/*
+	 * If some participant stopped probing early, we don't have all the match
+	 * bits, so we mustn't emit anything.  That only happens when no more
+	 * tuples are wanted anyway.
+	 */
+	if (batch->skip_unmatched)
+	{
+		hashtable->batches[curbatch].done = true;
+		ExecHashTableDetachBatch(hashtable);
+		return false;
+	}
+
+	/* Now prepare the process-local state, as for a non-parallel join. */
+	ExecPrepHashTableForUnmatched(hjstate);
+
+	return true;
+}
+
 /*
  * ExecScanHashTableForUnmatched
  *		scan the hash table for unmatched inner tuples
@@ -2130,6 +2370,67 @@ ExecScanHashTableForUnmatched(HashJoinState *hjstate, ExprContext *econtext)
 	return false;
 }
 
+/*
+ * ExecParallelScanHashTableForUnmatched
+ *		scan the current batch's shared hash table for unmatched inner tuples
+ *
+ * Only the participant that ExecParallelPrepHashTableForUnmatched chose
+ * calls this.  Parallel Hash doesn't use skew buckets.
+ */
+bool
+ExecParallelScanHashTableForUnmatched(HashJoinState *hjstate,
+									  ExprContext *econtext)
+{
+	HashJoinTable hashtable = hjstate->hj_HashTable;
+	HashJoinTuple hashTuple = hjstate->hj_CurTuple;
+
+	for (;;)
+	{
+		/*
+		 * hj_CurTuple is the address of the tuple last returned from the
+		 * current bucket, or NULL if it's time to start scanning a new
+		 * bucket.
+		 */
+		if (hashTuple != NULL)
+			hashTuple = ExecParallelHashNextTuple(hashtable, hashTuple);
+		else if (hjstate->hj_CurBucketNo < hashtable->nbuckets)
+			hashTuple = ExecParallelHashFirstTuple(hashtable,
+												   hjstate->hj_CurBucketNo++);
+		else
+			break;				/* finished all buckets */
+
+		while (hashTuple != NULL)
+		{
+			if (!HeapTupleHeaderHasMatch(HJTUPLE_MINTUPLE(hashTuple)))
+			{
+				TupleTableSlot *inntuple;
+
+				/* insert hashtable's tuple into exec slot */
+				inntuple = ExecStoreMinimalTuple(HJTUPLE_MINTUPLE(hashTuple),
+												 hjstate->hj_HashTupleSlot,
+												 false);	/* do not pfree */
+				econtext->ecxt_innertuple = inntuple;
+
+				/* see ExecScanHashTableForUnmatched */
+				ResetExprContext(econtext);
+
+				hjstate->hj_CurTuple = hashTuple;
+				return true;
+			}
+
+			hashTuple = ExecParallelHashNextTuple(hashtable, hashTuple);
+		}
+
+		/* allow this loop to be cancellable */
+		CHECK_FOR_INTERRUPTS();
+	}
+
+	/*
+	 * no more unmatched tuples
+	 */
+	return false;
+}
+
 /*
  * ExecHashTableReset
  *
@@ -3093,13 +3394,37 @@ ExecHashTableDetachBatch(HashJoinTable hashtable)
 	{
 		int			curbatch = hashtable->curbatch;
 		ParallelHashJoinBatch *batch = hashtable->batches[curbatch].shared;
+		bool		attached = true;
 
 		/* Make sure any temporary files are closed. */
 		sts_end_parallel_scan(hashtable->batches[curbatch].inner_tuples);
 		sts_end_parallel_scan(hashtable->batches[curbatch].outer_tuples);
 
-		/* Detach from the batch we were last working on. */
-		if (BarrierArriveAndDetach(&batch->batch_barrier))
+		/* After attaching we always get at least to PHJ_BATCH_PROBING. */
+		Assert(BarrierPhase(&batch->batch_barrier) == PHJ_BATCH_PROBING ||
+			   BarrierPhase(&batch->batch_barrier) == PHJ_BATCH_SCANNING);
+
+		/*
+		 * If we're abandoning the PHJ_BATCH_PROBING phase before reaching the
+		 * end of the outer tuples, the plan doesn't want any more tuples.
+		 * Without our match bits, nobody could correctly scan for unmatched
+		 * inner tuples, so tell whoever gets to PHJ_BATCH_SCANNING to skip
+		 * it, as if we had abandoned those tuples too.  The flag is only
+		 * read in that phase, so it needs no locking.
+		 */
+		if (BarrierPhase(&batch->batch_barrier) == PHJ_BATCH_PROBING &&
+			!hashtable->batches[curbatch].outer_eof)
+			batch->skip_unmatched = true;
+
+		/*
+		 * Detach from the batch we were last working on.  Even if we aren't
+		 * doing a right or full join, we step through PHJ_BATCH_SCANNING so
+		 * that the memory is always freed in PHJ_BATCH_DONE; that doesn't
+		 * involve waiting.
+		 */
+		if (BarrierPhase(&batch->batch_barrier) == PHJ_BATCH_PROBING)
+			attached = BarrierArriveAndDetachExceptLast(&batch->batch_barrier);
+		if (attached && BarrierArriveAndDetach(&batch->batch_barrier))
 		{
 			/*
 			 * Technically we shouldn't access the barrier because we're no
@@ -82,6 +82,7 @@
  *  PHJ_BATCH_ALLOCATING     -- one allocates buckets
  *  PHJ_BATCH_LOADING        -- all load the hash table from disk
  *  PHJ_BATCH_PROBING        -- all probe
+ *  PHJ_BATCH_SCANNING       -- one scans for unmatched inner tuples
  *  PHJ_BATCH_DONE           -- end
  *
  * Batch 0 is a special case, because it starts out in phase
@@ -99,7 +100,12 @@
  * while attached to a barrier, unless the barrier has reached its final
  * state.  In the slightly special case of the per-batch barrier, we return
  * tuples while in PHJ_BATCH_PROBING phase, but that's OK because we use
- * BarrierArriveAndDetach() to advance it to PHJ_BATCH_DONE without waiting.
+ * BarrierArriveAndDetachExceptLast() to advance it to PHJ_BATCH_SCANNING
+ * without waiting.  For right and full joins, the last participant to finish
+ * probing then scans the batch's hash table for unmatched inner tuples alone,
+ * since it's the only one known to see the final match bits, while the
+ * others move on to other batches.  Other joins pass straight through
+ * PHJ_BATCH_SCANNING to PHJ_BATCH_DONE.
  *
  *-------------------------------------------------------------------------
  */
@@ -113,7 +119,9 @@
 #include "executor/nodeHash.h"
 #include "executor/nodeHashjoin.h"
 #include "miscadmin.h"
+#include "parser/parsetree.h"
 #include "pgstat.h"
+#include "utils/lsyscache.h"
 #include "utils/memutils.h"
 #include "utils/sharedtuplestore.h"
 
@@ -133,12 +141,36 @@
 /* Returns true if doing null-fill on inner relation */
 #define HJ_FILL_INNER(hjstate)	((hjstate)->hj_NullOuterTupleSlot != NULL)
 
+/*
+ * Only bother with a runtime filter if the outer side is expected to return
+ * at least HJ_RUNTIME_FILTER_MIN_ROWS rows, and the planner doesn't expect
+ * most of them to find a join partner anyway.
+ */
+#define HJ_RUNTIME_FILTER_MIN_ROWS		1000
+#define HJ_RUNTIME_FILTER_MAX_MATCHED	0.5
+
+/*
+ * GUC variables: a hash table with at least hashjoin_prefetch_min_buckets
+ * buckets is assumed not to fit in CPU cache, so we fetch outer tuples
+ * hashjoin_prefetch_group_size at a time and prefetch their buckets before
+ * probing; see ExecHashJoinNextOuterTuple.  These are developer options, to
+ * let src/test/modules/test_hashjoin_perf measure where that pays off; the
+ * defaults should follow its results.
+ */
+int			hashjoin_prefetch_min_buckets = 65536;
+int			hashjoin_prefetch_group_size = 16;
+
 static TupleTableSlot *ExecHashJoinOuterGetTuple(PlanState *outerNode,
 												 HashJoinState *hjstate,
 												 uint32 *hashvalue);
 static TupleTableSlot *ExecParallelHashJoinOuterGetTuple(PlanState *outerNode,
 														 HashJoinState *hjstate,
 														 uint32 *hashvalue);
+static TupleTableSlot *ExecHashJoinNextOuterTuple(PlanState *outerNode,
+												  HashJoinState *hjstate,
+												  uint32 *hashvalue,
+												  bool parallel);
+static void ExecHashJoinInitOuterGroup(HashJoinState *hjstate);
 static TupleTableSlot *ExecHashJoinGetSavedTuple(HashJoinState *hjstate,
 												 BufFile *file,
 												 uint32 *hashvalue,
@@ -146,6 +178,8 @@ static TupleTableSlot *ExecHashJoinGetSavedTuple(HashJoinState *hjstate,
 static bool ExecHashJoinNewBatch(HashJoinState *hjstate);
 static bool ExecParallelHashJoinNewBatch(HashJoinState *hjstate);
 static void ExecParallelHashJoinPartitionOuter(HashJoinState *node);
+static void ExecHashJoinInitRuntimeFilter(HashJoinState *hjstate,
+										  HashJoin *node);
 
 
 /* ----------------------------------------------------------------
@@ -347,22 +381,37 @@ ExecHashJoinImpl(PlanState *pstate, bool parallel)
 				/*
 				 * We don't have an outer tuple, try to get the next one
 				 */
-				if (parallel)
-					outerTupleSlot =
-						ExecParallelHashJoinOuterGetTuple(outerNode, node,
-														  &hashvalue);
-				else
-					outerTupleSlot =
-						ExecHashJoinOuterGetTuple(outerNode, node, &hashvalue);
+				outerTupleSlot = ExecHashJoinNextOuterTuple(outerNode, node,
+															&hashvalue,
+															parallel);
 
 				if (TupIsNull(outerTupleSlot))
 				{
 					/* end of batch, or maybe whole join */
+					if (parallel)
+					{
+						/* we have all of our match bits for this batch */
+						hashtable->batches[hashtable->curbatch].outer_eof = true;
+					}
 					if (HJ_FILL_INNER(node))
 					{
 						/* set up to scan for unmatched inner tuples */
-						ExecPrepHashTableForUnmatched(node);
-						node->hj_JoinState = HJ_FILL_INNER_TUPLES;
+						if (parallel)
+						{
+							/*
+							 * Only one process is chosen to scan for
+							 * unmatched inner tuples; the others move on.
+							 */
+							if (ExecParallelPrepHashTableForUnmatched(node))
+								node->hj_JoinState = HJ_FILL_INNER_TUPLES;
+							else
+								node->hj_JoinState = HJ_NEED_NEW_BATCH;
+						}
+						else
+						{
+							ExecPrepHashTableForUnmatched(node);
+							node->hj_JoinState = HJ_FILL_INNER_TUPLES;
+						}
 					}
 					else
 						node->hj_JoinState = HJ_NEED_NEW_BATCH;
@@ -458,13 +507,16 @@ ExecHashJoinImpl(PlanState *pstate, bool parallel)
 					if (parallel)
 					{
 						/*
-						 * Full/right outer joins are currently not supported
-						 * for parallel joins, so we don't need to set the
-						 * match bit.  Experiments show that it's worth
-						 * avoiding the shared memory traffic on large
-						 * systems.
+						 * Only set the match bit if we'll need it, since
+						 * experiments show that it's worth avoiding the
+						 * shared memory traffic on large systems.  Several
+						 * processes may set the same bit concurrently, but
+						 * they all write the same value, and the bits are
+						 * only read once probing is finished.
 						 */
-						Assert(!HJ_FILL_INNER(node));
+						if (HJ_FILL_INNER(node) &&
+							!HeapTupleHeaderHasMatch(HJTUPLE_MINTUPLE(node->hj_CurTuple)))
+							HeapTupleHeaderSetMatch(HJTUPLE_MINTUPLE(node->hj_CurTuple));
 					}
 					else
 					{
@@ -531,11 +583,23 @@ ExecHashJoinImpl(PlanState *pstate, bool parallel)
 				 * so any unmatched inner tuples in the hashtable have to be
 				 * emitted before we continue to the next batch.
 				 */
-				if (!ExecScanHashTableForUnmatched(node, econtext))
+				if (parallel)
 				{
-					/* no more unmatched tuples */
-					node->hj_JoinState = HJ_NEED_NEW_BATCH;
-					continue;
+					if (!ExecParallelScanHashTableForUnmatched(node, econtext))
+					{
+						/* no more unmatched tuples */
+						node->hj_JoinState = HJ_NEED_NEW_BATCH;
+						continue;
+					}
+				}
+				else
+				{
+					if (!ExecScanHashTableForUnmatched(node, econtext))
+					{
+						/* no more unmatched tuples */
+						node->hj_JoinState = HJ_NEED_NEW_BATCH;
+						continue;
+					}
 				}
 
 				/*
@@ -752,9 +816,144 @@ ExecInitHashJoin(HashJoin *node, EState *estate, int eflags)
 	hjstate->hj_MatchedOuter = false;
 	hjstate->hj_OuterNotEmpty = false;
 
+	/* the outer tuple group is set up when first needed */
+	hjstate->hj_OuterGroupSize = hashjoin_prefetch_group_size;
+	hjstate->hj_OuterGroupSlots = NULL;
+	hjstate->hj_OuterGroupHashValues = NULL;
+	hjstate->hj_OuterGroupBuckets = NULL;
+	hjstate->hj_OuterGroupCount = 0;
+	hjstate->hj_OuterGroupPos = 0;
+	hjstate->hj_OuterGroupDone = false;
+
+	ExecHashJoinInitRuntimeFilter(hjstate, node);
+
 	return hjstate;
 }
 
+/*
+ * ExecHashJoinInitRuntimeFilter
+ *		Set up a runtime filter for the scan on the outer side of the join,
+ *		if that seems worthwhile
+ *
+ * The Hash node fills in the filter while building the hash table, and the
+ * outer scan then uses it to discard tuples that can't find a join partner
+ * before they're projected and returned to us.  That's only possible if
+ * the outer side is a plain relation scan whose tuples contain each of the
+ * outer hash keys as a column, and only correct if we don't have to return
+ * unmatched outer tuples.
+ *
+ * With Parallel Hash, each participant only sees part of the inner
+ * relation, so no participant would have a complete filter; we don't try to
+ * use one in that case.
+ */
+static void
+ExecHashJoinInitRuntimeFilter(HashJoinState *hjstate, HashJoin *node)
+{
+	PlanState  *outerState = outerPlanState(hjstate);
+	HashState  *hashstate = (HashState *) innerPlanState(hjstate);
+	Plan	   *outerNode = outerState->plan;
+	Index		scanrelid;
+	HashRuntimeFilter *rf;
+	AttrNumber *keyattnos;
+	int			nkeys;
+	int			i;
+	ListCell   *lc;
+	ListCell   *lc2;
+	ListCell   *lc3;
+
+	if (node->join.jointype != JOIN_INNER &&
+		node->join.jointype != JOIN_SEMI &&
+		node->join.jointype != JOIN_RIGHT)
+		return;
+
+	if (innerPlan(node)->parallel_aware)
+		return;
+
+	switch (nodeTag(outerState))
+	{
+		case T_SeqScanState:
+		case T_SampleScanState:
+		case T_IndexScanState:
+		case T_BitmapHeapScanState:
+		case T_TidScanState:
+			break;
+		default:
+			return;
+	}
+
+	if (outerNode->plan_rows < HJ_RUNTIME_FILTER_MIN_ROWS ||
+		node->join.plan.plan_rows >
+		outerNode->plan_rows * HJ_RUNTIME_FILTER_MAX_MATCHED)
+		return;
+
+	/*
+	 * Each outer hash key must be a Var referencing a column of the scan's
+	 * targetlist that is just a column of the scanned relation.
+	 */
+	scanrelid = ((Scan *) outerNode)->scanrelid;
+	nkeys = list_length(node->hashkeys);
+	keyattnos = (AttrNumber *) palloc(nkeys * sizeof(AttrNumber));
+	i = 0;
+	foreach(lc, node->hashkeys)
+	{
+		Expr	   *key = (Expr *) lfirst(lc);
+		TargetEntry *tle;
+		Expr	   *expr;
+
+		while (key && IsA(key, RelabelType))
+			key = ((RelabelType *) key)->arg;
+		if (key == NULL || !IsA(key, Var) ||
+			((Var *) key)->varno != OUTER_VAR)
+			break;
+
+		tle = get_tle_by_resno(outerNode->targetlist,
+							   ((Var *) key)->varattno);
+		if (tle == NULL)
+			break;
+		expr = tle->expr;
+		while (expr && IsA(expr, RelabelType))
+			expr = ((RelabelType *) expr)->arg;
+		if (expr == NULL || !IsA(expr, Var) ||
+			((Var *) expr)->varno != scanrelid ||
+			((Var *) expr)->varattno <= 0)
+			break;
+
+		keyattnos[i++] = ((Var *) expr)->varattno;
+	}
+	if (i < nkeys)
+	{
+		pfree(keyattnos);
+		return;
+	}
+
+	rf = (HashRuntimeFilter *) palloc0(sizeof(HashRuntimeFilter));
+	rf->nkeys = nkeys;
+	rf->keyattnos = keyattnos;
+	rf->hashfunctions = (FmgrInfo *) palloc(nkeys * sizeof(FmgrInfo));
+	rf->hashStrict = (bool *) palloc(nkeys * sizeof(bool));
+	rf->collations = (Oid *) palloc(nkeys * sizeof(Oid));
+
+	/* look up the outer hash functions the same way ExecHashTableCreate does */
+	i = 0;
+	forboth(lc2, node->hashoperators, lc3, node->hashcollations)
+	{
+		Oid			hashop = lfirst_oid(lc2);
+		Oid			left_hashfn;
+		Oid			right_hashfn;
+
+		if (!get_op_hash_functions(hashop, &left_hashfn, &right_hashfn))
+			elog(ERROR, "could not find hash function for hash operator %u",
+				 hashop);
+		fmgr_info(left_hashfn, &rf->hashfunctions[i]);
+		rf->hashStrict[i] = op_strict(hashop);
+		rf->collations[i] = lfirst_oid(lc3);
+		i++;
+	}
+
+	((ScanState *) outerState)->ss_RuntimeFilter = rf;
+	hashstate->runtime_filter = rf;
+}
+
 /* ----------------------------------------------------------------
  *		ExecEndHashJoin
  *
@@ -937,6 +1136,123 @@ ExecParallelHashJoinOuterGetTuple(PlanState *outerNode,
 	return NULL;
 }
 
+/*
+ * ExecHashJoinNextOuterTuple
+ *
+ *		get the next outer tuple to probe the hash table with, using
+ *		ExecHashJoinOuterGetTuple or ExecParallelHashJoinOuterGetTuple.
+ *
+ * If the hash table is large, we fetch the outer tuples a group at a time,
+ * copying each into a slot of its own, and let ExecHashPrefetchBuckets start
+ * loading the buckets they hash to before we return the first of them.
+ * Once the hash table doesn't fit in cache, copying the tuples costs much
+ * less than the cache misses it hides; for smaller tables it wouldn't pay,
+ * so we pass the tuples through one at a time.
+ *
+ * Returns a null slot at the end of the current batch, like the functions it
+ * calls.  Tuples of the group remain valid until the group is used up.
+ */
+static pg_attribute_always_inline TupleTableSlot *
+ExecHashJoinNextOuterTuple(PlanState *outerNode,
+						   HashJoinState *hjstate,
+						   uint32 *hashvalue,
+						   bool parallel)
+{
+	HashJoinTable hashtable = hjstate->hj_HashTable;
+	TupleTableSlot *slot;
+	int			n;
+
+	if (hjstate->hj_OuterGroupPos < hjstate->hj_OuterGroupCount)
+	{
+		n = hjstate->hj_OuterGroupPos++;
+		*hashvalue = hjstate->hj_OuterGroupHashValues[n];
+		return hjstate->hj_OuterGroupSlots[n];
+	}
+
+	hjstate->hj_OuterGroupCount = 0;
+	hjstate->hj_OuterGroupPos = 0;
+
+	/*
+	 * If the batch ran out while filling the last group, report its end now
+	 * rather than asking for more tuples.
+	 */
+	if (hjstate->hj_OuterGroupDone)
+	{
+		hjstate->hj_OuterGroupDone = false;
+		return NULL;
+	}
+
+	if (hashtable->nbuckets < hashjoin_prefetch_min_buckets)
+	{
+		if (parallel)
+			return ExecParallelHashJoinOuterGetTuple(outerNode, hjstate,
+													 hashvalue);
+		else
+			return ExecHashJoinOuterGetTuple(outerNode, hjstate, hashvalue);
+	}
+
+	if (hjstate->hj_OuterGroupSlots == NULL)
+		ExecHashJoinInitOuterGroup(hjstate);
+
+	for (n = 0; n < hjstate->hj_OuterGroupSize; n++)
+	{
+		uint32	   *groupHashValue = &hjstate->hj_OuterGroupHashValues[n];
+
+		if (parallel)
+			slot = ExecParallelHashJoinOuterGetTuple(outerNode, hjstate,
+													 groupHashValue);
+		else
+			slot = ExecHashJoinOuterGetTuple(outerNode, hjstate,
+											 groupHashValue);
+		if (TupIsNull(slot))
+		{
+			hjstate->hj_OuterGroupDone = (n > 0);
+			break;
+		}
+		ExecCopySlot(hjstate->hj_OuterGroupSlots[n], slot);
+	}
+
+	if (n == 0)
+		return NULL;
+
+	ExecHashPrefetchBuckets(hashtable, hjstate->hj_OuterGroupHashValues,
+							hjstate->hj_OuterGroupBuckets, n);
+
+	hjstate->hj_OuterGroupCount = n;
+	hjstate->hj_OuterGroupPos = 1;
+	*hashvalue = hjstate->hj_OuterGroupHashValues[0];
+	return hjstate->hj_OuterGroupSlots[0];
+}
+
+/*
+ * ExecHashJoinInitOuterGroup
+ *		allocate the slots and arrays used by ExecHashJoinNextOuterTuple
+ */
+static void
+ExecHashJoinInitOuterGroup(HashJoinState *hjstate)
+{
+	EState	   *estate = hjstate->js.ps.state;
+	PlanState  *outerState = outerPlanState(hjstate);
+	TupleDesc	outerDesc = ExecGetResultType(outerState);
+	const TupleTableSlotOps *ops = ExecGetResultSlotOps(outerState, NULL);
+	MemoryContext oldcontext;
+	int			i;
+
+	oldcontext = MemoryContextSwitchTo(estate->es_query_cxt);
+
+	hjstate->hj_OuterGroupSlots = (TupleTableSlot **)
+		palloc(hjstate->hj_OuterGroupSize * sizeof(TupleTableSlot *));
+	for (i = 0; i < hjstate->hj_OuterGroupSize; i++)
+		hjstate->hj_OuterGroupSlots[i] =
+			ExecInitExtraTupleSlot(estate, outerDesc, ops);
+	hjstate->hj_OuterGroupHashValues = (uint32 *)
+		palloc(hjstate->hj_OuterGroupSize * sizeof(uint32));
+	hjstate->hj_OuterGroupBuckets = (int *)
+		palloc(hjstate->hj_OuterGroupSize * sizeof(int));
+
+	MemoryContextSwitchTo(oldcontext);
+}
+
 /*
  * ExecHashJoinNewBatch
  *		switch to a new hashjoin batch
@@ -1173,14 +1489,30 @@ ExecParallelHashJoinNewBatch(HashJoinState *hjstate)
 					 * hash table stays alive until everyone's finished
 					 * probing it, but no participant is allowed to wait at
 					 * this barrier again (or else a deadlock could occur).
-					 * All attached participants must eventually call
-					 * BarrierArriveAndDetach() so that the final phase
+					 * All attached participants must eventually detach from
+					 * it, via ExecParallelPrepHashTableForUnmatched() or
+					 * ExecHashTableDetachBatch(), so that the final phase
 					 * PHJ_BATCH_DONE can be reached.
 					 */
 					ExecParallelHashTableSetCurrentBatch(hashtable, batchno);
 					sts_begin_parallel_scan(hashtable->batches[batchno].outer_tuples);
+					hashtable->batches[batchno].outer_eof = false;
 					return true;
 
+				case PHJ_BATCH_SCANNING:
+
+					/*
+					 * Another participant is already scanning this batch for
+					 * unmatched inner tuples, and we can't help with that.
+					 * Detach and go around again.  We might be the last to
+					 * detach, in which case ExecHashTableDetachBatch() frees
+					 * the hash table.
+					 */
+					ExecParallelHashTableSetCurrentBatch(hashtable, batchno);
+					hashtable->batches[batchno].done = true;
+					ExecHashTableDetachBatch(hashtable);
+					break;
+
 				case PHJ_BATCH_DONE:
 
 					/*
@@ -1298,6 +1630,8 @@ ExecHashJoinGetSavedTuple(HashJoinState *hjstate,
 void
 ExecReScanHashJoin(HashJoinState *node)
 {
+	HashState  *hashNode = (HashState *) innerPlanState(node);
+
 	/*
 	 * In a multi-batch join, we currently have to do rescans the hard way,
 	 * primarily because batch temp files may have already been released. But
@@ -1340,6 +1674,10 @@ ExecReScanHashJoin(HashJoinState *node)
 			node->hj_HashTable = NULL;
 			node->hj_JoinState = HJ_BUILD_HASHTABLE;
 
+			/* the runtime filter describes the old hash table, too */
+			if (hashNode->runtime_filter)
+				ExecHashResetRuntimeFilter(hashNode->runtime_filter);
+
 			/*
 			 * if chgParam of subnode is not null then plan will be re-scanned
 			 * by first ExecProcNode.
@@ -1358,6 +1696,11 @@ ExecReScanHashJoin(HashJoinState *node)
 	node->hj_MatchedOuter = false;
 	node->hj_FirstOuterTupleSlot = NULL;
 
+	/* forget any outer tuples fetched ahead */
+	node->hj_OuterGroupCount = 0;
+	node->hj_OuterGroupPos = 0;
+	node->hj_OuterGroupDone = false;
+
 	/*
 	 * if chgParam of subnode is not null then plan will be re-scanned by
 	 * first ExecProcNode.
@@ -0,0 +1,555 @@
+/*-------------------------------------------------------------------------
+ *
+ * nodeIncrementalSort.c
+ *	  Routines to handle incremental sorting of relations.
+ *
+ * Portions Copyright (c) 1996-2020, PostgreSQL Global Development Group
+ * Portions Copyright (c) 1994, Regents of the University of California
+ *
+ *
+ * IDENTIFICATION
+ *	  src/backend/executor/nodeIncrementalSort.c
+ *
+ * DESCRIPTION
+ *
+ *	Incremental sort is an optimized variant of multikey sort for cases
+ *	when the input is already sorted by a prefix of the sort keys.  For
+ *	example when a sort by (key1, key2 ... keyN) is requested, and the
+ *	input is already sorted by (key1, key2 ... keyM), M < N, we can
+ *	divide the input into groups where keys (key1, ... keyM) are equal,
+ *	and only sort on the remaining columns.
+ *
+ *	Consider the following example.  We have input tuples consisting of
+ *	two integers (X, Y) already presorted by X, while it's required to
+ *	sort them by both X and Y.  Let input tuples be following.
+ *
+ *	(1, 5)
+ *	(1, 2)
+ *	(2, 9)
+ *	(2, 1)
+ *	(2, 5)
+ *	(3, 3)
+ *	(3, 7)
+ *
+ *	An incremental sort algorithm would split the input into the following
+ *	groups, which have equal X, and then sort them by Y individually:
+ *
+ *		(1, 5) (1, 2)
+ *		(2, 9) (2, 1) (2, 5)
+ *		(3, 3) (3, 7)
+ *
+ *	After sorting these groups and putting them altogether, we would get
+ *	the following result which is sorted by X and Y, as requested:
+ *
+ *	(1, 2)
+ *	(1, 5)
+ *	(2, 1)
+ *	(2, 5)
+ *	(2, 9)
+ *	(3, 3)
+ *	(3, 7)
+ *
+ *	Incremental sort may be more efficient than plain sort, particularly
+ *	on large datasets, as it reduces the amount of data to sort at once,
+ *	making it more likely it fits into work_mem (eliminating the need to
+ *	spill to disk).  But the main advantage of incremental sort is that
+ *	it can start producing rows early, before sorting the whole dataset,
+ *	which is a significant benefit especially for queries with LIMIT.
+ *
+ *	Setting up a tuplesort for every single group would be expensive when
+ *	the groups are small, so we always collect at least
+ *	INCSORT_MIN_GROUP_SIZE tuples before looking for a group boundary, and
+ *	sort the collected tuples by all the sort keys.  That's still correct,
+ *	because the input is ordered by the presorted keys, so any tuples that
+ *	end up sorted together across a group boundary are already in the
+ *	right relative order.
+ *
+ *-------------------------------------------------------------------------
+ */
+
+#include "postgres.h"
+
+#include "access/parallel.h"
+#include "executor/execdebug.h"
+#include "executor/nodeIncrementalSort.h"
+#include "miscadmin.h"
+#include "utils/lsyscache.h"
+#include "utils/tuplesort.h"
+
+/*
+ * Minimum number of tuples sorted together, so that we don't pay the
+ * tuplesort setup cost for each of many tiny groups.
+ */
+#define INCSORT_MIN_GROUP_SIZE	32
+
+
+/* ----------------------------------------------------------------
+ *		instrumentIncrementalSortGroup
+ *
+ *		Accumulate statistics about a group that has just been sorted.
+ * ----------------------------------------------------------------
+ */
+static void
+instrumentIncrementalSortGroup(IncrementalSortState *node,
+							   Tuplesortstate *tuplesortstate)
+{
+	IncrementalSortInfo *info = &node->incsort_info;
+	TuplesortInstrumentation sort_instr;
+
+	tuplesort_get_stats(tuplesortstate, &sort_instr);
+
+	info->groupCount++;
+	info->totalSpaceUsed += sort_instr.spaceUsed;
+
+	/* Disk usage always wins over memory usage for the peak we report */
+	if ((sort_instr.spaceType == info->maxSpaceType &&
+		 sort_instr.spaceUsed > info->maxSpaceUsed) ||
+		(sort_instr.spaceType == SORT_SPACE_TYPE_DISK &&
+		 info->maxSpaceType != SORT_SPACE_TYPE_DISK))
+	{
+		info->maxSpaceUsed = sort_instr.spaceUsed;
+		info->maxSpaceType = sort_instr.spaceType;
+	}
+
+	info->sortMethods |= (1 << sort_instr.sortMethod);
+
+	/* Publish the running totals for the leader's EXPLAIN, if a worker */
+	if (node->shared_info && node->am_worker)
+	{
+		Assert(IsParallelWorker());
+		Assert(ParallelWorkerNumber <= node->shared_info->num_workers);
+		memcpy(&node->shared_info->sinfo[ParallelWorkerNumber], info,
+			   sizeof(IncrementalSortInfo));
+	}
+}
+
+/* ----------------------------------------------------------------
+ *		loadIncrementalSortGroup
+ *
+ *		Read the next group of tuples from the outer plan into a fresh
+ *		tuplesort and sort it.
+ *
+ *		We first unconditionally collect INCSORT_MIN_GROUP_SIZE tuples,
+ *		then keep adding tuples as long as their presorted keys are equal
+ *		to those of the last tuple collected (the pivot).  The first tuple
+ *		that doesn't match is saved in group_pivot and becomes the first
+ *		tuple of the following group.
+ * ----------------------------------------------------------------
+ */
+static void
+loadIncrementalSortGroup(IncrementalSortState *node)
+{
+	IncrementalSort *plannode = (IncrementalSort *) node->ss.ps.plan;
+	PlanState  *outerNode = outerPlanState(node);
+	ExprContext *econtext = node->ss.ps.ps_ExprContext;
+	Tuplesortstate *tuplesortstate;
+	int64		nTuples = 0;
+
+	SO1_printf("loadIncrementalSortGroup: %s\n",
+			   "calling tuplesort_begin");
+
+	tuplesortstate = tuplesort_begin_heap(ExecGetResultType(outerNode),
+										  plannode->sort.numCols,
+										  plannode->sort.sortColIdx,
+										  plannode->sort.sortOperators,
+										  plannode->sort.collations,
+										  plannode->sort.nullsFirst,
+										  work_mem,
+										  NULL, false);
+
+	/*
+	 * If bounded, we only need as many tuples out of this group as the
+	 * caller still wants; earlier groups have been returned already.
+	 */
+	if (node->bounded)
+	{
+		Assert(node->bound > node->bound_Done);
+		tuplesort_set_bound(tuplesortstate, node->bound - node->bound_Done);
+	}
+	node->tuplesortstate = (void *) tuplesortstate;
+
+	/* The tuple that ended the previous group starts this one */
+	if (node->pivot_pending)
+	{
+		tuplesort_puttupleslot(tuplesortstate, node->group_pivot);
+		nTuples++;
+		node->pivot_pending = false;
+	}
+
+	while (!node->outerNodeDone)
+	{
+		TupleTableSlot *slot = ExecProcNode(outerNode);
+
+		if (TupIsNull(slot))
+		{
+			node->outerNodeDone = true;
+			break;
+		}
+
+		if (nTuples < INCSORT_MIN_GROUP_SIZE)
+		{
+			tuplesort_puttupleslot(tuplesortstate, slot);
+			nTuples++;
+
+			/* Remember the last of the minimum tuples as the pivot */
+			if (nTuples == INCSORT_MIN_GROUP_SIZE)
+				ExecCopySlot(node->group_pivot, slot);
+			continue;
+		}
+
+		econtext->ecxt_innertuple = node->group_pivot;
+		econtext->ecxt_outertuple = slot;
+		if (ExecQualAndReset(node->presortedEq, econtext))
+		{
+			tuplesort_puttupleslot(tuplesortstate, slot);
+			nTuples++;
+		}
+		else
+		{
+			/* Found a group boundary; keep the tuple for the next group */
+			ExecCopySlot(node->group_pivot, slot);
+			node->pivot_pending = true;
+			break;
+		}
+	}
+
+	SO1_printf("loadIncrementalSortGroup: sorting " INT64_FORMAT " tuples\n",
+			   nTuples);
+
+	tuplesort_performsort(tuplesortstate);
+
+	if (node->ss.ps.instrument != NULL)
+		instrumentIncrementalSortGroup(node, tuplesortstate);
+
+	node->execution_status = INCSORT_READGROUP;
+}
+
+/* ----------------------------------------------------------------
+ *		ExecIncrementalSort
+ *
+ *		Assuming that outer subtree returns tuples presorted by some
+ *		prefix of the target sort columns, performs an incremental sort.
+ *		It fetches groups of tuples where the prefix sort columns are
+ *		equal and sorts them using tuplesort.  This approach avoids
+ *		sorting the whole dataset at once, and allows returning the
+ *		first tuples as soon as the first group has been sorted.
+ *
+ *		Conditions:
+ *		  -- none.
+ *
+ *		Initial States:
+ *		  -- the outer child is prepared to return the first tuple.
+ * ----------------------------------------------------------------
+ */
+static TupleTableSlot *
+ExecIncrementalSort(PlanState *pstate)
+{
+	IncrementalSortState *node = castNode(IncrementalSortState, pstate);
+	EState	   *estate = node->ss.ps.state;
+	ScanDirection dir;
+	TupleTableSlot *slot = node->ss.ps.ps_ResultTupleSlot;
+
+	CHECK_FOR_INTERRUPTS();
+
+	/* Incremental sort doesn't support backward scans */
+	Assert(ScanDirectionIsForward(estate->es_direction));
+
+	for (;;)
+	{
+		if (node->execution_status == INCSORT_READGROUP)
+		{
+			/*
+			 * Return the next tuple of the current group.  As for a plain
+			 * sort, we only rely on the slot's tuple remaining valid until
+			 * the next fetch from the tuplesort.
+			 */
+			if (tuplesort_gettupleslot((Tuplesortstate *) node->tuplesortstate,
+									   true, false, slot, NULL))
+			{
+				node->bound_Done++;
+				return slot;
+			}
+
+			/* Current group is exhausted, release it */
+			tuplesort_end((Tuplesortstate *) node->tuplesortstate);
+			node->tuplesortstate = NULL;
+
+			if (node->outerNodeDone && !node->pivot_pending)
+				node->execution_status = INCSORT_DONE;
+			else
+				node->execution_status = INCSORT_LOADGROUP;
+		}
+
+		/* Nothing more to do if the caller has all the tuples it wants */
+		if (node->bounded && node->bound_Done >= node->bound)
+			node->execution_status = INCSORT_DONE;
+
+		if (node->execution_status == INCSORT_DONE)
+			return ExecClearTuple(slot);
+
+		/*
+		 * Want to scan subplan in the forward direction while loading the
+		 * next group.
+		 */
+		dir = estate->es_direction;
+		estate->es_direction = ForwardScanDirection;
+		loadIncrementalSortGroup(node);
+		estate->es_direction = dir;
+	}
+}
+
+/* ----------------------------------------------------------------
+ *		ExecInitIncrementalSort
+ *
+ *		Creates the run-time state information for the incremental sort
+ *		node produced by the planner and initializes its outer subtree.
+ * ----------------------------------------------------------------
+ */
+IncrementalSortState *
+ExecInitIncrementalSort(IncrementalSort *node, EState *estate, int eflags)
+{
+	IncrementalSortState *incrsortstate;
+	TupleDesc	outerTupDesc;
+	Oid		   *eqOperators;
+	int			i;
+
+	SO1_printf("ExecInitIncrementalSort: %s\n",
+			   "initializing sort node");
+
+	/*
+	 * Incremental sort can't be used with EXEC_FLAG_BACKWARD or
+	 * EXEC_FLAG_MARK, because the current sort state contains only one
+	 * group of tuples at a time.
+	 */
+	Assert((eflags & (EXEC_FLAG_BACKWARD | EXEC_FLAG_MARK)) == 0);
+
+	/*
+	 * create state structure
+	 */
+	incrsortstate = makeNode(IncrementalSortState);
+	incrsortstate->ss.ps.plan = (Plan *) node;
+	incrsortstate->ss.ps.state = estate;
+	incrsortstate->ss.ps.ExecProcNode = ExecIncrementalSort;
+
+	incrsortstate->bounded = false;
+	incrsortstate->bound_Done = 0;
+	incrsortstate->outerNodeDone = false;
+	incrsortstate->execution_status = INCSORT_LOADGROUP;
+	incrsortstate->pivot_pending = false;
+	incrsortstate->tuplesortstate = NULL;
+	incrsortstate->incsort_info.maxSpaceType = SORT_SPACE_TYPE_MEMORY;
+
+	/*
+	 * Miscellaneous initialization
+	 *
+	 * We need an expression context to compare the presorted keys of
+	 * consecutive tuples.
+	 */
+	ExecAssignExprContext(estate, &incrsortstate->ss.ps);
+
+	/*
+	 * initialize child nodes
+	 *
+	 * We shield the child node from the need to support REWIND, BACKWARD, or
+	 * MARK/RESTORE.
+	 */
+	eflags &= ~(EXEC_FLAG_REWIND | EXEC_FLAG_BACKWARD | EXEC_FLAG_MARK);
+
+	outerPlanState(incrsortstate) = ExecInitNode(outerPlan(node), estate, eflags);
+	outerTupDesc = ExecGetResultType(outerPlanState(incrsortstate));
+
+	/*
+	 * Initialize scan slot and type.
+	 */
+	ExecCreateScanSlotFromOuterPlan(estate, &incrsortstate->ss, &TTSOpsVirtual);
+
+	/*
+	 * Initialize return slot and type. No need to initialize projection info
+	 * because this node doesn't do projections.
+	 */
+	ExecInitResultTupleSlotTL(&incrsortstate->ss.ps, &TTSOpsMinimalTuple);
+	incrsortstate->ss.ps.ps_ProjInfo = NULL;
+
+	/* Slot holding the tuple that group boundaries are checked against */
+	incrsortstate->group_pivot = ExecInitExtraTupleSlot(estate, outerTupDesc,
+														&TTSOpsMinimalTuple);
+
+	/*
+	 * Precompute the equality comparison of the presorted columns, using the
+	 * equality operators matching the sort operators.
+	 */
+	eqOperators = (Oid *) palloc(node->nPresortedCols * sizeof(Oid));
+	for (i = 0; i < node->nPresortedCols; i++)
+	{
+		Oid			sortop = node->sort.sortOperators[i];
+
+		eqOperators[i] = get_equality_op_for_ordering_op(sortop, NULL);
+		if (!OidIsValid(eqOperators[i]))
+			elog(ERROR, "missing equality operator for ordering operator %u",
+				 sortop);
+	}
+
+	incrsortstate->presortedEq =
+		execTuplesMatchPrepare(outerTupDesc,
+							   node->nPresortedCols,
+							   node->sort.sortColIdx,
+							   eqOperators,
+							   node->sort.collations,
+							   &incrsortstate->ss.ps);
+
+	SO1_printf("ExecInitIncrementalSort: %s\n",
+			   "sort node initialized");
+
+	return incrsortstate;
+}
+
+/* ----------------------------------------------------------------
+ *		ExecEndIncrementalSort(node)
+ * ----------------------------------------------------------------
+ */
+void
+ExecEndIncrementalSort(IncrementalSortState *node)
+{
+	SO1_printf("ExecEndIncrementalSort: %s\n",
+			   "shutting down sort node");
+
+	/*
+	 * clean out the tuple table
+	 */
+	ExecClearTuple(node->ss.ss_ScanTupleSlot);
+	/* must drop pointer to sort result tuple */
+	ExecClearTuple(node->ss.ps.ps_ResultTupleSlot);
+	ExecClearTuple(node->group_pivot);
+
+	/*
+	 * Release tuplesort resources
+	 */
+	if (node->tuplesortstate != NULL)
+		tuplesort_end((Tuplesortstate *) node->tuplesortstate);
+	node->tuplesortstate = NULL;
+
+	/*
+	 * shut down the subplan
+	 */
+	ExecEndNode(outerPlanState(node));
+
+	SO1_printf("ExecEndIncrementalSort: %s\n",
+			   "sort node shutdown");
+}
+
+void
+ExecReScanIncrementalSort(IncrementalSortState *node)
+{
+	PlanState  *outerPlan = outerPlanState(node);
+
+	/* must drop pointer to sort result tuple */
+	ExecClearTuple(node->ss.ps.ps_ResultTupleSlot);
+	ExecClearTuple(node->group_pivot);
+
+	/*
+	 * We only ever hold a single group, so unlike a plain sort we can never
+	 * just rewind: forget everything and re-read the subplan.
+	 */
+	if (node->tuplesortstate != NULL)
+		tuplesort_end((Tuplesortstate *) node->tuplesortstate);
+	node->tuplesortstate = NULL;
+
+	node->execution_status = INCSORT_LOADGROUP;
+	node->outerNodeDone = false;
+	node->pivot_pending = false;
+	node->bound_Done = 0;
+
+	/*
+	 * if chgParam of subnode is not null then plan will be re-scanned by
+	 * first ExecProcNode.
+	 */
+	if (outerPlan->chgParam == NULL)
+		ExecReScan(outerPlan);
+}
+
+/* ----------------------------------------------------------------
+ *						Parallel Query Support
+ * ----------------------------------------------------------------
+ */
+
+/* ----------------------------------------------------------------
+ *		ExecIncrementalSortEstimate
+ *
+ *		Estimate space required to propagate sort statistics.
+ * ----------------------------------------------------------------
+ */
+void
+ExecIncrementalSortEstimate(IncrementalSortState *node, ParallelContext *pcxt)
+{
+	Size		size;
+
+	/* don't need this if not instrumenting or no workers */
+	if (!node->ss.ps.instrument || pcxt->nworkers == 0)
+		return;
+
+	size = mul_size(pcxt->nworkers, sizeof(IncrementalSortInfo));
+	size = add_size(size, offsetof(SharedIncrementalSortInfo, sinfo));
+	shm_toc_estimate_chunk(&pcxt->estimator, size);
+	shm_toc_estimate_keys(&pcxt->estimator, 1);
+}
+
+/* ----------------------------------------------------------------
+ *		ExecIncrementalSortInitializeDSM
+ *
+ *		Initialize DSM space for sort statistics.
+ * ----------------------------------------------------------------
+ */
+void
+ExecIncrementalSortInitializeDSM(IncrementalSortState *node, ParallelContext *pcxt)
+{
+	Size		size;
+
+	/* don't need this if not instrumenting or no workers */
+	if (!node->ss.ps.instrument || pcxt->nworkers == 0)
+		return;
+
+	size = offsetof(SharedIncrementalSortInfo, sinfo)
+		+ pcxt->nworkers * sizeof(IncrementalSortInfo);
+	node->shared_info = shm_toc_allocate(pcxt->toc, size);
+	/* ensure any unfilled slots will contain zeroes */
+	memset(node->shared_info, 0, size);
+	node->shared_info->num_workers = pcxt->nworkers;
+	shm_toc_insert(pcxt->toc, node->ss.ps.plan->plan_node_id,
+				   node->shared_info);
+}
+
+/* ----------------------------------------------------------------
+ *		ExecIncrementalSortInitializeWorker
+ *
+ *		Attach worker to DSM space for sort statistics.
+ * ----------------------------------------------------------------
+ */
+void
+ExecIncrementalSortInitializeWorker(IncrementalSortState *node, ParallelWorkerContext *pwcxt)
+{
+	node->shared_info =
+		shm_toc_lookup(pwcxt->toc, node->ss.ps.plan->plan_node_id, true);
+	node->am_worker = true;
+}
+
+/* ----------------------------------------------------------------
+ *		ExecIncrementalSortRetrieveInstrumentation
+ *
+ *		Transfer sort statistics from DSM to private memory.
+ * ----------------------------------------------------------------
+ */
+void
+ExecIncrementalSortRetrieveInstrumentation(IncrementalSortState *node)
+{
+	Size		size;
+	SharedIncrementalSortInfo *si;
+
+	if (node->shared_info == NULL)
+		return;
+
+	size = offsetof(SharedIncrementalSortInfo, sinfo)
+		+ node->shared_info->num_workers * sizeof(IncrementalSortInfo);
+	si = palloc(size);
+	memcpy(si, node->shared_info, size);
+	node->shared_info = si;
+}
@@ -22,6 +22,7 @@
  *		ExecEndIndexScan		releases all storage.
  *		ExecIndexMarkPos		marks scan position.
  *		ExecIndexRestrPos		restores scan position.
+ *		ExecIndexScanSkipTo		moves scan forward to a key.
  *		ExecIndexScanEstimate	estimates DSM space needed for parallel index scan
  *		ExecIndexScanInitializeDSM initialize DSM for parallel indexscan
  *		ExecIndexScanReInitializeDSM reinitialize DSM for fresh scan
@@ -116,6 +117,7 @@ IndexNext(IndexScanState *node)
 								   node->iss_NumOrderByKeys);
 
 		node->iss_ScanDesc = scandesc;
+		scandesc->xs_ordered_rescans = node->iss_OrderedRescans;
 
 		/*
 		 * If no run-time keys to calculate or they are ready, go ahead and
@@ -885,6 +887,30 @@ ExecIndexRestrPos(IndexScanState *node)
 	index_restrpos(node->iss_ScanDesc);
 }
 
+/* ----------------------------------------------------------------
+ *		ExecIndexScanSkipTo
+ *
+ *		Repositions a running forward scan so that the next tuple
+ *		returned is the first one whose leading index column is >=
+ *		the argument of skipkey.  Returns false if the scan can't be
+ *		repositioned, in which case it continues where it was.
+ * ----------------------------------------------------------------
+ */
+bool
+ExecIndexScanSkipTo(IndexScanState *node, ScanKey skipkey)
+{
+	/*
+	 * An EPQ recheck doesn't really scan the index, and a reordering scan
+	 * may have tuples queued that we would have to throw away.
+	 */
+	if (node->ss.ps.state->es_epq_active != NULL ||
+		node->iss_ScanDesc == NULL ||
+		node->iss_NumOrderByKeys > 0)
+		return false;
+
+	return index_rescan_to_key(node->iss_ScanDesc, skipkey);
+}
+
 /* ----------------------------------------------------------------
  *		ExecInitIndexScan
  *
@@ -89,15 +89,27 @@
  *		proceed to another state.  This state is stored in the node's
  *		execution state information and is preserved across calls to
  *		ExecMergeJoin. -cim 10/31/89
+ *
+ *
+ *		When a small outer input is joined to a large inner input, most
+ *		of the time is spent in SKIPINNER_ADVANCE, reading inner tuples
+ *		that cannot match anything.  If the inner input is a btree index
+ *		scan on the first merge key, we instead ask the index to descend
+ *		directly to the current outer key once MJ_SKIP_THRESHOLD inner
+ *		tuples in a row have been skipped.  The threshold keeps us from
+ *		paying for a descent when the inputs are interleaved closely.
  */
 #include "postgres.h"
 
 #include "access/nbtree.h"
+#include "catalog/pg_index.h"
 #include "executor/execdebug.h"
+#include "executor/nodeIndexscan.h"
 #include "executor/nodeMergejoin.h"
 #include "miscadmin.h"
 #include "utils/lsyscache.h"
 #include "utils/memutils.h"
+#include "utils/rel.h"
 
 
 /*
@@ -115,6 +127,12 @@
 #define EXEC_MJ_ENDOUTER				10
 #define EXEC_MJ_ENDINNER				11
 
+/*
+ * Number of consecutive inner tuples we skip one at a time before asking
+ * the inner index scan to reposition itself at the outer key.
+ */
+#define MJ_SKIP_THRESHOLD				32
+
 /*
  * Runtime data for each mergejoin clause
  */
@@ -533,6 +551,141 @@ check_constant_qual(List *qual, bool *is_const_false)
 	return true;
 }
 
+/*
+ * MJInitInnerSkip
+ *
+ * Set up mj_InnerSkipKey if the inner input is a plain forward index scan
+ * whose leading index column is the inner side of the first mergeclause,
+ * in the same ordering.  Then a >= key on the current outer value finds
+ * the first inner tuple that can still match.
+ *
+ * Skipped inner tuples are never seen, so we can't do this when they have
+ * to be null-extended.
+ */
+static void
+MJInitInnerSkip(MergeJoinState *mergestate, MergeJoin *node)
+{
+	PlanState  *innerstate = innerPlanState(mergestate);
+	IndexScanState *indexstate;
+	IndexScan  *indexscan;
+	Relation	indexRel;
+	OpExpr	   *qual;
+	Var		   *innervar;
+	TargetEntry *tle;
+	Var		   *scanvar;
+	Oid			opfamily;
+	int			op_strategy;
+	Oid			op_lefttype;
+	Oid			op_righttype;
+	RegProcedure cmp_proc;
+	ScanKey		skipkey;
+
+	mergestate->mj_InnerSkipKey = NULL;
+	mergestate->mj_InnerSkipCount = 0;
+
+	if (mergestate->mj_FillInner || mergestate->mj_NumClauses == 0 ||
+		!IsA(innerstate, IndexScanState))
+		return;
+
+	indexstate = (IndexScanState *) innerstate;
+	indexscan = (IndexScan *) innerstate->plan;
+	indexRel = indexstate->iss_RelationDesc;
+
+	/* No index is opened in EXPLAIN-only mode */
+	if (indexRel == NULL ||
+		indexRel->rd_indam->amrescantokey == NULL ||
+		indexstate->iss_NumOrderByKeys > 0 ||
+		!ScanDirectionIsForward(indexscan->indexorderdir))
+		return;
+
+	/* The inner key must be a plain column, stored first in the index */
+	qual = (OpExpr *) linitial(node->mergeclauses);
+	innervar = (Var *) lsecond(qual->args);
+	if (!IsA(innervar, Var) || innervar->varno != INNER_VAR)
+		return;
+	tle = list_nth(indexscan->scan.plan.targetlist, innervar->varattno - 1);
+	scanvar = (Var *) tle->expr;
+	if (!IsA(scanvar, Var) ||
+		scanvar->varno != indexscan->scan.scanrelid ||
+		scanvar->varattno != indexRel->rd_index->indkey.values[0])
+		return;
+
+	/* ... and the index must be ordered the way the merge expects */
+	opfamily = node->mergeFamilies[0];
+	if (opfamily != indexRel->rd_opfamily[0] ||
+		node->mergeCollations[0] != indexRel->rd_indcollation[0] ||
+		node->mergeStrategies[0] != BTLessStrategyNumber ||
+		(indexRel->rd_indoption[0] & INDOPTION_DESC) != 0)
+		return;
+
+	/* The key carries an outer value, so we need a cross-type comparator */
+	get_op_opfamily_properties(qual->opno, opfamily, false,
+							   &op_strategy,
+							   &op_lefttype,
+							   &op_righttype);
+	cmp_proc = get_opfamily_proc(opfamily,
+								 indexRel->rd_opcintype[0],
+								 op_lefttype,
+								 BTORDER_PROC);
+	if (!RegProcedureIsValid(cmp_proc))
+		return;
+
+	skipkey = (ScanKey) palloc(sizeof(ScanKeyData));
+	ScanKeyEntryInitialize(skipkey,
+						   0,
+						   1,
+						   BTGreaterEqualStrategyNumber,
+						   op_lefttype,
+						   node->mergeCollations[0],
+						   cmp_proc,
+						   (Datum) 0);
+	mergestate->mj_InnerSkipKey = skipkey;
+}
+
+/*
+ * MJSkipInner
+ *
+ * Try to move the inner index scan forward to the current outer key.
+ * Only called in SKIPINNER_ADVANCE, where no inner tuple before that key
+ * can match the current outer tuple or any later one.
+ */
+static void
+MJSkipInner(MergeJoinState *mergestate)
+{
+	MergeJoinClause clause = &mergestate->mj_Clauses[0];
+	ScanKey		skipkey = mergestate->mj_InnerSkipKey;
+	ExprContext *econtext = mergestate->js.ps.ps_ExprContext;
+	MemoryContext oldContext;
+	int			cmp;
+
+	mergestate->mj_InnerSkipCount = 0;
+
+	if (TupIsNull(mergestate->mj_OuterTupleSlot) || clause->lisnull ||
+		TupIsNull(mergestate->mj_InnerTupleSlot))
+		return;
+
+	/*
+	 * We may be skipping because a later merge key differs while the first
+	 * one is equal.  Repositioning at the first key would then move the
+	 * scan backwards.
+	 */
+	oldContext = MemoryContextSwitchTo(econtext->ecxt_per_tuple_memory);
+	cmp = ApplySortComparator(clause->ldatum, clause->lisnull,
+							  clause->rdatum, clause->risnull,
+							  &clause->ssup);
+	MemoryContextSwitchTo(oldContext);
+	if (cmp <= 0)
+		return;
+
+	skipkey->sk_argument = clause->ldatum;
+	if (!ExecIndexScanSkipTo((IndexScanState *) innerPlanState(mergestate),
+							 skipkey))
+	{
+		/* don't keep asking */
+		mergestate->mj_InnerSkipKey = NULL;
+	}
+}
+
 
 /* ----------------------------------------------------------------
  *		ExecMergeTupleDump
@@ -1182,6 +1335,9 @@ ExecMergeJoin(PlanState *pstate)
 				compareResult = MJCompare(node);
 				MJ_DEBUG_COMPARE(compareResult);
 
+				if (compareResult <= 0)
+					node->mj_InnerSkipCount = 0;
+
 				if (compareResult == 0)
 				{
 					if (!node->mj_SkipMarkRestore)
@@ -1289,6 +1445,14 @@ ExecMergeJoin(PlanState *pstate)
 				if (node->mj_ExtraMarks)
 					ExecMarkPos(innerPlan);
 
+				/*
+				 * If we've been skipping inner tuples for a while, let the
+				 * inner index scan jump straight to the outer key.
+				 */
+				if (node->mj_InnerSkipKey != NULL &&
+					++node->mj_InnerSkipCount >= MJ_SKIP_THRESHOLD)
+					MJSkipInner(node);
+
 				/*
 				 * now we get the next inner tuple, if any
 				 */
@@ -1603,6 +1767,9 @@ ExecInitMergeJoin(MergeJoin *node, EState *estate, int eflags)
 											node->mergeNullsFirst,
 											(PlanState *) mergestate);
 
+	/* see if the inner index scan can skip ahead for us */
+	MJInitInnerSkip(mergestate, node);
+
 	/*
 	 * initialize join state
 	 */
@@ -1665,6 +1832,7 @@ ExecReScanMergeJoin(MergeJoinState *node)
 	node->mj_MatchedInner = false;
 	node->mj_OuterTupleSlot = NULL;
 	node->mj_InnerTupleSlot = NULL;
+	node->mj_InnerSkipCount = 0;
 
 	/*
 	 * if chgParam of subnodes is not null then plans will be re-scanned by
@@ -25,6 +25,11 @@
 #include "executor/nodeNestloop.h"
 #include "miscadmin.h"
 #include "utils/memutils.h"
+#include "utils/sortsupport.h"
+
+
+static TupleTableSlot *ExecNestLoopNextBatchedOuter(NestLoopState *node);
+static int	batch_key_cmp(const void *a, const void *b, void *arg);
 
 
 /* ----------------------------------------------------------------
@@ -106,7 +111,10 @@ ExecNestLoop(PlanState *pstate)
 		if (node->nl_NeedNewOuter)
 		{
 			ENL1_printf("getting new outer tuple");
-			outerTupleSlot = ExecProcNode(outerPlan);
+			if (node->nl_BatchSlots != NULL)
+				outerTupleSlot = ExecNestLoopNextBatchedOuter(node);
+			else
+				outerTupleSlot = ExecProcNode(outerPlan);
 
 			/*
 			 * if there are no more outer tuples, then the join is complete..
@@ -255,6 +263,82 @@ ExecNestLoop(PlanState *pstate)
 	}
 }
 
+/* ----------------------------------------------------------------
+ *		ExecNestLoopNextBatchedOuter
+ *
+ *		Returns the next outer tuple of a batched nestloop.  When the
+ *		current batch is used up, the next batchSize outer tuples are
+ *		copied and sorted on the key passed to the inner index scan, so
+ *		that the inner scans of a batch progress forward through the index.
+ *		Returns NULL at the end of the outer input.
+ * ----------------------------------------------------------------
+ */
+static TupleTableSlot *
+ExecNestLoopNextBatchedOuter(NestLoopState *node)
+{
+	NestLoop   *nl = (NestLoop *) node->js.ps.plan;
+	NestLoopParam *nlp = (NestLoopParam *) linitial(nl->nestParams);
+	int			i;
+
+	if (node->nl_BatchNext >= node->nl_BatchCount)
+	{
+		PlanState  *outerPlan = outerPlanState(node);
+
+		node->nl_BatchCount = 0;
+		node->nl_BatchNext = 0;
+
+		while (!node->nl_OuterDone && node->nl_BatchCount < nl->batchSize)
+		{
+			TupleTableSlot *outerTupleSlot = ExecProcNode(outerPlan);
+			TupleTableSlot *batchSlot;
+
+			if (TupIsNull(outerTupleSlot))
+			{
+				node->nl_OuterDone = true;
+				break;
+			}
+
+			i = node->nl_BatchCount++;
+			batchSlot = ExecCopySlot(node->nl_BatchSlots[i], outerTupleSlot);
+			node->nl_BatchKeys[i] = slot_getattr(batchSlot,
+												 nlp->paramval->varattno,
+												 &node->nl_BatchNulls[i]);
+			node->nl_BatchOrder[i] = i;
+		}
+
+		if (node->nl_BatchCount == 0)
+			return NULL;
+
+		qsort_arg(node->nl_BatchOrder, node->nl_BatchCount, sizeof(int),
+				  batch_key_cmp, node);
+	}
+
+	i = node->nl_BatchOrder[node->nl_BatchNext++];
+	return node->nl_BatchSlots[i];
+}
+
+/*
+ * qsort_arg comparator for the outer tuples of a batch.  Ties are broken by
+ * arrival order, so that equal keys are joined in outer order.
+ */
+static int
+batch_key_cmp(const void *a, const void *b, void *arg)
+{
+	NestLoopState *node = (NestLoopState *) arg;
+	int			ia = *(const int *) a;
+	int			ib = *(const int *) b;
+	int			compare;
+
+	compare = ApplySortComparator(node->nl_BatchKeys[ia],
+								  node->nl_BatchNulls[ia],
+								  node->nl_BatchKeys[ib],
+								  node->nl_BatchNulls[ib],
+								  node->nl_BatchSortKey);
+	if (compare != 0)
+		return compare;
+	return (ia > ib) - (ia < ib);
+}
+
 /* ----------------------------------------------------------------
  *		ExecInitNestLoop
  * ----------------------------------------------------------------
@@ -301,6 +385,17 @@ ExecInitNestLoop(NestLoop *node, EState *estate, int eflags)
 		eflags &= ~EXEC_FLAG_REWIND;
 	innerPlanState(nlstate) = ExecInitNode(innerPlan(node), estate, eflags);
 
+	/*
+	 * When batching, the outer tuples seen by our expressions are the copies
+	 * in the batch slots, not the outer plan's result slots.
+	 */
+	if (node->batchSize > 0)
+	{
+		nlstate->js.ps.outeropsset = true;
+		nlstate->js.ps.outeropsfixed = true;
+		nlstate->js.ps.outerops = &TTSOpsMinimalTuple;
+	}
+
 	/*
 	 * Initialize result slot, type and projection.
 	 */
@@ -340,6 +435,46 @@ ExecInitNestLoop(NestLoop *node, EState *estate, int eflags)
 				 (int) node->join.jointype);
 	}
 
+	/*
+	 * If the planner asked for batching, set up space for a batch of outer
+	 * tuples and their keys, and tell the inner index scan that its rescans
+	 * will move forward through the index.
+	 */
+	if (node->batchSize > 0)
+	{
+		TupleDesc	outerDesc = ExecGetResultType(outerPlanState(nlstate));
+		SortSupport sortKey;
+		int			i;
+
+		Assert(list_length(node->nestParams) == 1);
+		Assert(IsA(innerPlanState(nlstate), IndexScanState));
+
+		nlstate->nl_BatchSlots = (TupleTableSlot **)
+			palloc(node->batchSize * sizeof(TupleTableSlot *));
+		for (i = 0; i < node->batchSize; i++)
+			nlstate->nl_BatchSlots[i] =
+				ExecInitExtraTupleSlot(estate, outerDesc,
+									   &TTSOpsMinimalTuple);
+		nlstate->nl_BatchKeys = (Datum *)
+			palloc(node->batchSize * sizeof(Datum));
+		nlstate->nl_BatchNulls = (bool *)
+			palloc(node->batchSize * sizeof(bool));
+		nlstate->nl_BatchOrder = (int *)
+			palloc(node->batchSize * sizeof(int));
+
+		sortKey = (SortSupport) palloc0(sizeof(SortSupportData));
+		sortKey->ssup_cxt = CurrentMemoryContext;
+		sortKey->ssup_collation = node->batchCollation;
+		sortKey->ssup_nulls_first = false;
+		PrepareSortSupportFromOrderingOp(node->batchSortOp, sortKey);
+		nlstate->nl_BatchSortKey = sortKey;
+
+		((IndexScanState *) innerPlanState(nlstate))->iss_OrderedRescans = true;
+	}
+	nlstate->nl_BatchCount = 0;
+	nlstate->nl_BatchNext = 0;
+	nlstate->nl_OuterDone = false;
+
 	/*
 	 * finally, wipe the current outer tuple clean.
 	 */
@@ -408,4 +543,7 @@ ExecReScanNestLoop(NestLoopState *node)
 
 	node->nl_NeedNewOuter = true;
 	node->nl_MatchedOuter = false;
+	node->nl_BatchCount = 0;
+	node->nl_BatchNext = 0;
+	node->nl_OuterDone = false;
 }
@@ -0,0 +1,637 @@
+/*-------------------------------------------------------------------------
+ *
+ * nodeRedistribute.c
+ *	  Routines to exchange rows among parallel workers.
+ *
+ * Portions Copyright (c) 1996-2020, PostgreSQL Global Development Group
+ * Portions Copyright (c) 1994, Regents of the University of California
+ *
+ * A Redistribute node runs below a Gather or Gather Merge node, in each of
+ * the parallel workers.  Every worker reads the rows of its own copy of the
+ * subplan, and sends each row to the worker chosen by a hash of the key
+ * columns, through a shm_mq between each pair of workers.  Once all workers
+ * are done sending, each worker returns the rows it received, plus the rows
+ * it kept for itself.  So all rows with equal keys are returned by the same
+ * worker, which lets the nodes above compute e.g. window functions over
+ * each partition in parallel.
+ *
+ * Only the workers that were actually launched take part, and they cannot
+ * know how many there are before the leader has launched them all, so they
+ * wait for the leader to tell them.  The leader doesn't take part, since it
+ * also has to read the tuple queues of the Gather node; with workers running,
+ * its copy of the node returns no rows.  If no workers could be launched, or
+ * the plan isn't running in parallel mode at all, the leader returns all rows
+ * of the subplan itself.
+ *
+ * IDENTIFICATION
+ *	  src/backend/executor/nodeRedistribute.c
+ *
+ *-------------------------------------------------------------------------
+ */
+/*
+ * INTERFACE ROUTINES
+ *		ExecRedistribute			- exchange and return rows of the subplan
+ *		ExecInitRedistribute		- initialize node and subnodes
+ *		ExecEndRedistribute			- shutdown node and subnodes
+ *
+ */
+#include "postgres.h"
+
+#include "executor/executor.h"
+#include "executor/nodeRedistribute.h"
+#include "miscadmin.h"
+#include "pgstat.h"
+#include "storage/condition_variable.h"
+#include "storage/latch.h"
+#include "storage/shm_mq.h"
+#include "storage/spin.h"
+#include "utils/lsyscache.h"
+
+/* size of the queue between each pair of workers */
+#define REDISTRIBUTE_QUEUE_SIZE		16384
+
+/* number of rows read from the subplan between checks for incoming rows */
+#define REDISTRIBUTE_POLL_INTERVAL	64
+
+/*
+ * Shared state, followed by nworkers * nworkers queues.  The queue from
+ * worker i to worker j is the (i * nworkers + j)th one; the queues from a
+ * worker to itself are not used.
+ */
+typedef struct RedistributeShared
+{
+	slock_t		mutex;
+	int			nparticipants;	/* number of workers launched, or -1 if the
+								 * leader hasn't launched them yet */
+	ConditionVariable cv;		/* signaled when nparticipants is set */
+	int			nworkers;		/* number of workers planned */
+} RedistributeShared;
+
+#define RedistributeQueue(shared, sender, receiver) \
+	((shm_mq *) ((char *) (shared) + MAXALIGN(sizeof(RedistributeShared)) + \
+				 ((Size) (sender) * (shared)->nworkers + (receiver)) * \
+				 REDISTRIBUTE_QUEUE_SIZE))
+
+static TupleTableSlot *ExecRedistribute(PlanState *pstate);
+static void redistribute_rows(RedistributeState *node);
+static uint32 redistribute_hash(RedistributeState *node, TupleTableSlot *slot);
+static void redistribute_send(RedistributeState *node, int receiver,
+							  TupleTableSlot *slot);
+static bool redistribute_receive(RedistributeState *node);
+static void redistribute_wait(void);
+static void redistribute_detach(RedistributeState *node);
+
+
+/* ----------------------------------------------------------------
+ *		ExecRedistribute
+ *
+ *		In a worker, the first call exchanges all rows of the subplan with
+ *		the other workers, and collects the rows that belong to this worker
+ *		in a tuplestore.  Each call then returns the next row from there.
+ * ----------------------------------------------------------------
+ */
+static TupleTableSlot *
+ExecRedistribute(PlanState *pstate)
+{
+	RedistributeState *node = castNode(RedistributeState, pstate);
+	TupleTableSlot *slot = node->ps.ps_ResultTupleSlot;
+
+	CHECK_FOR_INTERRUPTS();
+
+	if (!IsParallelWorker())
+	{
+		/* the workers, if any, have been launched before we get here */
+		Assert(node->shared == NULL || node->nparticipants >= 0);
+
+		if (node->shared != NULL && node->nparticipants > 0)
+			return NULL;
+		return ExecProcNode(outerPlanState(node));
+	}
+
+	if (node->tuplestore == NULL)
+		redistribute_rows(node);
+
+	(void) tuplestore_gettupleslot(node->tuplestore, true, false, slot);
+	return slot;
+}
+
+/*
+ * Exchange all rows of the subplan with the other workers, and put the ones
+ * that belong to this worker into a new tuplestore.
+ */
+static void
+redistribute_rows(RedistributeState *node)
+{
+	RedistributeShared *shared = node->shared;
+	PlanState  *outerNode = outerPlanState(node);
+	int			nworkers = shared->nworkers;
+	int			i;
+
+	/* wait for the leader to tell us how many workers take part */
+	for (;;)
+	{
+		SpinLockAcquire(&shared->mutex);
+		node->nparticipants = shared->nparticipants;
+		SpinLockRelease(&shared->mutex);
+
+		if (node->nparticipants >= 0)
+			break;
+		ConditionVariableSleep(&shared->cv, WAIT_EVENT_EXECUTE_REDISTRIBUTE);
+	}
+	ConditionVariableCancelSleep();
+
+	Assert(ParallelWorkerNumber < node->nparticipants);
+
+	/* we won't hear from workers that were never launched */
+	for (i = node->nparticipants; i < nworkers; i++)
+	{
+		shm_mq_detach(node->outqueues[i]);
+		node->outqueues[i] = NULL;
+		shm_mq_detach(node->inqueues[i]);
+		node->inqueues[i] = NULL;
+	}
+	node->ninqueues = node->nparticipants - 1;
+
+	node->tuplestore = tuplestore_begin_heap(false, false, work_mem);
+
+	/*
+	 * Send each row of the subplan to its worker.  Check for incoming rows
+	 * every now and then, so that the other workers don't have to wait for
+	 * us to fill their queues to us.
+	 */
+	for (;;)
+	{
+		TupleTableSlot *slot = ExecProcNode(outerNode);
+		int			receiver;
+
+		if (TupIsNull(slot))
+			break;
+
+		receiver = redistribute_hash(node, slot) % node->nparticipants;
+		if (receiver == ParallelWorkerNumber)
+			tuplestore_puttupleslot(node->tuplestore, slot);
+		else
+			redistribute_send(node, receiver, slot);
+
+		if (++node->nread % REDISTRIBUTE_POLL_INTERVAL == 0)
+			(void) redistribute_receive(node);
+	}
+
+	/* let the other workers know we're done sending */
+	for (i = 0; i < nworkers; i++)
+	{
+		if (node->outqueues[i] != NULL)
+		{
+			shm_mq_detach(node->outqueues[i]);
+			node->outqueues[i] = NULL;
+		}
+	}
+
+	/* receive the rest of our rows, until they are done sending as well */
+	while (node->ninqueues > 0)
+	{
+		if (!redistribute_receive(node))
+			redistribute_wait();
+	}
+}
+
+/*
+ * Compute the hash value of the key columns of a row, the same way that
+ * ExecHashGetHashValue() does.
+ */
+static uint32
+redistribute_hash(RedistributeState *node, TupleTableSlot *slot)
+{
+	Redistribute *plan = (Redistribute *) node->ps.plan;
+	ExprContext *econtext = node->ps.ps_ExprContext;
+	MemoryContext oldContext;
+	uint32		hashkey = 0;
+	int			i;
+
+	ResetExprContext(econtext);
+	oldContext = MemoryContextSwitchTo(econtext->ecxt_per_tuple_memory);
+
+	for (i = 0; i < plan->numCols; i++)
+	{
+		Datum		keyval;
+		bool		isNull;
+
+		/* rotate hashkey left 1 bit at each step */
+		hashkey = (hashkey << 1) | ((hashkey & 0x80000000) ? 1 : 0);
+
+		keyval = slot_getattr(slot, plan->hashColIdx[i], &isNull);
+
+		/* NULLs hash to 0, leaving hashkey unmodified */
+		if (!isNull)
+		{
+			uint32		hkey;
+
+			hkey = DatumGetUInt32(FunctionCall1Coll(&node->hashfunctions[i],
+													plan->collations[i],
+													keyval));
+			hashkey ^= hkey;
+		}
+	}
+
+	MemoryContextSwitchTo(oldContext);
+
+	return hashkey;
+}
+
+/*
+ * Send a row to another worker.  While its queue is full, receive rows from
+ * the other workers, since they might be waiting for us to make room in
+ * their queues, too.  If the receiver has stopped, the row is dropped.
+ */
+static void
+redistribute_send(RedistributeState *node, int receiver, TupleTableSlot *slot)
+{
+	shm_mq_handle *mqh = node->outqueues[receiver];
+	MinimalTuple tuple;
+	bool		shouldFree;
+	shm_mq_result result;
+
+	if (mqh == NULL)
+		return;
+
+	tuple = ExecFetchSlotMinimalTuple(slot, &shouldFree);
+
+	for (;;)
+	{
+		result = shm_mq_send(mqh, tuple->t_len, tuple, true);
+		if (result != SHM_MQ_WOULD_BLOCK)
+			break;
+		if (!redistribute_receive(node))
+			redistribute_wait();
+	}
+
+	if (shouldFree)
+		pfree(tuple);
+
+	if (result == SHM_MQ_DETACHED)
+	{
+		shm_mq_detach(mqh);
+		node->outqueues[receiver] = NULL;
+	}
+	else if (result != SHM_MQ_SUCCESS)
+		ereport(ERROR,
+				(errcode(ERRCODE_OBJECT_NOT_IN_PREREQUISITE_STATE),
+				 errmsg("could not send tuple to shared-memory queue")));
+}
+
+/*
+ * Put all rows that are available from the other workers into the
+ * tuplestore, without waiting.  Returns true if any rows were received, or
+ * any worker turned out to be done sending.
+ */
+static bool
+redistribute_receive(RedistributeState *node)
+{
+	bool		progress = false;
+	int			i;
+
+	for (i = 0; i < node->nparticipants; i++)
+	{
+		shm_mq_handle *mqh = node->inqueues[i];
+
+		while (mqh != NULL)
+		{
+			shm_mq_result result;
+			Size		nbytes;
+			void	   *data;
+
+			result = shm_mq_receive(mqh, &nbytes, &data, true);
+			if (result == SHM_MQ_WOULD_BLOCK)
+				break;
+
+			progress = true;
+			if (result == SHM_MQ_DETACHED)
+			{
+				shm_mq_detach(mqh);
+				node->inqueues[i] = mqh = NULL;
+				node->ninqueues--;
+				break;
+			}
+
+			ExecStoreMinimalTuple((MinimalTuple) data, node->recvslot, false);
+			tuplestore_puttupleslot(node->tuplestore, node->recvslot);
+		}
+	}
+
+	ExecClearTuple(node->recvslot);
+
+	return progress;
+}
+
+/*
+ * Wait until another worker has sent us something, or made room in one of
+ * our queues to it.
+ */
+static void
+redistribute_wait(void)
+{
+	(void) WaitLatch(MyLatch, WL_LATCH_SET | WL_EXIT_ON_PM_DEATH, 0,
+					 WAIT_EVENT_EXECUTE_REDISTRIBUTE);
+	ResetLatch(MyLatch);
+	CHECK_FOR_INTERRUPTS();
+}
+
+/*
+ * Detach from all queues that are still attached.
+ */
+static void
+redistribute_detach(RedistributeState *node)
+{
+	int			i;
+
+	if (node->outqueues == NULL)
+		return;
+
+	for (i = 0; i < node->shared->nworkers; i++)
+	{
+		if (node->outqueues[i] != NULL)
+		{
+			shm_mq_detach(node->outqueues[i]);
+			node->outqueues[i] = NULL;
+		}
+		if (node->inqueues[i] != NULL)
+		{
+			shm_mq_detach(node->inqueues[i]);
+			node->inqueues[i] = NULL;
+		}
+	}
+	node->ninqueues = 0;
+}
+
+/* ----------------------------------------------------------------
+ *		ExecInitRedistribute
+ * ----------------------------------------------------------------
+ */
+RedistributeState *
+ExecInitRedistribute(Redistribute *node, EState *estate, int eflags)
+{
+	RedistributeState *rstate;
+	int			i;
+
+	/* check for unsupported flags */
+	Assert(!(eflags & (EXEC_FLAG_BACKWARD | EXEC_FLAG_MARK)));
+
+	/*
+	 * create state structure
+	 */
+	rstate = makeNode(RedistributeState);
+	rstate->ps.plan = (Plan *) node;
+	rstate->ps.state = estate;
+	rstate->ps.ExecProcNode = ExecRedistribute;
+	rstate->nparticipants = -1;
+
+	/*
+	 * Miscellaneous initialization
+	 *
+	 * create expression context for hashing the keys
+	 */
+	ExecAssignExprContext(estate, &rstate->ps);
+
+	/*
+	 * initialize child nodes
+	 */
+	outerPlanState(rstate) = ExecInitNode(outerPlan(node), estate, eflags);
+
+	/*
+	 * Initialize result type and slot.  In the leader, the rows may come
+	 * straight from the subplan, so the slot type varies.  No need to
+	 * initialize projection info because this node doesn't do projections.
+	 */
+	ExecInitResultTupleSlotTL(&rstate->ps, &TTSOpsMinimalTuple);
+	rstate->ps.resultopsset = true;
+	rstate->ps.resultopsfixed = false;
+	rstate->ps.ps_ProjInfo = NULL;
+
+	rstate->recvslot = ExecInitExtraTupleSlot(estate,
+											  ExecGetResultType(outerPlanState(rstate)),
+											  &TTSOpsMinimalTuple);
+
+	/*
+	 * Look up the hash functions of the keys
+	 */
+	rstate->hashfunctions = (FmgrInfo *) palloc(node->numCols * sizeof(FmgrInfo));
+	for (i = 0; i < node->numCols; i++)
+	{
+		Oid			lhs_hashfn;
+		Oid			rhs_hashfn;
+
+		if (!get_op_hash_functions(node->hashOperators[i],
+								   &lhs_hashfn, &rhs_hashfn))
+			elog(ERROR, "could not find hash function for hash operator %u",
+				 node->hashOperators[i]);
+		fmgr_info(lhs_hashfn, &rstate->hashfunctions[i]);
+	}
+
+	return rstate;
+}
+
+/* ----------------------------------------------------------------
+ *		ExecEndRedistribute
+ * ----------------------------------------------------------------
+ */
+void
+ExecEndRedistribute(RedistributeState *node)
+{
+	/*
+	 * let the other workers know we're gone
+	 */
+	redistribute_detach(node);
+
+	/*
+	 * Release tuplestore resources
+	 */
+	if (node->tuplestore != NULL)
+		tuplestore_end(node->tuplestore);
+	node->tuplestore = NULL;
+
+	/*
+	 * Free the exprcontext
+	 */
+	ExecFreeExprContext(&node->ps);
+
+	/*
+	 * clean out the tuple table
+	 */
+	ExecClearTuple(node->ps.ps_ResultTupleSlot);
+
+	/*
+	 * shut down the subplan
+	 */
+	ExecEndNode(outerPlanState(node));
+}
+
+/* ----------------------------------------------------------------
+ *		ExecReScanRedistribute
+ *
+ *		Only the leader can be rescanned, when the Gather node above it is.
+ *		The shared state is reset by ExecRedistributeReInitializeDSM, before
+ *		the workers are launched again.
+ * ----------------------------------------------------------------
+ */
+void
+ExecReScanRedistribute(RedistributeState *node)
+{
+	PlanState  *outerPlan = outerPlanState(node);
+
+	if (IsParallelWorker())
+		elog(ERROR, "cannot rescan a Redistribute node in a parallel worker");
+
+	ExecClearTuple(node->ps.ps_ResultTupleSlot);
+	node->nparticipants = -1;
+
+	/*
+	 * if chgParam of subnode is not null then plan will be re-scanned by
+	 * first ExecProcNode.
+	 */
+	if (outerPlan->chgParam == NULL)
+		ExecReScan(outerPlan);
+}
+
+/* ----------------------------------------------------------------
+ *						Parallel Query Support
+ * ----------------------------------------------------------------
+ */
+
+/* ----------------------------------------------------------------
+ *		ExecRedistributeEstimate
+ *
+ *		Estimate space required for the shared state and the queues.
+ * ----------------------------------------------------------------
+ */
+void
+ExecRedistributeEstimate(RedistributeState *node, ParallelContext *pcxt)
+{
+	Size		size;
+
+	size = mul_size(mul_size(pcxt->nworkers, pcxt->nworkers),
+					REDISTRIBUTE_QUEUE_SIZE);
+	size = add_size(size, MAXALIGN(sizeof(RedistributeShared)));
+	shm_toc_estimate_chunk(&pcxt->estimator, size);
+	shm_toc_estimate_keys(&pcxt->estimator, 1);
+}
+
+/* ----------------------------------------------------------------
+ *		ExecRedistributeInitializeDSM
+ *
+ *		Set up the shared state and the queues between the workers.
+ * ----------------------------------------------------------------
+ */
+void
+ExecRedistributeInitializeDSM(RedistributeState *node, ParallelContext *pcxt)
+{
+	RedistributeShared *shared;
+	Size		size;
+
+	size = MAXALIGN(sizeof(RedistributeShared)) +
+		(Size) pcxt->nworkers * pcxt->nworkers * REDISTRIBUTE_QUEUE_SIZE;
+	shared = shm_toc_allocate(pcxt->toc, size);
+	SpinLockInit(&shared->mutex);
+	ConditionVariableInit(&shared->cv);
+	shared->nworkers = pcxt->nworkers;
+	node->shared = shared;
+
+	ExecRedistributeReInitializeDSM(node, pcxt);
+
+	shm_toc_insert(pcxt->toc, node->ps.plan->plan_node_id, shared);
+}
+
+/* ----------------------------------------------------------------
+ *		ExecRedistributeReInitializeDSM
+ *
+ *		Reset the shared state and recreate the queues, before the workers
+ *		are launched again.
+ * ----------------------------------------------------------------
+ */
+void
+ExecRedistributeReInitializeDSM(RedistributeState *node,
+								ParallelContext *pcxt)
+{
+	RedistributeShared *shared = node->shared;
+	int			i;
+	int			j;
+
+	shared->nparticipants = -1;
+
+	for (i = 0; i < shared->nworkers; i++)
+	{
+		for (j = 0; j < shared->nworkers; j++)
+		{
+			if (i != j)
+				(void) shm_mq_create(RedistributeQueue(shared, i, j),
+									 REDISTRIBUTE_QUEUE_SIZE);
+		}
+	}
+}
+
+/* ----------------------------------------------------------------
+ *		ExecRedistributeInitializeWorker
+ *
+ *		Attach worker to the queues from and to each other worker.
+ * ----------------------------------------------------------------
+ */
+void
+ExecRedistributeInitializeWorker(RedistributeState *node,
+								 ParallelWorkerContext *pwcxt)
+{
+	RedistributeShared *shared;
+	MemoryContext oldcontext;
+	int			me = ParallelWorkerNumber;
+	int			i;
+
+	shared = shm_toc_lookup(pwcxt->toc, node->ps.plan->plan_node_id, false);
+	node->shared = shared;
+
+	oldcontext = MemoryContextSwitchTo(node->ps.state->es_query_cxt);
+	node->outqueues = (shm_mq_handle **)
+		palloc0(shared->nworkers * sizeof(shm_mq_handle *));
+	node->inqueues = (shm_mq_handle **)
+		palloc0(shared->nworkers * sizeof(shm_mq_handle *));
+
+	for (i = 0; i < shared->nworkers; i++)
+	{
+		shm_mq	   *mq;
+
+		if (i == me)
+			continue;
+
+		mq = RedistributeQueue(shared, me, i);
+		shm_mq_set_sender(mq, MyProc);
+		node->outqueues[i] = shm_mq_attach(mq, pwcxt->seg, NULL);
+
+		mq = RedistributeQueue(shared, i, me);
+		shm_mq_set_receiver(mq, MyProc);
+		node->inqueues[i] = shm_mq_attach(mq, pwcxt->seg, NULL);
+	}
+	MemoryContextSwitchTo(oldcontext);
+}
+
+/* ----------------------------------------------------------------
+ *		ExecRedistributeWorkersLaunched
+ *
+ *		Tell the workers how many of them were launched, once they have all
+ *		started up.  Waiting for that makes sure that a worker that failed to
+ *		start raises an error, instead of leaving the others waiting for its
+ *		rows forever.
+ * ----------------------------------------------------------------
+ */
+void
+ExecRedistributeWorkersLaunched(RedistributeState *node,
+								ParallelContext *pcxt)
+{
+	RedistributeShared *shared = node->shared;
+
+	if (pcxt->nworkers_launched > 0)
+		WaitForParallelWorkersToAttach(pcxt);
+
+	node->nparticipants = pcxt->nworkers_launched;
+
+	SpinLockAcquire(&shared->mutex);
+	shared->nparticipants = node->nparticipants;
+	SpinLockRelease(&shared->mutex);
+	ConditionVariableBroadcast(&shared->cv);
+}
@@ -16,6 +16,7 @@
  * INTERFACE ROUTINES
  *		ExecSeqScan				sequentially scans a relation.
  *		ExecSeqNext				retrieve next tuple in sequential order.
+ *		ExecSeqScanBatch		retrieve next batch of qualifying tuples.
  *		ExecInitSeqScan			creates and initializes a seqscan node.
  *		ExecEndSeqScan			releases any storage allocated.
  *		ExecReScanSeqScan		rescans the relation
@@ -29,11 +30,14 @@
 
 #include "access/relscan.h"
 #include "access/tableam.h"
+#include "executor/execBatch.h"
 #include "executor/execdebug.h"
 #include "executor/nodeSeqscan.h"
+#include "miscadmin.h"
 #include "utils/rel.h"
 
 static TupleTableSlot *SeqNext(SeqScanState *node);
+static TupleBatch *ExecSeqScanBatch(PlanState *pstate);
 
 /* ----------------------------------------------------------------
  *						Scan Support
@@ -114,6 +118,78 @@ ExecSeqScan(PlanState *pstate)
 					(ExecScanRecheckMtd) SeqRecheck);
 }
 
+/* ----------------------------------------------------------------
+ *		ExecSeqScanBatch(node)
+ *
+ *		Returns the next batch of qualifying tuples, or NULL at the end of
+ *		the scan.  Only used if the scan needs no projection, see
+ *		ExecInitSeqScan.
+ * ----------------------------------------------------------------
+ */
+static TupleBatch *
+ExecSeqScanBatch(PlanState *pstate)
+{
+	SeqScanState *node = castNode(SeqScanState, pstate);
+	EState	   *estate = node->ss.ps.state;
+	Relation	rel = node->ss.ss_currentRelation;
+	TableScanDesc scandesc;
+	TupleBatch *batch;
+
+	Assert(ScanDirectionIsForward(estate->es_direction));
+
+	/* the AM mustn't be called again once it has reported the end */
+	if (node->batch_done)
+		return NULL;
+
+	batch = node->batch;
+	if (batch == NULL)
+	{
+		batch = ExecCreateBatch(estate, RelationGetDescr(rel),
+								table_slot_callbacks(rel),
+								Max(executor_batch_size, 1));
+		node->batch = batch;
+	}
+
+	scandesc = node->ss.ss_currentScanDesc;
+	if (scandesc == NULL)
+	{
+		/* see SeqNext */
+		scandesc = table_beginscan(rel, estate->es_snapshot, 0, NULL);
+		node->ss.ss_currentScanDesc = scandesc;
+	}
+
+	do
+	{
+		int			prev_ntuples = batch->ntuples;
+		int			i;
+
+		CHECK_FOR_INTERRUPTS();
+
+		batch->ntuples = table_scan_getnextbatch(scandesc,
+												 ForwardScanDirection,
+												 batch->slots,
+												 batch->maxtuples);
+
+		/* release whatever the unused slots still hold */
+		for (i = batch->ntuples; i < prev_ntuples; i++)
+			ExecClearTuple(batch->slots[i]);
+
+		if (batch->ntuples < batch->maxtuples)
+			node->batch_done = true;
+
+		if (batch->ntuples == 0)
+		{
+			batch->nselected = 0;
+			return NULL;
+		}
+
+		ExecBatchQual(node->batchqual, batch, node->ss.ps.ps_ExprContext);
+		InstrCountFiltered1(node, batch->ntuples - batch->nselected);
+	} while (batch->nselected == 0 && !node->batch_done);
+
+	return batch->nselected > 0 ? batch : NULL;
+}
+
 
 /* ----------------------------------------------------------------
  *		ExecInitSeqScan
@@ -171,6 +247,23 @@ ExecInitSeqScan(SeqScan *node, EState *estate, int eflags)
 	scanstate->ss.ps.qual =
 		ExecInitQual(node->plan.qual, (PlanState *) scanstate);
 
+	/*
+	 * Offer the batch protocol to our parent, if the table AM supports it
+	 * and we don't need to project.  It's never used for EvalPlanQual
+	 * rechecks or backward scans.
+	 */
+	if (executor_batch_size > 0 &&
+		scanstate->ss.ps.ps_ProjInfo == NULL &&
+		estate->es_epq_active == NULL &&
+		!(eflags & EXEC_FLAG_BACKWARD) &&
+		scanstate->ss.ss_currentRelation->rd_tableam->scan_getnextbatch != NULL)
+	{
+		scanstate->batchqual = ExecInitBatchQual(node->plan.qual,
+												 scanstate->ss.ps.qual,
+												 (PlanState *) scanstate);
+		scanstate->ss.ps.ExecProcNodeBatch = ExecSeqScanBatch;
+	}
+
 	return scanstate;
 }
 
@@ -201,6 +294,8 @@ ExecEndSeqScan(SeqScanState *node)
 	if (node->ss.ps.ps_ResultTupleSlot)
 		ExecClearTuple(node->ss.ps.ps_ResultTupleSlot);
 	ExecClearTuple(node->ss.ss_ScanTupleSlot);
+	if (node->batch)
+		ExecClearBatch(node->batch);
 
 	/*
 	 * close heap scan
@@ -231,6 +326,10 @@ ExecReScanSeqScan(SeqScanState *node)
 		table_rescan(scan,		/* scan desc */
 					 NULL);		/* new scan keys */
 
+	if (node->batch)
+		ExecClearBatch(node->batch);
+	node->batch_done = false;
+
 	ExecScanReScan((ScanState *) node);
 }
 
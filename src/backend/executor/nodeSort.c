@@ -16,12 +16,17 @@
 #include "postgres.h"
 
 #include "access/parallel.h"
+#include "access/tableam.h"
 #include "executor/execdebug.h"
 #include "executor/nodeSort.h"
 #include "miscadmin.h"
 #include "utils/tuplesort.h"
 
 
+static void sort_put_narrow_tuple(SortState *node, TupleTableSlot *slot);
+static TupleTableSlot *sort_late_materialize(SortState *node);
+
+
 /* ----------------------------------------------------------------
  *		ExecSort
  *
@@ -29,6 +34,12 @@
  *		which saves the results in a temporary file or memory. After the
  *		initial call, returns a tuple from the file with each call.
  *
+ *		If the sort is late-materialized, the wide columns of the input
+ *		are replaced by nulls before the tuples go into tuplesort, and
+ *		are fetched again from the table, using the TID carried along in
+ *		the sorted tuple, as each tuple is returned.  Under a LIMIT, this
+ *		copies only the sort keys of all the rows that are discarded.
+ *
  *		Conditions:
  *		  -- none.
  *
@@ -109,7 +120,10 @@ ExecSort(PlanState *pstate)
 			if (TupIsNull(slot))
 				break;
 
-			tuplesort_puttupleslot(tuplesortstate, slot);
+			if (node->late_rel != NULL)
+				sort_put_narrow_tuple(node, slot);
+			else
+				tuplesort_puttupleslot(tuplesortstate, slot);
 		}
 
 		/*
@@ -148,6 +162,14 @@ ExecSort(PlanState *pstate)
 	 * tuples.  Note that we only rely on slot tuple remaining valid until the
 	 * next fetch from the tuplesort.
 	 */
+	if (node->late_rel != NULL)
+	{
+		(void) tuplesort_gettupleslot(tuplesortstate,
+									  ScanDirectionIsForward(dir),
+									  false, node->late_sortslot, NULL);
+		return sort_late_materialize(node);
+	}
+
 	slot = node->ss.ps.ps_ResultTupleSlot;
 	(void) tuplesort_gettupleslot(tuplesortstate,
 								  ScanDirectionIsForward(dir),
@@ -155,6 +177,92 @@ ExecSort(PlanState *pstate)
 	return slot;
 }
 
+/*
+ * Feed a tuple to tuplesort with its late-materialized columns set to null,
+ * so that they take no space in the sorted tuple.
+ */
+static void
+sort_put_narrow_tuple(SortState *node, TupleTableSlot *slot)
+{
+	TupleTableSlot *narrow = node->ss.ss_ScanTupleSlot;
+	int			natts = narrow->tts_tupleDescriptor->natts;
+	int			i;
+
+	slot_getallattrs(slot);
+
+	ExecClearTuple(narrow);
+	for (i = 0; i < natts; i++)
+	{
+		if (node->late_cols[i])
+		{
+			narrow->tts_values[i] = (Datum) 0;
+			narrow->tts_isnull[i] = true;
+		}
+		else
+		{
+			narrow->tts_values[i] = slot->tts_values[i];
+			narrow->tts_isnull[i] = slot->tts_isnull[i];
+		}
+	}
+	ExecStoreVirtualTuple(narrow);
+
+	/* tuplesort copies the values, so the input slot may move on */
+	tuplesort_puttupleslot((Tuplesortstate *) node->tuplesortstate, narrow);
+}
+
+/*
+ * Build the result tuple from the narrow tuple in late_sortslot, refetching
+ * the late-materialized columns from the table.  The result stays valid
+ * until the next fetch, like a tuple returned directly from tuplesort.
+ */
+static TupleTableSlot *
+sort_late_materialize(SortState *node)
+{
+	Sort	   *plannode = (Sort *) node->ss.ps.plan;
+	TupleTableSlot *sorted = node->late_sortslot;
+	TupleTableSlot *fetched = node->late_fetchslot;
+	TupleTableSlot *slot = node->ss.ps.ps_ResultTupleSlot;
+	int			natts = slot->tts_tupleDescriptor->natts;
+	AttrNumber	tidcol = plannode->lateTidColIdx - 1;
+	ItemPointer tid;
+	int			i;
+
+	ExecClearTuple(slot);
+	if (TupIsNull(sorted))
+		return slot;
+
+	slot_getallattrs(sorted);
+	memcpy(slot->tts_values, sorted->tts_values, natts * sizeof(Datum));
+	memcpy(slot->tts_isnull, sorted->tts_isnull, natts * sizeof(bool));
+
+	Assert(!sorted->tts_isnull[tidcol]);
+	tid = (ItemPointer) DatumGetPointer(sorted->tts_values[tidcol]);
+
+	/*
+	 * The scan saw this row version under the same snapshot, so it must
+	 * still be visible to us.
+	 */
+	if (!table_tuple_fetch_row_version(node->late_rel, tid,
+									   node->ss.ps.state->es_snapshot,
+									   fetched))
+		elog(ERROR, "failed to refetch tuple (%u,%u) in relation \"%s\"",
+			 ItemPointerGetBlockNumber(tid),
+			 ItemPointerGetOffsetNumber(tid),
+			 RelationGetRelationName(node->late_rel));
+
+	slot_getallattrs(fetched);
+	for (i = 0; i < plannode->numLateCols; i++)
+	{
+		AttrNumber	col = plannode->lateColIdx[i] - 1;
+		AttrNumber	attno = plannode->lateAttNums[i] - 1;
+
+		slot->tts_values[col] = fetched->tts_values[attno];
+		slot->tts_isnull[col] = fetched->tts_isnull[attno];
+	}
+
+	return ExecStoreVirtualTuple(slot);
+}
+
 /* ----------------------------------------------------------------
  *		ExecInitSort
  *
@@ -216,8 +324,29 @@ ExecInitSort(Sort *node, EState *estate, int eflags)
 	/*
 	 * Initialize return slot and type. No need to initialize projection info
 	 * because this node doesn't do projections.
+	 *
+	 * A late-materialized sort assembles its result tuples from the sorted
+	 * tuple and the refetched row, so it returns virtual tuples.
 	 */
-	ExecInitResultTupleSlotTL(&sortstate->ss.ps, &TTSOpsMinimalTuple);
+	if (node->lateRelid != 0)
+	{
+		TupleDesc	tupDesc = ExecGetResultType(outerPlanState(sortstate));
+		int			i;
+
+		ExecInitResultTupleSlotTL(&sortstate->ss.ps, &TTSOpsVirtual);
+
+		sortstate->late_rel = ExecGetRangeTableRelation(estate,
+														node->lateRelid);
+		sortstate->late_cols = (bool *) palloc0(tupDesc->natts * sizeof(bool));
+		for (i = 0; i < node->numLateCols; i++)
+			sortstate->late_cols[node->lateColIdx[i] - 1] = true;
+		sortstate->late_sortslot =
+			ExecInitExtraTupleSlot(estate, tupDesc, &TTSOpsMinimalTuple);
+		sortstate->late_fetchslot =
+			table_slot_create(sortstate->late_rel, &estate->es_tupleTable);
+	}
+	else
+		ExecInitResultTupleSlotTL(&sortstate->ss.ps, &TTSOpsMinimalTuple);
 	sortstate->ss.ps.ps_ProjInfo = NULL;
 
 	SO1_printf("ExecInitSort: %s\n",
@@ -242,6 +371,11 @@ ExecEndSort(SortState *node)
 	ExecClearTuple(node->ss.ss_ScanTupleSlot);
 	/* must drop pointer to sort result tuple */
 	ExecClearTuple(node->ss.ps.ps_ResultTupleSlot);
+	if (node->late_rel != NULL)
+	{
+		ExecClearTuple(node->late_sortslot);
+		ExecClearTuple(node->late_fetchslot);
+	}
 
 	/*
 	 * Release tuplesort resources
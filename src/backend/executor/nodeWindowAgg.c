@@ -22,6 +22,12 @@
  * As required by the SQL spec, the output represents the value of the
  * aggregate function over all rows in the current row's window frame.
  *
+ * When the frame head can move, an aggregate without an inverse transition
+ * function would have to be recomputed from scratch for nearly every row.
+ * If it has a combine function, we instead keep a segment tree of partial
+ * aggregate states over the partition, from which the state for any frame
+ * can be assembled by combining O(log N) partial states.
+ *
  *
  * Portions Copyright (c) 1996-2020, PostgreSQL Global Development Group
  * Portions Copyright (c) 1994, Regents of the University of California
@@ -156,8 +162,70 @@ typedef struct WindowStatePerAggData
 
 	/* Data local to eval_windowaggregates() */
 	bool		restart;		/* need to restart this agg in this cycle? */
+
+	/*
+	 * Fields for computing the aggregate using a segment tree, see
+	 * eval_segtree_aggregates().  The tree is in the partition's memory.
+	 */
+	bool		use_segtree;	/* compute using segment tree? */
+	Oid			combinefn_oid;	/* valid if use_segtree */
+	FmgrInfo	combinefn;
+	struct WindowSegTree *segtree;	/* NULL until built for the partition */
 } WindowStatePerAggData;
 
+/*
+ * Segment tree of partial aggregate states
+ *
+ * Each leaf holds the transition state of the aggregate over a single row of
+ * the partition (or the initial state, if the row was filtered out), and
+ * each inner node holds the result of combining its two children.  The
+ * transition state for any range of rows can then be built by combining the
+ * states of at most O(log N) nodes, in row order.
+ *
+ * The leaves are added one row at a time as the frame end advances, and an
+ * inner node is filled in as soon as its right child is complete.  To avoid
+ * keeping partial states for the whole partition in memory, the lower part of
+ * the tree is divided into blocks of SEGTREE_BLOCK_SIZE leaves, each holding
+ * its own complete binary tree in the usual array layout (node 1 is the root,
+ * node n has children 2n and 2n+1, and the leaves start at node
+ * SEGTREE_BLOCK_SIZE).  Blocks that lie entirely before the frame head can
+ * never be needed again, since the frame head doesn't move backwards, and
+ * are freed.  The roots of complete blocks are copied to the upper tree,
+ * which is kept in a separate array for each level, and is small enough to
+ * be kept for the whole partition.
+ */
+#define SEGTREE_BLOCK_BITS		10
+#define SEGTREE_BLOCK_SIZE		(1 << SEGTREE_BLOCK_BITS)
+#define SEGTREE_MAX_LEVELS		64
+
+/*
+ * The maximum number of nodes combined for one range: two per level of a
+ * block's tree for the first and last block, plus two per level of the upper
+ * tree.
+ */
+#define SEGTREE_MAX_PARTS		(4 * SEGTREE_BLOCK_BITS + 2 * SEGTREE_MAX_LEVELS)
+
+typedef struct WindowSegTreeNode
+{
+	Datum		value;
+	bool		isnull;
+} WindowSegTreeNode;
+
+typedef struct WindowSegTreeBlock
+{
+	WindowSegTreeNode nodes[2 * SEGTREE_BLOCK_SIZE];	/* node 0 is unused */
+} WindowSegTreeBlock;
+
+typedef struct WindowSegTree
+{
+	int64		nleaves;		/* number of rows added so far */
+	int64		nfreed;			/* blocks before this one have been freed */
+	int64		maxblocks;		/* allocated length of blocks[] */
+	WindowSegTreeBlock **blocks;	/* blocks of lower tree */
+	int64		upperlen[SEGTREE_MAX_LEVELS];	/* allocated length of levels */
+	WindowSegTreeNode *upper[SEGTREE_MAX_LEVELS];	/* upper tree levels */
+} WindowSegTree;
+
 static void initialize_windowaggregate(WindowAggState *winstate,
 									   WindowStatePerFunc perfuncstate,
 									   WindowStatePerAgg peraggstate);
@@ -173,12 +241,31 @@ static void finalize_windowaggregate(WindowAggState *winstate,
 									 Datum *result, bool *isnull);
 
 static void eval_windowaggregates(WindowAggState *winstate);
+static void eval_segtree_aggregates(WindowAggState *winstate);
+static void segtree_add_leaf(WindowAggState *winstate,
+							 WindowStatePerAgg peraggstate, bool fetched);
+static void segtree_release_blocks(WindowStatePerAgg peraggstate,
+								   int64 pos);
+static int	segtree_get_parts(WindowSegTree *segtree, int64 start, int64 end,
+							  WindowSegTreeNode **parts);
+static int	segtree_block_parts(WindowSegTreeBlock *block, int l, int r,
+								WindowSegTreeNode **parts, int nparts);
+static void segtree_combine(WindowAggState *winstate,
+							WindowStatePerAgg peraggstate,
+							WindowSegTreeNode *left,
+							WindowSegTreeNode *right,
+							WindowSegTreeNode *result);
+static void segtree_store(WindowAggState *winstate,
+						  WindowStatePerAgg peraggstate,
+						  WindowSegTreeNode *node,
+						  Datum value, bool isnull);
 static void eval_windowfunction(WindowAggState *winstate,
 								WindowStatePerFunc perfuncstate,
 								Datum *result, bool *isnull);
 
 static void begin_partition(WindowAggState *winstate);
 static void spool_tuples(WindowAggState *winstate, int64 pos);
+static void skip_partition(WindowAggState *winstate);
 static void release_partition(WindowAggState *winstate);
 
 static int	row_is_in_frame(WindowAggState *winstate, int64 pos,
@@ -665,6 +752,7 @@ eval_windowaggregates(WindowAggState *winstate)
 	int			wfuncno,
 				numaggs,
 				numaggs_restart,
+				numaggs_segtree,
 				i;
 	int64		aggregatedupto_nonrestarted;
 	MemoryContext oldContext;
@@ -707,7 +795,10 @@ eval_windowaggregates(WindowAggState *winstate)
 	 * unable to remove the tuple from aggregation.  If this happens, or if
 	 * the aggregate doesn't have an inverse transition function at all, we
 	 * must perform the aggregation all over again for all tuples within the
-	 * new frame boundaries.
+	 * new frame boundaries.  Aggregates that have no inverse transition
+	 * function but do have a combine function are instead evaluated using a
+	 * segment tree of partial states, see eval_segtree_aggregates; they take
+	 * no part in the incremental processing described here.
 	 *
 	 * If there's any exclusion clause, then we may have to aggregate over a
 	 * non-contiguous set of rows, so we punt and recalculate for every row.
@@ -780,10 +871,16 @@ eval_windowaggregates(WindowAggState *winstate)
 	 *----------
 	 */
 	numaggs_restart = 0;
+	numaggs_segtree = 0;
 	for (i = 0; i < numaggs; i++)
 	{
 		peraggstate = &winstate->peragg[i];
-		if (winstate->currentpos == 0 ||
+		if (peraggstate->use_segtree)
+		{
+			peraggstate->restart = false;
+			numaggs_segtree++;
+		}
+		else if (winstate->currentpos == 0 ||
 			(winstate->aggregatedbase != winstate->frameheadpos &&
 			 !OidIsValid(peraggstate->invtransfn_oid)) ||
 			(winstate->frameOptions & FRAMEOPTION_EXCLUSION) ||
@@ -803,7 +900,7 @@ eval_windowaggregates(WindowAggState *winstate)
 	 * i.e. advance_windowaggregate_base() can return false, in which case
 	 * we'll restart that aggregate below.
 	 */
-	while (numaggs_restart < numaggs &&
+	while (numaggs_restart + numaggs_segtree < numaggs &&
 		   winstate->aggregatedbase < winstate->frameheadpos)
 	{
 		/*
@@ -826,7 +923,7 @@ eval_windowaggregates(WindowAggState *winstate)
 			bool		ok;
 
 			peraggstate = &winstate->peragg[i];
-			if (peraggstate->restart)
+			if (peraggstate->restart || peraggstate->use_segtree)
 				continue;
 
 			wfuncno = peraggstate->wfuncno;
@@ -879,6 +976,10 @@ eval_windowaggregates(WindowAggState *winstate)
 	{
 		peraggstate = &winstate->peragg[i];
 
+		/* Segment tree aggregates are dealt with below */
+		if (peraggstate->use_segtree)
+			continue;
+
 		/* Aggregates using the shared ctx must restart if *any* agg does */
 		Assert(peraggstate->aggcontext != winstate->aggcontext ||
 			   numaggs_restart == 0 ||
@@ -955,6 +1056,9 @@ eval_windowaggregates(WindowAggState *winstate)
 		{
 			peraggstate = &winstate->peragg[i];
 
+			if (peraggstate->use_segtree)
+				continue;
+
 			/* Non-restarted aggs skip until aggregatedupto_nonrestarted */
 			if (!peraggstate->restart &&
 				winstate->aggregatedupto < aggregatedupto_nonrestarted)
@@ -978,6 +1082,10 @@ next_tuple:
 	/* The frame's end is not supposed to move backwards, ever */
 	Assert(aggregatedupto_nonrestarted <= winstate->aggregatedupto);
 
+	/* Compute the transition values of the segment tree aggregates */
+	if (numaggs_segtree > 0)
+		eval_segtree_aggregates(winstate);
+
 	/*
 	 * finalize aggregates and fill result/isnull fields.
 	 */
@@ -1019,6 +1127,462 @@ next_tuple:
 	}
 }
 
+/*
+ * eval_segtree_aggregates
+ * compute the transition values of aggregates evaluated using a segment tree
+ *
+ * The segment trees are first extended to cover all rows up to the end of
+ * the current frame; then each aggregate's transValue is set to the
+ * combination of the partial states covering the frame, ready for
+ * finalize_windowaggregate.  The caller must have made frameheadpos valid.
+ */
+static void
+eval_segtree_aggregates(WindowAggState *winstate)
+{
+	WindowObject agg_winobj = winstate->agg_winobj;
+	TupleTableSlot *slot = winstate->temp_slot_1;
+	WindowSegTree *segtree = NULL;
+	int64		frameheadpos;
+	int64		frametailpos;
+	int64		pos;
+	int			numaggs = winstate->numaggs;
+	int			i;
+
+	update_frametailpos(winstate);
+	frameheadpos = winstate->frameheadpos;
+	frametailpos = winstate->frametailpos;
+
+	/* frametailpos can point past the end of the partition */
+	spool_tuples(winstate, frametailpos - 1);
+	if (frametailpos > winstate->spooled_rows)
+		frametailpos = winstate->spooled_rows;
+
+	for (i = 0; i < numaggs; i++)
+	{
+		WindowStatePerAgg peraggstate = &winstate->peragg[i];
+
+		if (!peraggstate->use_segtree)
+			continue;
+
+		/* Set up the tree on first use in this partition */
+		if (peraggstate->segtree == NULL)
+			peraggstate->segtree = (WindowSegTree *)
+				MemoryContextAllocZero(winstate->partcontext,
+									   sizeof(WindowSegTree));
+
+		/* Release the previous row's result and working data */
+		MemoryContextResetAndDeleteChildren(peraggstate->aggcontext);
+		peraggstate->resultValue = (Datum) 0;
+		peraggstate->resultValueIsNull = true;
+
+		/* All the trees cover the same rows */
+		Assert(segtree == NULL ||
+			   segtree->nleaves == peraggstate->segtree->nleaves);
+		segtree = peraggstate->segtree;
+	}
+
+	/*
+	 * Add the rows that aren't covered yet.  Rows before the frame head can
+	 * never be in a frame again, so we don't fetch them (the tuplestore may
+	 * have discarded them already); we just add initial states for them to
+	 * keep the trees contiguous.
+	 */
+	for (pos = segtree->nleaves; pos < frametailpos; pos++)
+	{
+		bool		fetched = false;
+
+		if (pos >= frameheadpos)
+		{
+			if (!window_gettupleslot(agg_winobj, pos, slot))
+				elog(ERROR, "could not fetch frame row");
+
+			/* Set tuple context for evaluation of aggregate arguments */
+			winstate->tmpcontext->ecxt_outertuple = slot;
+			fetched = true;
+		}
+
+		for (i = 0; i < numaggs; i++)
+		{
+			WindowStatePerAgg peraggstate = &winstate->peragg[i];
+
+			if (peraggstate->use_segtree)
+				segtree_add_leaf(winstate, peraggstate, fetched);
+		}
+
+		/* Reset per-input-tuple context after each tuple */
+		ResetExprContext(winstate->tmpcontext);
+		ExecClearTuple(slot);
+	}
+
+	/* Now combine the partial states covering the frame */
+	for (i = 0; i < numaggs; i++)
+	{
+		WindowStatePerAgg peraggstate = &winstate->peragg[i];
+		WindowSegTreeNode *parts[SEGTREE_MAX_PARTS];
+		WindowSegTreeNode state;
+		MemoryContext oldContext;
+		int			nparts;
+		int			j;
+
+		if (!peraggstate->use_segtree)
+			continue;
+
+		segtree_release_blocks(peraggstate, frameheadpos);
+
+		nparts = segtree_get_parts(peraggstate->segtree,
+								   frameheadpos, frametailpos, parts);
+
+		if (nparts == 0)
+		{
+			/* empty frame */
+			peraggstate->transValue = peraggstate->initValue;
+			peraggstate->transValueIsNull = peraggstate->initValueIsNull;
+			continue;
+		}
+
+		oldContext = MemoryContextSwitchTo(peraggstate->aggcontext);
+		state = *parts[0];
+		for (j = 1; j < nparts; j++)
+			segtree_combine(winstate, peraggstate, &state, parts[j], &state);
+		MemoryContextSwitchTo(oldContext);
+
+		peraggstate->transValue = state.value;
+		peraggstate->transValueIsNull = state.isnull;
+	}
+}
+
+/*
+ * segtree_add_leaf
+ * add the next row of the partition to an aggregate's segment tree
+ *
+ * If 'fetched' is true, the row has been set up as the outer tuple of
+ * winstate->tmpcontext; otherwise the row is known to lie before the frame
+ * head, and the leaf gets the aggregate's initial state.
+ */
+static void
+segtree_add_leaf(WindowAggState *winstate, WindowStatePerAgg peraggstate,
+				 bool fetched)
+{
+	WindowSegTree *segtree = peraggstate->segtree;
+	WindowSegTreeBlock *block;
+	int64		blockno = segtree->nleaves >> SEGTREE_BLOCK_BITS;
+	int			idx = SEGTREE_BLOCK_SIZE +
+		(segtree->nleaves & (SEGTREE_BLOCK_SIZE - 1));
+	WindowSegTreeNode combined;
+	MemoryContext oldContext;
+
+	/* Compute the transition state for this row alone */
+	initialize_windowaggregate(winstate,
+							   &winstate->perfunc[peraggstate->wfuncno],
+							   peraggstate);
+	if (fetched)
+		advance_windowaggregate(winstate,
+								&winstate->perfunc[peraggstate->wfuncno],
+								peraggstate);
+
+	/* Start a new block if needed */
+	if (idx == SEGTREE_BLOCK_SIZE)
+	{
+		if (blockno >= segtree->maxblocks)
+		{
+			int64		newmax = Max(segtree->maxblocks * 2, 16);
+
+			oldContext = MemoryContextSwitchTo(winstate->partcontext);
+			if (segtree->blocks == NULL)
+				segtree->blocks = (WindowSegTreeBlock **)
+					palloc0(sizeof(WindowSegTreeBlock *) * newmax);
+			else
+			{
+				segtree->blocks = (WindowSegTreeBlock **)
+					repalloc(segtree->blocks,
+							 sizeof(WindowSegTreeBlock *) * newmax);
+				memset(segtree->blocks + segtree->maxblocks, 0,
+					   sizeof(WindowSegTreeBlock *) *
+					   (newmax - segtree->maxblocks));
+			}
+			segtree->maxblocks = newmax;
+			MemoryContextSwitchTo(oldContext);
+		}
+		segtree->blocks[blockno] = (WindowSegTreeBlock *)
+			MemoryContextAlloc(winstate->partcontext,
+							   sizeof(WindowSegTreeBlock));
+	}
+	block = segtree->blocks[blockno];
+
+	segtree_store(winstate, peraggstate, &block->nodes[idx],
+				  peraggstate->transValue, peraggstate->transValueIsNull);
+	segtree->nleaves++;
+
+	/*
+	 * Fill in the ancestors that are now complete, i.e. all those that this
+	 * leaf is the rightmost descendant of.  Do the combining in the
+	 * per-tuple context; segtree_store copies the results.
+	 */
+	oldContext = MemoryContextSwitchTo(winstate->tmpcontext->ecxt_per_tuple_memory);
+	while (idx > 1 && (idx & 1))
+	{
+		segtree_combine(winstate, peraggstate,
+						&block->nodes[idx - 1], &block->nodes[idx],
+						&combined);
+		idx >>= 1;
+		segtree_store(winstate, peraggstate, &block->nodes[idx],
+					  combined.value, combined.isnull);
+	}
+
+	/* If the block is complete, add its root to the upper tree likewise */
+	if (idx == 1)
+	{
+		int64		upperidx = blockno;
+		int			level = 0;
+
+		combined = block->nodes[1];
+		for (;;)
+		{
+			Assert(level < SEGTREE_MAX_LEVELS);
+			if (upperidx >= segtree->upperlen[level])
+			{
+				int64		newlen = Max(segtree->upperlen[level] * 2, 16);
+
+				if (segtree->upper[level] == NULL)
+					segtree->upper[level] = (WindowSegTreeNode *)
+						MemoryContextAlloc(winstate->partcontext,
+										   sizeof(WindowSegTreeNode) * newlen);
+				else
+					segtree->upper[level] = (WindowSegTreeNode *)
+						repalloc(segtree->upper[level],
+								 sizeof(WindowSegTreeNode) * newlen);
+				segtree->upperlen[level] = newlen;
+			}
+			segtree_store(winstate, peraggstate,
+						  &segtree->upper[level][upperidx],
+						  combined.value, combined.isnull);
+			if (!(upperidx & 1))
+				break;
+			segtree_combine(winstate, peraggstate,
+							&segtree->upper[level][upperidx - 1],
+							&segtree->upper[level][upperidx],
+							&combined);
+			upperidx >>= 1;
+			level++;
+		}
+	}
+	MemoryContextSwitchTo(oldContext);
+}
+
+/*
+ * segtree_release_blocks
+ * free the blocks of an aggregate's segment tree that lie before 'pos'
+ *
+ * Only complete blocks are freed; their roots live on in the upper tree.
+ */
+static void
+segtree_release_blocks(WindowStatePerAgg peraggstate, int64 pos)
+{
+	WindowSegTree *segtree = peraggstate->segtree;
+	int64		limit;
+
+	limit = Min(pos, segtree->nleaves) >> SEGTREE_BLOCK_BITS;
+	while (segtree->nfreed < limit)
+	{
+		WindowSegTreeBlock *block = segtree->blocks[segtree->nfreed];
+
+		if (!peraggstate->transtypeByVal)
+		{
+			int			i;
+
+			for (i = 1; i < 2 * SEGTREE_BLOCK_SIZE; i++)
+			{
+				if (!block->nodes[i].isnull)
+					pfree(DatumGetPointer(block->nodes[i].value));
+			}
+		}
+		pfree(block);
+		segtree->blocks[segtree->nfreed++] = NULL;
+	}
+}
+
+/*
+ * segtree_get_parts
+ * collect the segment tree nodes that together cover rows [start, end)
+ *
+ * The nodes are stored into parts[] in row order, and their number is
+ * returned.  All the rows must have been added to the tree already, and
+ * their blocks must not have been released.
+ */
+static int
+segtree_get_parts(WindowSegTree *segtree, int64 start, int64 end,
+				  WindowSegTreeNode **parts)
+{
+	int64		firstblock,
+				lastblock;
+	int			nparts = 0;
+
+	if (start >= end)
+		return 0;
+	Assert(end <= segtree->nleaves);
+
+	firstblock = start >> SEGTREE_BLOCK_BITS;
+	lastblock = (end - 1) >> SEGTREE_BLOCK_BITS;
+	Assert(firstblock >= segtree->nfreed);
+
+	if (firstblock == lastblock)
+		nparts = segtree_block_parts(segtree->blocks[firstblock],
+									 start & (SEGTREE_BLOCK_SIZE - 1),
+									 ((end - 1) & (SEGTREE_BLOCK_SIZE - 1)) + 1,
+									 parts, nparts);
+	else
+	{
+		WindowSegTreeNode *rparts[2 * SEGTREE_MAX_LEVELS];
+		int			nrparts = 0;
+		int64		l = firstblock + 1;
+		int64		r = lastblock;
+		int			level = 0;
+
+		/* tail of the first block */
+		nparts = segtree_block_parts(segtree->blocks[firstblock],
+									 start & (SEGTREE_BLOCK_SIZE - 1),
+									 SEGTREE_BLOCK_SIZE,
+									 parts, nparts);
+
+		/* complete blocks in between, from the upper tree */
+		while (l < r)
+		{
+			if (l & 1)
+				parts[nparts++] = &segtree->upper[level][l++];
+			if (r & 1)
+				rparts[nrparts++] = &segtree->upper[level][--r];
+			l >>= 1;
+			r >>= 1;
+			level++;
+		}
+		while (nrparts > 0)
+			parts[nparts++] = rparts[--nrparts];
+
+		/* head of the last block */
+		nparts = segtree_block_parts(segtree->blocks[lastblock],
+									 0,
+									 ((end - 1) & (SEGTREE_BLOCK_SIZE - 1)) + 1,
+									 parts, nparts);
+	}
+
+	Assert(nparts <= SEGTREE_MAX_PARTS);
+	return nparts;
+}
+
+/*
+ * segtree_block_parts
+ * append the nodes covering leaves [l, r) of one block to parts[]
+ *
+ * Returns the new number of entries in parts[].
+ */
+static int
+segtree_block_parts(WindowSegTreeBlock *block, int l, int r,
+					WindowSegTreeNode **parts, int nparts)
+{
+	WindowSegTreeNode *rparts[SEGTREE_BLOCK_BITS + 1];
+	int			nrparts = 0;
+
+	l += SEGTREE_BLOCK_SIZE;
+	r += SEGTREE_BLOCK_SIZE;
+	while (l < r)
+	{
+		if (l & 1)
+			parts[nparts++] = &block->nodes[l++];
+		if (r & 1)
+			rparts[nrparts++] = &block->nodes[--r];
+		l >>= 1;
+		r >>= 1;
+	}
+	while (nrparts > 0)
+		parts[nparts++] = rparts[--nrparts];
+
+	return nparts;
+}
+
+/*
+ * segtree_combine
+ * combine two partial aggregate states, 'left' covering the earlier rows
+ *
+ * The result is computed in the current memory context, and may point to
+ * the right input's data.  It's OK for 'result' to point to 'left'.
+ */
+static void
+segtree_combine(WindowAggState *winstate, WindowStatePerAgg peraggstate,
+				WindowSegTreeNode *left, WindowSegTreeNode *right,
+				WindowSegTreeNode *result)
+{
+	LOCAL_FCINFO(fcinfo, 2);
+	WindowStatePerFunc perfuncstate = &winstate->perfunc[peraggstate->wfuncno];
+
+	/*
+	 * A strict combine function mustn't be called with a NULL state.  If the
+	 * initial value is NULL, a NULL state means that no input rows have been
+	 * aggregated yet, so the other state is the result, just as in nodeAgg.c.
+	 * Otherwise, the transition function must have returned NULL, and the
+	 * result is NULL, since advance_windowaggregate would have ignored all
+	 * further input rows.
+	 */
+	if (peraggstate->combinefn.fn_strict && (left->isnull || right->isnull))
+	{
+		if (!peraggstate->initValueIsNull)
+		{
+			result->value = (Datum) 0;
+			result->isnull = true;
+		}
+		else if (right->isnull)
+			*result = *left;
+		else
+			*result = *right;
+		return;
+	}
+
+	InitFunctionCallInfoData(*fcinfo, &(peraggstate->combinefn), 2,
+							 perfuncstate->winCollation,
+							 (void *) winstate, NULL);
+
+	/*
+	 * Since it's called in aggregate context, the combine function may
+	 * scribble on its first input, so it must be a private copy.
+	 */
+	if (!peraggstate->transtypeByVal && !left->isnull)
+		fcinfo->args[0].value = datumCopy(left->value,
+										  peraggstate->transtypeByVal,
+										  peraggstate->transtypeLen);
+	else
+		fcinfo->args[0].value = left->value;
+	fcinfo->args[0].isnull = left->isnull;
+	fcinfo->args[1].value = right->value;
+	fcinfo->args[1].isnull = right->isnull;
+
+	winstate->curaggcontext = peraggstate->aggcontext;
+	result->value = FunctionCallInvoke(fcinfo);
+	result->isnull = fcinfo->isnull;
+	winstate->curaggcontext = NULL;
+}
+
+/*
+ * segtree_store
+ * store a copy of a partial aggregate state in a segment tree node
+ */
+static void
+segtree_store(WindowAggState *winstate, WindowStatePerAgg peraggstate,
+			  WindowSegTreeNode *node, Datum value, bool isnull)
+{
+	if (isnull)
+		node->value = (Datum) 0;
+	else
+	{
+		MemoryContext oldContext;
+
+		oldContext = MemoryContextSwitchTo(winstate->partcontext);
+		node->value = datumCopy(value,
+								peraggstate->transtypeByVal,
+								peraggstate->transtypeLen);
+		MemoryContextSwitchTo(oldContext);
+	}
+	node->isnull = isnull;
+}
+
 /*
  * eval_windowfunction
  *
@@ -1303,6 +1867,54 @@ spool_tuples(WindowAggState *winstate, int64 pos)
 	MemoryContextSwitchTo(oldcontext);
 }
 
+/*
+ * skip_partition
+ * Read and discard the remaining rows of the current partition from the
+ * outer node, leaving the first row of the next partition, if any, in
+ * first_part_slot just like spool_tuples does.
+ */
+static void
+skip_partition(WindowAggState *winstate)
+{
+	PlanState  *outerPlan;
+	TupleTableSlot *outerslot;
+	ExprContext *econtext = winstate->tmpcontext;
+	MemoryContext oldcontext;
+
+	if (winstate->partition_spooled)
+		return;
+
+	outerPlan = outerPlanState(winstate);
+
+	/* Must be in query context to call outerplan */
+	oldcontext = MemoryContextSwitchTo(winstate->ss.ps.ps_ExprContext->ecxt_per_query_memory);
+
+	for (;;)
+	{
+		outerslot = ExecProcNode(outerPlan);
+		if (TupIsNull(outerslot))
+		{
+			/* reached the end of the last partition */
+			winstate->more_partitions = false;
+			break;
+		}
+
+		econtext->ecxt_innertuple = winstate->first_part_slot;
+		econtext->ecxt_outertuple = outerslot;
+
+		if (!ExecQualAndReset(winstate->partEqfunction, econtext))
+		{
+			/* end of partition; copy the tuple for the next cycle */
+			ExecCopySlot(winstate->first_part_slot, outerslot);
+			winstate->more_partitions = true;
+			break;
+		}
+	}
+	winstate->partition_spooled = true;
+
+	MemoryContextSwitchTo(oldcontext);
+}
+
 /*
  * release_partition
  * clear information kept within a partition, including
@@ -1334,6 +1946,8 @@ release_partition(WindowAggState *winstate)
 	{
 		if (winstate->peragg[i].aggcontext != winstate->aggcontext)
 			MemoryContextResetAndDeleteChildren(winstate->peragg[i].aggcontext);
+		/* segment trees were in partcontext */
+		winstate->peragg[i].segtree = NULL;
 	}
 
 	if (winstate->buffer)
@@ -2016,7 +2630,9 @@ update_grouptailpos(WindowAggState *winstate)
  *	ExecWindowAgg receives tuples from its outer subplan and
  *	stores them into a tuplestore, then processes window functions.
  *	This node doesn't reduce nor qualify any row so the number of
- *	returned rows is exactly the same as its outer subplan's result.
+ *	returned rows is exactly the same as its outer subplan's result,
+ *	except that when the planner has given us a run condition, we stop
+ *	returning rows from a partition once it becomes false.
  * -----------------
  */
 static TupleTableSlot *
@@ -2099,143 +2715,167 @@ ExecWindowAgg(PlanState *pstate)
 		winstate->all_first = false;
 	}
 
-	if (winstate->buffer == NULL)
-	{
-		/* Initialize for first partition and set current row = 0 */
-		begin_partition(winstate);
-		/* If there are no input rows, we'll detect that and exit below */
-	}
-	else
-	{
-		/* Advance current row within partition */
-		winstate->currentpos++;
-		/* This might mean that the frame moves, too */
-		winstate->framehead_valid = false;
-		winstate->frametail_valid = false;
-		/* we don't need to invalidate grouptail here; see below */
-	}
-
-	/*
-	 * Spool all tuples up to and including the current row, if we haven't
-	 * already
-	 */
-	spool_tuples(winstate, winstate->currentpos);
-
-	/* Move to the next partition if we reached the end of this partition */
-	if (winstate->partition_spooled &&
-		winstate->currentpos >= winstate->spooled_rows)
+	for (;;)
 	{
-		release_partition(winstate);
-
-		if (winstate->more_partitions)
+		if (winstate->buffer == NULL)
 		{
+			/* Initialize for first partition and set current row = 0 */
 			begin_partition(winstate);
-			Assert(winstate->spooled_rows > 0);
+			/* If there are no input rows, we'll detect that and exit below */
 		}
 		else
 		{
-			winstate->all_done = true;
-			return NULL;
+			/* Advance current row within partition */
+			winstate->currentpos++;
+			/* This might mean that the frame moves, too */
+			winstate->framehead_valid = false;
+			winstate->frametail_valid = false;
+			/* we don't need to invalidate grouptail here; see below */
 		}
-	}
 
-	/* final output execution is in ps_ExprContext */
-	econtext = winstate->ss.ps.ps_ExprContext;
+		/*
+		 * Spool all tuples up to and including the current row, if we haven't
+		 * already
+		 */
+		spool_tuples(winstate, winstate->currentpos);
 
-	/* Clear the per-output-tuple context for current row */
-	ResetExprContext(econtext);
+		/* Move to the next partition if we reached the end of this partition */
+		if (winstate->partition_spooled &&
+			winstate->currentpos >= winstate->spooled_rows)
+		{
+			release_partition(winstate);
 
-	/*
-	 * Read the current row from the tuplestore, and save in ScanTupleSlot.
-	 * (We can't rely on the outerplan's output slot because we may have to
-	 * read beyond the current row.  Also, we have to actually copy the row
-	 * out of the tuplestore, since window function evaluation might cause the
-	 * tuplestore to dump its state to disk.)
-	 *
-	 * In GROUPS mode, or when tracking a group-oriented exclusion clause, we
-	 * must also detect entering a new peer group and update associated state
-	 * when that happens.  We use temp_slot_2 to temporarily hold the previous
-	 * row for this purpose.
-	 *
-	 * Current row must be in the tuplestore, since we spooled it above.
-	 */
-	tuplestore_select_read_pointer(winstate->buffer, winstate->current_ptr);
-	if ((winstate->frameOptions & (FRAMEOPTION_GROUPS |
-								   FRAMEOPTION_EXCLUDE_GROUP |
-								   FRAMEOPTION_EXCLUDE_TIES)) &&
-		winstate->currentpos > 0)
-	{
-		ExecCopySlot(winstate->temp_slot_2, winstate->ss.ss_ScanTupleSlot);
-		if (!tuplestore_gettupleslot(winstate->buffer, true, true,
-									 winstate->ss.ss_ScanTupleSlot))
-			elog(ERROR, "unexpected end of tuplestore");
-		if (!are_peers(winstate, winstate->temp_slot_2,
-					   winstate->ss.ss_ScanTupleSlot))
+			if (winstate->more_partitions)
+			{
+				begin_partition(winstate);
+				Assert(winstate->spooled_rows > 0);
+			}
+			else
+			{
+				winstate->all_done = true;
+				return NULL;
+			}
+		}
+
+		/* final output execution is in ps_ExprContext */
+		econtext = winstate->ss.ps.ps_ExprContext;
+
+		/* Clear the per-output-tuple context for current row */
+		ResetExprContext(econtext);
+
+		/*
+		 * Read the current row from the tuplestore, and save in ScanTupleSlot.
+		 * (We can't rely on the outerplan's output slot because we may have to
+		 * read beyond the current row.  Also, we have to actually copy the row
+		 * out of the tuplestore, since window function evaluation might cause
+		 * the tuplestore to dump its state to disk.)
+		 *
+		 * In GROUPS mode, or when tracking a group-oriented exclusion clause,
+		 * we must also detect entering a new peer group and update associated
+		 * state when that happens.  We use temp_slot_2 to temporarily hold the
+		 * previous row for this purpose.
+		 *
+		 * Current row must be in the tuplestore, since we spooled it above.
+		 */
+		tuplestore_select_read_pointer(winstate->buffer, winstate->current_ptr);
+		if ((winstate->frameOptions & (FRAMEOPTION_GROUPS |
+									   FRAMEOPTION_EXCLUDE_GROUP |
+									   FRAMEOPTION_EXCLUDE_TIES)) &&
+			winstate->currentpos > 0)
+		{
+			ExecCopySlot(winstate->temp_slot_2, winstate->ss.ss_ScanTupleSlot);
+			if (!tuplestore_gettupleslot(winstate->buffer, true, true,
+										 winstate->ss.ss_ScanTupleSlot))
+				elog(ERROR, "unexpected end of tuplestore");
+			if (!are_peers(winstate, winstate->temp_slot_2,
+						   winstate->ss.ss_ScanTupleSlot))
+			{
+				winstate->currentgroup++;
+				winstate->groupheadpos = winstate->currentpos;
+				winstate->grouptail_valid = false;
+			}
+			ExecClearTuple(winstate->temp_slot_2);
+		}
+		else
 		{
-			winstate->currentgroup++;
-			winstate->groupheadpos = winstate->currentpos;
-			winstate->grouptail_valid = false;
+			if (!tuplestore_gettupleslot(winstate->buffer, true, true,
+										 winstate->ss.ss_ScanTupleSlot))
+				elog(ERROR, "unexpected end of tuplestore");
 		}
-		ExecClearTuple(winstate->temp_slot_2);
-	}
-	else
-	{
-		if (!tuplestore_gettupleslot(winstate->buffer, true, true,
-									 winstate->ss.ss_ScanTupleSlot))
-			elog(ERROR, "unexpected end of tuplestore");
-	}
 
-	/*
-	 * Evaluate true window functions
-	 */
-	numfuncs = winstate->numfuncs;
-	for (i = 0; i < numfuncs; i++)
-	{
-		WindowStatePerFunc perfuncstate = &(winstate->perfunc[i]);
+		/*
+		 * Evaluate true window functions
+		 */
+		numfuncs = winstate->numfuncs;
+		for (i = 0; i < numfuncs; i++)
+		{
+			WindowStatePerFunc perfuncstate = &(winstate->perfunc[i]);
 
-		if (perfuncstate->plain_agg)
-			continue;
-		eval_windowfunction(winstate, perfuncstate,
-							&(econtext->ecxt_aggvalues[perfuncstate->wfuncstate->wfuncno]),
-							&(econtext->ecxt_aggnulls[perfuncstate->wfuncstate->wfuncno]));
-	}
+			if (perfuncstate->plain_agg)
+				continue;
+			eval_windowfunction(winstate, perfuncstate,
+								&(econtext->ecxt_aggvalues[perfuncstate->wfuncstate->wfuncno]),
+								&(econtext->ecxt_aggnulls[perfuncstate->wfuncstate->wfuncno]));
+		}
 
-	/*
-	 * Evaluate aggregates
-	 */
-	if (winstate->numaggs > 0)
-		eval_windowaggregates(winstate);
+		/*
+		 * Evaluate aggregates
+		 */
+		if (winstate->numaggs > 0)
+			eval_windowaggregates(winstate);
 
-	/*
-	 * If we have created auxiliary read pointers for the frame or group
-	 * boundaries, force them to be kept up-to-date, because we don't know
-	 * whether the window function(s) will do anything that requires that.
-	 * Failing to advance the pointers would result in being unable to trim
-	 * data from the tuplestore, which is bad.  (If we could know in advance
-	 * whether the window functions will use frame boundary info, we could
-	 * skip creating these pointers in the first place ... but unfortunately
-	 * the window function API doesn't require that.)
-	 */
-	if (winstate->framehead_ptr >= 0)
-		update_frameheadpos(winstate);
-	if (winstate->frametail_ptr >= 0)
-		update_frametailpos(winstate);
-	if (winstate->grouptail_ptr >= 0)
-		update_grouptailpos(winstate);
+		/*
+		 * If we have created auxiliary read pointers for the frame or group
+		 * boundaries, force them to be kept up-to-date, because we don't know
+		 * whether the window function(s) will do anything that requires that.
+		 * Failing to advance the pointers would result in being unable to trim
+		 * data from the tuplestore, which is bad.  (If we could know in
+		 * advance whether the window functions will use frame boundary info,
+		 * we could skip creating these pointers in the first place ... but
+		 * unfortunately the window function API doesn't require that.)
+		 */
+		if (winstate->framehead_ptr >= 0)
+			update_frameheadpos(winstate);
+		if (winstate->frametail_ptr >= 0)
+			update_frametailpos(winstate);
+		if (winstate->grouptail_ptr >= 0)
+			update_grouptailpos(winstate);
 
-	/*
-	 * Truncate any no-longer-needed rows from the tuplestore.
-	 */
-	tuplestore_trim(winstate->buffer);
+		/*
+		 * Truncate any no-longer-needed rows from the tuplestore.
+		 */
+		tuplestore_trim(winstate->buffer);
 
-	/*
-	 * Form and return a projection tuple using the windowfunc results and the
-	 * current row.  Setting ecxt_outertuple arranges that any Vars will be
-	 * evaluated with respect to that row.
-	 */
-	econtext->ecxt_outertuple = winstate->ss.ss_ScanTupleSlot;
+		/*
+		 * Form and return a projection tuple using the windowfunc results and
+		 * the current row.  Setting ecxt_outertuple arranges that any Vars
+		 * will be evaluated with respect to that row.
+		 */
+		econtext->ecxt_outertuple = winstate->ss.ss_ScanTupleSlot;
+
+		/*
+		 * If the run condition no longer holds, none of the remaining rows of
+		 * the partition can pass the upper qual either, so there's no point
+		 * in evaluating the window functions for them.  Without a PARTITION
+		 * BY clause that means we're done altogether.
+		 */
+		if (winstate->runcondition != NULL &&
+			!ExecQual(winstate->runcondition, econtext))
+		{
+			if (((WindowAgg *) winstate->ss.ps.plan)->partNumCols == 0)
+			{
+				winstate->all_done = true;
+				return NULL;
+			}
+
+			/* skip to the start of the next partition */
+			skip_partition(winstate);
+			winstate->currentpos = winstate->spooled_rows - 1;
+			continue;
+		}
 
-	return ExecProject(winstate->ss.ps.ps_ProjInfo);
+		return ExecProject(winstate->ss.ps.ps_ProjInfo);
+	}
 }
 
 /* -----------------
@@ -2364,6 +3004,13 @@ ExecInitWindowAgg(WindowAgg *node, EState *estate, int eflags)
 	ExecInitResultTupleSlotTL(&winstate->ss.ps, &TTSOpsVirtual);
 	ExecAssignProjectionInfo(&winstate->ss.ps, NULL);
 
+	/*
+	 * Initialize the run condition.  Like the targetlist, it may contain
+	 * WindowFuncs; those are matched up with the targetlist's below.
+	 */
+	winstate->runcondition = ExecInitQual(node->runCondition,
+										  (PlanState *) winstate);
+
 	/* Set up data for comparing tuples */
 	if (node->partNumCols > 0)
 		winstate->partEqfunction =
@@ -2627,12 +3274,14 @@ initialize_peragg(WindowAggState *winstate, WindowFunc *wfunc,
 	bool		use_ma_code;
 	Oid			transfn_oid,
 				invtransfn_oid,
-				finalfn_oid;
+				finalfn_oid,
+				combinefn_oid;
 	bool		finalextra;
 	char		finalmodify;
 	Expr	   *transfnexpr,
 			   *invtransfnexpr,
-			   *finalfnexpr;
+			   *finalfnexpr,
+			   *combinefnexpr;
 	Datum		textInitVal;
 	int			i;
 	ListCell   *lc;
@@ -2695,6 +3344,25 @@ initialize_peragg(WindowAggState *winstate, WindowFunc *wfunc,
 		initvalAttNo = Anum_pg_aggregate_agginitval;
 	}
 
+	/*
+	 * If we're not using the moving-aggregate implementation although the
+	 * frame head can move, every move of the frame head would force us to
+	 * restart the aggregation.  If the aggregate has a combine function, we
+	 * can use a segment tree of partial states instead.  That requires that
+	 * each row's transition state be computed just once, so the same
+	 * volatility rule applies as above.  With an EXCLUSION clause the frame
+	 * may not be contiguous, so we just restart in that case.  The
+	 * transition type is checked below.
+	 */
+	if (!use_ma_code &&
+		OidIsValid(aggform->aggcombinefn) &&
+		!(winstate->frameOptions & (FRAMEOPTION_START_UNBOUNDED_PRECEDING |
+									FRAMEOPTION_EXCLUSION)) &&
+		!contain_volatile_functions((Node *) wfunc))
+		combinefn_oid = aggform->aggcombinefn;
+	else
+		combinefn_oid = InvalidOid;
+
 	/*
 	 * ExecInitWindowAgg already checked permission to call aggregate function
 	 * ... but we still need to check the component functions
@@ -2739,6 +3407,16 @@ initialize_peragg(WindowAggState *winstate, WindowFunc *wfunc,
 							   get_func_name(finalfn_oid));
 			InvokeFunctionExecuteHook(finalfn_oid);
 		}
+
+		if (OidIsValid(combinefn_oid))
+		{
+			aclresult = pg_proc_aclcheck(combinefn_oid, aggOwner,
+										 ACL_EXECUTE);
+			if (aclresult != ACLCHECK_OK)
+				aclcheck_error(aclresult, OBJECT_FUNCTION,
+							   get_func_name(combinefn_oid));
+			InvokeFunctionExecuteHook(combinefn_oid);
+		}
 	}
 
 	/*
@@ -2851,6 +3529,23 @@ initialize_peragg(WindowAggState *winstate, WindowFunc *wfunc,
 				(errcode(ERRCODE_INVALID_FUNCTION_DEFINITION),
 				 errmsg("strictness of aggregate's forward and inverse transition functions must match")));
 
+	/*
+	 * Partial states of type "internal" can't be copied into a segment tree,
+	 * so we must restart the aggregation for those after all.
+	 */
+	if (OidIsValid(combinefn_oid) && aggtranstype != INTERNALOID)
+	{
+		build_aggregate_combinefn_expr(aggtranstype,
+									   wfunc->inputcollid,
+									   combinefn_oid,
+									   &combinefnexpr);
+		fmgr_info(combinefn_oid, &peraggstate->combinefn);
+		fmgr_info_set_expr((Node *) combinefnexpr, &peraggstate->combinefn);
+
+		peraggstate->use_segtree = true;
+		peraggstate->combinefn_oid = combinefn_oid;
+	}
+
 	/*
 	 * Moving aggregates use their own aggcontext.
 	 *
@@ -2864,8 +3559,11 @@ initialize_peragg(WindowAggState *winstate, WindowFunc *wfunc,
 	 * make the memory allocation rules for moving aggregates different than
 	 * they have historically been for plain aggregates, but that seems grotty
 	 * and likely to lead to memory leaks.
+	 *
+	 * Aggregates evaluated using a segment tree need their own aggcontext as
+	 * well, since they reset it for every row.
 	 */
-	if (OidIsValid(invtransfn_oid))
+	if (OidIsValid(invtransfn_oid) || peraggstate->use_segtree)
 		peraggstate->aggcontext =
 			AllocSetContextCreate(CurrentMemoryContext,
 								  "WindowAgg Per Aggregate",
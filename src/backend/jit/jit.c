@@ -36,6 +36,10 @@ bool		jit_dump_bitcode = false;
 bool		jit_expressions = true;
 bool		jit_profiling_support = false;
 bool		jit_tuple_deforming = true;
+bool		jit_code_cache = true;
+bool		jit_code_cache_on_disk = false;
+bool		jit_tiered_compilation = false;
+int			jit_tier_up_threshold = 1000;
 double		jit_above_cost = 100000;
 double		jit_inline_above_cost = 500000;
 double		jit_optimize_above_cost = 500000;
@@ -44,9 +48,30 @@ static JitProviderCallbacks provider;
 static bool provider_successfully_loaded = false;
 static bool provider_failed_loading = false;
 
+/*
+ * State of an expression that is interpreted until it has been evaluated
+ * jit_tier_up_threshold times, and JIT compiled from then on.
+ */
+typedef struct JitTierUpState
+{
+	/* interpreter function selected by ExecReadyInterpretedExpr() */
+	ExprStateEvalFunc interp_func;
+
+	/* context the expression was initialized in */
+	MemoryContext mcxt;
+
+	/* has CheckExprStillValid() been performed */
+	bool		checked;
+
+	/* evaluations left until compilation */
+	int			remaining;
+} JitTierUpState;
+
 
 static bool provider_init(void);
 static bool file_exists(const char *name);
+static Datum jit_tier_up_expr(struct ExprState *state,
+							  struct ExprContext *econtext, bool *isNull);
 
 
 /*
@@ -173,12 +198,97 @@ jit_compile_expr(struct ExprState *state)
 		return false;
 
 	/* this also takes !jit_enabled into account */
-	if (provider_init())
-		return provider.compile_expr(state);
+	if (!provider_init())
+		return false;
+
+	/*
+	 * With tiered compilation, start out interpreting the expression, and
+	 * only compile it once it has turned out to be evaluated often.
+	 */
+	if (state->parent->state->es_jit_flags & PGJIT_TIERED)
+	{
+		JitTierUpState *tstate;
+
+		ExecReadyInterpretedExpr(state);
+
+		tstate = palloc(sizeof(JitTierUpState));
+		tstate->interp_func = (ExprStateEvalFunc) state->evalfunc_private;
+		tstate->mcxt = CurrentMemoryContext;
+		tstate->checked = false;
+		tstate->remaining = jit_tier_up_threshold;
+
+		state->evalfunc = jit_tier_up_expr;
+		state->evalfunc_private = tstate;
+
+		return true;
+	}
+
+	return provider.compile_expr(state);
+}
+
+/*
+ * Attempt to compile the loop feeding input tuples from a batch to the
+ * transition expression evaltrans of an Agg node.  On success, the provider
+ * sets aggstate->input_pipeline.
+ */
+bool
+jit_compile_agg_pipeline(struct AggState *aggstate, struct ExprState *evaltrans)
+{
+	int			jit_flags = aggstate->ss.ps.state->es_jit_flags;
+
+	/* the transition expression has to be JITed to begin with */
+	if (!(jit_flags & PGJIT_PERFORM) || !(jit_flags & PGJIT_EXPR))
+		return false;
+
+	if (provider_init() && provider.compile_agg_pipeline)
+		return provider.compile_agg_pipeline(aggstate, evaltrans);
 
 	return false;
 }
 
+/*
+ * Evaluation callback of expressions set up for tiered compilation.
+ *
+ * This stands in for ExecInterpExprStillValid(), performing the same check
+ * on the first call, and then runs the interpreter until the expression has
+ * been evaluated jit_tier_up_threshold times.  At that point the expression
+ * is handed to the JIT provider, which installs its own evalfunc.  If it
+ * declines, the expression is interpreted from then on, without going
+ * through this function.
+ */
+static Datum
+jit_tier_up_expr(struct ExprState *state, struct ExprContext *econtext,
+				 bool *isNull)
+{
+	JitTierUpState *tstate = (JitTierUpState *) state->evalfunc_private;
+	MemoryContext oldcontext;
+
+	if (unlikely(!tstate->checked))
+	{
+		CheckExprStillValid(state, econtext);
+		tstate->checked = true;
+	}
+
+	if (likely(--tstate->remaining > 0))
+		return tstate->interp_func(state, econtext, isNull);
+
+	/*
+	 * The interpreter's evalfuncs don't look at evalfunc_private, so falling
+	 * back to interpretation just requires resetting evalfunc.  The provider
+	 * may allocate state that has to live as long as the expression, so
+	 * compile in the context the expression was initialized in, rather than
+	 * the one it is evaluated in.
+	 */
+	state->evalfunc = tstate->interp_func;
+	state->evalfunc_private = NULL;
+
+	oldcontext = MemoryContextSwitchTo(tstate->mcxt);
+	(void) provider.compile_expr(state);
+	MemoryContextSwitchTo(oldcontext);
+
+	return state->evalfunc(state, econtext, isNull);
+}
+
 /* Aggregate JIT instrumentation information */
 void
 InstrJitAgg(JitInstrumentation *dst, JitInstrumentation *add)
@@ -188,6 +298,8 @@ InstrJitAgg(JitInstrumentation *dst, JitInstrumentation *add)
 	INSTR_TIME_ADD(dst->inlining_counter, add->inlining_counter);
 	INSTR_TIME_ADD(dst->optimization_counter, add->optimization_counter);
 	INSTR_TIME_ADD(dst->emission_counter, add->emission_counter);
+	dst->deform_cache_hits += add->deform_cache_hits;
+	dst->deform_cache_misses += add->deform_cache_misses;
 }
 
 static bool
@@ -28,11 +28,19 @@
 #include <llvm-c/Transforms/Utils.h>
 #endif
 
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "common/hashfn.h"
+#include "executor/tuptable.h"
 #include "jit/llvmjit.h"
 #include "jit/llvmjit_emit.h"
+#include "lib/stringinfo.h"
 #include "miscadmin.h"
 #include "portability/instr_time.h"
+#include "storage/fd.h"
 #include "storage/ipc.h"
+#include "utils/hsearch.h"
 #include "utils/memutils.h"
 #include "utils/resowner_private.h"
 
@@ -43,6 +51,52 @@ typedef struct LLVMJitHandle
 	LLVMOrcModuleHandle orc_handle;
 } LLVMJitHandle;
 
+/*
+ * Entry in the code cache.  Code in the cache is never released, it stays
+ * loaded until the backend exits.
+ */
+typedef struct LLVMJitCacheEntry
+{
+	uint64		hash;			/* hash of key, hashtable key - must be first */
+	int			keylen;
+	char	   *key;			/* complete key, to detect hash collisions */
+	void	   *addr;			/* address of the emitted function */
+} LLVMJitCacheEntry;
+
+/*
+ * Fixed part of the key of a cached deform function, followed by one
+ * LLVMJitDeformKeyAtt for each attribute of the tuple descriptor.  These are
+ * the only inputs slot_build_deform() bases the generated code on.
+ */
+typedef struct LLVMJitDeformKey
+{
+	uint64		fingerprint;	/* see llvm_code_fingerprint */
+	int			flags;			/* PGJIT_OPT3 and PGJIT_INLINE bits */
+	int			kind;			/* type of slot */
+	int			natts;			/* number of attributes to deform */
+	int			desc_natts;		/* number of attributes in descriptor */
+	bool		sparse;			/* followed by bitmap of needed attributes? */
+} LLVMJitDeformKey;
+
+typedef struct LLVMJitDeformKeyAtt
+{
+	int16		attlen;
+	char		attalign;
+	bool		attbyval;
+	bool		attnotnull;
+	bool		atthasmissing;
+	bool		attisdropped;
+} LLVMJitDeformKeyAtt;
+
+/* don't keep more than this many functions in the code cache */
+#define LLVMJIT_CACHE_MAX_ENTRIES 256
+
+/* directory, relative to the data directory, for on-disk cache files */
+#define LLVMJIT_CACHE_DIR "pg_jit_cache"
+
+/* first word of on-disk cache files, followed by the key length and key */
+#define LLVMJIT_CACHE_MAGIC 0x504A4301
+
 
 /* types & functions commonly needed for JITing */
 LLVMTypeRef TypeSizeT;
@@ -92,6 +146,18 @@ static LLVMTargetRef llvm_targetref;
 static LLVMOrcJITStackRef llvm_opt0_orc;
 static LLVMOrcJITStackRef llvm_opt3_orc;
 
+/* code cache, see llvm_cached_deform() */
+static HTAB *llvm_code_cache = NULL;
+
+/*
+ * Hash of everything outside the cache key that emitted code depends on:
+ * server and LLVM versions, the struct layouts in llvmjit_types.bc and the
+ * CPU the code is emitted for.  Included in every cache key, so files in the
+ * on-disk cache emitted by a different build or on a different CPU are never
+ * used.
+ */
+uint64		llvm_code_fingerprint = 0;
+
 
 static void llvm_release_context(JitContext *context);
 static void llvm_session_initialize(void);
@@ -103,6 +169,7 @@ static void llvm_create_types(void);
 static uint64_t llvm_resolve_symbol(const char *name, void *ctx);
 
 
+
 PG_MODULE_MAGIC;
 
 
@@ -115,6 +182,7 @@ _PG_jit_provider_init(JitProviderCallbacks *cb)
 	cb->reset_after_error = llvm_reset_after_error;
 	cb->release_context = llvm_release_context;
 	cb->compile_expr = llvm_compile_expr;
+	cb->compile_agg_pipeline = llvm_compile_agg_pipeline;
 }
 
 /*
@@ -451,7 +519,7 @@ llvm_optimize_module(LLVMJitContext *context, LLVMModuleRef module)
 	 * functions are emitted, to reduce memory usage a bit.
 	 */
 	LLVMInitializeFunctionPassManager(llvm_fpm);
-	for (func = LLVMGetFirstFunction(context->module);
+	for (func = LLVMGetFirstFunction(module);
 		 func != NULL;
 		 func = LLVMGetNextFunction(func))
 		LLVMRunFunctionPassManager(llvm_fpm, func);
@@ -472,7 +540,7 @@ llvm_optimize_module(LLVMJitContext *context, LLVMModuleRef module)
 	if (context->base.flags & PGJIT_INLINE
 		&& !(context->base.flags & PGJIT_OPT3))
 		LLVMAddFunctionInliningPass(llvm_mpm);
-	LLVMRunPassManager(llvm_mpm, context->module);
+	LLVMRunPassManager(llvm_mpm, module);
 	LLVMDisposePassManager(llvm_mpm);
 
 	LLVMPassManagerBuilderDispose(llvm_pmb);
@@ -600,6 +668,353 @@ llvm_compile_module(LLVMJitContext *context)
 			 errhidecontext(true)));
 }
 
+/*
+ * Return the address of a function deforming a tuple of type desc up to
+ * natts columns, or only the ones set in needed if that isn't NULL (see
+ * slot_build_deform()), emitting it first if no matching function is in the
+ * code cache yet.  Returns NULL if the cache cannot be used, in which case the
+ * caller has to generate code the usual way.
+ *
+ * Contrary to code built with slot_compile_deform(), a cached function is
+ * emitted in a module of its own, right away, and lives until the backend
+ * exits.  With jit_code_cache_on_disk the emitted object is also written to
+ * LLVMJIT_CACHE_DIR, so other backends can load it instead of optimizing and
+ * emitting it themselves.
+ */
+void *
+llvm_cached_deform(LLVMJitContext *context, TupleDesc desc,
+				   const TupleTableSlotOps *ops, int natts,
+				   const bits8 *needed)
+{
+#if LLVM_VERSION_MAJOR > 6
+	StringInfoData key;
+	LLVMJitDeformKey hdr;
+	uint64		hash;
+	LLVMJitCacheEntry *entry;
+	char	   *keycopy;
+	bool		found;
+	char		funcname[NAMEDATALEN];
+	LLVMMemoryBufferRef buf;
+	LLVMOrcJITStackRef compile_orc;
+	LLVMOrcModuleHandle orc_handle;
+	LLVMOrcTargetAddress addr = 0;
+	instr_time	starttime;
+	instr_time	endtime;
+	int			attnum;
+
+	llvm_assert_in_fatal_section();
+
+	/* decline for slot types slot_build_deform() doesn't handle */
+	if (ops != &TTSOpsHeapTuple && ops != &TTSOpsBufferHeapTuple &&
+		ops != &TTSOpsMinimalTuple)
+		return NULL;
+
+	/* build the key */
+	memset(&hdr, 0, sizeof(hdr));
+	hdr.fingerprint = llvm_code_fingerprint;
+	hdr.flags = context->base.flags & (PGJIT_OPT3 | PGJIT_INLINE);
+	if (ops == &TTSOpsHeapTuple)
+		hdr.kind = 1;
+	else if (ops == &TTSOpsBufferHeapTuple)
+		hdr.kind = 2;
+	else
+		hdr.kind = 3;
+	hdr.natts = natts;
+	hdr.desc_natts = desc->natts;
+	hdr.sparse = needed != NULL;
+
+	initStringInfo(&key);
+	appendBinaryStringInfo(&key, (char *) &hdr, sizeof(hdr));
+	for (attnum = 0; attnum < desc->natts; attnum++)
+	{
+		Form_pg_attribute att = TupleDescAttr(desc, attnum);
+		LLVMJitDeformKeyAtt katt;
+
+		/* zero the padding too, the key is compared bytewise */
+		memset(&katt, 0, sizeof(katt));
+		katt.attlen = att->attlen;
+		katt.attalign = att->attalign;
+		katt.attbyval = att->attbyval;
+		katt.attnotnull = att->attnotnull;
+		katt.atthasmissing = att->atthasmissing;
+		katt.attisdropped = att->attisdropped;
+		appendBinaryStringInfo(&key, (char *) &katt, sizeof(katt));
+	}
+	if (needed)
+		appendBinaryStringInfo(&key, (const char *) needed, BITMAPLEN(natts));
+
+	hash = hash_bytes_extended((const unsigned char *) key.data, key.len, 0);
+
+	if (llvm_code_cache == NULL)
+	{
+		HASHCTL		ctl;
+
+		memset(&ctl, 0, sizeof(ctl));
+		ctl.keysize = sizeof(uint64);
+		ctl.entrysize = sizeof(LLVMJitCacheEntry);
+		ctl.hcxt = TopMemoryContext;
+		llvm_code_cache = hash_create("LLVM JIT code cache", 64, &ctl,
+									  HASH_ELEM | HASH_BLOBS | HASH_CONTEXT);
+	}
+
+	entry = (LLVMJitCacheEntry *) hash_search(llvm_code_cache, &hash,
+											  HASH_FIND, NULL);
+	if (entry)
+	{
+		/* on a hash collision, simply don't cache the second function */
+		if (entry->keylen != key.len ||
+			memcmp(entry->key, key.data, key.len) != 0)
+		{
+			pfree(key.data);
+			return NULL;
+		}
+
+		context->base.instr.deform_cache_hits++;
+		pfree(key.data);
+		return entry->addr;
+	}
+
+	if (hash_get_num_entries(llvm_code_cache) >= LLVMJIT_CACHE_MAX_ENTRIES)
+	{
+		pfree(key.data);
+		return NULL;
+	}
+
+	snprintf(funcname, sizeof(funcname), "pgjitcache_deform_%016" INT64_MODIFIER "x",
+			 hash);
+
+	buf = NULL;
+	if (jit_code_cache_on_disk)
+		buf = llvm_cache_read_file(hash, "o", &key);
+
+	if (buf != NULL)
+		context->base.instr.deform_cache_hits++;
+	else
+	{
+		LLVMModuleRef mod;
+		LLVMTargetMachineRef tm;
+		char	   *error = NULL;
+
+		context->base.instr.deform_cache_misses++;
+		context->base.instr.created_functions++;
+
+		mod = LLVMModuleCreateWithName("pgjitcache");
+		LLVMSetTarget(mod, llvm_triple);
+		LLVMSetDataLayout(mod, llvm_layout);
+		slot_build_deform(mod, funcname, desc, ops, natts, needed);
+
+		/*
+		 * This is called while generating code for an expression, and the
+		 * caller accounts all of that as generation time.  Move the time
+		 * spent on inlining, optimizing and emitting this function to the
+		 * respective counters instead of counting it twice.
+		 */
+		if (context->base.flags & PGJIT_INLINE)
+		{
+			INSTR_TIME_SET_CURRENT(starttime);
+			llvm_inline(mod);
+			INSTR_TIME_SET_CURRENT(endtime);
+			INSTR_TIME_SUBTRACT(endtime, starttime);
+			INSTR_TIME_ADD(context->base.instr.inlining_counter, endtime);
+			INSTR_TIME_SUBTRACT(context->base.instr.generation_counter, endtime);
+		}
+
+		INSTR_TIME_SET_CURRENT(starttime);
+		llvm_optimize_module(context, mod);
+		INSTR_TIME_SET_CURRENT(endtime);
+		INSTR_TIME_SUBTRACT(endtime, starttime);
+		INSTR_TIME_ADD(context->base.instr.optimization_counter, endtime);
+		INSTR_TIME_SUBTRACT(context->base.instr.generation_counter, endtime);
+
+		INSTR_TIME_SET_CURRENT(starttime);
+		if (context->base.flags & PGJIT_OPT3)
+			tm = llvm_opt3_targetmachine;
+		else
+			tm = llvm_opt0_targetmachine;
+		if (LLVMTargetMachineEmitToMemoryBuffer(tm, mod, LLVMObjectFile,
+												&error, &buf))
+			elog(ERROR, "failed to emit object for \"%s\": %s",
+				 funcname, error);
+		LLVMDisposeModule(mod);
+		INSTR_TIME_SET_CURRENT(endtime);
+		INSTR_TIME_SUBTRACT(endtime, starttime);
+		INSTR_TIME_ADD(context->base.instr.emission_counter, endtime);
+		INSTR_TIME_SUBTRACT(context->base.instr.generation_counter, endtime);
+
+		if (jit_code_cache_on_disk)
+			llvm_cache_write_file(hash, "o", &key, buf);
+	}
+
+	/* load the object, LLVMOrcAddObjectFile takes ownership of the buffer */
+	if (context->base.flags & PGJIT_OPT3)
+		compile_orc = llvm_opt3_orc;
+	else
+		compile_orc = llvm_opt0_orc;
+
+	if (LLVMOrcAddObjectFile(compile_orc, &orc_handle, buf,
+							 llvm_resolve_symbol, NULL))
+		elog(ERROR, "failed to JIT object for \"%s\"", funcname);
+	if (LLVMOrcGetSymbolAddress(compile_orc, &addr, funcname))
+		elog(ERROR, "failed to look up symbol \"%s\"", funcname);
+	if (!addr)
+		elog(ERROR, "failed to JIT: %s", funcname);
+
+	keycopy = MemoryContextAlloc(TopMemoryContext, key.len);
+	memcpy(keycopy, key.data, key.len);
+
+	entry = (LLVMJitCacheEntry *) hash_search(llvm_code_cache, &hash,
+											  HASH_ENTER, &found);
+	Assert(!found);
+	entry->keylen = key.len;
+	entry->key = keycopy;
+	entry->addr = (void *) (uintptr_t) addr;
+
+	pfree(key.data);
+
+	return entry->addr;
+#else
+	/* loading emitted objects requires LLVMOrcAddObjectFile() */
+	return NULL;
+#endif
+}
+
+/*
+ * Load the contents of the on-disk cache file with the given suffix for the
+ * given key.  Returns NULL if there is no file, or if it was written for a
+ * different key.  Only inlining choices ("inline") can be empty, when no
+ * function was chosen; any other file without contents must be truncated,
+ * and is treated as missing.
+ */
+LLVMMemoryBufferRef
+llvm_cache_read_file(uint64 hash, const char *suffix, StringInfo key)
+{
+	char		path[MAXPGPATH];
+	int			fd;
+	struct stat st;
+	char	   *data;
+	uint32		hdr[2];
+	LLVMMemoryBufferRef buf = NULL;
+
+	snprintf(path, sizeof(path), "%s/%016" INT64_MODIFIER "x.%s",
+			 LLVMJIT_CACHE_DIR, hash, suffix);
+
+	fd = OpenTransientFile(path, O_RDONLY | PG_BINARY);
+	if (fd < 0)
+	{
+		if (errno != ENOENT)
+			ereport(LOG,
+					(errcode_for_file_access(),
+					 errmsg("could not open file \"%s\": %m", path)));
+		return NULL;
+	}
+
+	if (fstat(fd, &st) < 0 ||
+		st.st_size < (off_t) (sizeof(hdr) + key->len) ||
+		(st.st_size == (off_t) (sizeof(hdr) + key->len) &&
+		 strcmp(suffix, "inline") != 0))
+	{
+		CloseTransientFile(fd);
+		return NULL;
+	}
+
+	data = palloc(st.st_size);
+	if (read(fd, data, st.st_size) == st.st_size)
+	{
+		memcpy(hdr, data, sizeof(hdr));
+
+		if (hdr[0] == LLVMJIT_CACHE_MAGIC && hdr[1] == key->len &&
+			memcmp(data + sizeof(hdr), key->data, key->len) == 0)
+		{
+			size_t		off = sizeof(hdr) + key->len;
+
+			buf = LLVMCreateMemoryBufferWithMemoryRangeCopy(data + off,
+															st.st_size - off,
+															path);
+		}
+	}
+
+	pfree(data);
+	CloseTransientFile(fd);
+
+	return buf;
+}
+
+/*
+ * Store buf in the on-disk cache.  Failure to do so is not an error, the
+ * contents just won't be found by other backends.
+ */
+void
+llvm_cache_write_file(uint64 hash, const char *suffix, StringInfo key,
+					  LLVMMemoryBufferRef buf)
+{
+	char		path[MAXPGPATH];
+	char		tmppath[MAXPGPATH];
+	int			fd;
+	uint32		hdr[2];
+	bool		ok;
+
+	snprintf(path, sizeof(path), "%s/%016" INT64_MODIFIER "x.%s",
+			 LLVMJIT_CACHE_DIR, hash, suffix);
+	snprintf(tmppath, sizeof(tmppath), "%s.%d.tmp", path, MyProcPid);
+
+	if (MakePGDirectory(LLVMJIT_CACHE_DIR) < 0 && errno != EEXIST)
+	{
+		ereport(LOG,
+				(errcode_for_file_access(),
+				 errmsg("could not create directory \"%s\": %m",
+						LLVMJIT_CACHE_DIR)));
+		return;
+	}
+
+	fd = OpenTransientFile(tmppath, O_WRONLY | O_CREAT | O_TRUNC | PG_BINARY);
+	if (fd < 0)
+	{
+		ereport(LOG,
+				(errcode_for_file_access(),
+				 errmsg("could not create file \"%s\": %m", tmppath)));
+		return;
+	}
+
+	hdr[0] = LLVMJIT_CACHE_MAGIC;
+	hdr[1] = key->len;
+
+	errno = 0;
+	ok = write(fd, hdr, sizeof(hdr)) == sizeof(hdr) &&
+		write(fd, key->data, key->len) == key->len &&
+		write(fd, LLVMGetBufferStart(buf), LLVMGetBufferSize(buf)) ==
+		LLVMGetBufferSize(buf);
+	if (!ok)
+	{
+		/* if write didn't set errno, assume problem is no disk space */
+		if (errno == 0)
+			errno = ENOSPC;
+		ereport(LOG,
+				(errcode_for_file_access(),
+				 errmsg("could not write file \"%s\": %m", tmppath)));
+	}
+
+	if (CloseTransientFile(fd) != 0 && ok)
+	{
+		ereport(LOG,
+				(errcode_for_file_access(),
+				 errmsg("could not close file \"%s\": %m", tmppath)));
+		ok = false;
+	}
+
+	/* concurrent writers of the same key write identical files */
+	if (ok && rename(tmppath, path) < 0)
+	{
+		ereport(LOG,
+				(errcode_for_file_access(),
+				 errmsg("could not rename file \"%s\" to \"%s\": %m",
+						tmppath, path)));
+		ok = false;
+	}
+
+	if (!ok)
+		unlink(tmppath);
+}
+
 /*
  * Per session initialization.
  */
@@ -642,6 +1057,17 @@ llvm_session_initialize(void)
 	elog(DEBUG2, "LLVMJIT detected CPU \"%s\", with features \"%s\"",
 		 cpu, features);
 
+	{
+		char	   *target;
+
+		target = psprintf("%d %d %s %s", PG_VERSION_NUM, LLVM_VERSION_MAJOR,
+						  cpu, features);
+		llvm_code_fingerprint =
+			hash_bytes_extended((const unsigned char *) target, strlen(target),
+								llvm_code_fingerprint);
+		pfree(target);
+	}
+
 	llvm_opt0_targetmachine =
 		LLVMCreateTargetMachine(llvm_targetref, llvm_triple, cpu, features,
 								LLVMCodeGenLevelNone,
@@ -788,6 +1214,9 @@ llvm_create_types(void)
 	{
 		elog(ERROR, "LLVMParseBitcode2 of %s failed", path);
 	}
+	llvm_code_fingerprint =
+		hash_bytes_extended((const unsigned char *) LLVMGetBufferStart(buf),
+							LLVMGetBufferSize(buf), llvm_code_fingerprint);
 	LLVMDisposeMemoryBuffer(buf);
 
 	/*
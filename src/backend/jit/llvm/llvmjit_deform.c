@@ -27,16 +27,65 @@
 #include "jit/llvmjit_emit.h"
 
 
+/* is attnum's bit set in the bitmap of needed attributes? */
+#define deform_att_needed(attnum, needed) \
+	((needed) == NULL || \
+	 ((needed)[(attnum) >> 3] & (1 << ((attnum) & 0x07))) != 0)
+
+
 /*
  * Create a function that deforms a tuple of type desc up to natts columns.
+ * If needed isn't NULL, only the columns whose bit is set in it are stored
+ * into the slot, see slot_build_deform().
  */
 LLVMValueRef
 slot_compile_deform(LLVMJitContext *context, TupleDesc desc,
-					const TupleTableSlotOps *ops, int natts)
+					const TupleTableSlotOps *ops, int natts,
+					const bits8 *needed)
 {
+	LLVMModuleRef mod;
 	char	   *funcname;
+	LLVMValueRef v_deform_fn;
 
-	LLVMModuleRef mod;
+	/* virtual tuples never need deforming, so don't generate code */
+	if (ops == &TTSOpsVirtual)
+		return NULL;
+
+	/* decline to JIT for slot types we don't know to handle */
+	if (ops != &TTSOpsHeapTuple && ops != &TTSOpsBufferHeapTuple &&
+		ops != &TTSOpsMinimalTuple)
+		return NULL;
+
+	mod = llvm_mutable_module(context);
+
+	funcname = llvm_expand_funcname(context, "deform");
+
+	v_deform_fn = slot_build_deform(mod, funcname, desc, ops, natts, needed);
+	LLVMSetLinkage(v_deform_fn, LLVMInternalLinkage);
+
+	return v_deform_fn;
+}
+
+/*
+ * Add an externally visible function named funcname to mod, deforming a
+ * tuple of type desc up to natts columns.  The generated code references no
+ * addresses other than those of named functions, so it can be emitted on its
+ * own and reused for any slot with a matching descriptor (see
+ * llvm_cached_deform()).
+ *
+ * If needed isn't NULL, it is a bitmap laid out like a tuple's null bitmap,
+ * and only the columns whose bit is set are stored into the slot.  The
+ * offsets of the others still have to be computed, but their values aren't
+ * loaded.  As for slot_getsparseattrs(), tts_nvalid and the saved offset then
+ * aren't updated, as the slot's arrays aren't valid up to natts.
+ *
+ * The caller has to have checked that ops is a slot type we can handle.
+ */
+LLVMValueRef
+slot_build_deform(LLVMModuleRef mod, const char *funcname, TupleDesc desc,
+				  const TupleTableSlotOps *ops, int natts,
+				  const bits8 *needed)
+{
 	LLVMBuilderRef b;
 
 	LLVMTypeRef deform_sig;
@@ -89,18 +138,8 @@ slot_compile_deform(LLVMJitContext *context, TupleDesc desc,
 
 	int			attnum;
 
-	/* virtual tuples never need deforming, so don't generate code */
-	if (ops == &TTSOpsVirtual)
-		return NULL;
-
-	/* decline to JIT for slot types we don't know to handle */
-	if (ops != &TTSOpsHeapTuple && ops != &TTSOpsBufferHeapTuple &&
-		ops != &TTSOpsMinimalTuple)
-		return NULL;
-
-	mod = llvm_mutable_module(context);
-
-	funcname = llvm_expand_funcname(context, "deform");
+	Assert(ops == &TTSOpsHeapTuple || ops == &TTSOpsBufferHeapTuple ||
+		   ops == &TTSOpsMinimalTuple);
 
 	/*
 	 * Check which columns have to exist, so we don't have to check the row's
@@ -137,7 +176,6 @@ slot_compile_deform(LLVMJitContext *context, TupleDesc desc,
 									  lengthof(param_types), 0);
 	}
 	v_deform_fn = LLVMAddFunction(mod, funcname, deform_sig);
-	LLVMSetLinkage(v_deform_fn, LLVMInternalLinkage);
 	LLVMSetParamAlignment(LLVMGetParam(v_deform_fn, 0), MAXIMUM_ALIGNOF);
 	llvm_copy_attributes(AttributeTemplate, v_deform_fn);
 
@@ -380,6 +418,7 @@ slot_compile_deform(LLVMJitContext *context, TupleDesc desc,
 		LLVMValueRef l_attno = l_int16_const(attnum);
 		LLVMValueRef v_attdatap;
 		LLVMValueRef v_resultp;
+		bool		wanted = deform_att_needed(attnum, needed);
 
 		/* build block checking whether we did all the necessary attributes */
 		LLVMPositionBuilderAtEnd(b, attcheckattnoblocks[attnum]);
@@ -454,14 +493,17 @@ slot_compile_deform(LLVMJitContext *context, TupleDesc desc,
 
 			LLVMPositionBuilderAtEnd(b, b_ifnull);
 
-			/* store null-byte */
-			LLVMBuildStore(b,
-						   l_int8_const(1),
-						   LLVMBuildGEP(b, v_tts_nulls, &l_attno, 1, ""));
-			/* store zero datum */
-			LLVMBuildStore(b,
-						   l_sizet_const(0),
-						   LLVMBuildGEP(b, v_tts_values, &l_attno, 1, ""));
+			if (wanted)
+			{
+				/* store null-byte */
+				LLVMBuildStore(b,
+							   l_int8_const(1),
+							   LLVMBuildGEP(b, v_tts_nulls, &l_attno, 1, ""));
+				/* store zero datum */
+				LLVMBuildStore(b,
+							   l_sizet_const(0),
+							   LLVMBuildGEP(b, v_tts_values, &l_attno, 1, ""));
+			}
 
 			LLVMBuildBr(b, b_next);
 			attguaranteedalign = false;
@@ -641,14 +683,16 @@ slot_compile_deform(LLVMJitContext *context, TupleDesc desc,
 		v_resultp = LLVMBuildGEP(b, v_tts_values, &l_attno, 1, "");
 
 		/* store null-byte (false) */
-		LLVMBuildStore(b, l_int8_const(0),
-					   LLVMBuildGEP(b, v_tts_nulls, &l_attno, 1, ""));
+		if (wanted)
+			LLVMBuildStore(b, l_int8_const(0),
+						   LLVMBuildGEP(b, v_tts_nulls, &l_attno, 1, ""));
 
 		/*
 		 * Store datum. For byval: datums copy the value, extend to Datum's
-		 * width, and store. For byref types: store pointer to data.
+		 * width, and store. For byref types: store pointer to data.  Skipped
+		 * columns only matter for their length.
 		 */
-		if (att->attbyval)
+		if (wanted && att->attbyval)
 		{
 			LLVMValueRef v_tmp_loaddata;
 			LLVMTypeRef vartypep =
@@ -661,7 +705,7 @@ slot_compile_deform(LLVMJitContext *context, TupleDesc desc,
 
 			LLVMBuildStore(b, v_tmp_loaddata, v_resultp);
 		}
-		else
+		else if (wanted)
 		{
 			LLVMValueRef v_tmp_loaddata;
 
@@ -737,6 +781,7 @@ slot_compile_deform(LLVMJitContext *context, TupleDesc desc,
 	/* build block that returns */
 	LLVMPositionBuilderAtEnd(b, b_out);
 
+	if (needed == NULL)
 	{
 		LLVMValueRef v_off = LLVMBuildLoad(b, v_offp, "");
 		LLVMValueRef v_flags;
@@ -747,8 +792,8 @@ slot_compile_deform(LLVMJitContext *context, TupleDesc desc,
 		v_flags = LLVMBuildLoad(b, v_flagsp, "tts_flags");
 		v_flags = LLVMBuildOr(b, v_flags, l_int16_const(TTS_FLAG_SLOW), "");
 		LLVMBuildStore(b, v_flags, v_flagsp);
-		LLVMBuildRetVoid(b);
 	}
+	LLVMBuildRetVoid(b);
 
 	LLVMDisposeBuilder(b);
 
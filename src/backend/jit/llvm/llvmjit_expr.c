@@ -323,15 +323,41 @@ llvm_compile_expr(ExprState *state)
 					/*
 					 * If the tupledesc of the to-be-deformed tuple is known,
 					 * and JITing of deforming is enabled, build deform
-					 * function specific to tupledesc and the exact number of
-					 * to-be-extracted attributes.
+					 * function specific to tupledesc and the exact set of
+					 * to-be-extracted attributes.  Prefer a function from the
+					 * code cache, which saves optimizing and emitting it
+					 * again, at the price of it not being inlined here.
 					 */
 					if (tts_ops && desc && (context->base.flags & PGJIT_DEFORM))
 					{
-						l_jit_deform =
-							slot_compile_deform(context, desc,
-												tts_ops,
-												op->d.fetch.last_var);
+						void	   *cached_deform = NULL;
+
+						if (jit_code_cache)
+							cached_deform =
+								llvm_cached_deform(context, desc,
+												   tts_ops,
+												   op->d.fetch.last_var,
+												   op->d.fetch.needed);
+
+						if (cached_deform)
+						{
+							LLVMTypeRef param_types[1];
+							LLVMTypeRef deform_sig;
+
+							param_types[0] = l_ptr(StructTupleTableSlot);
+							deform_sig = LLVMFunctionType(LLVMVoidType(),
+														  param_types,
+														  lengthof(param_types),
+														  0);
+							l_jit_deform = l_ptr_const(cached_deform,
+													   l_ptr(deform_sig));
+						}
+						else
+							l_jit_deform =
+								slot_compile_deform(context, desc,
+													tts_ops,
+													op->d.fetch.last_var,
+													op->d.fetch.needed);
 					}
 
 					if (l_jit_deform)
@@ -343,6 +369,19 @@ llvm_compile_expr(ExprState *state)
 						LLVMBuildCall(b, l_jit_deform,
 									  params, lengthof(params), "");
 					}
+					else if (op->d.fetch.needed)
+					{
+						LLVMValueRef params[3];
+
+						params[0] = v_slot;
+						params[1] = l_int32_const(op->d.fetch.last_var);
+						params[2] = l_ptr_const((void *) op->d.fetch.needed,
+												l_ptr(LLVMInt8Type()));
+
+						LLVMBuildCall(b,
+									  llvm_pg_func(mod, "slot_getsparseattrs_int"),
+									  params, lengthof(params), "");
+					}
 					else
 					{
 						LLVMValueRef params[2];
@@ -547,12 +586,24 @@ llvm_compile_expr(ExprState *state)
 
 			case EEOP_FUNCEXPR:
 			case EEOP_FUNCEXPR_STRICT:
+
+				/*
+				 * The built-in operators the interpreter evaluates itself
+				 * are strict functions; calling them lets them be inlined.
+				 */
+			case EEOP_FUNCEXPR_INT4_CMP:
+			case EEOP_FUNCEXPR_INT8_CMP:
+			case EEOP_FUNCEXPR_FLOAT8_CMP:
+			case EEOP_FUNCEXPR_BOOL_CMP:
+			case EEOP_FUNCEXPR_INT4_ARITH:
+			case EEOP_FUNCEXPR_INT8_ARITH:
+			case EEOP_FUNCEXPR_FLOAT8_ARITH:
 				{
 					FunctionCallInfo fcinfo = op->d.func.fcinfo_data;
 					LLVMValueRef v_fcinfo_isnull;
 					LLVMValueRef v_retval;
 
-					if (opcode == EEOP_FUNCEXPR_STRICT)
+					if (opcode != EEOP_FUNCEXPR)
 					{
 						LLVMBasicBlockRef b_nonull;
 						LLVMBasicBlockRef *b_checkargnulls;
@@ -1924,6 +1975,75 @@ llvm_compile_expr(ExprState *state)
 				LLVMBuildBr(b, opblocks[opno + 1]);
 				break;
 
+			case EEOP_COMMON_RESET:
+				{
+					LLVMValueRef v_generationp;
+					LLVMValueRef v_generation;
+
+					v_generationp =
+						l_ptr_const(&op->d.common_expr.common->generation,
+									l_ptr(LLVMInt64Type()));
+					v_generation = LLVMBuildLoad(b, v_generationp, "");
+					v_generation = LLVMBuildAdd(b, v_generation,
+												l_int64_const(1), "");
+					LLVMBuildStore(b, v_generation, v_generationp);
+
+					LLVMBuildBr(b, opblocks[opno + 1]);
+					break;
+				}
+
+			case EEOP_COMMON_FETCH:
+				{
+					CommonExpr *cexpr = op->d.common_expr.cexpr;
+					LLVMBasicBlockRef b_valid;
+					LLVMValueRef v_generation;
+					LLVMValueRef v_computed;
+					LLVMValueRef v_value;
+					LLVMValueRef v_isnull;
+
+					b_valid = l_bb_before_v(opblocks[opno + 1],
+											"op.%d.valid", opno);
+
+					/* has the value been computed for the current row? */
+					v_generation =
+						LLVMBuildLoad(b,
+									  l_ptr_const(&op->d.common_expr.common->generation,
+												  l_ptr(LLVMInt64Type())),
+									  "");
+					v_computed =
+						LLVMBuildLoad(b,
+									  l_ptr_const(&cexpr->generation,
+												  l_ptr(LLVMInt64Type())),
+									  "");
+					LLVMBuildCondBr(b,
+									LLVMBuildICmp(b, LLVMIntEQ, v_generation,
+												  v_computed, ""),
+									b_valid,
+									opblocks[opno + 1]);
+
+					/* if so, use it and skip computing it */
+					LLVMPositionBuilderAtEnd(b, b_valid);
+					v_value = LLVMBuildLoad(b,
+											l_ptr_const(&cexpr->value,
+														l_ptr(TypeSizeT)),
+											"");
+					v_isnull = LLVMBuildLoad(b,
+											 l_ptr_const(&cexpr->isnull,
+														 l_ptr(TypeStorageBool)),
+											 "");
+					LLVMBuildStore(b, v_value, v_resvaluep);
+					LLVMBuildStore(b, v_isnull, v_resnullp);
+
+					LLVMBuildBr(b, opblocks[op->d.common_expr.jumpdone]);
+					break;
+				}
+
+			case EEOP_COMMON_STORE:
+				build_EvalXFunc(b, mod, "ExecEvalCommonExprStore",
+								v_state, op);
+				LLVMBuildBr(b, opblocks[opno + 1]);
+				break;
+
 			case EEOP_AGG_STRICT_DESERIALIZE:
 			case EEOP_AGG_DESERIALIZE:
 				{
@@ -2085,6 +2205,12 @@ llvm_compile_expr(ExprState *state)
 					break;
 				}
 
+			case EEOP_AGG_HASHED_DISTINCT:
+				build_EvalXFunc(b, mod, "ExecEvalAggHashedDistinct",
+								v_state, op, v_econtext);
+				LLVMBuildBr(b, opblocks[opno + 1]);
+				break;
+
 			case EEOP_AGG_PLAIN_TRANS_INIT_STRICT_BYVAL:
 			case EEOP_AGG_PLAIN_TRANS_STRICT_BYVAL:
 			case EEOP_AGG_PLAIN_TRANS_BYVAL:
@@ -2429,6 +2555,23 @@ ExecRunCompiledExpr(ExprState *state, ExprContext *econtext, bool *isNull)
 	return func(state, econtext, isNull);
 }
 
+/*
+ * Return the name of the function generated for an expression, if it has
+ * been JIT compiled but not yet been called, NULL otherwise.  Code generated
+ * into the same module can call that function directly.
+ */
+const char *
+llvm_compiled_expr_funcname(ExprState *state)
+{
+	CompiledExprState *cstate;
+
+	if (state->evalfunc != ExecRunCompiledExpr)
+		return NULL;
+
+	cstate = state->evalfunc_private;
+	return cstate->funcname;
+}
+
 static LLVMValueRef
 BuildV1Call(LLVMJitContext *context, LLVMBuilderRef b,
 			LLVMModuleRef mod, FunctionCallInfo fcinfo,
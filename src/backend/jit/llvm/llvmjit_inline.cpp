@@ -11,6 +11,15 @@
  * so for all external functions, all the referenced functions (and
  * prerequisites) will be imported.
  *
+ * Planning requires loading the summary indexes and the modules defining the
+ * candidate functions, which easily takes hundreds of milliseconds the first
+ * time a backend inlines.  The plan only depends on the set of external
+ * functions the module references, so with jit_code_cache the plan is
+ * cached, together with the bitcode of just the definitions it imports.  On
+ * a cache hit, those definitions are imported without consulting the
+ * summaries at all.  With jit_code_cache_on_disk, plans are also stored in
+ * the on-disk code cache, shared by all backends.
+ *
  * Copyright (c) 2016-2020, PostgreSQL Global Development Group
  *
  * IDENTIFICATION
@@ -34,7 +43,9 @@ extern "C"
 #include <sys/types.h>
 #include <unistd.h>
 
+#include "common/hashfn.h"
 #include "common/string.h"
+#include "lib/stringinfo.h"
 #include "miscadmin.h"
 #include "storage/fd.h"
 }
@@ -45,12 +56,16 @@ extern "C"
 /* Avoid macro clash with LLVM's C++ headers */
 #undef Min
 
+#include <algorithm>
+#include <string>
+
 #include <llvm/ADT/SetVector.h>
 #include <llvm/ADT/StringSet.h>
 #include <llvm/ADT/StringMap.h>
 #include <llvm/Analysis/ModuleSummaryAnalysis.h>
 #if LLVM_VERSION_MAJOR > 3
 #include <llvm/Bitcode/BitcodeReader.h>
+#include <llvm/Bitcode/BitcodeWriter.h>
 #else
 #include <llvm/Bitcode/ReaderWriter.h>
 #include <llvm/Support/Error.h>
@@ -63,6 +78,8 @@ extern "C"
 #include <llvm/IR/ModuleSummaryIndex.h>
 #include <llvm/Linker/IRMover.h>
 #include <llvm/Support/ManagedStatic.h>
+#include <llvm/Support/raw_ostream.h>
+#include <llvm/Transforms/Utils/Cloning.h>
 
 
 /*
@@ -112,6 +129,12 @@ typedef llvm::StringMap<std::unique_ptr<llvm::Module> > ModuleCache;
 llvm::ManagedStatic<ModuleCache> module_cache;
 typedef llvm::StringMap<std::unique_ptr<llvm::ModuleSummaryIndex> > SummaryCache;
 llvm::ManagedStatic<SummaryCache> summary_cache;
+/* serialized inline plans, see inline_plan_key() */
+typedef llvm::StringMap<std::string> InlinePlanCache;
+llvm::ManagedStatic<InlinePlanCache> inline_plan_cache;
+
+/* don't keep more than this many inline plans in memory */
+#define INLINE_PLAN_CACHE_MAX_ENTRIES 64
 
 
 static std::unique_ptr<ImportMapTy> llvm_build_inline_plan(llvm::Module *mod);
@@ -140,10 +163,18 @@ static void function_references(llvm::Function &F,
 								llvm::SmallPtrSet<llvm::GlobalVariable *, 8> &referencedVars,
 								llvm::SmallPtrSet<llvm::Function *, 8> &referencedFunctions);
 
+static std::string summary_path(llvm::StringRef modpath);
 static void add_module_to_inline_search_path(InlineSearchPath& path, llvm::StringRef modpath);
 static llvm::SmallVector<llvm::GlobalValueSummary *, 1>
 summaries_for_guid(const InlineSearchPath& path, llvm::GlobalValue::GUID guid);
 
+#if LLVM_VERSION_MAJOR > 6
+static bool inline_plan_key(llvm::Module *mod, std::string &key);
+static std::unique_ptr<ImportMapTy> inline_plan_lookup(const std::string &key);
+static void inline_plan_store(const std::string &key, ImportMapTy *globalsToInline);
+static std::unique_ptr<ImportMapTy> inline_plan_deserialize(llvm::StringRef payload);
+#endif
+
 /* verbose debugging for inliner development */
 /* #define INLINE_DEBUG */
 #ifdef INLINE_DEBUG
@@ -160,10 +191,28 @@ void
 llvm_inline(LLVMModuleRef M)
 {
 	llvm::Module *mod = llvm::unwrap(M);
+	std::unique_ptr<ImportMapTy> globalsToInline;
+#if LLVM_VERSION_MAJOR > 6
+	std::string key;
+	bool use_cache = jit_code_cache && inline_plan_key(mod, key);
+
+	if (use_cache)
+		globalsToInline = inline_plan_lookup(key);
+	if (globalsToInline)
+	{
+		llvm_execute_inline_plan(mod, globalsToInline.get());
+		return;
+	}
+#endif
 
-	std::unique_ptr<ImportMapTy> globalsToInline = llvm_build_inline_plan(mod);
+	globalsToInline = llvm_build_inline_plan(mod);
 	if (!globalsToInline)
 		return;
+#if LLVM_VERSION_MAJOR > 6
+	/* has to happen before executing the plan consumes the modules */
+	if (use_cache)
+		inline_plan_store(key, globalsToInline.get());
+#endif
 	llvm_execute_inline_plan(mod, globalsToInline.get());
 }
 
@@ -786,6 +835,21 @@ llvm_load_summary(llvm::StringRef path)
 	return nullptr;
 }
 
+/*
+ * Return the path of the summary index file for modpath, which has to start
+ * with $libdir/.
+ */
+static std::string
+summary_path(llvm::StringRef modpath)
+{
+	std::string path(modpath);
+
+	path = path.replace(0, strlen("$libdir"), std::string(pkglib_path) + "/bitcode");
+	path += ".index.bc";
+
+	return path;
+}
+
 /*
  * Attempt to add modpath to the search path.
  */
@@ -800,10 +864,7 @@ add_module_to_inline_search_path(InlineSearchPath& searchpath, llvm::StringRef m
 	auto it = summary_cache->find(modpath);
 	if (it == summary_cache->end())
 	{
-		std::string path(modpath);
-		path = path.replace(0, strlen("$libdir"), std::string(pkglib_path) + "/bitcode");
-		path += ".index.bc";
-		(*summary_cache)[modpath] = llvm_load_summary(path);
+		(*summary_cache)[modpath] = llvm_load_summary(summary_path(modpath));
 		it = summary_cache->find(modpath);
 	}
 
@@ -877,3 +938,287 @@ create_redirection_function(std::unique_ptr<llvm::Module> &importMod,
 
 	return AF;
 }
+
+#if LLVM_VERSION_MAJOR > 6
+
+/*
+ * Build the key for caching the inline plan for mod.
+ *
+ * llvm_build_inline_plan() only looks at the external functions mod
+ * declares, and at the summaries and modules of the search path, so the key
+ * consists of the sorted names of the former, and of the size and
+ * modification time of the summary index of each module that may be searched.
+ * The latter change whenever postgres or an extension is reinstalled.
+ * Returns false if the plan cannot be cached.
+ */
+static bool
+inline_plan_key(llvm::Module *mod, std::string &key)
+{
+	llvm::SmallVector<llvm::StringRef, 64> names;
+	llvm::SmallVector<std::string, 4> modpaths;
+
+	modpaths.push_back("$libdir/postgres");
+
+	for (const llvm::Function &funcDecl : mod->functions())
+	{
+		char *cmodname;
+		char *cfuncname;
+
+		if (!funcDecl.isDeclaration() || funcDecl.isIntrinsic())
+			continue;
+
+		names.push_back(funcDecl.getName());
+
+		llvm_split_symbol_name(funcDecl.getName().data(), &cmodname, &cfuncname);
+		if (cmodname && llvm::StringRef(cmodname).startswith("$libdir/"))
+			modpaths.push_back(cmodname);
+	}
+
+	std::sort(names.begin(), names.end());
+	std::sort(modpaths.begin(), modpaths.end());
+	modpaths.erase(std::unique(modpaths.begin(), modpaths.end()),
+				   modpaths.end());
+
+	key.append((const char *) &llvm_code_fingerprint,
+			   sizeof(llvm_code_fingerprint));
+
+	for (const std::string &modpath : modpaths)
+	{
+		struct stat st;
+		int64 filestat[2] = {-1, -1};
+
+		if (stat(summary_path(modpath).c_str(), &st) == 0)
+		{
+			filestat[0] = st.st_size;
+			filestat[1] = st.st_mtime;
+		}
+		else if (modpath == "$libdir/postgres")
+			return false;		/* no inlining possible */
+
+		key.append(modpath);
+		key.push_back('\0');
+		key.append((const char *) filestat, sizeof(filestat));
+	}
+
+	for (llvm::StringRef name : names)
+	{
+		key.append(name.data(), name.size());
+		key.push_back('\0');
+	}
+
+	return true;
+}
+
+/*
+ * Look up the plan for key, first in memory, then on disk.  On success, the
+ * modules to import from are put into module_cache, as
+ * llvm_execute_inline_plan() expects.  Returns an empty pointer if the plan
+ * is not cached.
+ */
+static std::unique_ptr<ImportMapTy>
+inline_plan_lookup(const std::string &key)
+{
+	auto it = inline_plan_cache->find(key);
+	std::string payload;
+	StringInfoData skey;
+	LLVMMemoryBufferRef buf;
+
+	if (it != inline_plan_cache->end())
+		return inline_plan_deserialize(it->second);
+
+	if (!jit_code_cache_on_disk)
+		return nullptr;
+
+	initStringInfo(&skey);
+	appendBinaryStringInfo(&skey, key.data(), key.size());
+	buf = llvm_cache_read_file(hash_bytes_extended((const unsigned char *) key.data(),
+												   key.size(), 0),
+							   "inline", &skey);
+	pfree(skey.data);
+	if (buf == NULL)
+		return nullptr;
+
+	payload.assign(LLVMGetBufferStart(buf), LLVMGetBufferSize(buf));
+	LLVMDisposeMemoryBuffer(buf);
+
+	if (inline_plan_cache->size() < INLINE_PLAN_CACHE_MAX_ENTRIES)
+	{
+		it = inline_plan_cache->insert(std::make_pair(key, std::move(payload))).first;
+		return inline_plan_deserialize(it->second);
+	}
+
+	return inline_plan_deserialize(payload);
+}
+
+/*
+ * Append a length-prefixed item to a serialized plan.
+ */
+static void
+plan_append(std::string &payload, const char *data, uint32 len)
+{
+	payload.append((const char *) &len, sizeof(len));
+	payload.append(data, len);
+}
+
+/*
+ * Read a length-prefixed item from the front of a serialized plan.
+ */
+static bool
+plan_read(llvm::StringRef &payload, llvm::StringRef &item)
+{
+	uint32 len;
+
+	if (payload.size() < sizeof(len))
+		return false;
+	memcpy(&len, payload.data(), sizeof(len));
+	payload = payload.drop_front(sizeof(len));
+
+	if (payload.size() < len)
+		return false;
+	item = payload.take_front(len);
+	payload = payload.drop_front(len);
+
+	return true;
+}
+
+/*
+ * Serialize a freshly built plan and cache it.
+ *
+ * For each module to import from, the plan is stored as the module's path,
+ * the names of the globals to import, and the bitcode of a copy of the module
+ * that only keeps the definitions of those globals.  That copy is all
+ * llvm_execute_inline_plan() needs to perform the same import again.
+ */
+static void
+inline_plan_store(const std::string &key, ImportMapTy *globalsToInline)
+{
+	std::string payload;
+
+	for (const auto& toInline : *globalsToInline)
+	{
+		llvm::StringRef modPath = toInline.first();
+		const llvm::StringSet<>& modGlobalsToInline = toInline.second;
+		llvm::StringSet<> funcNames;
+		std::string names;
+		llvm::ValueToValueMapTy VMap;
+		llvm::SmallVector<char, 0> bitcode;
+		llvm::raw_svector_ostream os(bitcode);
+
+		Assert(module_cache->count(modPath));
+
+		for (auto &glob: modGlobalsToInline)
+		{
+			char *modname;
+			char *funcname;
+
+			llvm_split_symbol_name(glob.first().data(), &modname, &funcname);
+			funcNames.insert(funcname);
+
+			names.append(glob.first().data(), glob.first().size());
+			names.push_back('\0');
+		}
+
+		std::unique_ptr<llvm::Module> extractMod =
+			llvm::CloneModule(*(*module_cache)[modPath], VMap,
+							  [&funcNames](const llvm::GlobalValue *GV) {
+								  return funcNames.count(GV->getName()) > 0;
+							  });
+
+		/* drop the declarations of everything not referenced */
+		for (auto it = extractMod->begin(); it != extractMod->end();)
+		{
+			llvm::Function &F = *it++;
+
+			if (F.isDeclaration() && F.use_empty())
+				F.eraseFromParent();
+		}
+		for (auto it = extractMod->global_begin(); it != extractMod->global_end();)
+		{
+			llvm::GlobalVariable &GV = *it++;
+
+			if (GV.isDeclaration() && GV.use_empty())
+				GV.eraseFromParent();
+		}
+
+		llvm::WriteBitcodeToFile(*extractMod, os);
+
+		plan_append(payload, modPath.data(), modPath.size());
+		plan_append(payload, names.data(), names.size());
+		plan_append(payload, bitcode.data(), bitcode.size());
+	}
+
+	if (jit_code_cache_on_disk)
+	{
+		StringInfoData skey;
+		LLVMMemoryBufferRef buf;
+
+		initStringInfo(&skey);
+		appendBinaryStringInfo(&skey, key.data(), key.size());
+		buf = LLVMCreateMemoryBufferWithMemoryRange(payload.data(),
+													payload.size(),
+													"inline plan", false);
+		llvm_cache_write_file(hash_bytes_extended((const unsigned char *) key.data(),
+												  key.size(), 0),
+							  "inline", &skey, buf);
+		LLVMDisposeMemoryBuffer(buf);
+		pfree(skey.data);
+	}
+
+	if (inline_plan_cache->size() < INLINE_PLAN_CACHE_MAX_ENTRIES ||
+		inline_plan_cache->count(key))
+		(*inline_plan_cache)[key] = std::move(payload);
+}
+
+/*
+ * Parse a serialized plan, putting the modules to import from into
+ * module_cache.  Returns an empty pointer if the plan cannot be parsed, in
+ * which case module_cache is left alone.
+ */
+static std::unique_ptr<ImportMapTy>
+inline_plan_deserialize(llvm::StringRef payload)
+{
+	std::unique_ptr<ImportMapTy> globalsToInline(new ImportMapTy());
+	llvm::SmallVector<std::pair<llvm::StringRef, std::unique_ptr<llvm::Module> >, 4> importMods;
+
+	while (!payload.empty())
+	{
+		llvm::StringRef modPath;
+		llvm::StringRef names;
+		llvm::StringRef bitcode;
+
+		if (!plan_read(payload, modPath) ||
+			!plan_read(payload, names) ||
+			!plan_read(payload, bitcode))
+			return nullptr;
+
+		llvm::Expected<std::unique_ptr<llvm::Module> > ModOrErr =
+			llvm::parseBitcodeFile(llvm::MemoryBufferRef(bitcode, modPath),
+								   *llvm::unwrap(LLVMGetGlobalContext()));
+		if (!ModOrErr)
+		{
+			llvm::consumeError(ModOrErr.takeError());
+			return nullptr;
+		}
+
+		{
+			llvm::StringSet<> &modGlobalsToInline = (*globalsToInline)[modPath];
+
+			while (!names.empty())
+			{
+				std::pair<llvm::StringRef, llvm::StringRef> split = names.split('\0');
+
+				modGlobalsToInline.insert(split.first);
+				names = split.second;
+			}
+		}
+
+		importMods.push_back(std::make_pair(modPath, std::move(ModOrErr.get())));
+	}
+
+	for (auto &importMod : importMods)
+		(*module_cache)[importMod.first] = std::move(importMod.second);
+
+	return globalsToInline;
+}
+
+#endif							/* LLVM_VERSION_MAJOR > 6 */
@@ -0,0 +1,294 @@
+/*-------------------------------------------------------------------------
+ *
+ * llvmjit_pipeline.c
+ *	  Generate code for the input loop of an aggregation.
+ *
+ * When the input of an Agg node arrives in batches, the per-tuple work left
+ * to do is to point the per-input-tuple expression context at the tuple,
+ * look up its hash table entries if needed, evaluate the transition
+ * expression and reset the per-tuple memory.  Generating that loop into the
+ * module holding the JIT compiled transition expression lets the optimizer
+ * inline the expression, and the tuple deforming code inlined into it, into
+ * the loop, instead of making an indirect call for each tuple.
+ *
+ * Portions Copyright (c) 1996-2020, PostgreSQL Global Development Group
+ * Portions Copyright (c) 1994, Regents of the University of California
+ *
+ * IDENTIFICATION
+ *	  src/backend/jit/llvm/llvmjit_pipeline.c
+ *
+ *-------------------------------------------------------------------------
+ */
+
+#include "postgres.h"
+
+#include <llvm-c/Core.h>
+
+#include "executor/execExpr.h"
+#include "executor/nodeAgg.h"
+#include "jit/llvmjit.h"
+#include "jit/llvmjit_emit.h"
+#include "portability/instr_time.h"
+
+
+typedef struct CompiledAggPipeline
+{
+	LLVMJitContext *context;
+	const char *funcname;
+	ExprState  *evaltrans;
+} CompiledAggPipeline;
+
+static void ExecRunCompiledAggPipeline(AggState *aggstate,
+									   TupleTableSlot **slots, int *sel,
+									   int start, int end);
+
+
+/*
+ * JIT compile the input loop of aggstate, evaluating the transition
+ * expression evaltrans for each input tuple.
+ *
+ * This only works if evaltrans itself has been JIT compiled into the
+ * module that's still open for writing, so the generated loop can call it
+ * directly.
+ */
+bool
+llvm_compile_agg_pipeline(AggState *aggstate, ExprState *evaltrans)
+{
+	EState	   *estate = aggstate->ss.ps.state;
+	ExprContext *tmpcontext = aggstate->tmpcontext;
+	bool		hashed = aggstate->aggstrategy == AGG_HASHED;
+	LLVMJitContext *context;
+	const char *evalname;
+	char	   *funcname;
+
+	LLVMModuleRef mod;
+	LLVMBuilderRef b;
+	LLVMTypeRef pipeline_sig;
+	LLVMValueRef v_pipeline_fn;
+	LLVMValueRef v_eval_fn;
+
+	LLVMBasicBlockRef b_entry;
+	LLVMBasicBlockRef b_check;
+	LLVMBasicBlockRef b_body;
+	LLVMBasicBlockRef b_fast;
+	LLVMBasicBlockRef b_slow;
+	LLVMBasicBlockRef b_next;
+	LLVMBasicBlockRef b_out;
+
+	LLVMValueRef v_aggstate;
+	LLVMValueRef v_slots;
+	LLVMValueRef v_sel;
+	LLVMValueRef v_start;
+	LLVMValueRef v_end;
+	LLVMValueRef v_ip;
+	LLVMValueRef v_isnullp;
+	LLVMValueRef v_evaltrans;
+	LLVMValueRef v_tmpcontext;
+	LLVMValueRef v_tuplemem;
+
+	instr_time	starttime;
+	instr_time	endtime;
+
+	context = (LLVMJitContext *) estate->es_jit;
+	if (context == NULL || context->module == NULL)
+		return false;
+
+	evalname = llvm_compiled_expr_funcname(evaltrans);
+	if (evalname == NULL)
+		return false;
+
+	llvm_enter_fatal_on_oom();
+
+	v_eval_fn = LLVMGetNamedFunction(context->module, evalname);
+	if (v_eval_fn == NULL)
+	{
+		/* emitted already, or generated into an earlier module */
+		llvm_leave_fatal_on_oom();
+		return false;
+	}
+
+	INSTR_TIME_SET_CURRENT(starttime);
+
+	mod = llvm_mutable_module(context);
+
+	b = LLVMCreateBuilder();
+
+	funcname = llvm_expand_funcname(context, "aggpipeline");
+
+	/* Create the signature and function */
+	{
+		LLVMTypeRef param_types[5];
+
+		param_types[0] = l_ptr(StructAggState);	/* aggstate */
+		param_types[1] = l_ptr(l_ptr(StructTupleTableSlot));	/* slots */
+		param_types[2] = l_ptr(LLVMInt32Type());	/* sel */
+		param_types[3] = LLVMInt32Type();	/* start */
+		param_types[4] = LLVMInt32Type();	/* end */
+
+		pipeline_sig = LLVMFunctionType(LLVMVoidType(),
+										param_types, lengthof(param_types),
+										false);
+	}
+	v_pipeline_fn = LLVMAddFunction(mod, funcname, pipeline_sig);
+	LLVMSetLinkage(v_pipeline_fn, LLVMExternalLinkage);
+	LLVMSetVisibility(v_pipeline_fn, LLVMDefaultVisibility);
+	llvm_copy_attributes(AttributeTemplate, v_pipeline_fn);
+
+	b_entry = LLVMAppendBasicBlock(v_pipeline_fn, "entry");
+	b_check = LLVMAppendBasicBlock(v_pipeline_fn, "check");
+	b_body = LLVMAppendBasicBlock(v_pipeline_fn, "body");
+	b_fast = LLVMAppendBasicBlock(v_pipeline_fn, "evaltrans");
+	b_slow = LLVMAppendBasicBlock(v_pipeline_fn, "advance");
+	b_next = LLVMAppendBasicBlock(v_pipeline_fn, "next");
+	b_out = LLVMAppendBasicBlock(v_pipeline_fn, "out");
+
+	v_aggstate = LLVMGetParam(v_pipeline_fn, 0);
+	v_slots = LLVMGetParam(v_pipeline_fn, 1);
+	v_sel = LLVMGetParam(v_pipeline_fn, 2);
+	v_start = LLVMGetParam(v_pipeline_fn, 3);
+	v_end = LLVMGetParam(v_pipeline_fn, 4);
+
+	/* these stay the same for the lifetime of the node */
+	v_evaltrans = l_ptr_const(evaltrans, l_ptr(StructExprState));
+	v_tmpcontext = l_ptr_const(tmpcontext, l_ptr(StructExprContext));
+	v_tuplemem = l_ptr_const(tmpcontext->ecxt_per_tuple_memory,
+							 l_ptr(StructMemoryContextData));
+
+	LLVMPositionBuilderAtEnd(b, b_entry);
+	v_ip = LLVMBuildAlloca(b, LLVMInt32Type(), "i");
+	v_isnullp = LLVMBuildAlloca(b, TypeParamBool, "isnull");
+	LLVMBuildStore(b, v_start, v_ip);
+	LLVMBuildBr(b, b_check);
+
+	/* loop while i < end */
+	LLVMPositionBuilderAtEnd(b, b_check);
+	LLVMBuildCondBr(b,
+					LLVMBuildICmp(b, LLVMIntSLT,
+								  LLVMBuildLoad(b, v_ip, ""),
+								  v_end, ""),
+					b_body, b_out);
+
+	/* set up tmpcontext->ecxt_outertuple = slots[sel[i]] */
+	LLVMPositionBuilderAtEnd(b, b_body);
+	{
+		LLVMValueRef v_i;
+		LLVMValueRef v_slotno;
+		LLVMValueRef v_slot;
+
+		v_i = LLVMBuildLoad(b, v_ip, "");
+		v_slotno = LLVMBuildLoad(b, LLVMBuildGEP(b, v_sel, &v_i, 1, ""),
+								 "slotno");
+		v_slot = LLVMBuildLoad(b, LLVMBuildGEP(b, v_slots, &v_slotno, 1, ""),
+							   "slot");
+		LLVMBuildStore(b, v_slot,
+					   LLVMBuildStructGEP(b, v_tmpcontext,
+										  FIELDNO_EXPRCONTEXT_OUTERTUPLE,
+										  "v_outertuplep"));
+	}
+
+	/*
+	 * For hashed aggregation, find or build the hash table entries.  If that
+	 * made the hash table spill, the transition expression to use is a
+	 * different one, and the generic code has to evaluate it.
+	 */
+	if (hashed)
+	{
+		LLVMValueRef v_cur;
+
+		v_cur = LLVMBuildCall(b,
+							  llvm_pg_func(mod, "ExecAggPipelineLookup"),
+							  &v_aggstate, 1, "evaltrans");
+		LLVMBuildCondBr(b,
+						LLVMBuildICmp(b, LLVMIntEQ, v_cur, v_evaltrans, ""),
+						b_fast, b_slow);
+	}
+	else
+		LLVMBuildBr(b, b_fast);
+
+	/* evaluate the transition expression in the per-tuple memory context */
+	LLVMPositionBuilderAtEnd(b, b_fast);
+	{
+		LLVMValueRef v_oldcontext;
+		LLVMValueRef params[3];
+
+		v_oldcontext = l_mcxt_switch(mod, b, v_tuplemem);
+
+		params[0] = v_evaltrans;
+		params[1] = v_tmpcontext;
+		params[2] = v_isnullp;
+		LLVMBuildCall(b, v_eval_fn, params, lengthof(params), "");
+
+		l_mcxt_switch(mod, b, v_oldcontext);
+		LLVMBuildBr(b, b_next);
+	}
+
+	LLVMPositionBuilderAtEnd(b, b_slow);
+	LLVMBuildCall(b, llvm_pg_func(mod, "ExecAggPipelineAdvance"),
+				  &v_aggstate, 1, "");
+	LLVMBuildBr(b, b_next);
+
+	/* reset per-input-tuple context, and move on to the next tuple */
+	LLVMPositionBuilderAtEnd(b, b_next);
+	LLVMBuildCall(b, llvm_pg_func(mod, "MemoryContextReset"),
+				  &v_tuplemem, 1, "");
+	LLVMBuildStore(b,
+				   LLVMBuildAdd(b, LLVMBuildLoad(b, v_ip, ""),
+								l_int32_const(1), ""),
+				   v_ip);
+	LLVMBuildBr(b, b_check);
+
+	LLVMPositionBuilderAtEnd(b, b_out);
+	LLVMBuildRetVoid(b);
+
+	LLVMDisposeBuilder(b);
+
+	/* as for expressions, defer emitting until the first call */
+	{
+		CompiledAggPipeline *cstate = palloc0(sizeof(CompiledAggPipeline));
+
+		cstate->context = context;
+		cstate->funcname = funcname;
+		cstate->evaltrans = evaltrans;
+
+		aggstate->input_pipeline = ExecRunCompiledAggPipeline;
+		aggstate->input_pipeline_private = cstate;
+	}
+
+	llvm_leave_fatal_on_oom();
+
+	INSTR_TIME_SET_CURRENT(endtime);
+	INSTR_TIME_ACCUM_DIFF(context->base.instr.generation_counter,
+						  endtime, starttime);
+
+	return true;
+}
+
+/*
+ * Run compiled input loop.
+ *
+ * This will only be called for the first batch.  As the generated code calls
+ * the transition expression's function directly, make sure the expression is
+ * still valid first, as ExecRunCompiledExpr() would have done.
+ */
+static void
+ExecRunCompiledAggPipeline(AggState *aggstate, TupleTableSlot **slots,
+						   int *sel, int start, int end)
+{
+	CompiledAggPipeline *cstate = aggstate->input_pipeline_private;
+	AggInputPipeline func;
+
+	Assert(start < end);
+	aggstate->tmpcontext->ecxt_outertuple = slots[sel[start]];
+	CheckExprStillValid(cstate->evaltrans, aggstate->tmpcontext);
+
+	llvm_enter_fatal_on_oom();
+	func = (AggInputPipeline) llvm_get_function(cstate->context,
+												cstate->funcname);
+	llvm_leave_fatal_on_oom();
+	Assert(func);
+
+	/* remove indirection via this function for future calls */
+	aggstate->input_pipeline = func;
+
+	func(aggstate, slots, sel, start, end);
+}
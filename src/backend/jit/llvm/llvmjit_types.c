@@ -37,6 +37,7 @@
 #include "nodes/execnodes.h"
 #include "nodes/memnodes.h"
 #include "utils/expandeddatum.h"
+#include "utils/memutils.h"
 #include "utils/palloc.h"
 
 
@@ -99,12 +100,16 @@ FunctionReturningBool(void)
 void	   *referenced_functions[] =
 {
 	ExecAggInitGroup,
+	ExecAggPipelineAdvance,
+	ExecAggPipelineLookup,
 	ExecAggTransReparent,
+	ExecEvalAggHashedDistinct,
 	ExecEvalAggOrderedTransDatum,
 	ExecEvalAggOrderedTransTuple,
 	ExecEvalAlternativeSubPlan,
 	ExecEvalArrayCoerce,
 	ExecEvalArrayExpr,
+	ExecEvalCommonExprStore,
 	ExecEvalConstraintCheck,
 	ExecEvalConstraintNotNull,
 	ExecEvalConvertRowtype,
@@ -133,8 +138,10 @@ void	   *referenced_functions[] =
 	ExecEvalWholeRowVar,
 	ExecEvalXmlExpr,
 	MakeExpandedObjectReadOnlyInternal,
+	MemoryContextReset,
 	slot_getmissingattrs,
 	slot_getsomeattrs_int,
+	slot_getsparseattrs_int,
 	strlen,
 	varsize_any,
 };
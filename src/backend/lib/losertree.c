@@ -0,0 +1,236 @@
+/*-------------------------------------------------------------------------
+ *
+ * losertree.c
+ *	  A tournament ("loser") tree for K-way merging
+ *
+ * A loser tree is a complete binary tree whose leaves are the merge sources.
+ * Each internal node remembers the loser of the match played between the
+ * winners of its two subtrees, and the overall winner is kept separately.
+ * After the winner has been consumed and its source has advanced (or run
+ * dry), only the matches on the path from that source's leaf to the root
+ * need to be replayed, which costs one comparison per level.  A binary heap
+ * used for the same job needs up to two comparisons per level to sift the
+ * replacement down, so the tree roughly halves the comparisons spent per
+ * merged value.
+ *
+ * Portions Copyright (c) 2020, PostgreSQL Global Development Group
+ *
+ * IDENTIFICATION
+ *	  src/backend/lib/losertree.c
+ *
+ *-------------------------------------------------------------------------
+ */
+
+#include "postgres.h"
+
+#include "lib/losertree.h"
+
+static inline bool source_beats(losertree *tree, int a, int b);
+static void replay(losertree *tree, int source);
+
+/*
+ * losertree_allocate
+ *
+ * Returns a pointer to a newly-allocated tree that can merge up to the given
+ * number of sources, in the order defined by the given comparator function,
+ * which will be invoked with the additional argument specified by 'arg'.
+ */
+losertree *
+losertree_allocate(int capacity, losertree_comparator compare, void *arg)
+{
+	int			sz;
+	losertree  *tree;
+
+	Assert(capacity > 0);
+
+	/*
+	 * lt_nodes holds the losers, plus the same again as scratch for build.
+	 * The exhausted flags follow in the same chunk, so that callers can
+	 * account for the whole tree with GetMemoryChunkSpace().
+	 */
+	sz = offsetof(losertree, lt_nodes) + sizeof(int) * 2 * capacity;
+	tree = (losertree *) palloc(sz + sizeof(bool) * capacity);
+	tree->lt_capacity = capacity;
+	tree->lt_compare = compare;
+	tree->lt_arg = arg;
+	tree->lt_exhausted = (bool *) ((char *) tree + sz);
+
+	losertree_reset(tree, capacity);
+
+	return tree;
+}
+
+/*
+ * losertree_reset
+ *
+ * Prepares the tree for a new merge of 'nsources' sources, numbered from 0.
+ * All sources start out exhausted; add the ones that have data with
+ * losertree_add_unordered(), then call losertree_build().
+ */
+void
+losertree_reset(losertree *tree, int nsources)
+{
+	if (nsources < 0 || nsources > tree->lt_capacity)
+		elog(ERROR, "too many loser tree sources");
+	tree->lt_nsources = nsources;
+	tree->lt_nactive = 0;
+	memset(tree->lt_exhausted, true, sizeof(bool) * nsources);
+}
+
+/*
+ * losertree_free
+ *
+ * Releases memory used by the given losertree.
+ */
+void
+losertree_free(losertree *tree)
+{
+	pfree(tree);
+}
+
+/*
+ * losertree_add_unordered
+ *
+ * Marks the given source as having a current value.  The tree is not valid
+ * again until losertree_build() has been called.
+ */
+void
+losertree_add_unordered(losertree *tree, int source)
+{
+	Assert(source >= 0 && source < tree->lt_nsources);
+	Assert(tree->lt_exhausted[source]);
+	tree->lt_exhausted[source] = false;
+	tree->lt_nactive++;
+}
+
+/*
+ * losertree_build
+ *
+ * Plays the initial tournament among all sources, using K - 1 comparisons
+ * for K sources.
+ */
+void
+losertree_build(losertree *tree)
+{
+	int			nsources = tree->lt_nsources;
+	int		   *winners = &tree->lt_nodes[tree->lt_capacity];
+	int			n;
+
+	if (nsources == 0)
+		return;
+
+	/*
+	 * Node n has children 2n and 2n + 1.  Nodes nsources .. 2 * nsources - 1
+	 * are the leaves, standing for the sources themselves.
+	 */
+	for (n = nsources - 1; n >= 1; n--)
+	{
+		int			left = 2 * n;
+		int			right = 2 * n + 1;
+
+		left = (left >= nsources) ? left - nsources : winners[left];
+		right = (right >= nsources) ? right - nsources : winners[right];
+
+		if (source_beats(tree, right, left))
+		{
+			winners[n] = right;
+			tree->lt_nodes[n] = left;
+		}
+		else
+		{
+			winners[n] = left;
+			tree->lt_nodes[n] = right;
+		}
+	}
+
+	tree->lt_nodes[0] = (nsources == 1) ? 0 : winners[1];
+}
+
+/*
+ * losertree_first
+ *
+ * Returns the source whose current value comes first, without modifying the
+ * tree.  The tree must not be empty.
+ */
+int
+losertree_first(losertree *tree)
+{
+	Assert(!losertree_empty(tree));
+	return tree->lt_nodes[0];
+}
+
+/*
+ * losertree_replace_first
+ *
+ * To be called after the caller has replaced the current value of the winning
+ * source with its next value.  Restores the tree in O(log n) time, with one
+ * comparison per level.
+ */
+void
+losertree_replace_first(losertree *tree)
+{
+	Assert(!losertree_empty(tree));
+	replay(tree, tree->lt_nodes[0]);
+}
+
+/*
+ * losertree_remove_first
+ *
+ * To be called when the winning source has no more values.  The source will
+ * lose every match from now on.
+ */
+void
+losertree_remove_first(losertree *tree)
+{
+	int			source;
+
+	Assert(!losertree_empty(tree));
+	source = tree->lt_nodes[0];
+	tree->lt_exhausted[source] = true;
+	tree->lt_nactive--;
+
+	if (tree->lt_nactive > 0)
+		replay(tree, source);
+}
+
+/*
+ * Does source a win its match against source b?  An exhausted source loses
+ * against anything without consulting the comparator; ties go to the lower
+ * source number, to keep the merge deterministic.
+ */
+static inline bool
+source_beats(losertree *tree, int a, int b)
+{
+	int			cmp;
+
+	if (tree->lt_exhausted[a])
+		return false;
+	if (tree->lt_exhausted[b])
+		return true;
+
+	cmp = tree->lt_compare(a, b, tree->lt_arg);
+	return cmp < 0 || (cmp == 0 && a < b);
+}
+
+/*
+ * Replay the matches on the path from the given source's leaf to the root.
+ */
+static void
+replay(losertree *tree, int source)
+{
+	int			winner = source;
+	int			n;
+
+	for (n = (tree->lt_nsources + source) / 2; n >= 1; n /= 2)
+	{
+		int			loser = tree->lt_nodes[n];
+
+		if (source_beats(tree, loser, winner))
+		{
+			tree->lt_nodes[n] = winner;
+			winner = loser;
+		}
+	}
+
+	tree->lt_nodes[0] = winner;
+}
@@ -18,6 +18,7 @@
 #include <limits.h>
 #include <math.h>
 
+#include "access/stratnum.h"
 #include "access/sysattr.h"
 #include "access/tsmapi.h"
 #include "catalog/pg_class.h"
@@ -30,6 +31,7 @@
 #ifdef OPTIMIZER_DEBUG
 #include "nodes/print.h"
 #endif
+#include "nodes/supportnodes.h"
 #include "optimizer/appendinfo.h"
 #include "optimizer/clauses.h"
 #include "optimizer/cost.h"
@@ -140,6 +142,8 @@ static void subquery_push_qual(Query *subquery,
 							   RangeTblEntry *rte, Index rti, Node *qual);
 static void recurse_push_qual(Node *setOp, Query *topquery,
 							  RangeTblEntry *rte, Index rti, Node *qual);
+static void check_and_push_window_quals(Query *subquery, Index rti,
+										Node *clause);
 static void remove_unused_subquery_outputs(Query *subquery, RelOptInfo *rel);
 
 
@@ -2263,7 +2267,14 @@ set_subquery_pathlist(PlannerInfo *root, RelOptInfo *rel,
 			}
 			else
 			{
-				/* Keep it in the upper query */
+				/*
+				 * Keep it in the upper query.  If it filters on the result
+				 * of a window function, the subquery's WindowAgg may still
+				 * be able to use it to stop early.
+				 */
+				if (!rinfo->pseudoconstant &&
+					!(safetyInfo.unsafeLeaky && contain_leaked_vars(clause)))
+					check_and_push_window_quals(subquery, rti, clause);
 				upperrestrictlist = lappend(upperrestrictlist, rinfo);
 			}
 		}
@@ -3414,6 +3425,189 @@ recurse_push_qual(Node *setOp, Query *topquery,
  *			SIMPLIFYING SUBQUERY TARGETLISTS
  *****************************************************************************/
 
+/*
+ * check_and_push_window_quals
+ *		Check if a qual that can't be pushed into a subquery compares the
+ *		result of one of the subquery's window functions with a constant in a
+ *		way that lets the WindowAgg stop evaluating the function once the
+ *		comparison fails, and if so add a run condition for it.
+ *
+ * For example, row_number() only goes up within a partition, so once
+ * "row_number() OVER (...) <= 10" becomes false it can never become true
+ * again until the next partition starts.  Whether a window function behaves
+ * like that is determined by its prosupport function, see
+ * SupportRequestWFuncMonotonic.
+ *
+ * The qual itself is always kept in the upper query; the run condition is
+ * only an optimization, and the WindowAgg may not use it at all.
+ */
+static void
+check_and_push_window_quals(Query *subquery, Index rti, Node *clause)
+{
+	OpExpr	   *opexpr = (OpExpr *) clause;
+	Expr	   *leftop;
+	Expr	   *rightop;
+	Var		   *var;
+	bool		wfunc_left;
+	TargetEntry *tle;
+	WindowFunc *wfunc;
+	WindowClause *wclause = NULL;
+	Oid			prosupport;
+	SupportRequestWFuncMonotonic req;
+	SupportRequestWFuncMonotonic *res;
+	List	   *opinfos;
+	ListCell   *lc;
+
+	if (!subquery->hasWindowFuncs || subquery->distinctClause != NIL ||
+		subquery->setOperations != NULL)
+		return;
+
+	if (!IsA(opexpr, OpExpr) || list_length(opexpr->args) != 2 ||
+		contain_volatile_functions(clause))
+		return;
+
+	/* we need a Var of the subquery on one side and a Const on the other */
+	leftop = (Expr *) linitial(opexpr->args);
+	rightop = (Expr *) lsecond(opexpr->args);
+	if (IsA(leftop, Var) && IsA(rightop, Const))
+	{
+		var = (Var *) leftop;
+		wfunc_left = true;
+	}
+	else if (IsA(rightop, Var) && IsA(leftop, Const))
+	{
+		var = (Var *) rightop;
+		wfunc_left = false;
+	}
+	else
+		return;
+
+	if (var->varno != rti || var->varlevelsup != 0 || var->varattno <= 0)
+		return;
+
+	/* ... which must be the result of a plain window function */
+	tle = get_tle_by_resno(subquery->targetList, var->varattno);
+	if (tle == NULL || !IsA(tle->expr, WindowFunc))
+		return;
+	wfunc = (WindowFunc *) tle->expr;
+	if (wfunc->args != NIL || wfunc->aggfilter != NULL)
+		return;
+
+	foreach(lc, subquery->windowClause)
+	{
+		WindowClause *wc = (WindowClause *) lfirst(lc);
+
+		if (wc->winref == wfunc->winref)
+		{
+			wclause = wc;
+			break;
+		}
+	}
+	if (wclause == NULL)
+		return;
+
+	prosupport = get_func_support(wfunc->winfnoid);
+	if (!OidIsValid(prosupport))
+		return;
+
+	req.type = T_SupportRequestWFuncMonotonic;
+	req.window_func = wfunc;
+	req.window_clause = wclause;
+	req.monotonic = MONOTONICFUNC_NONE;
+
+	res = (SupportRequestWFuncMonotonic *)
+		DatumGetPointer(OidFunctionCall1(prosupport,
+										 PointerGetDatum(&req)));
+	if (res == NULL || res->monotonic == MONOTONICFUNC_NONE)
+		return;
+
+	/*
+	 * Now see whether the operator is a btree comparison operator, and if so
+	 * whether the comparison can only go from true to false as the function
+	 * moves through the partition.
+	 */
+	opinfos = get_op_btree_interpretation(opexpr->opno);
+	foreach(lc, opinfos)
+	{
+		OpBtreeInterpretation *opinfo = (OpBtreeInterpretation *) lfirst(lc);
+		MonotonicFunction needed;
+		Oid			runopno;
+		Expr	   *runcond;
+
+		switch (opinfo->strategy)
+		{
+			case BTLessStrategyNumber:
+			case BTLessEqualStrategyNumber:
+				/* wfunc < const needs an increasing function, and vice versa */
+				needed = wfunc_left ? MONOTONICFUNC_INCREASING :
+					MONOTONICFUNC_DECREASING;
+				if ((res->monotonic & needed) == 0)
+					continue;
+				runopno = opexpr->opno;
+				break;
+
+			case BTGreaterStrategyNumber:
+			case BTGreaterEqualStrategyNumber:
+				needed = wfunc_left ? MONOTONICFUNC_DECREASING :
+					MONOTONICFUNC_INCREASING;
+				if ((res->monotonic & needed) == 0)
+					continue;
+				runopno = opexpr->opno;
+				break;
+
+			case BTEqualStrategyNumber:
+
+				/*
+				 * A function that doesn't change within a partition can use
+				 * the equality itself.  Otherwise, once the function has
+				 * moved past the constant it can't come back to it, so use
+				 * <= or >= as the run condition instead.
+				 */
+				if (res->monotonic == MONOTONICFUNC_BOTH)
+				{
+					runopno = opexpr->opno;
+					break;
+				}
+				if (res->monotonic == MONOTONICFUNC_INCREASING)
+					runopno = get_opfamily_member(opinfo->opfamily_id,
+												  opinfo->oplefttype,
+												  opinfo->oprighttype,
+												  wfunc_left ?
+												  BTLessEqualStrategyNumber :
+												  BTGreaterEqualStrategyNumber);
+				else
+					runopno = get_opfamily_member(opinfo->opfamily_id,
+												  opinfo->oplefttype,
+												  opinfo->oprighttype,
+												  wfunc_left ?
+												  BTGreaterEqualStrategyNumber :
+												  BTLessEqualStrategyNumber);
+				if (!OidIsValid(runopno))
+					continue;
+				break;
+
+			default:
+				continue;
+		}
+
+		if (wfunc_left)
+			runcond = make_opclause(runopno, opexpr->opresulttype, false,
+									(Expr *) copyObject(wfunc),
+									(Expr *) copyObject(rightop),
+									opexpr->opcollid, opexpr->inputcollid);
+		else
+			runcond = make_opclause(runopno, opexpr->opresulttype, false,
+									(Expr *) copyObject(leftop),
+									(Expr *) copyObject(wfunc),
+									opexpr->opcollid, opexpr->inputcollid);
+		set_opfuncid((OpExpr *) runcond);
+
+		wclause->runCondition = lappend(wclause->runCondition, runcond);
+		break;
+	}
+	list_free_deep(opinfos);
+}
+
 /*
  * remove_unused_subquery_outputs
  *		Remove subquery targetlist items we don't need
@@ -3857,6 +4051,10 @@ print_path(PlannerInfo *root, Path *path, int indent)
 			ptype = "Material";
 			subpath = ((MaterialPath *) path)->subpath;
 			break;
+		case T_ResultCachePath:
+			ptype = "ResultCache";
+			subpath = ((ResultCachePath *) path)->subpath;
+			break;
 		case T_UniquePath:
 			ptype = "Unique";
 			subpath = ((UniquePath *) path)->subpath;
@@ -3869,6 +4067,10 @@ print_path(PlannerInfo *root, Path *path, int indent)
 			ptype = "GatherMerge";
 			subpath = ((GatherMergePath *) path)->subpath;
 			break;
+		case T_RedistributePath:
+			ptype = "Redistribute";
+			subpath = ((RedistributePath *) path)->subpath;
+			break;
 		case T_ProjectionPath:
 			ptype = "Projection";
 			subpath = ((ProjectionPath *) path)->subpath;
@@ -3881,6 +4083,10 @@ print_path(PlannerInfo *root, Path *path, int indent)
 			ptype = "Sort";
 			subpath = ((SortPath *) path)->subpath;
 			break;
+		case T_IncrementalSortPath:
+			ptype = "IncrementalSort";
+			subpath = ((SortPath *) path)->subpath;
+			break;
 		case T_GroupPath:
 			ptype = "Group";
 			subpath = ((GroupPath *) path)->subpath;
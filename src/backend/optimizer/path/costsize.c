@@ -79,6 +79,7 @@
 #include "executor/executor.h"
 #include "executor/nodeAgg.h"
 #include "executor/nodeHash.h"
+#include "executor/nodeResultCache.h"
 #include "miscadmin.h"
 #include "nodes/makefuncs.h"
 #include "nodes/nodeFuncs.h"
@@ -128,11 +129,15 @@ bool		enable_indexonlyscan = true;
 bool		enable_bitmapscan = true;
 bool		enable_tidscan = true;
 bool		enable_sort = true;
+bool		enable_incremental_sort = true;
 bool		enable_hashagg = true;
 bool		enable_hashagg_disk = true;
 bool		enable_groupingsets_hash_disk = false;
 bool		enable_nestloop = true;
+bool		enable_batched_nestloop = false;
+bool		enable_late_materialization = true;
 bool		enable_material = true;
+bool		enable_resultcache = false;
 bool		enable_mergejoin = true;
 bool		enable_hashjoin = true;
 bool		enable_gathermerge = true;
@@ -140,7 +145,10 @@ bool		enable_partitionwise_join = false;
 bool		enable_partitionwise_aggregate = false;
 bool		enable_parallel_append = true;
 bool		enable_parallel_hash = true;
+bool		enable_parallel_hashagg = true;
+bool		enable_parallel_window = true;
 bool		enable_partition_pruning = true;
+bool		enable_async_append = true;
 
 typedef struct
 {
@@ -457,6 +465,61 @@ cost_gather_merge(GatherMergePath *path, PlannerInfo *root,
 	path->path.total_cost = (startup_cost + run_cost + input_total_cost);
 }
 
+/*
+ * cost_redistribute
+ *	  Determines and returns the cost of exchanging the rows of a partial
+ *	  path among the parallel workers.
+ *
+ * 'numCols' is the number of key columns to hash.  'tuples' is the number
+ * of rows each worker reads from its input.
+ *
+ * Each worker hashes its input rows and sends those that belong to another
+ * worker through a shared memory queue, which we charge at the same rate as
+ * sending rows to the leader.  It stores the rows it receives, like a
+ * Material node, and can't return any before all workers are done sending,
+ * so all of that goes into the startup cost.  The leader doesn't take part,
+ * so the rows are divided among the workers only.
+ */
+void
+cost_redistribute(Path *path, int numCols,
+				  Cost input_startup_cost, Cost input_total_cost,
+				  double tuples, int width)
+{
+	Cost		startup_cost = input_total_cost;
+	Cost		run_cost = 0;
+	int			nworkers = path->parallel_workers;
+	double		output_tuples;
+	double		nbytes;
+	long		work_mem_bytes = work_mem * 1024L;
+
+	Assert(nworkers > 0);
+	output_tuples = clamp_row_est(tuples * get_parallel_divisor(path) /
+								  nworkers);
+	nbytes = relation_byte_size(output_tuples, width);
+
+	path->rows = output_tuples;
+
+	/* hash the keys, and send all but our own share of the rows */
+	startup_cost += cpu_operator_cost * numCols * tuples;
+	startup_cost += parallel_tuple_cost * tuples * (nworkers - 1) / nworkers;
+
+	/* store and fetch the rows, charged like cost_material */
+	startup_cost += cpu_operator_cost * output_tuples;
+	run_cost += cpu_operator_cost * output_tuples;
+
+	/* if we will spill to disk, write and read each page once */
+	if (nbytes > work_mem_bytes)
+	{
+		double		npages = ceil(nbytes / BLCKSZ);
+
+		startup_cost += seq_page_cost * npages;
+		run_cost += seq_page_cost * npages;
+	}
+
+	path->startup_cost = startup_cost;
+	path->total_cost = startup_cost + run_cost;
+}
+
 /*
  * cost_index
  *	  Determines and returns the cost of scanning a relation using an index.
@@ -1648,9 +1711,9 @@ cost_recursive_union(Path *runion, Path *nrterm, Path *rterm)
 }
 
 /*
- * cost_sort
- *	  Determines and returns the cost of sorting a relation, including
- *	  the cost of reading the input data.
+ * cost_tuplesort
+ *	  Determines and returns the cost of sorting a relation using tuplesort,
+ *	  not including the cost of reading the input data.
  *
  * If the total volume of data to sort is less than sort_mem, we will do
  * an in-memory sort, which requires no I/O and about t*log2(t) tuple
@@ -1677,39 +1740,23 @@ cost_recursive_union(Path *runion, Path *nrterm, Path *rterm)
  * specifying nonzero comparison_cost; typically that's used for any extra
  * work that has to be done to prepare the inputs to the comparison operators.
  *
- * 'pathkeys' is a list of sort keys
- * 'input_cost' is the total cost for reading the input data
  * 'tuples' is the number of tuples in the relation
  * 'width' is the average tuple width in bytes
  * 'comparison_cost' is the extra cost per comparison, if any
  * 'sort_mem' is the number of kilobytes of work memory allowed for the sort
  * 'limit_tuples' is the bound on the number of output tuples; -1 if no bound
- *
- * NOTE: some callers currently pass NIL for pathkeys because they
- * can't conveniently supply the sort keys.  Since this routine doesn't
- * currently do anything with pathkeys anyway, that doesn't matter...
- * but if it ever does, it should react gracefully to lack of key data.
- * (Actually, the thing we'd most likely be interested in is just the number
- * of sort keys, which all callers *could* supply.)
  */
-void
-cost_sort(Path *path, PlannerInfo *root,
-		  List *pathkeys, Cost input_cost, double tuples, int width,
-		  Cost comparison_cost, int sort_mem,
-		  double limit_tuples)
+static void
+cost_tuplesort(Cost *startup_cost, Cost *run_cost,
+			   double tuples, int width,
+			   Cost comparison_cost, int sort_mem,
+			   double limit_tuples)
 {
-	Cost		startup_cost = input_cost;
-	Cost		run_cost = 0;
 	double		input_bytes = relation_byte_size(tuples, width);
 	double		output_bytes;
 	double		output_tuples;
 	long		sort_mem_bytes = sort_mem * 1024L;
 
-	if (!enable_sort)
-		startup_cost += disable_cost;
-
-	path->rows = tuples;
-
 	/*
 	 * We want to be sure the cost of a sort is never estimated as zero, even
 	 * if passed-in tuple count is zero.  Besides, mustn't do log(0)...
@@ -1748,7 +1795,7 @@ cost_sort(Path *path, PlannerInfo *root,
 		 *
 		 * Assume about N log2 N comparisons
 		 */
-		startup_cost += comparison_cost * tuples * LOG2(tuples);
+		*startup_cost = comparison_cost * tuples * LOG2(tuples);
 
 		/* Disk costs */
 
@@ -1759,7 +1806,7 @@ cost_sort(Path *path, PlannerInfo *root,
 			log_runs = 1.0;
 		npageaccesses = 2.0 * npages * log_runs;
 		/* Assume 3/4ths of accesses are sequential, 1/4th are not */
-		startup_cost += npageaccesses *
+		*startup_cost += npageaccesses *
 			(seq_page_cost * 0.75 + random_page_cost * 0.25);
 	}
 	else if (tuples > 2 * output_tuples || input_bytes > sort_mem_bytes)
@@ -1770,12 +1817,12 @@ cost_sort(Path *path, PlannerInfo *root,
 		 * factor is a bit higher than for quicksort.  Tweak it so that the
 		 * cost curve is continuous at the crossover point.
 		 */
-		startup_cost += comparison_cost * tuples * LOG2(2.0 * output_tuples);
+		*startup_cost = comparison_cost * tuples * LOG2(2.0 * output_tuples);
 	}
 	else
 	{
 		/* We'll use plain quicksort on all the input tuples */
-		startup_cost += comparison_cost * tuples * LOG2(tuples);
+		*startup_cost = comparison_cost * tuples * LOG2(tuples);
 	}
 
 	/*
@@ -1786,8 +1833,164 @@ cost_sort(Path *path, PlannerInfo *root,
 	 * here --- the upper LIMIT will pro-rate the run cost so we'd be double
 	 * counting the LIMIT otherwise.
 	 */
-	run_cost += cpu_operator_cost * tuples;
+	*run_cost = cpu_operator_cost * tuples;
+}
+
+/*
+ * cost_incremental_sort
+ *	  Determines and returns the cost of sorting a relation incrementally,
+ *	  when the input path is presorted by a prefix of the pathkeys.
+ *
+ * 'presorted_keys' is the number of leading pathkeys by which the input path
+ * is sorted.
+ *
+ * We estimate the number of groups into which the relation is divided by the
+ * leading pathkeys, and then calculate the cost of sorting a single group
+ * with tuplesort using cost_tuplesort().  The startup cost is that of reading
+ * and sorting the first group; the remaining groups are charged as run cost.
+ */
+void
+cost_incremental_sort(Path *path,
+					  PlannerInfo *root, List *pathkeys, int presorted_keys,
+					  Cost input_startup_cost, Cost input_total_cost,
+					  double input_tuples, int width, Cost comparison_cost,
+					  int sort_mem, double limit_tuples)
+{
+	Cost		startup_cost = 0,
+				run_cost = 0,
+				input_run_cost = input_total_cost - input_startup_cost;
+	double		group_tuples,
+				input_groups;
+	Cost		group_startup_cost,
+				group_run_cost,
+				group_input_run_cost;
+	List	   *presortedExprs = NIL;
+	ListCell   *l;
+	int			i = 0;
+	bool		unknown_varno = false;
+
+	Assert(presorted_keys != 0);
+
+	/*
+	 * We want to be sure the cost of a sort is never estimated as zero, even
+	 * if passed-in tuple count is zero.  Besides, mustn't do log(0)...
+	 */
+	if (input_tuples < 2.0)
+		input_tuples = 2.0;
+
+	/* Default estimate of number of groups, capped to one group per row. */
+	input_groups = Min(input_tuples, DEFAULT_NUM_DISTINCT);
+
+	/*
+	 * Extract presorted keys as list of expressions.
+	 *
+	 * We need to be careful about Vars containing "varno 0" which might have
+	 * been introduced by generate_append_tlist, which would confuse
+	 * estimate_num_groups (in fact it'd fail for such expressions).  If we
+	 * find any, just fall back to DEFAULT_NUM_DISTINCT groups.
+	 */
+	foreach(l, pathkeys)
+	{
+		PathKey    *key = (PathKey *) lfirst(l);
+		EquivalenceMember *member = (EquivalenceMember *)
+		linitial(key->pk_eclass->ec_members);
 
+		if (bms_is_member(0, pull_varnos((Node *) member->em_expr)))
+		{
+			unknown_varno = true;
+			break;
+		}
+
+		presortedExprs = lappend(presortedExprs, member->em_expr);
+
+		i++;
+		if (i >= presorted_keys)
+			break;
+	}
+
+	/* Estimate number of groups with equal presorted keys. */
+	if (!unknown_varno)
+		input_groups = estimate_num_groups(root, presortedExprs, input_tuples,
+										   NULL);
+
+	group_tuples = input_tuples / input_groups;
+	group_input_run_cost = input_run_cost / input_groups;
+
+	/*
+	 * Estimate average cost of sorting of one group where presorted keys are
+	 * equal.  Incremental sort is sensitive to the distribution of tuples to
+	 * the groups, and we're relying on quite rough assumptions here, so be
+	 * pessimistic and increase the average group size by half.
+	 */
+	cost_tuplesort(&group_startup_cost, &group_run_cost,
+				   1.5 * group_tuples, width, comparison_cost, sort_mem,
+				   limit_tuples);
+
+	/*
+	 * Startup cost of incremental sort is the startup cost of its first group
+	 * plus the cost of its input.
+	 */
+	startup_cost += group_startup_cost
+		+ input_startup_cost + group_input_run_cost;
+
+	/*
+	 * After we started producing tuples from the first group, the cost of
+	 * producing all the tuples is given by the cost to finish processing this
+	 * group, plus the total cost to process the remaining groups, plus the
+	 * remaining cost of input.
+	 */
+	run_cost += group_run_cost
+		+ (group_run_cost + group_startup_cost) * (input_groups - 1)
+		+ group_input_run_cost * (input_groups - 1);
+
+	/*
+	 * Incremental sort adds some overhead by itself.  Firstly, it has to
+	 * detect the sort groups, which is roughly equal to one extra copy and
+	 * comparison per tuple.  Secondly, it has to set up a new tuplesort for
+	 * every group.
+	 */
+	run_cost += (cpu_tuple_cost + comparison_cost) * input_tuples;
+	run_cost += 2.0 * cpu_tuple_cost * input_groups;
+
+	path->rows = input_tuples;
+	path->startup_cost = startup_cost;
+	path->total_cost = startup_cost + run_cost;
+}
+
+/*
+ * cost_sort
+ *	  Determines and returns the cost of sorting a relation, including
+ *	  the cost of reading the input data.
+ *
+ * NOTE: some callers currently pass NIL for pathkeys because they
+ * can't conveniently supply the sort keys.  Since this routine doesn't
+ * currently do anything with pathkeys anyway, that doesn't matter...
+ * but if it ever does, it should react gracefully to lack of key data.
+ * (Actually, the thing we'd most likely be interested in is just the number
+ * of sort keys, which all callers *could* supply.)
+ *
+ * See cost_tuplesort for an explanation of the other parameters.
+ */
+void
+cost_sort(Path *path, PlannerInfo *root,
+		  List *pathkeys, Cost input_cost, double tuples, int width,
+		  Cost comparison_cost, int sort_mem,
+		  double limit_tuples)
+{
+	Cost		startup_cost;
+	Cost		run_cost;
+
+	cost_tuplesort(&startup_cost, &run_cost,
+				   tuples, width,
+				   comparison_cost, sort_mem,
+				   limit_tuples);
+
+	if (!enable_sort)
+		startup_cost += disable_cost;
+
+	startup_cost += input_cost;
+
+	path->rows = tuples;
 	path->startup_cost = startup_cost;
 	path->total_cost = startup_cost + run_cost;
 }
@@ -2139,6 +2342,133 @@ cost_material(Path *path,
 	path->total_cost = startup_cost + run_cost;
 }
 
+/*
+ * cost_resultcache_rescan
+ *	  Determines the estimated cost of rescanning a ResultCache node.
+ *
+ * In order to estimate this, we must gain knowledge of how often we expect to
+ * be called and how many distinct sets of parameters we are likely to be
+ * called with.  If we expect a good cache hit ratio, then we can set our
+ * costs to account for that hit ratio, plus a little bit of cost for the
+ * caching itself.  Caching will not work out well if we expect to be called
+ * with too many distinct parameter values.  The worst-case here is that we
+ * never see the same parameter values twice, in which case we'd never get a
+ * cache hit and caching would be a complete waste of effort.
+ */
+static void
+cost_resultcache_rescan(PlannerInfo *root, ResultCachePath *rcpath,
+						Cost *rescan_startup_cost, Cost *rescan_total_cost)
+{
+	Cost		input_startup_cost = rcpath->subpath->startup_cost;
+	Cost		input_total_cost = rcpath->subpath->total_cost;
+	double		tuples = rcpath->subpath->rows;
+	double		calls = rcpath->calls;
+	int			width = rcpath->subpath->pathtarget->width;
+	double		work_mem_bytes = work_mem * 1024L;
+	double		est_entry_bytes;
+	double		est_cache_entries;
+	double		ndistinct;
+	double		evict_ratio;
+	double		hit_ratio;
+	Cost		startup_cost;
+	Cost		total_cost;
+	ListCell   *lc;
+
+	/*
+	 * Estimate the memory a single cache entry needs: the tuples themselves
+	 * plus the executor's per-entry and per-tuple bookkeeping.
+	 */
+	est_entry_bytes = relation_byte_size(tuples, width) +
+		ExecEstimateCacheEntryOverheadBytes(tuples);
+
+	/* estimate on the upper limit of cache entries we can hold at once */
+	est_cache_entries = Max(floor(work_mem_bytes / est_entry_bytes), 1.0);
+
+	/* estimate on the distinct number of parameter values */
+	ndistinct = estimate_num_groups(root, rcpath->param_exprs, calls, NULL);
+
+	/*
+	 * If any of the parameters has no statistics, the estimate above is
+	 * built on a default guess, and a guess that happens to promise lots of
+	 * repeats could make us pick a cache that never gets a hit.  Assume every
+	 * call sees new parameter values in that case.
+	 */
+	foreach(lc, rcpath->param_exprs)
+	{
+		VariableStatData vardata;
+		bool		isdefault;
+
+		examine_variable(root, (Node *) lfirst(lc), 0, &vardata);
+		(void) get_variable_numdistinct(&vardata, &isdefault);
+		ReleaseVariableStats(vardata);
+
+		if (isdefault)
+		{
+			ndistinct = calls;
+			break;
+		}
+	}
+
+	/* Clamp to sane values */
+	ndistinct = clamp_row_est(Min(ndistinct, calls));
+
+	/*
+	 * Remember how many entries we expect to need, so the executor can size
+	 * its hash table accordingly.
+	 */
+	rcpath->est_entries = (uint32) Min(Min(ndistinct, est_cache_entries),
+									   PG_UINT32_MAX);
+
+	/*
+	 * When there are more distinct parameter values than fit in the cache,
+	 * some entries must be evicted.  Estimate what fraction of the lookups
+	 * will cause an eviction.
+	 */
+	evict_ratio = 1.0 - Min(est_cache_entries, ndistinct) / ndistinct;
+
+	/*
+	 * Every distinct parameter value misses the cache at least once.  Of the
+	 * remaining calls, we can only expect a hit when the entry is still in
+	 * the cache, which we approximate by the fraction of the distinct values
+	 * the cache can hold at once.
+	 */
+	hit_ratio = ((calls - ndistinct) / calls) *
+		(Min(est_cache_entries, ndistinct) / ndistinct);
+
+	Assert(hit_ratio >= 0 && hit_ratio <= 1.0);
+
+	/*
+	 * Set the total_cost accounting for the expected cache hit ratio.  We
+	 * also add on a cpu_operator_cost to account for a cache lookup.  This
+	 * will happen regardless of whether it's a cache hit or not.
+	 */
+	total_cost = input_total_cost * (1.0 - hit_ratio) + cpu_operator_cost;
+
+	/*
+	 * Charge a cpu_tuple_cost for evicting a cache entry, plus a tenth of a
+	 * cpu_operator_cost for freeing each of its tuples.
+	 */
+	total_cost += cpu_tuple_cost * evict_ratio;
+	total_cost += cpu_operator_cost / 10.0 * evict_ratio * tuples;
+
+	/*
+	 * Storing the results of a miss isn't free either: charge a
+	 * cpu_tuple_cost for creating the entry and a cpu_operator_cost for each
+	 * tuple stored in it.
+	 */
+	total_cost += (1.0 - hit_ratio) *
+		(cpu_tuple_cost + cpu_operator_cost * tuples);
+
+	/*
+	 * Getting the first row must also be proportioned according to the
+	 * expected cache hit ratio, plus the cost of the lookup itself.
+	 */
+	startup_cost = input_startup_cost * (1.0 - hit_ratio) + cpu_tuple_cost;
+
+	*rescan_startup_cost = startup_cost;
+	*rescan_total_cost = total_cost;
+}
+
 /*
  * cost_agg
  *		Determines and returns the cost of performing an Agg plan node,
@@ -2233,6 +2563,9 @@ cost_agg(Path *path, PlannerInfo *root,
 		startup_cost += aggcosts->transCost.per_tuple * input_tuples;
 		/* cost of computing hash value */
 		startup_cost += (cpu_operator_cost * numGroupCols) * input_tuples;
+		/* cost of probing the per-group tables of DISTINCT aggregates */
+		startup_cost += (cpu_operator_cost * (numGroupCols + 1)) *
+			aggcosts->numHashableDistinctAggs * input_tuples;
 		startup_cost += aggcosts->finalCost.startup;
 
 		total_cost = startup_cost;
@@ -2327,6 +2660,46 @@ cost_agg(Path *path, PlannerInfo *root,
 	path->total_cost = total_cost;
 }
 
+/*
+ * cost_parallel_hashagg
+ *		Determines and returns the cost of performing a parallel-aware
+ *		hashed Agg node.
+ *
+ * Each participant writes the tuples it reads from its partial input to
+ * shared partitions, and then aggregates the partitions it claims, so it
+ * finalizes only its share of the groups.  input_tuples is the number of
+ * tuples read by one participant, and path->parallel_workers must be set.
+ */
+void
+cost_parallel_hashagg(Path *path, PlannerInfo *root,
+					  const AggClauseCosts *aggcosts,
+					  int numGroupCols, double numGroups,
+					  List *quals,
+					  Cost input_startup_cost, Cost input_total_cost,
+					  double input_tuples, double input_width)
+{
+	double		parallel_divisor = get_parallel_divisor(path);
+	double		pages;
+
+	cost_agg(path, root, AGG_HASHED, aggcosts,
+			 numGroupCols, clamp_row_est(numGroups / parallel_divisor),
+			 quals,
+			 input_startup_cost, input_total_cost,
+			 input_tuples, input_width);
+
+	/*
+	 * Every input tuple is written to a shared partition and read back
+	 * before any group can be emitted.  Unlike the spilling accounted for
+	 * by cost_agg(), this always happens, so also charge for copying each
+	 * tuple out and storing it back into a slot.
+	 */
+	pages = relation_byte_size(input_tuples, input_width) / BLCKSZ;
+	path->startup_cost += pages * (random_page_cost + seq_page_cost);
+	path->startup_cost += (cpu_operator_cost + cpu_tuple_cost) * input_tuples;
+	path->total_cost += pages * (random_page_cost + seq_page_cost);
+	path->total_cost += (cpu_operator_cost + cpu_tuple_cost) * input_tuples;
+}
+
 /*
  * cost_windowagg
  *		Determines and returns the cost of performing a WindowAgg plan node,
@@ -3864,6 +4237,10 @@ cost_rescan(PlannerInfo *root, Path *path,
 				*rescan_total_cost = run_cost;
 			}
 			break;
+		case T_ResultCache:
+			cost_resultcache_rescan(root, (ResultCachePath *) path,
+									rescan_startup_cost, rescan_total_cost);
+			break;
 		default:
 			*rescan_startup_cost = path->startup_cost;
 			*rescan_total_cost = path->total_cost;
@@ -19,8 +19,11 @@
 #include <limits.h>
 #include <math.h>
 
+#include "access/stratnum.h"
 #include "access/sysattr.h"
+#include "catalog/pg_am.h"
 #include "catalog/pg_class.h"
+#include "catalog/pg_type.h"
 #include "foreign/fdwapi.h"
 #include "miscadmin.h"
 #include "nodes/extensible.h"
@@ -70,6 +73,17 @@
 #define CP_LABEL_TLIST		0x0004	/* tlist must contain sortgrouprefs */
 #define CP_IGNORE_TLIST		0x0008	/* caller will replace tlist */
 
+/*
+ * A sort is late-materialized only if the columns it could leave out of the
+ * sorted tuples are at least this wide on average, and if it is expected to
+ * return no more than this fraction of its input rows.
+ */
+#define LATE_MAT_MIN_WIDTH			256
+#define LATE_MAT_MAX_OUTPUT_FRACTION	0.1
+
+/* Number of outer rows a batched nestloop collects before probing the inner */
+#define NESTLOOP_BATCH_SIZE			64
+
 
 static Plan *create_plan_recurse(PlannerInfo *root, Path *best_path,
 								 int flags);
@@ -90,14 +104,26 @@ static Result *create_group_result_plan(PlannerInfo *root,
 static ProjectSet *create_project_set_plan(PlannerInfo *root, ProjectSetPath *best_path);
 static Material *create_material_plan(PlannerInfo *root, MaterialPath *best_path,
 									  int flags);
+static ResultCache *create_resultcache_plan(PlannerInfo *root,
+											ResultCachePath *best_path,
+											int flags);
 static Plan *create_unique_plan(PlannerInfo *root, UniquePath *best_path,
 								int flags);
 static Gather *create_gather_plan(PlannerInfo *root, GatherPath *best_path);
+static Redistribute *create_redistribute_plan(PlannerInfo *root,
+											  RedistributePath *best_path,
+											  int flags);
 static Plan *create_projection_plan(PlannerInfo *root,
 									ProjectionPath *best_path,
 									int flags);
 static Plan *inject_projection_plan(Plan *subplan, List *tlist, bool parallel_safe);
-static Sort *create_sort_plan(PlannerInfo *root, SortPath *best_path, int flags);
+static Plan *create_sort_plan(PlannerInfo *root, SortPath *best_path, int flags);
+static void consider_batched_nestloop(NestLoop *join_plan, NestPath *best_path);
+static bool consider_sort_late_materialization(PlannerInfo *root,
+											   SortPath *best_path,
+											   Sort *plan);
+static IncrementalSort *create_incrementalsort_plan(PlannerInfo *root,
+													 IncrementalSortPath *best_path, int flags);
 static Group *create_group_plan(PlannerInfo *root, GroupPath *best_path);
 static Unique *create_upper_unique_plan(PlannerInfo *root, UpperUniquePath *best_path,
 										int flags);
@@ -168,6 +194,7 @@ static void copy_generic_path_info(Plan *dest, Path *src);
 static void copy_plan_costsize(Plan *dest, Plan *src);
 static void label_sort_with_costsize(PlannerInfo *root, Sort *plan,
 									 double limit_tuples);
+static bool is_async_capable_path(Path *path);
 static SeqScan *make_seqscan(List *qptlist, List *qpqual, Index scanrelid);
 static SampleScan *make_samplescan(List *qptlist, List *qpqual, Index scanrelid,
 								   TableSampleClause *tsc);
@@ -244,6 +271,10 @@ static MergeJoin *make_mergejoin(List *tlist,
 static Sort *make_sort(Plan *lefttree, int numCols,
 					   AttrNumber *sortColIdx, Oid *sortOperators,
 					   Oid *collations, bool *nullsFirst);
+static IncrementalSort *make_incrementalsort(Plan *lefttree,
+											 int numCols, int nPresortedCols,
+											 AttrNumber *sortColIdx, Oid *sortOperators,
+											 Oid *collations, bool *nullsFirst);
 static Plan *prepare_sort_from_pathkeys(Plan *lefttree, List *pathkeys,
 										Relids relids,
 										const AttrNumber *reqColIdx,
@@ -258,17 +289,27 @@ static EquivalenceMember *find_ec_member_for_tle(EquivalenceClass *ec,
 												 Relids relids);
 static Sort *make_sort_from_pathkeys(Plan *lefttree, List *pathkeys,
 									 Relids relids);
+static IncrementalSort *make_incrementalsort_from_pathkeys(Plan *lefttree,
+														   List *pathkeys, Relids relids, int nPresortedCols);
 static Sort *make_sort_from_groupcols(List *groupcls,
 									  AttrNumber *grpColIdx,
 									  Plan *lefttree);
 static Material *make_material(Plan *lefttree);
+static Redistribute *make_redistribute(Plan *lefttree, int numCols,
+									   AttrNumber *hashColIdx,
+									   Oid *hashOperators, Oid *collations);
+static ResultCache *make_resultcache(Plan *lefttree, Oid *hashoperators,
+									 Oid *collations,
+									 List *param_exprs,
+									 bool singlerow,
+									 uint32 est_entries);
 static WindowAgg *make_windowagg(List *tlist, Index winref,
 								 int partNumCols, AttrNumber *partColIdx, Oid *partOperators, Oid *partCollations,
 								 int ordNumCols, AttrNumber *ordColIdx, Oid *ordOperators, Oid *ordCollations,
 								 int frameOptions, Node *startOffset, Node *endOffset,
 								 Oid startInRangeFunc, Oid endInRangeFunc,
 								 Oid inRangeColl, bool inRangeAsc, bool inRangeNullsFirst,
-								 Plan *lefttree);
+								 List *runCondition, Plan *lefttree);
 static Group *make_group(List *tlist, List *qual, int numGroupCols,
 						 AttrNumber *grpColIdx, Oid *grpOperators, Oid *grpCollations,
 						 Plan *lefttree);
@@ -436,6 +477,11 @@ create_plan_recurse(PlannerInfo *root, Path *best_path, int flags)
 												 (MaterialPath *) best_path,
 												 flags);
 			break;
+		case T_ResultCache:
+			plan = (Plan *) create_resultcache_plan(root,
+													(ResultCachePath *) best_path,
+													flags);
+			break;
 		case T_Unique:
 			if (IsA(best_path, UpperUniquePath))
 			{
@@ -456,9 +502,14 @@ create_plan_recurse(PlannerInfo *root, Path *best_path, int flags)
 											   (GatherPath *) best_path);
 			break;
 		case T_Sort:
-			plan = (Plan *) create_sort_plan(root,
-											 (SortPath *) best_path,
-											 flags);
+			plan = create_sort_plan(root,
+									(SortPath *) best_path,
+									flags);
+			break;
+		case T_IncrementalSort:
+			plan = (Plan *) create_incrementalsort_plan(root,
+														(IncrementalSortPath *) best_path,
+														flags);
 			break;
 		case T_Group:
 			plan = (Plan *) create_group_plan(root,
@@ -506,6 +557,11 @@ create_plan_recurse(PlannerInfo *root, Path *best_path, int flags)
 			plan = (Plan *) create_gather_merge_plan(root,
 													 (GatherMergePath *) best_path);
 			break;
+		case T_Redistribute:
+			plan = (Plan *) create_redistribute_plan(root,
+													 (RedistributePath *) best_path,
+													 flags);
+			break;
 		default:
 			elog(ERROR, "unrecognized node type: %d",
 				 (int) best_path->pathtype);
@@ -1077,6 +1133,7 @@ create_append_plan(PlannerInfo *root, AppendPath *best_path, int flags)
 	Oid		   *nodeSortOperators = NULL;
 	Oid		   *nodeCollations = NULL;
 	bool	   *nodeNullsFirst = NULL;
+	bool		consider_async = false;
 
 	/*
 	 * The subpaths list could be empty, if every child was proven empty by
@@ -1140,6 +1197,15 @@ create_append_plan(PlannerInfo *root, AppendPath *best_path, int flags)
 		tlist_was_changed = (orig_tlist_length != list_length(plan->plan.targetlist));
 	}
 
+	/*
+	 * If appropriate, consider async append.  Async execution is only done by
+	 * a non-parallel Append producing unordered output, and it's pointless
+	 * with a single child, which setrefs.c would remove anyway.
+	 */
+	consider_async = (enable_async_append && pathkeys == NIL &&
+					  !best_path->path.parallel_safe &&
+					  list_length(best_path->subpaths) > 1);
+
 	/* Build the plan for each child */
 	foreach(subpaths, best_path->subpaths)
 	{
@@ -1206,6 +1272,11 @@ create_append_plan(PlannerInfo *root, AppendPath *best_path, int flags)
 			}
 		}
 
+		/* If needed, check to see if subplan can be executed asynchronously */
+		if (consider_async && IsA(subplan, ForeignScan) &&
+			is_async_capable_path(subpath))
+			subplan->async_capable = true;
+
 		subplans = lappend(subplans, subplan);
 	}
 
@@ -1503,6 +1574,62 @@ create_material_plan(PlannerInfo *root, MaterialPath *best_path, int flags)
 	return plan;
 }
 
+/*
+ * create_resultcache_plan
+ *	  Create a ResultCache plan for 'best_path' and (recursively) plans
+ *	  for its subpaths.
+ *
+ *	  Returns a Plan node.
+ */
+static ResultCache *
+create_resultcache_plan(PlannerInfo *root, ResultCachePath *best_path, int flags)
+{
+	ResultCache *plan;
+	Plan	   *subplan;
+	Oid		   *operators;
+	Oid		   *collations;
+	List	   *param_exprs = NIL;
+	ListCell   *lc;
+	ListCell   *lc2;
+	int			nkeys;
+	int			i;
+
+	/* As with Material, we don't want excess columns in the cached tuples */
+	subplan = create_plan_recurse(root, best_path->subpath,
+								  flags | CP_SMALL_TLIST);
+
+	/*
+	 * The cache keys are the outer-side expressions of the parameterized
+	 * path's join clauses, so they must be evaluated from the nestloop's
+	 * parameters just like the inner scan's own references to them.
+	 */
+	param_exprs = (List *) replace_nestloop_params(root, (Node *)
+												   best_path->param_exprs);
+
+	nkeys = list_length(param_exprs);
+	Assert(nkeys > 0);
+	operators = palloc(nkeys * sizeof(Oid));
+	collations = palloc(nkeys * sizeof(Oid));
+
+	i = 0;
+	forboth(lc, param_exprs, lc2, best_path->hash_operators)
+	{
+		Expr	   *param_expr = (Expr *) lfirst(lc);
+		Oid			opno = lfirst_oid(lc2);
+
+		operators[i] = opno;
+		collations[i] = exprCollation((Node *) param_expr);
+		i++;
+	}
+
+	plan = make_resultcache(subplan, operators, collations, param_exprs,
+							best_path->singlerow, best_path->est_entries);
+
+	copy_generic_path_info(&plan->plan, (Path *) best_path);
+
+	return plan;
+}
+
 /*
  * create_unique_plan
  *	  Create a Unique plan for 'best_path' and (recursively) plans
@@ -1797,6 +1924,57 @@ create_gather_merge_plan(PlannerInfo *root, GatherMergePath *best_path)
 	return gm_plan;
 }
 
+/*
+ * create_redistribute_plan
+ *
+ *	  Create a Redistribute plan for 'best_path' and (recursively) plans
+ *	  for its subpaths.
+ */
+static Redistribute *
+create_redistribute_plan(PlannerInfo *root, RedistributePath *best_path,
+						 int flags)
+{
+	Redistribute *plan;
+	Plan	   *subplan;
+	int			numCols = list_length(best_path->hashClauses);
+	AttrNumber *hashColIdx;
+	Oid		   *hashOperators;
+	Oid		   *collations;
+	int			keyno = 0;
+	ListCell   *lc;
+
+	/*
+	 * We don't want to send any excess columns to the other workers, so
+	 * request a smaller tlist.  We also need the keys to be labeled with
+	 * their sortgrouprefs, to find them.
+	 */
+	subplan = create_plan_recurse(root, best_path->subpath,
+								  flags | CP_SMALL_TLIST | CP_LABEL_TLIST);
+
+	hashColIdx = (AttrNumber *) palloc(sizeof(AttrNumber) * numCols);
+	hashOperators = (Oid *) palloc(sizeof(Oid) * numCols);
+	collations = (Oid *) palloc(sizeof(Oid) * numCols);
+
+	foreach(lc, best_path->hashClauses)
+	{
+		SortGroupClause *sgc = (SortGroupClause *) lfirst(lc);
+		TargetEntry *tle = get_sortgroupclause_tle(sgc, subplan->targetlist);
+
+		hashColIdx[keyno] = tle->resno;
+		hashOperators[keyno] = sgc->eqop;
+		collations[keyno] = exprCollation((Node *) tle->expr);
+		Assert(OidIsValid(hashOperators[keyno]));
+		keyno++;
+	}
+
+	plan = make_redistribute(subplan, numCols, hashColIdx, hashOperators,
+							 collations);
+
+	copy_generic_path_info(&plan->plan, (Path *) best_path);
+
+	return plan;
+}
+
 /*
  * create_projection_plan
  *
@@ -1965,11 +2143,12 @@ change_plan_targetlist(Plan *subplan, List *tlist, bool tlist_parallel_safe)
  *	  Create a Sort plan for 'best_path' and (recursively) plans
  *	  for its subpaths.
  */
-static Sort *
+static Plan *
 create_sort_plan(PlannerInfo *root, SortPath *best_path, int flags)
 {
 	Sort	   *plan;
 	Plan	   *subplan;
+	List	   *tlist;
 
 	/*
 	 * We don't want any excess columns in the sorted tuples, so request a
@@ -1991,6 +2170,173 @@ create_sort_plan(PlannerInfo *root, SortPath *best_path, int flags)
 
 	copy_generic_path_info(&plan->plan, (Path *) best_path);
 
+	/*
+	 * Late materialization adds a junk ctid column to the sort's output.  If
+	 * the caller needs the exact tlist, strip it off again with a Result,
+	 * which costs little since it only sees the sort's few output rows.
+	 */
+	tlist = plan->plan.targetlist;
+	if (enable_late_materialization &&
+		consider_sort_late_materialization(root, best_path, plan) &&
+		(flags & CP_EXACT_TLIST) != 0)
+		return inject_projection_plan(&plan->plan, tlist,
+									  plan->plan.parallel_safe);
+
+	return &plan->plan;
+}
+
+/*
+ * consider_sort_late_materialization
+ *
+ *	  Decide whether a Sort directly above a scan of a table should leave the
+ *	  wide columns of the scan out of the sorted tuples, and fetch them again
+ *	  by TID for the tuples it returns.  That pays off only when the output
+ *	  is a small part of the input, ie there's a LIMIT above, so that the
+ *	  random heap fetches are fewer than the tuples spared from being copied
+ *	  through tuplesort.  If so, add a junk ctid column to the scan's tlist,
+ *	  fill in the late materialization fields of the Sort, and return true.
+ */
+static bool
+consider_sort_late_materialization(PlannerInfo *root, SortPath *best_path,
+								   Sort *plan)
+{
+	Plan	   *subplan = plan->plan.lefttree;
+	RelOptInfo *rel = best_path->subpath->parent;
+	Index		scanrelid;
+	RangeTblEntry *rte;
+	List	   *tlist;
+	AttrNumber *lateColIdx;
+	AttrNumber *lateAttNums;
+	int			numLateCols = 0;
+	int32		lateWidth = 0;
+	ListCell   *lc;
+	TargetEntry *tle;
+
+	/*
+	 * Refetching a row must give back the row version the scan saw, which
+	 * the snapshot guarantees for a plain SELECT.  EvalPlanQual rechecks
+	 * substitute newer row versions, so don't bother with row marks or
+	 * data-modifying queries.
+	 */
+	if (root->parse->commandType != CMD_SELECT || root->rowMarks != NIL)
+		return false;
+
+	/* Is the output expected to be small compared to the input? */
+	if (best_path->limit_tuples <= 0 ||
+		best_path->limit_tuples >
+		LATE_MAT_MAX_OUTPUT_FRACTION * best_path->subpath->rows)
+		return false;
+
+	/* The input must be a scan returning the table's own rows */
+	if (!IsA(subplan, SeqScan) &&
+		!IsA(subplan, IndexScan) &&
+		!IsA(subplan, BitmapHeapScan))
+		return false;
+	scanrelid = ((Scan *) subplan)->scanrelid;
+	rte = planner_rt_fetch(scanrelid, root);
+	if (rte->rtekind != RTE_RELATION ||
+		(rte->relkind != RELKIND_RELATION &&
+		 rte->relkind != RELKIND_MATVIEW))
+		return false;
+	Assert(rel->reloptkind == RELOPT_BASEREL ||
+		   rel->reloptkind == RELOPT_OTHER_MEMBER_REL);
+
+	/*
+	 * Collect the columns that are plain user columns of the table and not
+	 * sort keys; anything else stays in the sorted tuples.
+	 */
+	lateColIdx = (AttrNumber *) palloc(list_length(subplan->targetlist) *
+									   sizeof(AttrNumber));
+	lateAttNums = (AttrNumber *) palloc(list_length(subplan->targetlist) *
+										sizeof(AttrNumber));
+	foreach(lc, subplan->targetlist)
+	{
+		Var		   *var;
+		int			i;
+
+		tle = (TargetEntry *) lfirst(lc);
+		var = (Var *) tle->expr;
+		if (!IsA(var, Var) ||
+			var->varno != scanrelid ||
+			var->varlevelsup != 0 ||
+			var->varattno <= 0)
+			continue;
+
+		for (i = 0; i < plan->numCols; i++)
+		{
+			if (plan->sortColIdx[i] == tle->resno)
+				break;
+		}
+		if (i < plan->numCols)
+			continue;
+
+		lateColIdx[numLateCols] = tle->resno;
+		lateAttNums[numLateCols] = var->varattno;
+		numLateCols++;
+
+		if (var->varattno <= rel->max_attr &&
+			rel->attr_widths[var->varattno - rel->min_attr] > 0)
+			lateWidth += rel->attr_widths[var->varattno - rel->min_attr];
+		else
+			lateWidth += get_typavgwidth(var->vartype, var->vartypmod);
+	}
+
+	if (lateWidth < LATE_MAT_MIN_WIDTH)
+	{
+		pfree(lateColIdx);
+		pfree(lateAttNums);
+		return false;
+	}
+
+	/*
+	 * Add the ctid as a junk column.  The Sort shares its input's tlist, so
+	 * update both.
+	 */
+	tle = makeTargetEntry((Expr *) makeVar(scanrelid,
+										   SelfItemPointerAttributeNumber,
+										   TIDOID,
+										   -1,
+										   InvalidOid,
+										   0),
+						  list_length(subplan->targetlist) + 1,
+						  NULL,
+						  true);
+	tlist = lappend(list_copy(subplan->targetlist), tle);
+	subplan->targetlist = tlist;
+	plan->plan.targetlist = tlist;
+
+	plan->lateRelid = scanrelid;
+	plan->lateTidColIdx = tle->resno;
+	plan->numLateCols = numLateCols;
+	plan->lateColIdx = lateColIdx;
+	plan->lateAttNums = lateAttNums;
+
+	return true;
+}
+
+/*
+ * create_incrementalsort_plan
+ *
+ *	  Do the same as create_sort_plan, but create IncrementalSort plan.
+ */
+static IncrementalSort *
+create_incrementalsort_plan(PlannerInfo *root, IncrementalSortPath *best_path,
+							int flags)
+{
+	IncrementalSort *plan;
+	Plan	   *subplan;
+
+	/* See comments in create_sort_plan() above */
+	subplan = create_plan_recurse(root, best_path->spath.subpath,
+								  flags | CP_SMALL_TLIST);
+	plan = make_incrementalsort_from_pathkeys(subplan,
+											  best_path->spath.path.pathkeys,
+											  IS_OTHER_REL(best_path->spath.subpath->parent) ?
+											  best_path->spath.path.parent->relids : NULL,
+											  best_path->nPresortedCols);
+
+	copy_generic_path_info(&plan->sort.plan, (Path *) best_path);
+
 	return plan;
 }
 
@@ -2400,6 +2746,7 @@ create_windowagg_plan(PlannerInfo *root, WindowAggPath *best_path)
 	AttrNumber *ordColIdx;
 	Oid		   *ordOperators;
 	Oid		   *ordCollations;
+	List	   *runCondition;
 	ListCell   *lc;
 
 	/*
@@ -2456,6 +2803,17 @@ create_windowagg_plan(PlannerInfo *root, WindowAggPath *best_path)
 		ordNumCols++;
 	}
 
+	/*
+	 * The executor can only act on a run condition in the topmost WindowAgg;
+	 * a lower one would have to keep returning the rest of the partition to
+	 * the WindowAggs above it anyway.  The qual itself is still checked above
+	 * the WindowAgg, so it's OK to just ignore the run condition otherwise.
+	 */
+	if (best_path->topwindow)
+		runCondition = wc->runCondition;
+	else
+		runCondition = NIL;
+
 	/* And finally we can make the WindowAgg node */
 	plan = make_windowagg(tlist,
 						  wc->winref,
@@ -2475,6 +2833,7 @@ create_windowagg_plan(PlannerInfo *root, WindowAggPath *best_path)
 						  wc->inRangeColl,
 						  wc->inRangeAsc,
 						  wc->inRangeNullsFirst,
+						  runCondition,
 						  subplan);
 
 	copy_generic_path_info(&plan->plan, (Path *) best_path);
@@ -4070,9 +4429,85 @@ create_nestloop_plan(PlannerInfo *root,
 
 	copy_generic_path_info(&join_plan->join.plan, &best_path->path);
 
+	if (enable_batched_nestloop)
+		consider_batched_nestloop(join_plan, best_path);
+
 	return join_plan;
 }
 
+/*
+ * consider_batched_nestloop
+ *	  Decide whether the nestloop should join its outer rows in batches.
+ *
+ * Within a batch, the outer rows are joined in key order rather than in the
+ * order they arrive, so we can only do this if nothing above relies on the
+ * join producing the outer ordering.  The single nestloop param must be an
+ * equality key on the leading column of an ascending btree index scan;
+ * probing that index with ascending keys lets each descent start from the
+ * leaf the previous one ended on.
+ */
+static void
+consider_batched_nestloop(NestLoop *join_plan, NestPath *best_path)
+{
+	Path	   *outer_path = best_path->outerjoinpath;
+	IndexPath  *ipath = (IndexPath *) best_path->innerjoinpath;
+	IndexOptInfo *index;
+	IndexScan  *iscan;
+	NestLoopParam *nlp;
+	ListCell   *lc;
+
+	if (best_path->path.pathkeys != NIL ||
+		outer_path->rows < 2 ||
+		list_length(join_plan->nestParams) != 1 ||
+		ipath->path.pathtype != T_IndexScan ||
+		!IsA(join_plan->join.plan.righttree, IndexScan))
+		return;
+
+	nlp = (NestLoopParam *) linitial(join_plan->nestParams);
+	if (!IsA(nlp->paramval, Var))
+		return;
+
+	index = ipath->indexinfo;
+	iscan = (IndexScan *) join_plan->join.plan.righttree;
+	if (index->relam != BTREE_AM_OID ||
+		index->reverse_sort[0] ||
+		ScanDirectionIsBackward(iscan->indexorderdir))
+		return;
+
+	foreach(lc, iscan->indexqual)
+	{
+		OpExpr	   *clause = (OpExpr *) lfirst(lc);
+		Var		   *indexvar;
+		Param	   *param;
+		Oid			sortop;
+
+		if (!IsA(clause, OpExpr) || list_length(clause->args) != 2)
+			continue;
+		indexvar = (Var *) linitial(clause->args);
+		param = (Param *) lsecond(clause->args);
+		if (!IsA(indexvar, Var) || indexvar->varno != INDEX_VAR ||
+			indexvar->varattno != 1 ||
+			!IsA(param, Param) || param->paramkind != PARAM_EXEC ||
+			param->paramid != nlp->paramno)
+			continue;
+		if (get_op_opfamily_strategy(clause->opno,
+									 index->opfamily[0]) != BTEqualStrategyNumber)
+			continue;
+
+		/* Order the keys the way the index does */
+		sortop = get_opfamily_member(index->opfamily[0],
+									 param->paramtype, param->paramtype,
+									 BTLessStrategyNumber);
+		if (!OidIsValid(sortop))
+			continue;
+
+		join_plan->batchSize = NESTLOOP_BATCH_SIZE;
+		join_plan->batchSortOp = sortop;
+		join_plan->batchCollation = index->indexcollations[0];
+		return;
+	}
+}
+
 static MergeJoin *
 create_mergejoin_plan(PlannerInfo *root,
 					  MergePath *best_path)
@@ -5573,6 +6008,9 @@ make_nestloop(List *tlist,
 	node->join.inner_unique = inner_unique;
 	node->join.joinqual = joinclauses;
 	node->nestParams = nestParams;
+	node->batchSize = 0;
+	node->batchSortOp = InvalidOid;
+	node->batchCollation = InvalidOid;
 
 	return node;
 }
@@ -5693,6 +6131,37 @@ make_sort(Plan *lefttree, int numCols,
 	return node;
 }
 
+/*
+ * make_incrementalsort --- basic routine to build an IncrementalSort plan node
+ *
+ * Caller must have built the sortColIdx, sortOperators, collations, and
+ * nullsFirst arrays already.
+ */
+static IncrementalSort *
+make_incrementalsort(Plan *lefttree, int numCols, int nPresortedCols,
+					 AttrNumber *sortColIdx, Oid *sortOperators,
+					 Oid *collations, bool *nullsFirst)
+{
+	IncrementalSort *node;
+	Plan	   *plan;
+
+	node = makeNode(IncrementalSort);
+
+	plan = &node->sort.plan;
+	plan->targetlist = lefttree->targetlist;
+	plan->qual = NIL;
+	plan->lefttree = lefttree;
+	plan->righttree = NULL;
+	node->nPresortedCols = nPresortedCols;
+	node->sort.numCols = numCols;
+	node->sort.sortColIdx = sortColIdx;
+	node->sort.sortOperators = sortOperators;
+	node->sort.collations = collations;
+	node->sort.nullsFirst = nullsFirst;
+
+	return node;
+}
+
 /*
  * prepare_sort_from_pathkeys
  *	  Prepare to sort according to given pathkeys
@@ -6039,6 +6508,42 @@ make_sort_from_pathkeys(Plan *lefttree, List *pathkeys, Relids relids)
 					 collations, nullsFirst);
 }
 
+/*
+ * make_incrementalsort_from_pathkeys
+ *	  Create sort plan to sort according to given pathkeys
+ *
+ *	  'lefttree' is the node which yields input tuples
+ *	  'pathkeys' is the list of pathkeys by which the result is to be sorted
+ *	  'relids' is the set of relations required by prepare_sort_from_pathkeys()
+ *	  'nPresortedCols' is the number of presorted columns in input tuples
+ */
+static IncrementalSort *
+make_incrementalsort_from_pathkeys(Plan *lefttree, List *pathkeys,
+								   Relids relids, int nPresortedCols)
+{
+	int			numsortkeys;
+	AttrNumber *sortColIdx;
+	Oid		   *sortOperators;
+	Oid		   *collations;
+	bool	   *nullsFirst;
+
+	/* Compute sort column info, and adjust lefttree as needed */
+	lefttree = prepare_sort_from_pathkeys(lefttree, pathkeys,
+										  relids,
+										  NULL,
+										  false,
+										  &numsortkeys,
+										  &sortColIdx,
+										  &sortOperators,
+										  &collations,
+										  &nullsFirst);
+
+	/* Now build the IncrementalSort node */
+	return make_incrementalsort(lefttree, numsortkeys, nPresortedCols,
+								sortColIdx, sortOperators,
+								collations, nullsFirst);
+}
+
 /*
  * make_sort_from_sortclauses
  *	  Create sort plan to sort according to given sortclauses
@@ -6150,6 +6655,48 @@ make_material(Plan *lefttree)
 	return node;
 }
 
+static Redistribute *
+make_redistribute(Plan *lefttree, int numCols, AttrNumber *hashColIdx,
+				  Oid *hashOperators, Oid *collations)
+{
+	Redistribute *node = makeNode(Redistribute);
+	Plan	   *plan = &node->plan;
+
+	plan->targetlist = lefttree->targetlist;
+	plan->qual = NIL;
+	plan->lefttree = lefttree;
+	plan->righttree = NULL;
+
+	node->numCols = numCols;
+	node->hashColIdx = hashColIdx;
+	node->hashOperators = hashOperators;
+	node->collations = collations;
+
+	return node;
+}
+
+static ResultCache *
+make_resultcache(Plan *lefttree, Oid *hashoperators, Oid *collations,
+				 List *param_exprs, bool singlerow, uint32 est_entries)
+{
+	ResultCache *node = makeNode(ResultCache);
+	Plan	   *plan = &node->plan;
+
+	plan->targetlist = lefttree->targetlist;
+	plan->qual = NIL;
+	plan->lefttree = lefttree;
+	plan->righttree = NULL;
+
+	node->numKeys = list_length(param_exprs);
+	node->hashOperators = hashoperators;
+	node->collations = collations;
+	node->param_exprs = param_exprs;
+	node->singlerow = singlerow;
+	node->est_entries = est_entries;
+
+	return node;
+}
+
 /*
  * materialize_finished_plan: stick a Material node atop a completed plan
  *
@@ -6233,7 +6780,7 @@ make_windowagg(List *tlist, Index winref,
 			   int frameOptions, Node *startOffset, Node *endOffset,
 			   Oid startInRangeFunc, Oid endInRangeFunc,
 			   Oid inRangeColl, bool inRangeAsc, bool inRangeNullsFirst,
-			   Plan *lefttree)
+			   List *runCondition, Plan *lefttree)
 {
 	WindowAgg  *node = makeNode(WindowAgg);
 	Plan	   *plan = &node->plan;
@@ -6255,6 +6802,7 @@ make_windowagg(List *tlist, Index winref,
 	node->inRangeColl = inRangeColl;
 	node->inRangeAsc = inRangeAsc;
 	node->inRangeNullsFirst = inRangeNullsFirst;
+	node->runCondition = runCondition;
 
 	plan->targetlist = tlist;
 	plan->lefttree = lefttree;
@@ -6773,7 +7321,10 @@ is_projection_capable_path(Path *path)
 	{
 		case T_Hash:
 		case T_Material:
+		case T_ResultCache:
+		case T_Redistribute:
 		case T_Sort:
+		case T_IncrementalSort:
 		case T_Unique:
 		case T_SetOp:
 		case T_LockRows:
@@ -6817,7 +7368,10 @@ is_projection_capable_plan(Plan *plan)
 	{
 		case T_Hash:
 		case T_Material:
+		case T_ResultCache:
+		case T_Redistribute:
 		case T_Sort:
+		case T_IncrementalSort:
 		case T_Unique:
 		case T_SetOp:
 		case T_LockRows:
@@ -6841,3 +7395,28 @@ is_projection_capable_plan(Plan *plan)
 	}
 	return true;
 }
+
+/*
+ * is_async_capable_path
+ *		Check whether a given Path node is async-capable.
+ */
+static bool
+is_async_capable_path(Path *path)
+{
+	switch (nodeTag(path))
+	{
+		case T_ForeignPath:
+			{
+				FdwRoutine *fdwroutine = path->parent->fdwroutine;
+
+				Assert(fdwroutine != NULL);
+				if (fdwroutine->IsForeignPathAsyncCapable != NULL &&
+					fdwroutine->IsForeignPathAsyncCapable((ForeignPath *) path))
+					return true;
+			}
+			break;
+		default:
+			break;
+	}
+	return false;
+}
@@ -183,13 +183,14 @@ static RelOptInfo *create_window_paths(PlannerInfo *root,
 									   bool output_target_parallel_safe,
 									   WindowFuncLists *wflists,
 									   List *activeWindows);
-static void create_one_window_path(PlannerInfo *root,
-								   RelOptInfo *window_rel,
-								   Path *path,
-								   PathTarget *input_target,
-								   PathTarget *output_target,
-								   WindowFuncLists *wflists,
-								   List *activeWindows);
+static Path *create_one_window_path(PlannerInfo *root,
+									RelOptInfo *window_rel,
+									Path *path,
+									PathTarget *input_target,
+									PathTarget *output_target,
+									WindowFuncLists *wflists,
+									List *activeWindows);
+static List *get_window_hash_clauses(List *activeWindows);
 static RelOptInfo *create_distinct_paths(PlannerInfo *root,
 										 RelOptInfo *input_rel);
 static RelOptInfo *create_ordered_paths(PlannerInfo *root,
@@ -535,10 +536,18 @@ standard_planner(Query *parse, const char *query_string, int cursorOptions,
 
 	result->jitFlags = PGJIT_NONE;
 	if (jit_enabled && jit_above_cost >= 0 &&
-		top_plan->total_cost > jit_above_cost)
+		(jit_tiered_compilation || top_plan->total_cost > jit_above_cost))
 	{
 		result->jitFlags |= PGJIT_PERFORM;
 
+		/*
+		 * With tiered compilation, the cost estimate doesn't decide whether
+		 * to JIT; the executor compiles expressions once they have been
+		 * evaluated often enough.
+		 */
+		if (jit_tiered_compilation)
+			result->jitFlags |= PGJIT_TIERED;
+
 		/*
 		 * Decide how much effort should be put into generating better code.
 		 */
@@ -3856,18 +3865,24 @@ create_grouping_paths(PlannerInfo *root,
 		 * preventing us from hashing (and we should therefore consider plans
 		 * with hashes).
 		 *
-		 * Executor doesn't support hashed aggregation with DISTINCT or ORDER
-		 * BY aggregates.  (Doing so would imply storing *all* the input
-		 * values in the hash table, and/or running many sorts in parallel,
-		 * either of which seems like a certain loser.)  We similarly don't
-		 * support ordered-set aggregates in hashed aggregation, but that case
-		 * is also included in the numOrderedAggs count.
+		 * Executor doesn't support hashed aggregation with ORDER BY
+		 * aggregates.  (Doing so would imply storing *all* the input values
+		 * in the hash table, and/or running many sorts in parallel, either of
+		 * which seems like a certain loser.)  We similarly don't support
+		 * ordered-set aggregates in hashed aggregation, but that case is also
+		 * included in the numOrderedAggs count.  Plain DISTINCT aggregates
+		 * that have a combine function can have their input deduplicated
+		 * with a per-group hash table, but only when there is a single set
+		 * of grouping columns; see get_agg_clause_costs_walker().
 		 *
 		 * Note: grouping_is_hashable() is much more expensive to check than
 		 * the other gating conditions, so we want to do it last.
 		 */
 		if ((parse->groupClause != NIL &&
-			 agg_costs->numOrderedAggs == 0 &&
+			 (agg_costs->numOrderedAggs == 0 ||
+			  (parse->groupingSets == NIL &&
+			   agg_costs->numOrderedAggs ==
+			   agg_costs->numHashableDistinctAggs)) &&
 			 (gd ? gd->any_hashable : grouping_is_hashable(parse->groupClause))))
 			flags |= GROUPING_CAN_USE_HASH;
 
@@ -4591,13 +4606,119 @@ create_window_paths(PlannerInfo *root,
 
 		if (path == input_rel->cheapest_total_path ||
 			pathkeys_contained_in(root->window_pathkeys, path->pathkeys))
-			create_one_window_path(root,
-								   window_rel,
-								   path,
-								   input_target,
-								   output_target,
-								   wflists,
-								   activeWindows);
+			add_path(window_rel,
+					 create_one_window_path(root,
+											window_rel,
+											path,
+											input_target,
+											output_target,
+											wflists,
+											activeWindows));
+	}
+
+	/*
+	 * Each partition has to be seen by a single process.  So to compute the
+	 * window functions in the parallel workers, their rows must first be
+	 * redistributed among the workers by a hash of keys that all windows
+	 * partition by.  Each worker then sorts and processes its own share of
+	 * the partitions, and the results are gathered.
+	 *
+	 * The Redistribute node needs every worker to run it to completion, so
+	 * we don't offer such paths to upper levels as partial paths: the Gather
+	 * must come right on top.
+	 */
+	if (window_rel->consider_parallel && enable_parallel_window &&
+		input_rel->partial_pathlist != NIL)
+	{
+		List	   *hashClauses = get_window_hash_clauses(activeWindows);
+
+		if (hashClauses != NIL)
+		{
+			Path	   *path;
+			double		total_groups;
+
+			path = (Path *) create_redistribute_path(root, window_rel,
+													 linitial(input_rel->partial_pathlist),
+													 hashClauses);
+			path = create_one_window_path(root,
+										  window_rel,
+										  path,
+										  input_target,
+										  output_target,
+										  wflists,
+										  activeWindows);
+
+			total_groups = path->rows * path->parallel_workers;
+			add_path(window_rel, (Path *)
+					 create_gather_path(root, window_rel, path,
+										path->pathtarget, NULL,
+										&total_groups));
+
+			/* Each worker returns its rows in the order of the last window */
+			if (path->pathkeys != NIL)
+				add_path(window_rel, (Path *)
+						 create_gather_merge_path(root, window_rel, path,
+												  path->pathtarget,
+												  path->pathkeys, NULL,
+												  &total_groups));
+		}
+	}
+
+	/*
+	 * Otherwise, the window functions must be computed in the leader.  But
+	 * the sort needed by the first window is often the most expensive part
+	 * of the query, and generate_gather_paths() will only have made Gather
+	 * Merge paths for partial paths that are already suitably sorted.  So
+	 * also consider sorting the cheapest partial path in the workers and
+	 * merging the results with Gather Merge below the WindowAggs.
+	 */
+	if (input_rel->partial_pathlist != NIL)
+	{
+		Path	   *cheapest_partial_path;
+		WindowClause *wc = linitial_node(WindowClause, activeWindows);
+		List	   *window_pathkeys;
+
+		cheapest_partial_path = linitial(input_rel->partial_pathlist);
+		window_pathkeys = make_pathkeys_for_window(root,
+												   wc,
+												   root->processed_tlist);
+
+		/*
+		 * Without any sort order to provide, a plain Gather is just as good,
+		 * and if the cheapest partial path is already sorted, we've tried
+		 * this above.
+		 */
+		if (window_pathkeys != NIL &&
+			!pathkeys_contained_in(window_pathkeys,
+								   cheapest_partial_path->pathkeys))
+		{
+			Path	   *path;
+			double		total_groups;
+
+			path = (Path *) create_sort_path(root,
+											 window_rel,
+											 cheapest_partial_path,
+											 window_pathkeys,
+											 -1.0);
+
+			total_groups = cheapest_partial_path->rows *
+				cheapest_partial_path->parallel_workers;
+			path = (Path *)
+				create_gather_merge_path(root, window_rel,
+										 path,
+										 path->pathtarget,
+										 window_pathkeys, NULL,
+										 &total_groups);
+
+			add_path(window_rel,
+					 create_one_window_path(root,
+											window_rel,
+											path,
+											input_target,
+											output_target,
+											wflists,
+											activeWindows));
+		}
 	}
 
 	/*
@@ -4623,7 +4744,7 @@ create_window_paths(PlannerInfo *root,
 
 /*
  * Stack window-function implementation steps atop the given Path, and
- * add the result to window_rel.
+ * return the result.
  *
  * window_rel: upperrel to contain result
  * path: input Path to use (must return input_target)
@@ -4632,7 +4753,7 @@ create_window_paths(PlannerInfo *root,
  * wflists: result of find_window_functions
  * activeWindows: result of select_active_windows
  */
-static void
+static Path *
 create_one_window_path(PlannerInfo *root,
 					   RelOptInfo *window_rel,
 					   Path *path,
@@ -4709,10 +4830,55 @@ create_one_window_path(PlannerInfo *root,
 		path = (Path *)
 			create_windowagg_path(root, window_rel, path, window_target,
 								  wflists->windowFuncs[wc->winref],
-								  wc);
+								  wc,
+								  lnext(activeWindows, l) == NULL);
+	}
+
+	return path;
+}
+
+/*
+ * get_window_hash_clauses
+ *		Return the partitioning SortGroupClauses that are common to all
+ *		active windows and hashable, or NIL if there are none.
+ *
+ * Rows with equal values of these keys always fall into the same partition
+ * of every window, so it's safe to process them in different workers.
+ */
+static List *
+get_window_hash_clauses(List *activeWindows)
+{
+	WindowClause *wc = linitial_node(WindowClause, activeWindows);
+	List	   *result = NIL;
+	ListCell   *lc;
+
+	foreach(lc, wc->partitionClause)
+	{
+		SortGroupClause *sgc = lfirst_node(SortGroupClause, lc);
+		bool		common = true;
+		ListCell   *lc2;
+
+		if (!sgc->hashable)
+			continue;
+
+		/* the first window passes this check trivially */
+		foreach(lc2, activeWindows)
+		{
+			WindowClause *wc2 = lfirst_node(WindowClause, lc2);
+
+			if (get_sortgroupref_clause_noerr(sgc->tleSortGroupRef,
+											  wc2->partitionClause) == NULL)
+			{
+				common = false;
+				break;
+			}
+		}
+
+		if (common)
+			result = lappend(result, sgc);
 	}
 
-	add_path(window_rel, path);
+	return result;
 }
 
 /*
@@ -4964,12 +5130,15 @@ create_ordered_paths(PlannerInfo *root,
 
 	foreach(lc, input_rel->pathlist)
 	{
-		Path	   *path = (Path *) lfirst(lc);
+		Path	   *input_path = (Path *) lfirst(lc);
+		Path	   *path = input_path;
 		bool		is_sorted;
+		int			presorted_keys;
 
-		is_sorted = pathkeys_contained_in(root->sort_pathkeys,
-										  path->pathkeys);
-		if (path == cheapest_input_path || is_sorted)
+		is_sorted = pathkeys_count_contained_in(root->sort_pathkeys,
+												input_path->pathkeys,
+												&presorted_keys);
+		if (input_path == cheapest_input_path || is_sorted)
 		{
 			if (!is_sorted)
 			{
@@ -4988,6 +5157,31 @@ create_ordered_paths(PlannerInfo *root,
 
 			add_path(ordered_rel, path);
 		}
+
+		/*
+		 * If the input path is sorted by some prefix of the required
+		 * ordering, also consider an incremental sort on top of it.  Unlike
+		 * a full sort, we can't restrict ourselves to the cheapest input
+		 * path: the cost of an incremental sort depends on how well
+		 * presorted the input is, and its lower startup cost may let it win
+		 * out under a LIMIT despite a higher total cost.
+		 */
+		if (!is_sorted && presorted_keys > 0 && enable_incremental_sort)
+		{
+			path = (Path *) create_incremental_sort_path(root,
+														 ordered_rel,
+														 input_path,
+														 root->sort_pathkeys,
+														 presorted_keys,
+														 limit_tuples);
+
+			/* Add projection step if needed */
+			if (path->pathtarget != target)
+				path = apply_projection_to_path(root, ordered_rel,
+												path, target);
+
+			add_path(ordered_rel, path);
+		}
 	}
 
 	/*
@@ -6547,6 +6741,29 @@ add_paths_to_grouping_rel(PlannerInfo *root, RelOptInfo *input_rel,
 										 agg_costs,
 										 dNumGroups));
 			}
+
+			/*
+			 * We can also let all the workers hash the cheapest partial path
+			 * into one set of shared partitions, and then aggregate the
+			 * partitions between them.  Unlike partial aggregation, this
+			 * doesn't need combine functions, and there's no Finalize step
+			 * for the leader to do alone, which matters most when there are
+			 * nearly as many groups as input rows.  The result is a partial
+			 * path of complete groups, gathered below.
+			 */
+			if (enable_parallel_hashagg && grouped_rel->consider_parallel &&
+				input_rel->partial_pathlist != NIL)
+			{
+				add_partial_path(grouped_rel, (Path *)
+								 create_parallel_hashagg_path(root,
+															  grouped_rel,
+															  linitial(input_rel->partial_pathlist),
+															  grouped_rel->reltarget,
+															  parse->groupClause,
+															  havingQual,
+															  agg_costs,
+															  dNumGroups));
+			}
 		}
 
 		/*
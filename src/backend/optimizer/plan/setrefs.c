@@ -676,8 +676,18 @@ set_plan_refs(PlannerInfo *root, Plan *plan, int rtoffset)
 			set_hash_references(root, plan, rtoffset);
 			break;
 
-		case T_Material:
 		case T_Sort:
+			{
+				Sort	   *splan = (Sort *) plan;
+
+				/* a late-materialized sort refers to its scanned rel */
+				if (splan->lateRelid != 0)
+					splan->lateRelid += rtoffset;
+			}
+			/* FALL THRU */
+		case T_Material:
+		case T_Redistribute:
+		case T_IncrementalSort:
 		case T_Unique:
 		case T_SetOp:
 
@@ -696,6 +706,24 @@ set_plan_refs(PlannerInfo *root, Plan *plan, int rtoffset)
 			 */
 			Assert(plan->qual == NIL);
 			break;
+
+		case T_ResultCache:
+			{
+				ResultCache *rcplan = (ResultCache *) plan;
+
+				/*
+				 * Like Material, ResultCache returns its input tuples
+				 * unmodified, but its cache key expressions still need the
+				 * usual fixups.
+				 */
+				set_dummy_tlist_references(plan, rtoffset);
+				Assert(plan->qual == NIL);
+
+				rcplan->param_exprs = fix_scan_list(root, rcplan->param_exprs,
+													rtoffset);
+			}
+			break;
+
 		case T_LockRows:
 			{
 				LockRows   *splan = (LockRows *) plan;
@@ -768,6 +796,25 @@ set_plan_refs(PlannerInfo *root, Plan *plan, int rtoffset)
 
 				set_upper_references(root, plan, rtoffset);
 
+				/*
+				 * The run condition references the WindowAgg's own window
+				 * functions, whose arguments must be fixed up just like the
+				 * ones in the targetlist.
+				 */
+				if (wplan->runCondition != NIL)
+				{
+					indexed_tlist *subplan_itlist;
+
+					subplan_itlist = build_tlist_index(plan->lefttree->targetlist);
+					wplan->runCondition = (List *)
+						fix_upper_expr(root,
+									   (Node *) wplan->runCondition,
+									   subplan_itlist,
+									   OUTER_VAR,
+									   rtoffset);
+					pfree(subplan_itlist);
+				}
+
 				/*
 				 * Like Limit node limit/offset expressions, WindowAgg has
 				 * frame offset expressions, which cannot contain subplan
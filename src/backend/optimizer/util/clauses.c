@@ -38,6 +38,7 @@
 #include "optimizer/optimizer.h"
 #include "optimizer/plancat.h"
 #include "optimizer/planmain.h"
+#include "optimizer/tlist.h"
 #include "parser/analyze.h"
 #include "parser/parse_agg.h"
 #include "parser/parse_coerce.h"
@@ -313,6 +314,22 @@ get_agg_clause_costs_walker(Node *node, get_agg_clause_costs_context *context)
 		{
 			costs->numOrderedAggs++;
 			costs->hasNonPartial = true;
+
+			/*
+			 * A hashed Agg can eliminate duplicate inputs of a plain DISTINCT
+			 * aggregate with a per-group hash table, but it can't deliver the
+			 * input in any particular order.  So that's only allowed for
+			 * aggregates that have a combine function: partial aggregation
+			 * already feeds their input to them in an arbitrary order, so
+			 * their results must not depend on it.  array_agg, string_agg and
+			 * the like have none, and are left to the sort-based
+			 * implementation.  Aggregates with ORDER BY always are, too.
+			 */
+			if (aggref->aggorder == NIL &&
+				!AGGKIND_IS_ORDERED_SET(aggref->aggkind) &&
+				OidIsValid(aggcombinefn) &&
+				grouping_is_hashable(aggref->aggdistinct))
+				costs->numHashableDistinctAggs++;
 		}
 
 		/*
@@ -205,6 +205,33 @@ BarrierArriveAndDetach(Barrier *barrier)
 	return BarrierDetachImpl(barrier, true);
 }
 
+/*
+ * Arrive at a barrier, and detach all but the last to arrive.  Returns true if
+ * the caller was the last to arrive, and is therefore still attached, in the
+ * next phase.  This lets one participant carry on alone with work that can
+ * only begin once all others have finished, without anyone having to wait.
+ * It must not be used while other participants might be waiting.
+ */
+bool
+BarrierArriveAndDetachExceptLast(Barrier *barrier)
+{
+	Assert(!barrier->static_party);
+
+	SpinLockAcquire(&barrier->mutex);
+	if (barrier->participants > 1)
+	{
+		--barrier->participants;
+		SpinLockRelease(&barrier->mutex);
+
+		return false;
+	}
+	Assert(barrier->participants == 1);
+	++barrier->phase;
+	SpinLockRelease(&barrier->mutex);
+
+	return true;
+}
+
 /*
  * Attach to a barrier.  All waiting participants will now wait for this
  * participant to call BarrierArriveAndWait(), BarrierDetach() or
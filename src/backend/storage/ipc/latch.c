@@ -1950,3 +1950,12 @@ drainSelfPipe(void)
 	}
 }
 #endif							/* !WIN32 */
+
+/*
+ * Get the number of wait events registered in a given WaitEventSet.
+ */
+int
+GetNumRegisteredWaitEvents(WaitEventSet *set)
+{
+	return set->nevents;
+}
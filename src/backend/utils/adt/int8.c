@@ -831,6 +831,57 @@ int8inc(PG_FUNCTION_ARGS)
 	}
 }
 
+/*
+ * Planner support function for count(*), whose transition function is
+ * int8inc
+ */
+Datum
+int8inc_support(PG_FUNCTION_ARGS)
+{
+	Node	   *rawreq = (Node *) PG_GETARG_POINTER(0);
+
+	if (IsA(rawreq, SupportRequestWFuncMonotonic))
+	{
+		SupportRequestWFuncMonotonic *req = (SupportRequestWFuncMonotonic *) rawreq;
+		MonotonicFunction monotonic = MONOTONICFUNC_NONE;
+		int			frameOptions = req->window_clause->frameOptions;
+
+		/*
+		 * Excluding the current row or its peers from the frame shrinks it
+		 * by a varying amount, so nothing can be said about the count then.
+		 */
+		if (frameOptions & FRAMEOPTION_EXCLUSION)
+		{
+			req->monotonic = MONOTONICFUNC_NONE;
+			PG_RETURN_POINTER(req);
+		}
+
+		/*
+		 * With a frame that starts at the beginning of the partition, the
+		 * frame can only grow as we move through the partition, so the count
+		 * can only go up.  Likewise, it can only go down if the frame always
+		 * ends at the end of the partition.
+		 */
+		if (frameOptions & FRAMEOPTION_START_UNBOUNDED_PRECEDING)
+			monotonic |= MONOTONICFUNC_INCREASING;
+		if (frameOptions & FRAMEOPTION_END_UNBOUNDED_FOLLOWING)
+			monotonic |= MONOTONICFUNC_DECREASING;
+
+		/*
+		 * Without ORDER BY, all rows are peers, so in RANGE or GROUPS mode
+		 * every row sees the same frame.
+		 */
+		if (req->window_clause->orderClause == NIL &&
+			(frameOptions & (FRAMEOPTION_RANGE | FRAMEOPTION_GROUPS)))
+			monotonic = MONOTONICFUNC_BOTH;
+
+		req->monotonic = monotonic;
+		PG_RETURN_POINTER(req);
+	}
+
+	PG_RETURN_POINTER(NULL);
+}
+
 Datum
 int8dec(PG_FUNCTION_ARGS)
 {
@@ -43,6 +43,8 @@
 #include "commands/vacuum.h"
 #include "commands/variable.h"
 #include "common/string.h"
+#include "executor/execBatch.h"
+#include "executor/nodeHashjoin.h"
 #include "funcapi.h"
 #include "jit/jit.h"
 #include "libpq/auth.h"
@@ -133,6 +135,7 @@ extern bool trace_syncscan;
 #ifdef DEBUG_BOUNDED_SORT
 extern bool optimize_bounded_sort;
 #endif
+extern bool optimize_integer_sort;
 
 static int	GUC_check_errcode_value;
 
@@ -959,6 +962,16 @@ static struct config_bool ConfigureNamesBool[] =
 		true,
 		NULL, NULL, NULL
 	},
+	{
+		{"enable_async_append", PGC_USERSET, QUERY_TUNING_METHOD,
+			gettext_noop("Enables the planner's use of async append plans."),
+			NULL,
+			GUC_EXPLAIN
+		},
+		&enable_async_append,
+		true,
+		NULL, NULL, NULL
+	},
 	{
 		{"enable_bitmapscan", PGC_USERSET, QUERY_TUNING_METHOD,
 			gettext_noop("Enables the planner's use of bitmap-scan plans."),
@@ -989,6 +1002,16 @@ static struct config_bool ConfigureNamesBool[] =
 		true,
 		NULL, NULL, NULL
 	},
+	{
+		{"enable_incremental_sort", PGC_USERSET, QUERY_TUNING_METHOD,
+			gettext_noop("Enables the planner's use of incremental sort steps."),
+			NULL,
+			GUC_EXPLAIN
+		},
+		&enable_incremental_sort,
+		true,
+		NULL, NULL, NULL
+	},
 	{
 		{"enable_hashagg", PGC_USERSET, QUERY_TUNING_METHOD,
 			gettext_noop("Enables the planner's use of hashed aggregation plans."),
@@ -1019,6 +1042,16 @@ static struct config_bool ConfigureNamesBool[] =
 		false,
 		NULL, NULL, NULL
 	},
+	{
+		{"enable_late_materialization", PGC_USERSET, QUERY_TUNING_METHOD,
+			gettext_noop("Enables the planner's use of late materialization for sorts of wide rows."),
+			NULL,
+			GUC_EXPLAIN
+		},
+		&enable_late_materialization,
+		true,
+		NULL, NULL, NULL
+	},
 	{
 		{"enable_material", PGC_USERSET, QUERY_TUNING_METHOD,
 			gettext_noop("Enables the planner's use of materialization."),
@@ -1029,6 +1062,16 @@ static struct config_bool ConfigureNamesBool[] =
 		true,
 		NULL, NULL, NULL
 	},
+	{
+		{"enable_resultcache", PGC_USERSET, QUERY_TUNING_METHOD,
+			gettext_noop("Enables the planner's use of result caching."),
+			NULL,
+			GUC_EXPLAIN
+		},
+		&enable_resultcache,
+		false,
+		NULL, NULL, NULL
+	},
 	{
 		{"enable_nestloop", PGC_USERSET, QUERY_TUNING_METHOD,
 			gettext_noop("Enables the planner's use of nested-loop join plans."),
@@ -1039,6 +1082,16 @@ static struct config_bool ConfigureNamesBool[] =
 		true,
 		NULL, NULL, NULL
 	},
+	{
+		{"enable_batched_nestloop", PGC_USERSET, QUERY_TUNING_METHOD,
+			gettext_noop("Enables batching of outer rows in nested-loop joins with an inner index scan."),
+			NULL,
+			GUC_EXPLAIN
+		},
+		&enable_batched_nestloop,
+		false,
+		NULL, NULL, NULL
+	},
 	{
 		{"enable_mergejoin", PGC_USERSET, QUERY_TUNING_METHOD,
 			gettext_noop("Enables the planner's use of merge join plans."),
@@ -1109,6 +1162,26 @@ static struct config_bool ConfigureNamesBool[] =
 		true,
 		NULL, NULL, NULL
 	},
+	{
+		{"enable_parallel_hashagg", PGC_USERSET, QUERY_TUNING_METHOD,
+			gettext_noop("Enables the planner's use of parallel hashed aggregation plans."),
+			NULL,
+			GUC_EXPLAIN
+		},
+		&enable_parallel_hashagg,
+		true,
+		NULL, NULL, NULL
+	},
+	{
+		{"enable_parallel_window", PGC_USERSET, QUERY_TUNING_METHOD,
+			gettext_noop("Enables the planner's use of parallel window function plans."),
+			NULL,
+			GUC_EXPLAIN
+		},
+		&enable_parallel_window,
+		true,
+		NULL, NULL, NULL
+	},
 	{
 		{"enable_partition_pruning", PGC_USERSET, QUERY_TUNING_METHOD,
 			gettext_noop("Enables plan-time and run-time partition pruning."),
@@ -1973,6 +2046,37 @@ static struct config_bool ConfigureNamesBool[] =
 		NULL, NULL, NULL
 	},
 
+	{
+		{"jit_code_cache", PGC_USERSET, QUERY_TUNING_OTHER,
+			gettext_noop("Reuse JIT compiled code across queries."),
+			NULL
+		},
+		&jit_code_cache,
+		true,
+		NULL, NULL, NULL
+	},
+
+	{
+		{"jit_code_cache_on_disk", PGC_SIGHUP, QUERY_TUNING_OTHER,
+			gettext_noop("Share JIT compiled code with other sessions through files in the data directory."),
+			NULL
+		},
+		&jit_code_cache_on_disk,
+		false,
+		NULL, NULL, NULL
+	},
+
+	{
+		{"jit_tiered_compilation", PGC_USERSET, QUERY_TUNING_OTHER,
+			gettext_noop("Start executing expressions without JIT, and compile those that are evaluated often."),
+			NULL,
+			GUC_EXPLAIN
+		},
+		&jit_tiered_compilation,
+		false,
+		NULL, NULL, NULL
+	},
+
 	{
 		{"jit_debugging_support", PGC_SU_BACKEND, DEVELOPER_OPTIONS,
 			gettext_noop("Register JIT compiled function with debugger."),
@@ -2040,6 +2144,17 @@ static struct config_bool ConfigureNamesBool[] =
 		NULL, NULL, NULL
 	},
 
+	{
+		{"optimize_integer_sort", PGC_USERSET, DEVELOPER_OPTIONS,
+			gettext_noop("Use specialized sort routines for integer sort keys."),
+			NULL,
+			GUC_NOT_IN_SAMPLE
+		},
+		&optimize_integer_sort,
+		true,
+		NULL, NULL, NULL
+	},
+
 	{
 		{"data_sync_retry", PGC_POSTMASTER, ERROR_HANDLING_OPTIONS,
 			gettext_noop("Whether to continue running after a failure to sync data files."),
@@ -2124,6 +2239,28 @@ static struct config_int ConfigureNamesInt[] =
 		8, 1, INT_MAX,
 		NULL, NULL, NULL
 	},
+	{
+		{"executor_batch_size", PGC_USERSET, QUERY_TUNING_OTHER,
+			gettext_noop("Sets the maximum number of tuples passed between "
+						 "executor nodes at once."),
+			gettext_noop("Scans that support it return tuples to their "
+						 "parent node in batches of up to this many tuples. "
+						 "Zero disables batching.")
+		},
+		&executor_batch_size,
+		1024, 0, 65536,
+		NULL, NULL, NULL
+	},
+	{
+		{"jit_tier_up_threshold", PGC_USERSET, QUERY_TUNING_OTHER,
+			gettext_noop("Sets the number of evaluations after which an expression is JIT compiled."),
+			gettext_noop("Only used if jit_tiered_compilation is enabled."),
+			GUC_EXPLAIN
+		},
+		&jit_tier_up_threshold,
+		1000, 1, INT_MAX,
+		NULL, NULL, NULL
+	},
 	{
 		{"geqo_threshold", PGC_USERSET, QUERY_TUNING_GEQO,
 			gettext_noop("Sets the threshold of FROM items beyond which GEQO is used."),
@@ -2647,6 +2784,30 @@ static struct config_int ConfigureNamesInt[] =
 		NULL, NULL, NULL
 	},
 
+	{
+		{"hashjoin_prefetch_min_buckets", PGC_USERSET, DEVELOPER_OPTIONS,
+			gettext_noop("Sets the minimum number of hash join buckets for which "
+						 "buckets are prefetched."),
+			NULL,
+			GUC_NOT_IN_SAMPLE
+		},
+		&hashjoin_prefetch_min_buckets,
+		65536, 0, INT_MAX,
+		NULL, NULL, NULL
+	},
+
+	{
+		{"hashjoin_prefetch_group_size", PGC_USERSET, DEVELOPER_OPTIONS,
+			gettext_noop("Sets the number of outer tuples whose hash join buckets "
+						 "are prefetched together."),
+			NULL,
+			GUC_NOT_IN_SAMPLE
+		},
+		&hashjoin_prefetch_group_size,
+		16, 1, 1024,
+		NULL, NULL, NULL
+	},
+
 	{
 		{"wal_keep_segments", PGC_SIGHUP, REPLICATION_SENDING,
 			gettext_noop("Sets the number of WAL files held for standby servers."),
@@ -12,6 +12,11 @@
 # specialized to the particular data type of interest (in this case, SortTuple)
 # are faster than the generic routines.
 #
+# Besides the generic versions, we generate versions that inline the
+# comparison of the leading key when its comparator is one of the integer
+# comparators exported by tuplesort.c, since those are by far the most
+# commonly sorted types.
+#
 #	Modifications from vanilla NetBSD source:
 #	  Add do ... while() macro fix
 #	  Remove __inline, _DIAGASSERTs, __P
@@ -53,6 +58,58 @@ print <<'EOM';
 EOM
 emit_qsort_implementation();
 
+# Variants with the leading key comparison inlined, for the common integer
+# sort keys.  The full comparator is only called to break ties, if there is
+# anything left to compare after the leading key.
+$SUFFIX      = 'tuple_int32';
+$EXTRAARGS   = ', Tuplesortstate *state';
+$EXTRAPARAMS = ', state';
+$CMPPARAMS   = ', state';
+print <<'EOM';
+
+static pg_attribute_always_inline int
+cmp_tuple_int32(SortTuple *a, SortTuple *b, Tuplesortstate *state)
+{
+	int			compare;
+
+	compare = ApplyInt32SortComparator(a->datum1, a->isnull1,
+									   b->datum1, b->isnull1,
+									   &state->sortKeys[0]);
+	if (compare != 0 || state->onlyKey != NULL)
+		return compare;
+
+	return state->comparetup(a, b, state);
+}
+
+EOM
+emit_qsort_implementation();
+
+$SUFFIX = 'tuple_signed';
+print <<'EOM';
+
+#if SIZEOF_DATUM >= 8
+
+static pg_attribute_always_inline int
+cmp_tuple_signed(SortTuple *a, SortTuple *b, Tuplesortstate *state)
+{
+	int			compare;
+
+	compare = ApplySignedSortComparator(a->datum1, a->isnull1,
+										b->datum1, b->isnull1,
+										&state->sortKeys[0]);
+	if (compare != 0 || state->onlyKey != NULL)
+		return compare;
+
+	return state->comparetup(a, b, state);
+}
+
+EOM
+emit_qsort_implementation();
+print <<'EOM';
+
+#endif							/* SIZEOF_DATUM >= 8 */
+EOM
+
 sub emit_qsort_boilerplate
 {
 	print <<'EOM';
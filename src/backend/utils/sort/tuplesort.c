@@ -31,26 +31,28 @@
  * input is reached, we dump out remaining tuples in memory into a final run,
  * then merge the runs using Algorithm D.
  *
- * When merging runs, we use a heap containing just the frontmost tuple from
- * each source run; we repeatedly output the smallest tuple and replace it
- * with the next tuple from its source tape (if any).  When the heap empties,
- * the merge is complete.  The basic merge algorithm thus needs very little
- * memory --- only M tuples for an M-way merge, and M is constrained to a
- * small number.  However, we can still make good use of our full workMem
- * allocation by pre-reading additional blocks from each source tape.  Without
- * prereading, our access pattern to the temporary file would be very erratic;
- * on average we'd read one block from each of M source tapes during the same
- * time that we're writing M blocks to the output tape, so there is no
- * sequentiality of access at all, defeating the read-ahead methods used by
- * most Unix kernels.  Worse, the output tape gets written into a very random
- * sequence of blocks of the temp file, ensuring that things will be even
- * worse when it comes time to read that tape.  A straightforward merge pass
- * thus ends up doing a lot of waiting for disk seeks.  We can improve matters
- * by prereading from each source tape sequentially, loading about workMem/M
- * bytes from each tape in turn, and making the sequential blocks immediately
- * available for reuse.  This approach helps to localize both read and write
- * accesses.  The pre-reading is handled by logtape.c, we just tell it how
- * much memory to use for the buffers.
+ * When merging runs, we keep just the frontmost tuple from each source run,
+ * organized in a tournament ("loser") tree, per Knuth 5.4.1; we repeatedly
+ * output the smallest tuple and replace it with the next tuple from its
+ * source tape (if any), which only requires replaying the matches on the
+ * path from that tape's leaf to the root of the tree.  When all source runs
+ * are exhausted, the merge is complete.  The basic merge algorithm thus needs
+ * very little memory --- only M tuples for an M-way merge, and M is
+ * constrained to a small number.  However, we can still make good use of our
+ * full workMem allocation by pre-reading additional blocks from each source
+ * tape.  Without prereading, our access pattern to the temporary file would be
+ * very erratic; on average we'd read one block from each of M source tapes
+ * during the same time that we're writing M blocks to the output tape, so
+ * there is no sequentiality of access at all, defeating the read-ahead methods
+ * used by most Unix kernels.  Worse, the output tape gets written into a very
+ * random sequence of blocks of the temp file, ensuring that things will be
+ * even worse when it comes time to read that tape.  A straightforward merge
+ * pass thus ends up doing a lot of waiting for disk seeks.  We can improve
+ * matters by prereading from each source tape sequentially, loading about
+ * workMem/M bytes from each tape in turn, and making the sequential blocks
+ * immediately available for reuse.  This approach helps to localize both read
+ * and write accesses.  The pre-reading is handled by logtape.c, we just tell
+ * it how much memory to use for the buffers.
  *
  * When the caller requests random access to the sort result, we form
  * the final sorted run on a logical tape which is then "frozen", so
@@ -103,6 +105,7 @@
 #include "catalog/pg_am.h"
 #include "commands/tablespace.h"
 #include "executor/executor.h"
+#include "lib/losertree.h"
 #include "miscadmin.h"
 #include "pg_trace.h"
 #include "utils/datum.h"
@@ -134,6 +137,8 @@ bool		trace_sort = false;
 bool		optimize_bounded_sort = true;
 #endif
 
+bool		optimize_integer_sort = true;
+
 
 /*
  * The objects we actually sort are SortTuple structs.  These contain
@@ -221,6 +226,13 @@ typedef enum
 #define TAPE_BUFFER_OVERHEAD		BLCKSZ
 #define MERGE_BUFFER_SIZE			(BLCKSZ * 32)
 
+/*
+ * Minimum number of tuples for which a single-key sort on an integer type
+ * uses a radix sort rather than quicksort.  Below this, the fixed cost of the
+ * counting passes is not recouped.
+ */
+#define RADIX_SORT_MIN_TUPLES		1024
+
 typedef int (*SortTupleComparator) (const SortTuple *a, const SortTuple *b,
 									Tuplesortstate *state);
 
@@ -286,9 +298,11 @@ struct Tuplesortstate
 	/*
 	 * This array holds the tuples now in sort memory.  If we are in state
 	 * INITIAL, the tuples are in no particular order; if we are in state
-	 * SORTEDINMEM, the tuples are in final sorted order; in states BUILDRUNS
-	 * and FINALMERGE, the tuples are organized in "heap" order per Algorithm
-	 * H.  In state SORTEDONTAPE, the array is not used.
+	 * SORTEDINMEM, the tuples are in final sorted order; in state BOUNDED,
+	 * the tuples are organized in "heap" order per Algorithm H.  While
+	 * merging (in states BUILDRUNS and FINALMERGE), memtuples[i] holds the
+	 * current tuple of the i'th merge source, and mergetree says which of
+	 * them comes first.  In state SORTEDONTAPE, the array is not used.
 	 */
 	SortTuple  *memtuples;		/* array of SortTuple structs */
 	int			memtupcount;	/* number of tuples currently present */
@@ -306,7 +320,7 @@ struct Tuplesortstate
 	 * For the slab, we use one large allocation, divided into SLAB_SLOT_SIZE
 	 * slots.  The allocation is sized to have one slot per tape, plus one
 	 * additional slot.  We need that many slots to hold all the tuples kept
-	 * in the heap during merge, plus the one we have last returned from the
+	 * in memtuples during merge, plus the one we have last returned from the
 	 * sort, with tuplesort_gettuple.
 	 *
 	 * Initially, all the slots are kept in a linked list of free slots.  When
@@ -357,6 +371,13 @@ struct Tuplesortstate
 	 */
 	bool	   *mergeactive;	/* active input run source? */
 
+	/*
+	 * Tournament tree over the memtuples[] entries of the current merge pass.
+	 * Allocated in mergeruns(); memtupcount tracks the number of sources in
+	 * the tree that are not yet exhausted.
+	 */
+	losertree  *mergetree;
+
 	/*
 	 * Variables for Algorithm D.  Note that destTape is a "logical" tape
 	 * number, ie, an index into the tp_xxx[] arrays.  Be careful to keep
@@ -601,10 +622,12 @@ static void mergeruns(Tuplesortstate *state);
 static void mergeonerun(Tuplesortstate *state);
 static void beginmerge(Tuplesortstate *state);
 static bool mergereadnext(Tuplesortstate *state, int srcTape, SortTuple *stup);
+static int	merge_compare_sources(int a, int b, void *arg);
 static void dumptuples(Tuplesortstate *state, bool alltuples);
 static void make_bounded_heap(Tuplesortstate *state);
 static void sort_bounded_heap(Tuplesortstate *state);
 static void tuplesort_sort_memtuples(Tuplesortstate *state);
+static bool tuplesort_radix_sort(Tuplesortstate *state, bool is_int32);
 static void tuplesort_heap_insert(Tuplesortstate *state, SortTuple *tuple);
 static void tuplesort_heap_replace_top(Tuplesortstate *state, SortTuple *tuple);
 static void tuplesort_heap_delete_top(Tuplesortstate *state);
@@ -653,7 +676,9 @@ static void free_sort_tuple(Tuplesortstate *state, SortTuple *stup);
  * any variant of SortTuples, using the appropriate comparetup function.
  * qsort_ssup() is specialized for the case where the comparetup function
  * reduces to ApplySortComparator(), that is single-key MinimalTuple sorts
- * and Datum sorts.
+ * and Datum sorts.  qsort_tuple_int32() and qsort_tuple_signed() inline the
+ * comparison of the leading key for the integer comparators defined at the
+ * end of this file.
  */
 #include "qsort_tuple.c"
 
@@ -2092,10 +2117,13 @@ tuplesort_gettuple_common(Tuplesortstate *state, bool forward,
 			 */
 			if (state->memtupcount > 0)
 			{
-				int			srcTape = state->memtuples[0].srctape;
-				SortTuple	newtup;
+				int			source = losertree_first(state->mergetree);
+				SortTuple  *top = &state->memtuples[source];
+				int			srcTape = top->srctape;
 
-				*stup = state->memtuples[0];
+				CHECK_FOR_INTERRUPTS();
+
+				*stup = *top;
 
 				/*
 				 * Remember the tuple we return, so that we can recycle its
@@ -2104,16 +2132,17 @@ tuplesort_gettuple_common(Tuplesortstate *state, bool forward,
 				state->lastReturnedTuple = stup->tuple;
 
 				/*
-				 * Pull next tuple from tape, and replace the returned tuple
-				 * at top of the heap with it.
+				 * Pull next tuple from tape into the returned tuple's merge
+				 * slot, and replay its path through the tournament tree.
 				 */
-				if (!mergereadnext(state, srcTape, &newtup))
+				if (!mergereadnext(state, srcTape, top))
 				{
 					/*
 					 * If no more data, we've reached end of run on this tape.
-					 * Remove the top node from the heap.
+					 * Retire its source from the tree.
 					 */
-					tuplesort_heap_delete_top(state);
+					losertree_remove_first(state->mergetree);
+					state->memtupcount--;
 
 					/*
 					 * Rewind to free the read buffer.  It'd go away at the
@@ -2123,8 +2152,8 @@ tuplesort_gettuple_common(Tuplesortstate *state, bool forward,
 					LogicalTapeRewindForWrite(state->tapeset, srcTape);
 					return true;
 				}
-				newtup.srctape = srcTape;
-				tuplesort_heap_replace_top(state, &newtup);
+				top->srctape = srcTape;
+				losertree_replace_first(state->mergetree);
 				return true;
 			}
 			return false;
@@ -2596,7 +2625,7 @@ mergeruns(Tuplesortstate *state)
 
 	/*
 	 * We no longer need a large memtuples array.  (We will allocate a smaller
-	 * one for the heap later.)
+	 * one for the merge later.)
 	 */
 	FREEMEM(state, GetMemoryChunkSpace(state->memtuples));
 	pfree(state->memtuples);
@@ -2625,7 +2654,7 @@ mergeruns(Tuplesortstate *state)
 
 	/*
 	 * Initialize the slab allocator.  We need one slab slot per input tape,
-	 * for the tuples in the heap, plus one to hold the tuple last returned
+	 * for the tuples being merged, plus one to hold the tuple last returned
 	 * from tuplesort_gettuple.  (If we're sorting pass-by-val Datums,
 	 * however, we don't need to do allocate anything.)
 	 *
@@ -2638,12 +2667,15 @@ mergeruns(Tuplesortstate *state)
 		init_slab_allocator(state, 0);
 
 	/*
-	 * Allocate a new 'memtuples' array, for the heap.  It will hold one tuple
-	 * from each input tape.
+	 * Allocate a new 'memtuples' array, and the tournament tree over it.  It
+	 * will hold one tuple from each input tape.
 	 */
 	state->memtupsize = numInputTapes;
 	state->memtuples = (SortTuple *) palloc(numInputTapes * sizeof(SortTuple));
 	USEMEM(state, GetMemoryChunkSpace(state->memtuples));
+	state->mergetree = losertree_allocate(numInputTapes,
+										  merge_compare_sources, state);
+	USEMEM(state, GetMemoryChunkSpace(state->mergetree));
 
 	/*
 	 * Use all the remaining memory we have available for read buffers among
@@ -2793,43 +2825,50 @@ mergeonerun(Tuplesortstate *state)
 
 	/*
 	 * Start the merge by loading one tuple from each active source tape into
-	 * the heap.  We can also decrease the input run/dummy run counts.
+	 * the tournament tree.  We can also decrease the input run/dummy run
+	 * counts.
 	 */
 	beginmerge(state);
 
 	/*
-	 * Execute merge by repeatedly extracting lowest tuple in heap, writing it
+	 * Execute merge by repeatedly extracting the winning tuple, writing it
 	 * out, and replacing it with next tuple from same tape (if there is
 	 * another one).
 	 */
 	while (state->memtupcount > 0)
 	{
-		SortTuple	stup;
+		int			source = losertree_first(state->mergetree);
+		SortTuple  *top = &state->memtuples[source];
+
+		CHECK_FOR_INTERRUPTS();
 
 		/* write the tuple to destTape */
-		srcTape = state->memtuples[0].srctape;
-		WRITETUP(state, destTape, &state->memtuples[0]);
+		srcTape = top->srctape;
+		WRITETUP(state, destTape, top);
 
 		/* recycle the slot of the tuple we just wrote out, for the next read */
-		if (state->memtuples[0].tuple)
-			RELEASE_SLAB_SLOT(state, state->memtuples[0].tuple);
+		if (top->tuple)
+			RELEASE_SLAB_SLOT(state, top->tuple);
 
 		/*
-		 * pull next tuple from the tape, and replace the written-out tuple in
-		 * the heap with it.
+		 * pull next tuple from the tape into the same merge slot, and replay
+		 * its path through the tree.
 		 */
-		if (mergereadnext(state, srcTape, &stup))
+		if (mergereadnext(state, srcTape, top))
 		{
-			stup.srctape = srcTape;
-			tuplesort_heap_replace_top(state, &stup);
+			top->srctape = srcTape;
+			losertree_replace_first(state->mergetree);
 		}
 		else
-			tuplesort_heap_delete_top(state);
+		{
+			losertree_remove_first(state->mergetree);
+			state->memtupcount--;
+		}
 	}
 
 	/*
-	 * When the heap empties, we're done.  Write an end-of-run marker on the
-	 * output tape, and increment its count of real runs.
+	 * When all sources are exhausted, we're done.  Write an end-of-run
+	 * marker on the output tape, and increment its count of real runs.
 	 */
 	markrunend(state, destTape);
 	state->tp_runs[state->tapeRange]++;
@@ -2846,7 +2885,8 @@ mergeonerun(Tuplesortstate *state)
  *
  * We decrease the counts of real and dummy runs for each tape, and mark
  * which tapes contain active input runs in mergeactive[].  Then, fill the
- * merge heap with the first tuple from each active tape.
+ * merge slots with the first tuple from each active tape, and play the
+ * initial tournament among them.
  */
 static void
 beginmerge(Tuplesortstate *state)
@@ -2854,8 +2894,9 @@ beginmerge(Tuplesortstate *state)
 	int			activeTapes;
 	int			tapenum;
 	int			srcTape;
+	int			source;
 
-	/* Heap should be empty here */
+	/* Merge slots should be empty here */
 	Assert(state->memtupcount == 0);
 
 	/* Adjust run counts and mark the active tapes */
@@ -2878,17 +2919,35 @@ beginmerge(Tuplesortstate *state)
 	Assert(activeTapes > 0);
 	state->activeTapes = activeTapes;
 
-	/* Load the merge heap with the first tuple from each input tape */
+	/* Load the merge slots with the first tuple from each input tape */
 	for (srcTape = 0; srcTape < state->maxTapes; srcTape++)
 	{
-		SortTuple	tup;
+		SortTuple  *tup = &state->memtuples[state->memtupcount];
 
-		if (mergereadnext(state, srcTape, &tup))
+		if (mergereadnext(state, srcTape, tup))
 		{
-			tup.srctape = srcTape;
-			tuplesort_heap_insert(state, &tup);
+			tup->srctape = srcTape;
+			state->memtupcount++;
 		}
 	}
+
+	losertree_reset(state->mergetree, state->memtupcount);
+	for (source = 0; source < state->memtupcount; source++)
+		losertree_add_unordered(state->mergetree, source);
+	losertree_build(state->mergetree);
+
+#ifdef TRACE_SORT
+	if (trace_sort)
+	{
+		int			depth = 0;
+
+		while ((1 << depth) < state->memtupcount)
+			depth++;
+		elog(LOG, "worker %d starting %d-way merge using a tournament tree of depth %d: %s",
+			 state->worker, state->memtupcount, depth,
+			 pg_rusage_show(&state->ru_start));
+	}
+#endif
 }
 
 /*
@@ -2915,6 +2974,17 @@ mergereadnext(Tuplesortstate *state, int srcTape, SortTuple *stup)
 	return true;
 }
 
+/*
+ * merge_compare_sources - tournament tree comparator for merge slots
+ */
+static int
+merge_compare_sources(int a, int b, void *arg)
+{
+	Tuplesortstate *state = (Tuplesortstate *) arg;
+
+	return COMPARETUP(state, &state->memtuples[a], &state->memtuples[b]);
+}
+
 /*
  * dumptuples - remove tuples from memtuples and write initial run to tape
  *
@@ -3304,6 +3374,8 @@ sort_bounded_heap(Tuplesortstate *state)
  * Sort all memtuples using specialized qsort() routines.
  *
  * Quicksort is used for small in-memory sorts, and external sort runs.
+ * Large sorts on a single integer key use a radix sort instead, if there's
+ * memory for it.
  */
 static void
 tuplesort_sort_memtuples(Tuplesortstate *state)
@@ -3312,6 +3384,43 @@ tuplesort_sort_memtuples(Tuplesortstate *state)
 
 	if (state->memtupcount > 1)
 	{
+		SortSupport leadKey = state->sortKeys;
+
+		/*
+		 * Is datum1 the leading key's value, and is the key of a type we have
+		 * specialized sort routines for?  CLUSTER only sets datum1 if the
+		 * leading index column is a simple column reference.  The routines
+		 * can be disabled for benchmarking, see test_sort_perf.
+		 */
+		if (optimize_integer_sort &&
+			leadKey != NULL && leadKey->abbrev_converter == NULL &&
+			(state->comparetup != comparetup_cluster ||
+			 state->indexInfo->ii_IndexAttrNumbers[0] != 0))
+		{
+			if (leadKey->comparator == ssup_datum_int32_cmp)
+			{
+				if (state->onlyKey == NULL ||
+					state->memtupcount < RADIX_SORT_MIN_TUPLES ||
+					!tuplesort_radix_sort(state, true))
+					qsort_tuple_int32(state->memtuples,
+									  state->memtupcount,
+									  state);
+				return;
+			}
+#if SIZEOF_DATUM >= 8
+			if (leadKey->comparator == ssup_datum_signed_cmp)
+			{
+				if (state->onlyKey == NULL ||
+					state->memtupcount < RADIX_SORT_MIN_TUPLES ||
+					!tuplesort_radix_sort(state, false))
+					qsort_tuple_signed(state->memtuples,
+									   state->memtupcount,
+									   state);
+				return;
+			}
+#endif
+		}
+
 		/* Can we use the single-key sort function? */
 		if (state->onlyKey != NULL)
 			qsort_ssup(state->memtuples, state->memtupcount,
@@ -3324,6 +3433,138 @@ tuplesort_sort_memtuples(Tuplesortstate *state)
 	}
 }
 
+/*
+ * Sort all memtuples with a least-significant-digit radix sort on datum1.
+ *
+ * This is only valid if the sort order is fully determined by the leading
+ * key, which must be of one of the integer types recognized by
+ * tuplesort_sort_memtuples().  The keys are mapped to unsigned integers that
+ * sort in the desired order, and distributed on one byte at a time, skipping
+ * bytes that are the same in all keys.  NULLs are moved to the appropriate
+ * end beforehand.
+ *
+ * This needs a second array as large as memtuples, so we only do it if that
+ * fits in the remaining memory budget.  Returns false if the sort was not
+ * done, in which case the caller must sort some other way.
+ */
+static bool
+tuplesort_radix_sort(Tuplesortstate *state, bool is_int32)
+{
+	SortSupport ssup = state->onlyKey;
+	SortTuple  *memtuples = state->memtuples;
+	size_t		n = state->memtupcount;
+	Size		bufsize = n * sizeof(SortTuple);
+	int			nbytes = is_int32 ? 4 : 8;
+	uint64		flip;
+	size_t		counts[8][256];
+	SortTuple  *keys;
+	SortTuple  *src;
+	SortTuple  *dst;
+	SortTuple  *buffer;
+	size_t		nkeys;
+	size_t		nfront;
+	size_t		i;
+	int			byte;
+
+	Assert(ssup != NULL && ssup == state->sortKeys);
+
+	if (state->availMem < (int64) bufsize)
+		return false;
+	buffer = (SortTuple *) MemoryContextAllocExtended(state->sortcontext,
+													  bufsize,
+													  MCXT_ALLOC_HUGE |
+													  MCXT_ALLOC_NO_OOM);
+	if (buffer == NULL)
+		return false;
+
+	/* Move NULLs to the front or back, leaving the keys contiguous */
+	nfront = 0;
+	for (i = 0; i < n; i++)
+	{
+		if (memtuples[i].isnull1 == ssup->ssup_nulls_first)
+		{
+			SortTuple	tmp = memtuples[nfront];
+
+			memtuples[nfront++] = memtuples[i];
+			memtuples[i] = tmp;
+		}
+	}
+	if (ssup->ssup_nulls_first)
+	{
+		keys = memtuples + nfront;
+		nkeys = n - nfront;
+	}
+	else
+	{
+		keys = memtuples;
+		nkeys = nfront;
+	}
+
+	/*
+	 * Flipping the sign bit makes signed integers sort correctly as
+	 * unsigned; flipping all bits reverses the order.
+	 */
+	flip = is_int32 ? UINT64CONST(0x80000000) : UINT64CONST(0x8000000000000000);
+	if (ssup->ssup_reverse)
+		flip ^= is_int32 ? UINT64CONST(0xFFFFFFFF) : PG_UINT64_MAX;
+
+#define RADIX_KEY(tup) \
+	(is_int32 ? \
+	 ((uint64) (uint32) DatumGetInt32((tup)->datum1) ^ flip) : \
+	 ((uint64) (tup)->datum1 ^ flip))
+
+	/* Count the occurrences of each value of each byte in a single pass */
+	memset(counts, 0, sizeof(counts));
+	for (i = 0; i < nkeys; i++)
+	{
+		uint64		key = RADIX_KEY(&keys[i]);
+
+		for (byte = 0; byte < nbytes; byte++)
+			counts[byte][(key >> (byte * 8)) & 0xFF]++;
+	}
+
+	src = keys;
+	dst = buffer;
+	for (byte = 0; byte < nbytes && nkeys > 0; byte++)
+	{
+		size_t	   *count = counts[byte];
+		size_t		offset;
+		int			shift = byte * 8;
+		SortTuple  *tmp;
+
+		CHECK_FOR_INTERRUPTS();
+
+		/* nothing to do if all keys have the same value in this byte */
+		if (count[(RADIX_KEY(&src[0]) >> shift) & 0xFF] == nkeys)
+			continue;
+
+		/* turn the counts into starting offsets */
+		offset = 0;
+		for (i = 0; i < 256; i++)
+		{
+			size_t		c = count[i];
+
+			count[i] = offset;
+			offset += c;
+		}
+
+		for (i = 0; i < nkeys; i++)
+			dst[count[(RADIX_KEY(&src[i]) >> shift) & 0xFF]++] = src[i];
+
+		tmp = src;
+		src = dst;
+		dst = tmp;
+	}
+
+#undef RADIX_KEY
+
+	if (src != keys)
+		memcpy(keys, src, nkeys * sizeof(SortTuple));
+	pfree(buffer);
+
+	return true;
+}
+
 /*
  * Insert a new tuple into an empty or existing heap, maintaining the
  * heap invariant.  Caller is responsible for ensuring there's room.
@@ -4529,3 +4770,39 @@ free_sort_tuple(Tuplesortstate *state, SortTuple *stup)
 	FREEMEM(state, GetMemoryChunkSpace(stup->tuple));
 	pfree(stup->tuple);
 }
+
+/*
+ * Comparators for sort keys that compare like plain signed integers.  These
+ * are exported for use by the sortsupport routines of such types, so that
+ * tuplesort_sort_memtuples() can recognize them by address and use its
+ * specialized sort routines.
+ */
+#if SIZEOF_DATUM >= 8
+int
+ssup_datum_signed_cmp(Datum x, Datum y, SortSupport ssup)
+{
+	int64		xx = DatumGetInt64(x);
+	int64		yy = DatumGetInt64(y);
+
+	if (xx < yy)
+		return -1;
+	else if (xx > yy)
+		return 1;
+	else
+		return 0;
+}
+#endif
+
+int
+ssup_datum_int32_cmp(Datum x, Datum y, SortSupport ssup)
+{
+	int32		xx = DatumGetInt32(x);
+	int32		yy = DatumGetInt32(y);
+
+	if (xx < yy)
+		return -1;
+	else if (xx > yy)
+		return 1;
+	else
+		return 0;
+}
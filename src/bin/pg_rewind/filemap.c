@@ -85,6 +85,9 @@ static const char *excludeDirContents[] =
 	/* Contents zeroed on startup, see StartupSUBTRANS(). */
 	"pg_subtrans",
 
+	/* Contents are a cache, see llvm_cached_deform(). */
+	"pg_jit_cache",
+
 	/* end of list */
 	NULL
 };
@@ -143,6 +143,10 @@ typedef void (*ammarkpos_function) (IndexScanDesc scan);
 /* restore marked scan position */
 typedef void (*amrestrpos_function) (IndexScanDesc scan);
 
+/* reposition scan at first tuple >= key on the leading column */
+typedef bool (*amrescantokey_function) (IndexScanDesc scan,
+										ScanKey skipkey);
+
 /*
  * Callback function signatures - for parallel index scans.
  */
@@ -229,6 +233,7 @@ typedef struct IndexAmRoutine
 	amendscan_function amendscan;
 	ammarkpos_function ammarkpos;	/* can be NULL */
 	amrestrpos_function amrestrpos; /* can be NULL */
+	amrescantokey_function amrescantokey;	/* can be NULL */
 
 	/* interface functions to support parallel index scans */
 	amestimateparallelscan_function amestimateparallelscan; /* can be NULL */
@@ -158,6 +158,7 @@ extern void index_rescan(IndexScanDesc scan,
 extern void index_endscan(IndexScanDesc scan);
 extern void index_markpos(IndexScanDesc scan);
 extern void index_restrpos(IndexScanDesc scan);
+extern bool index_rescan_to_key(IndexScanDesc scan, ScanKey skipkey);
 extern Size index_parallelscan_estimate(Relation indexrel, Snapshot snapshot);
 extern void index_parallelscan_initialize(Relation heaprel, Relation indexrel,
 										  Snapshot snapshot, ParallelIndexScanDesc target);
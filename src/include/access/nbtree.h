@@ -947,6 +947,20 @@ typedef struct BTScanOpaqueData
 	 */
 	int			markItemIndex;	/* itemIndex, or -1 if not valid */
 
+	/*
+	 * Boundary key set by btrescantokey(), to be used by the next _bt_first
+	 * call instead of the scan keys to find the starting position.
+	 */
+	bool		skipKeyValid;	/* is skipKey set? */
+	ScanKeyData skipKey;		/* >= key on the first index column */
+
+	/*
+	 * Leaf page on which the last _bt_first call started, or that
+	 * btrescantokey() left.  _bt_first may start from here rather than from
+	 * the root if the scan is known to be moving forward.
+	 */
+	BlockNumber hintBlkno;
+
 	/* keep these last in struct for efficiency */
 	BTScanPosData currPos;		/* current position data */
 	BTScanPosData markPos;		/* marked position, if any */
@@ -1017,6 +1031,7 @@ extern void btparallelrescan(IndexScanDesc scan);
 extern void btendscan(IndexScanDesc scan);
 extern void btmarkpos(IndexScanDesc scan);
 extern void btrestrpos(IndexScanDesc scan);
+extern bool btrescantokey(IndexScanDesc scan, ScanKey skipkey);
 extern IndexBulkDeleteResult *btbulkdelete(IndexVacuumInfo *info,
 										   IndexBulkDeleteResult *stats,
 										   IndexBulkDeleteCallback callback,
@@ -224,6 +224,21 @@ typedef struct TableAmRoutine
 									 ScanDirection direction,
 									 TupleTableSlot *slot);
 
+	/*
+	 * Return up to `nslots` next tuples from `scan`, stored in slots[0 ..
+	 * n-1], and return n.  Unlike with scan_getnextslot, all returned tuples
+	 * must stay valid until their slot is cleared or reused.  A result
+	 * smaller than `nslots` indicates the end of the scan; the callback is
+	 * not called again after that, unless the scan is restarted.
+	 *
+	 * Optional callback; executor nodes use scan_getnextslot if it is not
+	 * provided.
+	 */
+	int			(*scan_getnextbatch) (TableScanDesc scan,
+									  ScanDirection direction,
+									  TupleTableSlot **slots,
+									  int nslots);
+
 
 	/* ------------------------------------------------------------------------
 	 * Parallel table scan related functions.
@@ -907,6 +922,26 @@ table_scan_getnextslot(TableScanDesc sscan, ScanDirection direction, TupleTableS
 	return sscan->rs_rd->rd_tableam->scan_getnextslot(sscan, direction, slot);
 }
 
+/*
+ * Return up to `nslots` next tuples from `scan`, stored in slots[].  Only
+ * valid if the table AM provides the scan_getnextbatch callback.
+ */
+static inline int
+table_scan_getnextbatch(TableScanDesc sscan, ScanDirection direction,
+						TupleTableSlot **slots, int nslots)
+{
+	Oid			relid = RelationGetRelid(sscan->rs_rd);
+	int			ntuples;
+	int			i;
+
+	ntuples = sscan->rs_rd->rd_tableam->scan_getnextbatch(sscan, direction,
+														  slots, nslots);
+	for (i = 0; i < ntuples; i++)
+		slots[i]->tts_tableOid = relid;
+
+	return ntuples;
+}
+
 
 /* ----------------------------------------------------------------------------
  * Parallel table scan related functions.
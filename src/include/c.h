@@ -206,6 +206,18 @@
 #define unlikely(x) ((x) != 0)
 #endif
 
+/*
+ * Hint to the CPU that the memory at the given address will soon be read, so
+ * that it can start loading it into cache.  This never faults, even for an
+ * invalid address.  Like the branch hints, it's only worth using in hot code
+ * paths where cache misses are known to be a problem.
+ */
+#if __GNUC__ >= 3
+#define pg_prefetch_mem(a)	__builtin_prefetch(a)
+#else
+#define pg_prefetch_mem(a)	((void) (a))
+#endif
+
 /*
  * CppAsString
  *		Convert the argument to a string, using the C preprocessor.
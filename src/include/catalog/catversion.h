@@ -53,6 +53,6 @@
  */
 
 /*							yyyymmddN */
-#define CATALOG_VERSION_NO	202003281
+#define CATALOG_VERSION_NO	202003282
 
 #endif
@@ -0,0 +1,104 @@
+/*-------------------------------------------------------------------------
+ *
+ * execBatch.h
+ *	  Support for passing tuples between executor nodes in batches.
+ *
+ *
+ * Portions Copyright (c) 1996-2020, PostgreSQL Global Development Group
+ * Portions Copyright (c) 1994, Regents of the University of California
+ *
+ * src/include/executor/execBatch.h
+ *
+ *-------------------------------------------------------------------------
+ */
+#ifndef EXECBATCH_H
+#define EXECBATCH_H
+
+#include "executor/execBatchKernels.h"
+#include "executor/tuptable.h"
+#include "fmgr.h"
+#include "nodes/execnodes.h"
+
+/*
+ * A TupleBatch holds a number of tuples returned by a node's
+ * ExecProcNodeBatch method.  Like a node's result slot, the batch is owned
+ * by the node that produced it and is valid until the next call.
+ *
+ * slots[0 .. ntuples-1] contain the tuples fetched by the producer, and
+ * sel[0 .. nselected-1] are the indexes of those that passed the node's
+ * quals, in scan order.  A batch returned to the caller always has at least
+ * one selected tuple; end of data is signalled by returning NULL.
+ *
+ * The remaining arrays are scratch space used for evaluating quals one
+ * column at a time over the whole batch.
+ */
+typedef struct TupleBatch
+{
+	int			maxtuples;		/* allocated length of the arrays */
+	int			ntuples;		/* number of filled slots */
+	int			nselected;		/* number of valid entries in sel[] */
+	TupleTableSlot **slots;		/* fetched tuples */
+	int		   *sel;			/* selection vector: indexes into slots[] */
+	Datum	   *colvalues;		/* column workspace, indexed like sel[] */
+	bool	   *colisnull;
+	int64	   *colint64;		/* same, widened to int64 for kernels */
+	float8	   *colfloat8;		/* same, as float8 for kernels */
+	uint64	   *matches;		/* kernel result bitmap */
+} TupleBatch;
+
+/*
+ * How the values of a column are widened for a comparison kernel.
+ */
+typedef enum BatchKernelInput
+{
+	BATCH_KERNEL_NONE,			/* call the operator's function */
+	BATCH_KERNEL_INT16,			/* int2 column, int64 kernel */
+	BATCH_KERNEL_INT32,			/* int4 or date column, int64 kernel */
+	BATCH_KERNEL_INT64,			/* int8 or timestamp column, int64 kernel */
+	BATCH_KERNEL_FLOAT8			/* float8 column, float8 kernel */
+} BatchKernelInput;
+
+/*
+ * One step of a BatchQualState.  Simple "Var op Const" clauses with a strict
+ * operator are evaluated by gathering the Var's column for all selected
+ * tuples and then either running a comparison kernel, for the built-in
+ * comparison operators of the common fixed-width types, or else calling the
+ * operator's function directly.  Any other clauses are evaluated row by row
+ * with an ordinary ExprState.
+ */
+typedef struct BatchQualStep
+{
+	/* columnar step: attnum > 0 */
+	AttrNumber	attnum;			/* scan attribute compared */
+	int			argno;			/* argument position of the column value */
+	bool		constisnull;	/* comparison against NULL never succeeds */
+	FunctionCallInfo fcinfo;	/* call info with the constant filled in */
+	BatchKernelInput kernel;	/* kernel to use instead, if any */
+	BatchCompareOp cmp;			/* kernel comparison, "column op const" */
+	int64		constint64;		/* constant for the int64 kernel */
+	float8		constfloat8;	/* constant for the float8 kernel */
+
+	/* row-at-a-time step: attnum == 0 */
+	ExprState  *rowqual;
+} BatchQualStep;
+
+typedef struct BatchQualState
+{
+	int			nsteps;
+	BatchQualStep *steps;		/* evaluated in the order of the qual list */
+	AttrNumber	maxattnum;		/* highest attnum used by a columnar step */
+} BatchQualState;
+
+/* GUC parameter */
+extern PGDLLIMPORT int executor_batch_size;
+
+extern TupleBatch *ExecCreateBatch(EState *estate, TupleDesc tupdesc,
+								   const TupleTableSlotOps *tts_ops,
+								   int maxtuples);
+extern void ExecClearBatch(TupleBatch *batch);
+extern BatchQualState *ExecInitBatchQual(List *qual, ExprState *rowqual,
+										 PlanState *parent);
+extern void ExecBatchQual(BatchQualState *bqstate, TupleBatch *batch,
+						  ExprContext *econtext);
+
+#endif							/* EXECBATCH_H */
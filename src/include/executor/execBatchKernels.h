@@ -0,0 +1,84 @@
+/*-------------------------------------------------------------------------
+ *
+ * execBatchKernels.h
+ *	  Comparison kernels for evaluating quals over a batch of column values.
+ *
+ * The kernels compare an array of values with a constant and set a bit in
+ * the result bitmap for each value that satisfies the comparison.  The
+ * int64 kernels also serve int2, int4, date and timestamp columns, whose
+ * values are widened to int64 before comparison.
+ *
+ * On x86-64, SSE 4.2 versions of the kernels are used if the compiler
+ * supports the intrinsics.  Like the CRC-32C code, we rely on configure's
+ * SSE 4.2 tests for that, and check at runtime whether the CPU supports
+ * the instructions unless they're targeted at compile time.
+ *
+ * Portions Copyright (c) 1996-2020, PostgreSQL Global Development Group
+ * Portions Copyright (c) 1994, Regents of the University of California
+ *
+ * src/include/executor/execBatchKernels.h
+ *
+ *-------------------------------------------------------------------------
+ */
+#ifndef EXECBATCHKERNELS_H
+#define EXECBATCHKERNELS_H
+
+/* comparison performed by a kernel, "value op constant" */
+typedef enum BatchCompareOp
+{
+	BATCH_CMP_EQ,
+	BATCH_CMP_NE,
+	BATCH_CMP_LT,
+	BATCH_CMP_LE,
+	BATCH_CMP_GT,
+	BATCH_CMP_GE
+} BatchCompareOp;
+
+/*
+ * The float8 kernels follow the semantics of the float8 comparison
+ * operators, which sort NaNs after all other values.  The constant must not
+ * be a NaN, though.
+ */
+
+/* number of uint64 words needed for a result bitmap of n values */
+#define BATCH_MATCH_WORDS(n)	(((n) + 63) / 64)
+
+typedef void (*BatchCompareInt64Fn) (BatchCompareOp op, const int64 *values,
+									 int nvalues, int64 constval,
+									 uint64 *matches);
+typedef void (*BatchCompareFloat8Fn) (BatchCompareOp op, const float8 *values,
+									  int nvalues, float8 constval,
+									  uint64 *matches);
+
+#if defined(USE_SSE42_CRC32C)
+/* SSE 4.2 instructions are available at compile time, use them directly */
+#define USE_SSE42_BATCH_KERNELS
+#define ExecBatchCompareInt64	ExecBatchCompareInt64_sse42
+#define ExecBatchCompareFloat8	ExecBatchCompareFloat8_sse42
+#elif defined(USE_SSE42_CRC32C_WITH_RUNTIME_CHECK)
+/* choose between the SSE 4.2 and plain C kernels at runtime */
+#define USE_SSE42_BATCH_KERNELS
+#define USE_SSE42_BATCH_KERNELS_WITH_RUNTIME_CHECK
+extern BatchCompareInt64Fn ExecBatchCompareInt64;
+extern BatchCompareFloat8Fn ExecBatchCompareFloat8;
+#else
+#define ExecBatchCompareInt64	ExecBatchCompareInt64_scalar
+#define ExecBatchCompareFloat8	ExecBatchCompareFloat8_scalar
+#endif
+
+extern void ExecBatchCompareInt64_scalar(BatchCompareOp op,
+										 const int64 *values, int nvalues,
+										 int64 constval, uint64 *matches);
+extern void ExecBatchCompareFloat8_scalar(BatchCompareOp op,
+										  const float8 *values, int nvalues,
+										  float8 constval, uint64 *matches);
+#ifdef USE_SSE42_BATCH_KERNELS
+extern void ExecBatchCompareInt64_sse42(BatchCompareOp op,
+										const int64 *values, int nvalues,
+										int64 constval, uint64 *matches);
+extern void ExecBatchCompareFloat8_sse42(BatchCompareOp op,
+										 const float8 *values, int nvalues,
+										 float8 constval, uint64 *matches);
+#endif
+
+#endif							/* EXECBATCHKERNELS_H */
@@ -26,6 +26,8 @@ struct SubscriptingRefState;
 #define EEO_FLAG_INTERPRETER_INITIALIZED	(1 << 1)
 /* jump-threading is in use */
 #define EEO_FLAG_DIRECT_THREADED			(1 << 2)
+/* some FETCHSOME step only extracts the referenced attributes */
+#define EEO_FLAG_SPARSE_DEFORM				(1 << 3)
 
 /* Typical API for out-of-line evaluation subroutines */
 typedef void (*ExecEvalSubroutine) (ExprState *state,
@@ -91,6 +93,19 @@ typedef enum ExprEvalOp
 	EEOP_FUNCEXPR_FUSAGE,
 	EEOP_FUNCEXPR_STRICT_FUSAGE,
 
+	/*
+	 * Evaluate one of the built-in strict operators of ExecInitBuiltinFunc()
+	 * directly, without calling the function, unless that's needed to report
+	 * an error.  The operation is identified by d.func.builtin.
+	 */
+	EEOP_FUNCEXPR_INT4_CMP,
+	EEOP_FUNCEXPR_INT8_CMP,
+	EEOP_FUNCEXPR_FLOAT8_CMP,
+	EEOP_FUNCEXPR_BOOL_CMP,
+	EEOP_FUNCEXPR_INT4_ARITH,
+	EEOP_FUNCEXPR_INT8_ARITH,
+	EEOP_FUNCEXPR_FLOAT8_ARITH,
+
 	/*
 	 * Evaluate boolean AND expression, one step per subexpression. FIRST/LAST
 	 * subexpressions are special-cased for performance.  Since AND always has
@@ -220,12 +235,22 @@ typedef enum ExprEvalOp
 	EEOP_SUBPLAN,
 	EEOP_ALTERNATIVE_SUBPLAN,
 
+	/*
+	 * Share the value of a common subexpression between its occurrences:
+	 * start a new row, fetch the value if already computed for the current
+	 * row (else fall through to computing it), or remember the computed value.
+	 */
+	EEOP_COMMON_RESET,
+	EEOP_COMMON_FETCH,
+	EEOP_COMMON_STORE,
+
 	/* aggregation related nodes */
 	EEOP_AGG_STRICT_DESERIALIZE,
 	EEOP_AGG_DESERIALIZE,
 	EEOP_AGG_STRICT_INPUT_CHECK_ARGS,
 	EEOP_AGG_STRICT_INPUT_CHECK_NULLS,
 	EEOP_AGG_PLAIN_PERGROUP_NULLCHECK,
+	EEOP_AGG_HASHED_DISTINCT,
 	EEOP_AGG_PLAIN_TRANS_INIT_STRICT_BYVAL,
 	EEOP_AGG_PLAIN_TRANS_STRICT_BYVAL,
 	EEOP_AGG_PLAIN_TRANS_BYVAL,
@@ -239,6 +264,21 @@ typedef enum ExprEvalOp
 	EEOP_LAST
 } ExprEvalOp;
 
+/* Operation performed by EEOP_FUNCEXPR_*_CMP and EEOP_FUNCEXPR_*_ARITH */
+typedef enum ExprBuiltinOp
+{
+	EEO_BUILTIN_EQ,
+	EEO_BUILTIN_NE,
+	EEO_BUILTIN_LT,
+	EEO_BUILTIN_LE,
+	EEO_BUILTIN_GT,
+	EEO_BUILTIN_GE,
+	EEO_BUILTIN_PL,
+	EEO_BUILTIN_MI,
+	EEO_BUILTIN_MUL,
+	EEO_BUILTIN_DIV
+} ExprBuiltinOp;
+
 
 typedef struct ExprEvalStep
 {
@@ -272,6 +312,8 @@ typedef struct ExprEvalStep
 			TupleDesc	known_desc;
 			/* type of slot, can only be relied upon if fixed is set */
 			const TupleTableSlotOps *kind;
+			/* bitmap of attributes to fetch, NULL to fetch all up to last_var */
+			const bits8 *needed;
 		}			fetch;
 
 		/* for EEOP_INNER/OUTER/SCAN_[SYS]VAR[_FIRST] */
@@ -325,6 +367,8 @@ typedef struct ExprEvalStep
 			/* faster to access without additional indirection: */
 			PGFunction	fn_addr;	/* actual call address */
 			int			nargs;	/* number of arguments */
+			/* for EEOP_FUNCEXPR_*_CMP / _ARITH, the operation to perform */
+			ExprBuiltinOp builtin;
 		}			func;
 
 		/* for EEOP_BOOL_*_STEP */
@@ -596,6 +640,15 @@ typedef struct ExprEvalStep
 			AlternativeSubPlanState *asstate;
 		}			alternative_subplan;
 
+		/* for EEOP_COMMON_* */
+		struct
+		{
+			CommonExprs *common;	/* the parent's common subexpressions */
+			CommonExpr *cexpr;	/* the one at hand, NULL for RESET */
+			int			jumpdone;	/* FETCH: jump here if value is valid */
+			int16		typlen; /* STORE: length of result type */
+		}			common_expr;
+
 		/* for EEOP_AGG_*DESERIALIZE */
 		struct
 		{
@@ -632,6 +685,7 @@ typedef struct ExprEvalStep
 
 		/* for EEOP_AGG_PLAIN_TRANS_[INIT_][STRICT_]{BYVAL,BYREF} */
 		/* for EEOP_AGG_ORDERED_TRANS_{DATUM,TUPLE} */
+		/* for EEOP_AGG_HASHED_DISTINCT */
 		struct
 		{
 			AggStatePerTrans pertrans;
@@ -736,6 +790,7 @@ extern void ExecEvalSubPlan(ExprState *state, ExprEvalStep *op,
 							ExprContext *econtext);
 extern void ExecEvalAlternativeSubPlan(ExprState *state, ExprEvalStep *op,
 									   ExprContext *econtext);
+extern void ExecEvalCommonExprStore(ExprState *state, ExprEvalStep *op);
 extern void ExecEvalWholeRowVar(ExprState *state, ExprEvalStep *op,
 								ExprContext *econtext);
 extern void ExecEvalSysVar(ExprState *state, ExprEvalStep *op,
@@ -750,5 +805,7 @@ extern void ExecEvalAggOrderedTransDatum(ExprState *state, ExprEvalStep *op,
 										 ExprContext *econtext);
 extern void ExecEvalAggOrderedTransTuple(ExprState *state, ExprEvalStep *op,
 										 ExprContext *econtext);
+extern void ExecEvalAggHashedDistinct(ExprState *state, ExprEvalStep *op,
+									  ExprContext *econtext);
 
 #endif							/* EXEC_EXPR_H */
@@ -223,6 +223,8 @@ extern void EvalPlanQualEnd(EPQState *epqstate);
  */
 extern PlanState *ExecInitNode(Plan *node, EState *estate, int eflags);
 extern void ExecSetExecProcNode(PlanState *node, ExecProcNodeMtd function);
+extern void ExecSetExecProcNodeBatch(PlanState *node,
+									 ExecProcNodeBatchMtd function);
 extern Node *MultiExecProcNode(PlanState *node);
 extern void ExecEndNode(PlanState *node);
 extern bool ExecShutdownNode(PlanState *node);
@@ -246,6 +248,24 @@ ExecProcNode(PlanState *node)
 }
 #endif
 
+/* ----------------------------------------------------------------
+ *		ExecProcNodeBatch
+ *
+ *		Execute the given node to return a(nother) batch of tuples.
+ *		Only valid if node->ExecProcNodeBatch is set.
+ * ----------------------------------------------------------------
+ */
+#ifndef FRONTEND
+static inline struct TupleBatch *
+ExecProcNodeBatch(PlanState *node)
+{
+	if (node->chgParam != NULL) /* something changed? */
+		ExecReScan(node);		/* let ReScan handle this */
+
+	return node->ExecProcNodeBatch(node);
+}
+#endif
+
 /*
  * prototypes from functions in execExpr.c
  */
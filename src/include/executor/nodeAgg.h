@@ -14,6 +14,7 @@
 #ifndef NODEAGG_H
 #define NODEAGG_H
 
+#include "access/parallel.h"
 #include "nodes/execnodes.h"
 
 
@@ -109,6 +110,15 @@ typedef struct AggStatePerTransData
 	FmgrInfo	equalfnOne;
 	ExprState  *equalfnMulti;
 
+	/*
+	 * In hashed aggregation, DISTINCT is implemented without sorting: each
+	 * combination of grouping columns and input values that has been passed
+	 * to the transfn is remembered in distincttable, and duplicates are
+	 * skipped.  distinctslot is used to build the lookup keys.
+	 */
+	TupleHashTable distincttable;
+	TupleTableSlot *distinctslot;
+
 	/*
 	 * initial value from pg_aggregate entry
 	 */
@@ -314,6 +324,17 @@ extern AggState *ExecInitAgg(Agg *node, EState *estate, int eflags);
 extern void ExecEndAgg(AggState *node);
 extern void ExecReScanAgg(AggState *node);
 
+/* parallel hash aggregation support */
+extern void ExecAggEstimate(AggState *node, ParallelContext *pcxt);
+extern void ExecAggInitializeDSM(AggState *node, ParallelContext *pcxt);
+extern void ExecAggReInitializeDSM(AggState *node, ParallelContext *pcxt);
+extern void ExecAggInitializeWorker(AggState *node,
+									ParallelWorkerContext *pwcxt);
+
+/* support for the JIT compiled input pipeline */
+extern ExprState *ExecAggPipelineLookup(AggState *aggstate);
+extern void ExecAggPipelineAdvance(AggState *aggstate);
+
 extern Size hash_agg_entry_size(int numAggs, Size tupleWidth,
 								Size transitionSpace);
 extern void hash_agg_set_limits(double hashentrysize, uint64 input_groups,
@@ -55,9 +55,15 @@ extern void ExecHashGetBucketAndBatch(HashJoinTable hashtable,
 									  int *batchno);
 extern bool ExecScanHashBucket(HashJoinState *hjstate, ExprContext *econtext);
 extern bool ExecParallelScanHashBucket(HashJoinState *hjstate, ExprContext *econtext);
+extern void ExecHashPrefetchBuckets(HashJoinTable hashtable,
+									const uint32 *hashvalues,
+									int *bucketnos, int nvalues);
 extern void ExecPrepHashTableForUnmatched(HashJoinState *hjstate);
 extern bool ExecScanHashTableForUnmatched(HashJoinState *hjstate,
 										  ExprContext *econtext);
+extern bool ExecParallelPrepHashTableForUnmatched(HashJoinState *hjstate);
+extern bool ExecParallelScanHashTableForUnmatched(HashJoinState *hjstate,
+												  ExprContext *econtext);
 extern void ExecHashTableReset(HashJoinTable hashtable);
 extern void ExecHashTableResetMatchFlags(HashJoinTable hashtable);
 extern void ExecChooseHashTableSize(double ntuples, int tupwidth, bool useskew,
@@ -75,5 +81,9 @@ extern void ExecHashRetrieveInstrumentation(HashState *node);
 extern void ExecShutdownHash(HashState *node);
 extern void ExecHashGetInstrumentation(HashInstrumentation *instrument,
 									   HashJoinTable hashtable);
+extern bool ExecHashRuntimeFilterRejects(HashRuntimeFilter *rf,
+										 TupleTableSlot *slot,
+										 ExprContext *econtext);
+extern void ExecHashResetRuntimeFilter(HashRuntimeFilter *rf);
 
 #endif							/* NODEHASH_H */
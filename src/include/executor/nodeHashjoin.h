@@ -18,6 +18,10 @@
 #include "nodes/execnodes.h"
 #include "storage/buffile.h"
 
+/* GUC variables */
+extern int	hashjoin_prefetch_min_buckets;
+extern int	hashjoin_prefetch_group_size;
+
 extern HashJoinState *ExecInitHashJoin(HashJoin *node, EState *estate, int eflags);
 extern void ExecEndHashJoin(HashJoinState *node);
 extern void ExecReScanHashJoin(HashJoinState *node);
@@ -22,6 +22,7 @@ extern IndexScanState *ExecInitIndexScan(IndexScan *node, EState *estate, int ef
 extern void ExecEndIndexScan(IndexScanState *node);
 extern void ExecIndexMarkPos(IndexScanState *node);
 extern void ExecIndexRestrPos(IndexScanState *node);
+extern bool ExecIndexScanSkipTo(IndexScanState *node, ScanKey skipkey);
 extern void ExecReScanIndexScan(IndexScanState *node);
 extern void ExecIndexScanEstimate(IndexScanState *node, ParallelContext *pcxt);
 extern void ExecIndexScanInitializeDSM(IndexScanState *node, ParallelContext *pcxt);
@@ -0,0 +1,37 @@
+/*-------------------------------------------------------------------------
+ *
+ * nodeRedistribute.h
+ *	  prototypes for nodeRedistribute.c
+ *
+ *
+ * Portions Copyright (c) 1996-2020, PostgreSQL Global Development Group
+ * Portions Copyright (c) 1994, Regents of the University of California
+ *
+ * src/include/executor/nodeRedistribute.h
+ *
+ *-------------------------------------------------------------------------
+ */
+#ifndef NODEREDISTRIBUTE_H
+#define NODEREDISTRIBUTE_H
+
+#include "access/parallel.h"
+#include "nodes/execnodes.h"
+
+extern RedistributeState *ExecInitRedistribute(Redistribute *node,
+											   EState *estate, int eflags);
+extern void ExecEndRedistribute(RedistributeState *node);
+extern void ExecReScanRedistribute(RedistributeState *node);
+
+/* parallel scan support */
+extern void ExecRedistributeEstimate(RedistributeState *node,
+									 ParallelContext *pcxt);
+extern void ExecRedistributeInitializeDSM(RedistributeState *node,
+										  ParallelContext *pcxt);
+extern void ExecRedistributeReInitializeDSM(RedistributeState *node,
+											ParallelContext *pcxt);
+extern void ExecRedistributeInitializeWorker(RedistributeState *node,
+											 ParallelWorkerContext *pwcxt);
+extern void ExecRedistributeWorkersLaunched(RedistributeState *node,
+											ParallelContext *pcxt);
+
+#endif							/* NODEREDISTRIBUTE_H */
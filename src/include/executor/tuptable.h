@@ -329,6 +329,8 @@ extern Datum ExecFetchSlotHeapTupleDatum(TupleTableSlot *slot);
 extern void slot_getmissingattrs(TupleTableSlot *slot, int startAttNum,
 								 int lastAttNum);
 extern void slot_getsomeattrs_int(TupleTableSlot *slot, int attnum);
+extern void slot_getsparseattrs_int(TupleTableSlot *slot, int attnum,
+									const bits8 *needed);
 
 
 #ifndef FRONTEND
@@ -344,6 +346,19 @@ slot_getsomeattrs(TupleTableSlot *slot, int attnum)
 		slot_getsomeattrs_int(slot, attnum);
 }
 
+/*
+ * Like slot_getsomeattrs, but only the entries whose bit is set in needed, a
+ * bitmap of attributes laid out like a tuple's null bitmap, are made valid.
+ * The remaining entries up to attnum are left alone, and tts_nvalid is not
+ * advanced, see slot_getsparseattrs_int().
+ */
+static inline void
+slot_getsparseattrs(TupleTableSlot *slot, int attnum, const bits8 *needed)
+{
+	if (slot->tts_nvalid < attnum)
+		slot_getsparseattrs_int(slot, attnum, needed);
+}
+
 /*
  * slot_getallattrs
  *		This function forces all the entries of the slot's Datum/isnull
@@ -22,6 +22,7 @@
 #define PGJIT_INLINE   (1 << 2)
 #define PGJIT_EXPR	   (1 << 3)
 #define PGJIT_DEFORM   (1 << 4)
+#define PGJIT_TIERED   (1 << 5)
 
 
 typedef struct JitInstrumentation
@@ -40,6 +41,10 @@ typedef struct JitInstrumentation
 
 	/* accumulated time for code emission */
 	instr_time	emission_counter;
+
+	/* number of deform functions found / not found in the code cache */
+	size_t		deform_cache_hits;
+	size_t		deform_cache_misses;
 } JitInstrumentation;
 
 /*
@@ -69,12 +74,16 @@ typedef void (*JitProviderResetAfterErrorCB) (void);
 typedef void (*JitProviderReleaseContextCB) (JitContext *context);
 struct ExprState;
 typedef bool (*JitProviderCompileExprCB) (struct ExprState *state);
+struct AggState;
+typedef bool (*JitProviderCompileAggPipelineCB) (struct AggState *aggstate,
+												 struct ExprState *evaltrans);
 
 struct JitProviderCallbacks
 {
 	JitProviderResetAfterErrorCB reset_after_error;
 	JitProviderReleaseContextCB release_context;
 	JitProviderCompileExprCB compile_expr;
+	JitProviderCompileAggPipelineCB compile_agg_pipeline;
 };
 
 
@@ -86,6 +95,10 @@ extern bool jit_dump_bitcode;
 extern bool jit_expressions;
 extern bool jit_profiling_support;
 extern bool jit_tuple_deforming;
+extern bool jit_code_cache;
+extern bool jit_code_cache_on_disk;
+extern bool jit_tiered_compilation;
+extern int	jit_tier_up_threshold;
 extern double jit_above_cost;
 extern double jit_inline_above_cost;
 extern double jit_optimize_above_cost;
@@ -99,6 +112,8 @@ extern void jit_release_context(JitContext *context);
  * not be able to perform JIT (i.e. return false).
  */
 extern bool jit_compile_expr(struct ExprState *state);
+extern bool jit_compile_agg_pipeline(struct AggState *aggstate,
+									 struct ExprState *evaltrans);
 extern void InstrJitAgg(JitInstrumentation *dst, JitInstrumentation *add);
 
 
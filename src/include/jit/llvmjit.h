@@ -101,15 +101,36 @@ extern LLVMValueRef llvm_function_reference(LLVMJitContext *context,
 
 extern void llvm_inline(LLVMModuleRef mod);
 
+struct TupleTableSlotOps;
+extern void *llvm_cached_deform(LLVMJitContext *context, TupleDesc desc,
+								const struct TupleTableSlotOps *ops, int natts,
+								const bits8 *needed);
+
+/* on-disk code cache, shared by all backends */
+struct StringInfoData;
+extern uint64 llvm_code_fingerprint;
+extern LLVMMemoryBufferRef llvm_cache_read_file(uint64 hash, const char *suffix,
+												struct StringInfoData *key);
+extern void llvm_cache_write_file(uint64 hash, const char *suffix,
+								  struct StringInfoData *key,
+								  LLVMMemoryBufferRef buf);
+
 /*
  ****************************************************************************
  * Code generation functions.
  ****************************************************************************
  */
 extern bool llvm_compile_expr(struct ExprState *state);
-struct TupleTableSlotOps;
+extern const char *llvm_compiled_expr_funcname(struct ExprState *state);
+extern bool llvm_compile_agg_pipeline(struct AggState *aggstate,
+									  struct ExprState *evaltrans);
 extern LLVMValueRef slot_compile_deform(struct LLVMJitContext *context, TupleDesc desc,
-										const struct TupleTableSlotOps *ops, int natts);
+										const struct TupleTableSlotOps *ops, int natts,
+										const bits8 *needed);
+extern LLVMValueRef slot_build_deform(LLVMModuleRef mod, const char *funcname,
+									  TupleDesc desc,
+									  const struct TupleTableSlotOps *ops,
+									  int natts, const bits8 *needed);
 
 /*
  ****************************************************************************
@@ -0,0 +1,61 @@
+/*
+ * losertree.h
+ *
+ * A tournament ("loser") tree for K-way merging
+ *
+ * Portions Copyright (c) 2020, PostgreSQL Global Development Group
+ *
+ * src/include/lib/losertree.h
+ */
+
+#ifndef LOSERTREE_H
+#define LOSERTREE_H
+
+/*
+ * The tree does not store the values being merged; the caller keeps the
+ * current value of each source in an array of its own, and the tree deals
+ * only in source numbers.  The comparator must return <0 iff the current
+ * value of source a should be emitted before that of source b, 0 iff they
+ * are equal, and >0 otherwise.
+ */
+typedef int (*losertree_comparator) (int a, int b, void *arg);
+
+/*
+ * losertree
+ *
+ *		lt_capacity		maximum number of sources
+ *		lt_nsources		number of sources in the current merge
+ *		lt_nactive		number of sources not yet exhausted
+ *		lt_compare		comparison function to define the merge order
+ *		lt_arg			user data for comparison function
+ *		lt_exhausted	per-source flag, set once the source has run dry
+ *		lt_nodes		lt_nodes[0] is the current winner, lt_nodes[1] ..
+ *						lt_nodes[nsources - 1] hold the loser of the match
+ *						played at that internal node; the remaining space is
+ *						scratch for losertree_build()
+ */
+typedef struct losertree
+{
+	int			lt_capacity;
+	int			lt_nsources;
+	int			lt_nactive;
+	losertree_comparator lt_compare;
+	void	   *lt_arg;
+	bool	   *lt_exhausted;
+	int			lt_nodes[FLEXIBLE_ARRAY_MEMBER];
+} losertree;
+
+extern losertree *losertree_allocate(int capacity,
+									 losertree_comparator compare,
+									 void *arg);
+extern void losertree_reset(losertree *tree, int nsources);
+extern void losertree_free(losertree *tree);
+extern void losertree_add_unordered(losertree *tree, int source);
+extern void losertree_build(losertree *tree);
+extern int	losertree_first(losertree *tree);
+extern void losertree_replace_first(losertree *tree);
+extern void losertree_remove_first(losertree *tree);
+
+#define losertree_empty(t)			((t)->lt_nactive == 0)
+
+#endif							/* LOSERTREE_H */
@@ -17,6 +17,7 @@
 #include "access/tupconvert.h"
 #include "executor/instrument.h"
 #include "fmgr.h"
+#include "lib/ilist.h"
 #include "lib/pairingheap.h"
 #include "nodes/params.h"
 #include "nodes/plannodes.h"
@@ -113,6 +114,10 @@ typedef struct ExprState
 
 	Datum	   *innermost_domainval;
 	bool	   *innermost_domainnull;
+
+	/* common subexpressions shared with the parent's qual or projection */
+	struct CommonExprs *common;
+	Expr	   *common_node;	/* common subexpression being compiled */
 } ExprState;
 
 
@@ -929,6 +934,42 @@ typedef struct DomainConstraintState
  */
 typedef TupleTableSlot *(*ExecProcNodeMtd) (struct PlanState *pstate);
 
+/* ----------------
+ *	 CommonExprs
+ *
+ * Subexpressions occurring more than once in the qual and target list of a
+ * plan node (see ExecInitCommonExpr()).  They are computed once per row, and
+ * every later occurrence reuses the value.  A value is valid for the current
+ * row if its generation matches the generation of the CommonExprs, which is
+ * advanced whenever the node starts on a new row.
+ * ----------------
+ */
+typedef struct CommonExpr
+{
+	Expr	   *expr;			/* the subexpression */
+	int			nuses;			/* number of occurrences sharing the value */
+	uint64		generation;		/* row the value was computed for */
+	Datum		value;
+	bool		isnull;
+} CommonExpr;
+
+typedef struct CommonExprs
+{
+	uint64		generation;		/* current row */
+	int			ncommon;		/* number of entries in common[] */
+	CommonExpr *common;
+} CommonExprs;
+
+/* ----------------
+ *	 ExecProcNodeBatchMtd
+ *
+ * Optional method called by ExecProcNodeBatch to return the next batch of
+ * tuples from an executor node (see execBatch.c).  It returns NULL if no
+ * more tuples are available.
+ * ----------------
+ */
+typedef struct TupleBatch *(*ExecProcNodeBatchMtd) (struct PlanState *pstate);
+
 /* ----------------
  *		PlanState node
  *
@@ -949,6 +990,11 @@ typedef struct PlanState
 	ExecProcNodeMtd ExecProcNode;	/* function to return next tuple */
 	ExecProcNodeMtd ExecProcNodeReal;	/* actual function, if above is a
 										 * wrapper */
+	ExecProcNodeBatchMtd ExecProcNodeBatch; /* function to return next
+											 * batch, or NULL if the node
+											 * doesn't support batches */
+	ExecProcNodeBatchMtd ExecProcNodeBatchReal; /* actual function, if above
+												 * is a wrapper */
 
 	Instrumentation *instrument;	/* Optional runtime stats for this node */
 	WorkerInstrumentation *worker_instrument;	/* per-worker instrumentation */
@@ -981,6 +1027,8 @@ typedef struct PlanState
 	TupleTableSlot *ps_ResultTupleSlot; /* slot for my result tuples */
 	ExprContext *ps_ExprContext;	/* node's expression-evaluation context */
 	ProjectionInfo *ps_ProjInfo;	/* info for doing tuple projection */
+	CommonExprs *ps_CommonExprs;	/* subexpressions shared by qual and
+									 * projection, or NULL if not set up */
 
 	/*
 	 * Scanslot's descriptor if known. This is a bit of a hack, but otherwise
@@ -1024,6 +1072,12 @@ typedef struct PlanState
 	bool		outeropsset;
 	bool		inneropsset;
 	bool		resultopsset;
+
+	/*
+	 * True if the node is executed asynchronously by its parent, see
+	 * execAsync.c.
+	 */
+	bool		async_capable;
 } PlanState;
 
 /* ----------------
@@ -1052,6 +1106,11 @@ typedef struct PlanState
 		if (((PlanState *)(node))->instrument) \
 			((PlanState *)(node))->instrument->nfiltered2 += (delta); \
 	} while(0)
+#define InstrCountFiltered3(node, delta) \
+	do { \
+		if (((PlanState *)(node))->instrument) \
+			((PlanState *)(node))->instrument->nfiltered3 += (delta); \
+	} while(0)
 
 /*
  * EPQState is state for executing an EvalPlanQual recheck on a candidate
@@ -1195,6 +1254,25 @@ typedef struct ModifyTableState
 	TupleConversionMap **mt_per_subplan_tupconv_maps;
 } ModifyTableState;
 
+/* ----------------
+ *	 AsyncRequest
+ *
+ *		State for an asynchronous tuple request.  The requestor is the node
+ *		that wants a tuple (currently always an Append), the requestee is the
+ *		async-capable child that is asked to produce one.
+ * ----------------
+ */
+typedef struct AsyncRequest
+{
+	struct PlanState *requestor;	/* Node that wants a tuple */
+	struct PlanState *requestee;	/* Node from which a tuple is wanted */
+	int			request_index;	/* Scratch space for requestor */
+	bool		callback_pending;	/* Callback is needed */
+	bool		request_complete;	/* Request complete, result valid */
+	TupleTableSlot *result;		/* Result (NULL or an empty slot if no more
+								 * tuples) */
+} AsyncRequest;
+
 /* ----------------
  *	 AppendState information
  *
@@ -1205,6 +1283,16 @@ typedef struct ModifyTableState
  *							eliminated from the scan, or NULL if not possible.
  *		valid_subplans		for runtime pruning, valid appendplans indexes to
  *							scan.
+ *		asyncplans			indexes of the async-capable appendplans
+ *		asyncrequests		AsyncRequest for each async-capable subplan,
+ *							indexed like appendplans
+ *		asyncresults		tuples returned by async subplans that have not
+ *							yet been returned to our caller
+ *		syncdone			true if all the sync subplans are done
+ *		nasyncremain		number of async subplans not yet exhausted
+ *		needrequest			async subplans that need a new request
+ *		eventset			WaitEventSet used to wait for async subplans
+ *		valid_asyncplans	valid async subplans, once determined
  * ----------------
  */
 
@@ -1220,6 +1308,7 @@ struct AppendState
 	PlanState **appendplans;	/* array of PlanStates for my inputs */
 	int			as_nplans;
 	int			as_whichplan;
+	bool		as_begun;		/* false means need to initialize */
 	int			as_first_partial_plan;	/* Index of 'appendplans' containing
 										 * the first partial plan */
 	ParallelAppendState *as_pstate; /* parallel coordination info */
@@ -1227,6 +1316,18 @@ struct AppendState
 	struct PartitionPruneState *as_prune_state;
 	Bitmapset  *as_valid_subplans;
 	bool		(*choose_next_subplan) (AppendState *);
+
+	/* asynchronous execution state */
+	Bitmapset  *as_asyncplans;
+	int			as_nasyncplans;
+	AsyncRequest **as_asyncrequests;
+	TupleTableSlot **as_asyncresults;
+	int			as_nasyncresults;
+	bool		as_syncdone;
+	int			as_nasyncremain;
+	Bitmapset  *as_needrequest;
+	struct WaitEventSet *as_eventset;
+	Bitmapset  *as_valid_asyncplans;
 };
 
 /* ----------------
@@ -1323,6 +1424,7 @@ typedef struct BitmapOrState
  *		currentRelation    relation being scanned (NULL if none)
  *		currentScanDesc    current scan descriptor for scan (NULL if none)
  *		ScanTupleSlot	   pointer to slot in tuple table holding scan tuple
+ *		RuntimeFilter	   filter supplied by a parent hash join (NULL if none)
  * ----------------
  */
 typedef struct ScanState
@@ -1331,6 +1433,7 @@ typedef struct ScanState
 	Relation	ss_currentRelation;
 	struct TableScanDescData *ss_currentScanDesc;
 	TupleTableSlot *ss_ScanTupleSlot;
+	struct HashRuntimeFilter *ss_RuntimeFilter;
 } ScanState;
 
 /* ----------------
@@ -1341,6 +1444,9 @@ typedef struct SeqScanState
 {
 	ScanState	ss;				/* its first field is NodeTag */
 	Size		pscan_len;		/* size of parallel heap scan descriptor */
+	struct TupleBatch *batch;	/* result batch, if running in batch mode */
+	struct BatchQualState *batchqual;	/* qual prepared for batches */
+	bool		batch_done;		/* scan exhausted in batch mode? */
 } SeqScanState;
 
 /* ----------------
@@ -1401,6 +1507,7 @@ typedef struct
  *		RuntimeContext	   expr context for evaling runtime Skeys
  *		RelationDesc	   index relation descriptor
  *		ScanDesc		   index scan descriptor
+ *		OrderedRescans	   true if rescans will come in ascending key order
  *
  *		ReorderQueue	   tuples that need reordering due to re-check
  *		ReachedEnd		   have we fetched all tuples from index already?
@@ -1427,6 +1534,7 @@ typedef struct IndexScanState
 	ExprContext *iss_RuntimeContext;
 	Relation	iss_RelationDesc;
 	struct IndexScanDescData *iss_ScanDesc;
+	bool		iss_OrderedRescans;
 
 	/* These are needed for re-checking ORDER BY expr ordering */
 	pairingheap *iss_ReorderQueue;
@@ -1848,6 +1956,15 @@ typedef struct JoinState
  *		NeedNewOuter	   true if need new outer tuple on next call
  *		MatchedOuter	   true if found a join match for current outer tuple
  *		NullInnerTupleSlot prepared null tuple for left outer joins
+ *
+ *		The remaining fields are used only if the outer rows are batched:
+ *		BatchSlots		   copies of the outer rows in the current batch
+ *		BatchKeys/Nulls	   the batch key of each outer row
+ *		BatchOrder		   indexes into BatchSlots, sorted by batch key
+ *		BatchCount		   number of outer rows in the current batch
+ *		BatchNext		   next position in BatchOrder to join
+ *		OuterDone		   true if the outer plan has been read to the end
+ *		BatchSortKey	   sort support for the batch key
  * ----------------
  */
 typedef struct NestLoopState
@@ -1856,6 +1973,14 @@ typedef struct NestLoopState
 	bool		nl_NeedNewOuter;
 	bool		nl_MatchedOuter;
 	TupleTableSlot *nl_NullInnerTupleSlot;
+	TupleTableSlot **nl_BatchSlots;
+	Datum	   *nl_BatchKeys;
+	bool	   *nl_BatchNulls;
+	int		   *nl_BatchOrder;
+	int			nl_BatchCount;
+	int			nl_BatchNext;
+	bool		nl_OuterDone;
+	SortSupport nl_BatchSortKey;
 } NestLoopState;
 
 /* ----------------
@@ -1878,6 +2003,9 @@ typedef struct NestLoopState
  *		NullInnerTupleSlot prepared null tuple for left outer joins
  *		OuterEContext	   workspace for computing outer tuple's join values
  *		InnerEContext	   workspace for computing inner tuple's join values
+ *		InnerSkipKey	   >= key for repositioning the inner index scan, or
+ *						   NULL if the inner scan can't skip ahead
+ *		InnerSkipCount	   inner tuples skipped since the last reposition
  * ----------------
  */
 /* private in nodeMergejoin.c: */
@@ -1903,6 +2031,8 @@ typedef struct MergeJoinState
 	TupleTableSlot *mj_NullInnerTupleSlot;
 	ExprContext *mj_OuterEContext;
 	ExprContext *mj_InnerEContext;
+	struct ScanKeyData *mj_InnerSkipKey;
+	int			mj_InnerSkipCount;
 } MergeJoinState;
 
 /* ----------------
@@ -1928,6 +2058,15 @@ typedef struct MergeJoinState
  *		hj_JoinState			current state of ExecHashJoin state machine
  *		hj_MatchedOuter			true if found a join match for current outer
  *		hj_OuterNotEmpty		true if outer relation known not empty
+ *		hj_OuterGroupSize		max number of outer tuples in a group
+ *		hj_OuterGroupSlots		copies of a group of outer tuples fetched
+ *								ahead, or NULL if not allocated yet
+ *		hj_OuterGroupHashValues	hash values of those tuples
+ *		hj_OuterGroupBuckets	workspace for prefetching their buckets
+ *		hj_OuterGroupCount		number of tuples in the current group
+ *		hj_OuterGroupPos		index of next tuple to return from the group
+ *		hj_OuterGroupDone		true if the current batch's outer tuples
+ *								ran out while filling the group
  * ----------------
  */
 
@@ -1955,6 +2094,13 @@ typedef struct HashJoinState
 	int			hj_JoinState;
 	bool		hj_MatchedOuter;
 	bool		hj_OuterNotEmpty;
+	int			hj_OuterGroupSize;
+	TupleTableSlot **hj_OuterGroupSlots;
+	uint32	   *hj_OuterGroupHashValues;
+	int		   *hj_OuterGroupBuckets;
+	int			hj_OuterGroupCount;
+	int			hj_OuterGroupPos;
+	bool		hj_OuterGroupDone;
 } HashJoinState;
 
 
@@ -1980,6 +2126,81 @@ typedef struct MaterialState
 	Tuplestorestate *tuplestorestate;
 } MaterialState;
 
+struct ResultCacheEntry;
+struct ResultCacheTuple;
+struct ResultCacheKey;
+
+/* ----------------
+ *	 ResultCacheInstrumentation information
+ *
+ *		Statistics collected by a ResultCache node for EXPLAIN ANALYZE.
+ * ----------------
+ */
+typedef struct ResultCacheInstrumentation
+{
+	uint64		cache_hits;		/* number of rescans where we've found the
+								 * scan parameter values to be cached */
+	uint64		cache_misses;	/* number of rescans where we've not found the
+								 * scan parameter values to be cached */
+	uint64		cache_evictions;	/* number of cache entries removed due to
+									 * the need to free memory */
+	uint64		cache_overflows;	/* number of times we've had to bypass the
+									 * cache when filling it due to not being
+									 * able to free enough space to store the
+									 * current scan's tuples */
+	uint64		mem_peak;		/* peak memory usage in bytes */
+} ResultCacheInstrumentation;
+
+/* ----------------
+ *	 Shared memory container for per-worker result cache information
+ * ----------------
+ */
+typedef struct SharedResultCacheInfo
+{
+	int			num_workers;
+	ResultCacheInstrumentation sinstrument[FLEXIBLE_ARRAY_MEMBER];
+} SharedResultCacheInfo;
+
+/* ----------------
+ *	 ResultCacheState information
+ *
+ *		resultcache nodes are used to cache recent and commonly seen results
+ *		from a parameterized scan.
+ * ----------------
+ */
+typedef struct ResultCacheState
+{
+	ScanState	ss;				/* its first field is NodeTag */
+	int			rc_status;		/* value of ExecResultCache state machine */
+	int			nkeys;			/* number of cache keys */
+	struct resultcache_hash *hashtable; /* hash table for cache entries */
+	TupleDesc	hashkeydesc;	/* tuple descriptor for cache keys */
+	TupleTableSlot *tableslot;	/* min tuple slot for existing cache entries */
+	TupleTableSlot *probeslot;	/* virtual slot used for hash lookups */
+	ExprState  *cache_eq_expr;	/* Compare exec params to hash key */
+	ExprState **param_exprs;	/* exprs containing the parameters to this
+								 * node */
+	FmgrInfo   *hashfunctions;	/* lookup data for hash funcs nkeys in size */
+	Oid		   *collations;		/* collation for comparisons nkeys in size */
+	uint64		mem_used;		/* bytes of memory used by cache */
+	uint64		mem_limit;		/* memory limit in bytes for the cache */
+	uint32		est_entries;	/* initial size of the hash table */
+	MemoryContext tableContext; /* memory context to store cache data */
+	dlist_head	lru_list;		/* least recently used entry list */
+	struct ResultCacheTuple *last_tuple;	/* Used to point to the last tuple
+											 * returned during a cache hit and
+											 * the tuple we last stored when
+											 * populating the cache. */
+	struct ResultCacheEntry *entry; /* the entry that 'last_tuple' belongs to
+									 * or NULL if 'last_tuple' is NULL. */
+	bool		singlerow;		/* true if the cache entry is to be marked as
+								 * complete after caching the first tuple. */
+	Bitmapset  *keyparamids;	/* Param->paramids of expressions belonging to
+								 * param_exprs */
+	ResultCacheInstrumentation stats;	/* execution statistics */
+	SharedResultCacheInfo *shared_info; /* statistics for parallel workers */
+} ResultCacheState;
+
 /* ----------------
  *	 Shared memory container for per-worker sort information
  * ----------------
@@ -2006,8 +2227,74 @@ typedef struct SortState
 	void	   *tuplesortstate; /* private state of tuplesort.c */
 	bool		am_worker;		/* are we a worker? */
 	SharedSortInfo *shared_info;	/* one entry per worker */
+	/* these are used only for a late-materialized sort: */
+	Relation	late_rel;		/* relation to refetch late columns from */
+	bool	   *late_cols;		/* which columns are left out of the sort? */
+	TupleTableSlot *late_sortslot;	/* tuple as returned by tuplesort */
+	TupleTableSlot *late_fetchslot; /* row refetched from late_rel */
 } SortState;
 
+/* ----------------
+ *	 Instrumentation information for IncrementalSort
+ *
+ *		sortMethods is a bitmask of (1 << TuplesortMethod) values seen
+ *		across all the groups sorted so far.
+ * ----------------
+ */
+typedef struct IncrementalSortInfo
+{
+	int64		groupCount;		/* number of groups sorted */
+	long		totalSpaceUsed; /* sum of space used by all groups, in kB */
+	long		maxSpaceUsed;	/* largest space used by a single group */
+	TuplesortSpaceType maxSpaceType;	/* type of space maxSpaceUsed is */
+	bits32		sortMethods;	/* bitmask of sort methods used */
+} IncrementalSortInfo;
+
+/* ----------------
+ *	 Shared memory container for per-worker incremental sort information
+ * ----------------
+ */
+typedef struct SharedIncrementalSortInfo
+{
+	int			num_workers;
+	IncrementalSortInfo sinfo[FLEXIBLE_ARRAY_MEMBER];
+} SharedIncrementalSortInfo;
+
+/* ----------------
+ *	 IncrementalSortState information
+ *
+ *		The node alternates between loading a group of tuples into the
+ *		tuplesort and reading the sorted group back out.  A group always
+ *		contains at least a minimum number of tuples (so that tiny groups
+ *		don't each pay for a separate tuplesort) and never splits a run of
+ *		tuples with equal presorted keys.  group_pivot holds the tuple that
+ *		was read from the input but belongs to the next group.
+ * ----------------
+ */
+typedef enum
+{
+	INCSORT_LOADGROUP,
+	INCSORT_READGROUP,
+	INCSORT_DONE
+} IncrementalSortExecutionStatus;
+
+typedef struct IncrementalSortState
+{
+	ScanState	ss;				/* its first field is NodeTag */
+	bool		bounded;		/* is the result set bounded? */
+	int64		bound;			/* if bounded, how many tuples are needed */
+	int64		bound_Done;		/* tuples returned so far */
+	bool		outerNodeDone;	/* finished fetching tuples from outer node */
+	IncrementalSortExecutionStatus execution_status;
+	ExprState  *presortedEq;	/* equality of the presorted columns */
+	TupleTableSlot *group_pivot;	/* last tuple compared against */
+	bool		pivot_pending;	/* group_pivot starts the next group */
+	void	   *tuplesortstate; /* private state of tuplesort.c */
+	IncrementalSortInfo incsort_info;	/* statistics for EXPLAIN ANALYZE */
+	bool		am_worker;		/* are we a worker? */
+	SharedIncrementalSortInfo *shared_info; /* one entry per worker */
+} IncrementalSortState;
+
 /* ---------------------
  *	GroupState information
  * ---------------------
@@ -2038,6 +2325,15 @@ typedef struct AggStatePerGroupData *AggStatePerGroup;
 typedef struct AggStatePerPhaseData *AggStatePerPhase;
 typedef struct AggStatePerHashData *AggStatePerHash;
 
+/*
+ * JIT compiled function advancing the aggregates for the input tuples
+ * slots[sel[start]] .. slots[sel[end - 1]] of a batch.
+ */
+struct AggState;
+typedef void (*AggInputPipeline) (struct AggState *aggstate,
+								  TupleTableSlot **slots, int *sel,
+								  int start, int end);
+
 typedef struct AggState
 {
 	ScanState	ss;				/* its first field is NodeTag */
@@ -2072,6 +2368,9 @@ typedef struct AggState
 	Tuplesortstate *sort_in;	/* sorted input to phases > 1 */
 	Tuplesortstate *sort_out;	/* input is copied here for next phase */
 	TupleTableSlot *sort_slot;	/* slot for sort results */
+	struct TupleBatch *input_batch; /* current batch from outer plan, if it
+									 * supports batches */
+	int			input_batch_pos;	/* next selection vector entry to use */
 	/* these fields are used in AGG_PLAIN and AGG_SORTED modes: */
 	AggStatePerGroup *pergroups;	/* grouping set indexed array of per-group
 									 * pointers */
@@ -2104,10 +2403,22 @@ typedef struct AggState
 										 * per-group pointers */
 
 	/* support for evaluation of agg input expressions: */
-#define FIELDNO_AGGSTATE_ALL_PERGROUPS 49
+#define FIELDNO_AGGSTATE_ALL_PERGROUPS 51
 	AggStatePerGroup *all_pergroups;	/* array of first ->pergroups, than
 										 * ->hash_pergroup */
 	ProjectionInfo *combinedproj;	/* projection machinery */
+
+	/* these fields are used by a parallel-aware AGG_HASHED node: */
+	struct ParallelHashAggState *shared_hash;	/* shared state in DSM, or
+												 * NULL if not parallel */
+	struct SharedTuplestoreAccessor **shared_partitions;	/* accessors for
+															 * the shared
+															 * partitions */
+	bool		shared_attached;	/* attached to the shared barrier? */
+
+	/* JIT compiled input loop, used with a batch-capable outer plan: */
+	AggInputPipeline input_pipeline;	/* NULL if not compiled */
+	void	   *input_pipeline_private; /* private state for it */
 } AggState;
 
 /* ----------------
@@ -2131,6 +2442,7 @@ typedef struct WindowAggState
 	WindowStatePerAgg peragg;	/* per-plain-aggregate information */
 	ExprState  *partEqfunction; /* equality funcs for partition columns */
 	ExprState  *ordEqfunction;	/* equality funcs for ordering columns */
+	ExprState  *runcondition;	/* once false, rest of partition is skipped */
 	Tuplestorestate *buffer;	/* stores rows of current partition */
 	int			current_ptr;	/* read pointer # for current row */
 	int			framehead_ptr;	/* read pointer # for frame head, if used */
@@ -2263,9 +2575,36 @@ typedef struct GatherMergeState
 	TupleTableSlot **gm_slots;	/* array with nreaders+1 entries */
 	struct TupleQueueReader **reader;	/* array with nreaders active entries */
 	struct GMReaderTupleBuffer *gm_tuple_buffers;	/* nreaders tuple buffers */
-	struct binaryheap *gm_heap; /* binary heap of slot indices */
+	struct losertree *gm_tree;	/* tournament tree of slot indices */
 } GatherMergeState;
 
+/* ----------------
+ *	 RedistributeState information
+ *
+ *		Redistribute nodes exchange the rows of their subplan among the
+ *		parallel workers.  Each worker keeps the rows that belong to it in a
+ *		tuplestore until all workers are done sending, and then returns them.
+ * ----------------
+ */
+struct RedistributeShared;		/* private in nodeRedistribute.c */
+struct shm_mq_handle;
+
+typedef struct RedistributeState
+{
+	PlanState	ps;				/* its first field is NodeTag */
+	FmgrInfo   *hashfunctions;	/* lookup data for hash functions */
+	struct RedistributeShared *shared;	/* shared state, or NULL */
+	int			nparticipants;	/* number of workers taking part, or -1 if
+								 * not known yet */
+	/* the remaining fields are only used in workers */
+	struct shm_mq_handle **outqueues;	/* queues to each worker, or NULL */
+	struct shm_mq_handle **inqueues;	/* queues from each worker, or NULL */
+	int			ninqueues;		/* number of input queues still attached */
+	uint64		nread;			/* number of rows read from the subplan */
+	Tuplestorestate *tuplestore;	/* rows to return, once filled */
+	TupleTableSlot *recvslot;	/* slot for rows received from others */
+} RedistributeState;
+
 /* ----------------
  *	 Values displayed by EXPLAIN ANALYZE
  * ----------------
@@ -2293,11 +2632,36 @@ typedef struct SharedHashInfo
  *	 HashState information
  * ----------------
  */
+/* ----------------
+ *	 HashRuntimeFilter information
+ *
+ *		A Bloom filter over the hash values of the inner tuples of a hash
+ *		join, filled in while the hash table is built.  The scan on the
+ *		outer side of the join checks its tuples against it, so that those
+ *		that can't have a join partner are discarded before they are
+ *		projected and passed up to the join.  keyattnos[] are the scan
+ *		tuple's attributes that correspond to the join's outer hash keys.
+ * ----------------
+ */
+typedef struct HashRuntimeFilter
+{
+	struct bloom_filter *filter;	/* NULL until the hash table is built */
+	int			nkeys;			/* number of hash keys */
+	AttrNumber *keyattnos;		/* scan tuple attribute of each key */
+	FmgrInfo   *hashfunctions;	/* outer hash function of each key */
+	bool	   *hashStrict;		/* is each hash join operator strict? */
+	Oid		   *collations;		/* collation of each key */
+	bool		disabled;		/* true if we gave up on the filter */
+	uint64		nchecked;		/* # of tuples checked against the filter */
+	uint64		nremoved;		/* # of them that the filter removed */
+} HashRuntimeFilter;
+
 typedef struct HashState
 {
 	PlanState	ps;				/* its first field is NodeTag */
 	HashJoinTable hashtable;	/* hash table for the hashjoin */
 	List	   *hashkeys;		/* list of ExprState nodes */
+	HashRuntimeFilter *runtime_filter;	/* filter to fill in, or NULL */
 
 	SharedHashInfo *shared_info;	/* one entry per worker */
 	HashInstrumentation *hinstrument;	/* this worker's entry */
@@ -1360,6 +1360,7 @@ typedef struct WindowClause
 	bool		inRangeNullsFirst;	/* nulls sort first for in_range tests? */
 	Index		winref;			/* ID referenced by window functions */
 	bool		copiedOrder;	/* did we copy orderClause from refname? */
+	List	   *runCondition;	/* qual to help short-circuit execution */
 } WindowClause;
 
 /*
@@ -57,6 +57,8 @@ typedef struct AggClauseCosts
 {
 	int			numAggs;		/* total number of aggregate functions */
 	int			numOrderedAggs; /* number w/ DISTINCT/ORDER BY/WITHIN GROUP */
+	int			numHashableDistinctAggs;	/* number of those that can dedup
+											 * their input by hashing */
 	bool		hasNonPartial;	/* does any agg not support partial mode? */
 	bool		hasNonSerial;	/* is any partial agg non-serializable? */
 	QualCost	transCost;		/* total per-input-row execution costs */
@@ -1428,6 +1430,26 @@ typedef struct MaterialPath
 	Path	   *subpath;
 } MaterialPath;
 
+/*
+ * ResultCachePath represents a ResultCache plan node, i.e., a cache of the
+ * results of a parameterized subpath, keyed by the parameter values.  This
+ * is used as the inner side of a parameterized nested loop so that repeated
+ * outer values don't need to rescan the inner side.
+ */
+typedef struct ResultCachePath
+{
+	Path		path;
+	Path	   *subpath;		/* path whose results are cached */
+	List	   *hash_operators; /* hash operators for each key */
+	List	   *param_exprs;	/* cache keys */
+	bool		singlerow;		/* true if the cache entry is to be marked as
+								 * complete after caching the first record. */
+	double		calls;			/* expected number of rescans */
+	uint32		est_entries;	/* maximum number of entries that the
+								 * planner expects will fit in the cache, or 0
+								 * if unknown */
+} ResultCachePath;
+
 /*
  * UniquePath represents elimination of distinct rows from the output of
  * its subpath.
@@ -1480,6 +1502,19 @@ typedef struct GatherMergePath
 	int			num_workers;	/* number of workers sought to help */
 } GatherMergePath;
 
+/*
+ * RedistributePath represents exchanging the rows of a partial path among
+ * the parallel workers, so that all rows with equal values of the given
+ * keys are returned by the same worker.  The result is still a partial
+ * path, but with rows from different workers interleaved, so it's unsorted.
+ */
+typedef struct RedistributePath
+{
+	Path		path;
+	Path	   *subpath;		/* path for each worker */
+	List	   *hashClauses;	/* SortGroupClauses of the keys to hash */
+} RedistributePath;
+
 
 /*
  * All join-type paths share these fields.
@@ -1618,8 +1653,21 @@ typedef struct SortPath
 {
 	Path		path;
 	Path	   *subpath;		/* path representing input source */
+	double		limit_tuples;	/* bound on output tuples, or -1 if none */
 } SortPath;
 
+/*
+ * IncrementalSortPath represents an incremental sort step
+ *
+ * This is like a regular sort, except some leading key columns are assumed
+ * to be ordered already.
+ */
+typedef struct IncrementalSortPath
+{
+	SortPath	spath;
+	int			nPresortedCols; /* number of presorted columns */
+} IncrementalSortPath;
+
 /*
  * GroupPath represents grouping (of presorted input)
  *
@@ -1722,6 +1770,7 @@ typedef struct WindowAggPath
 	Path		path;
 	Path	   *subpath;		/* path representing input source */
 	WindowClause *winclause;	/* WindowClause we'll be using */
+	bool		topwindow;		/* topmost WindowAgg of the query level? */
 } WindowAggPath;
 
 /*
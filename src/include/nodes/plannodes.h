@@ -135,6 +135,11 @@ typedef struct Plan
 	bool		parallel_aware; /* engage parallel-aware logic? */
 	bool		parallel_safe;	/* OK to use as part of parallel plan? */
 
+	/*
+	 * information needed for asynchronous execution
+	 */
+	bool		async_capable;	/* engage asynchronous-capable logic? */
+
 	/*
 	 * Common structural data for all Plan types.
 	 */
@@ -695,12 +700,21 @@ typedef struct Join
  * Vars, but perhaps someday that'd be worth relaxing.  (Note: during plan
  * creation, the paramval can actually be a PlaceHolderVar expression; but it
  * must be a Var with varno OUTER_VAR by the time it gets to the executor.)
+ *
+ * If batchSize is nonzero, there is exactly one nestParam, and the inner
+ * subplan is a btree index scan using it as an equality key on the first
+ * index column.  The executor then reads outer rows batchSize at a time and
+ * joins each batch in the order of batchSortOp, so that successive inner
+ * scans move forward through the index.
  * ----------------
  */
 typedef struct NestLoop
 {
 	Join		join;
 	List	   *nestParams;		/* list of NestLoopParam nodes */
+	int			batchSize;		/* outer rows per batch, or 0 if not batched */
+	Oid			batchSortOp;	/* ordering operator for the batch key */
+	Oid			batchCollation; /* collation for the batch key */
 } NestLoop;
 
 typedef struct NestLoopParam
@@ -760,6 +774,31 @@ typedef struct Material
 	Plan		plan;
 } Material;
 
+/* ----------------
+ *		result cache node
+ *
+ * Caches the output of its subplan for each distinct set of parameter
+ * values, so that rescans with parameter values seen before can be answered
+ * without executing the subplan.  param_exprs are the expressions, evaluated
+ * on each rescan, that make up the cache key; hashOperators are the equality
+ * operators to compare them with.
+ * ----------------
+ */
+typedef struct ResultCache
+{
+	Plan		plan;
+	int			numKeys;		/* size of the two arrays below */
+	Oid		   *hashOperators;	/* hash operators for each key */
+	Oid		   *collations;		/* collations for each key */
+	List	   *param_exprs;	/* exprs containing the cache key parameters */
+	bool		singlerow;		/* true if the cache entry should be marked
+								 * as complete after we store the first tuple
+								 * in it */
+	uint32		est_entries;	/* estimated number of entries the planner
+								 * expects will fit in the cache, or 0 if
+								 * unknown */
+} ResultCache;
+
 /* ----------------
  *		sort node
  * ----------------
@@ -772,8 +811,34 @@ typedef struct Sort
 	Oid		   *sortOperators;	/* OIDs of operators to sort them by */
 	Oid		   *collations;		/* OIDs of collations */
 	bool	   *nullsFirst;		/* NULLS FIRST/LAST directions */
+
+	/*
+	 * If lateRelid is nonzero, the sort is late-materialized: the columns
+	 * listed in lateColIdx are left out of the sorted tuples and are fetched
+	 * again from relation lateRelid, using the TID in column lateTidColIdx,
+	 * as each tuple is returned.  See nodeSort.c.
+	 */
+	Index		lateRelid;		/* RT index of the scanned relation, or 0 */
+	AttrNumber	lateTidColIdx;	/* index of its ctid in the target list */
+	int			numLateCols;	/* number of late-materialized columns */
+	AttrNumber *lateColIdx;		/* their indexes in the target list */
+	AttrNumber *lateAttNums;	/* their attribute numbers in lateRelid */
 } Sort;
 
+/* ----------------
+ *		incremental sort node
+ *
+ * The input is assumed to be sorted by the first nPresortedCols sort
+ * columns already; only groups of tuples with equal values in those
+ * columns need to be sorted.
+ * ----------------
+ */
+typedef struct IncrementalSort
+{
+	Sort		sort;
+	int			nPresortedCols; /* number of presorted columns */
+} IncrementalSort;
+
 /* ---------------
  *	 group node -
  *		Used for queries with GROUP BY (but no aggregates) specified.
@@ -845,6 +910,8 @@ typedef struct WindowAgg
 	Oid			inRangeColl;	/* collation for in_range tests */
 	bool		inRangeAsc;		/* use ASC sort order for in_range tests? */
 	bool		inRangeNullsFirst;	/* nulls sort first for in_range tests? */
+	/* qual which, once false, stays false for the rest of the partition: */
+	List	   *runCondition;
 } WindowAgg;
 
 /* ----------------
@@ -901,6 +968,25 @@ typedef struct GatherMerge
 								 * at gather merge or one of it's child node */
 } GatherMerge;
 
+/* ------------
+ *		redistribute node
+ *
+ * Each parallel worker sends every row of its subplan to the worker chosen
+ * by a hash of the key columns, and then returns the rows it received, so
+ * that all rows with equal keys end up in the same worker.  The leader takes
+ * no part unless no workers could be launched, in which case it returns all
+ * rows itself.
+ * ------------
+ */
+typedef struct Redistribute
+{
+	Plan		plan;
+	int			numCols;		/* number of hash key columns */
+	AttrNumber *hashColIdx;		/* their indexes in the target list */
+	Oid		   *hashOperators;	/* equality operators of the keys */
+	Oid		   *collations;		/* OIDs of collations */
+} Redistribute;
+
 /* ----------------
  *		hash build node
  *
@@ -38,6 +38,7 @@
 struct PlannerInfo;				/* avoid including pathnodes.h here */
 struct IndexOptInfo;
 struct SpecialJoinInfo;
+struct WindowClause;
 
 
 /*
@@ -239,4 +240,41 @@ typedef struct SupportRequestIndexCondition
 								 * equivalent of the function call */
 } SupportRequestIndexCondition;
 
+/*
+ * The WFuncMonotonic request allows the planner to ask whether a window
+ * function's result is monotonically increasing or decreasing as rows are
+ * processed within a window partition, given the window's frame options.
+ * If the result is monotonically increasing, then once a qual like
+ * "wfunc <= const" becomes false for some row of the partition, it must be
+ * false for all remaining rows of that partition too, which allows the
+ * executor to stop evaluating the partition early.
+ *
+ * The support function should set "monotonic" to the appropriate
+ * MonotonicFunction value and return a pointer to the request node.  If
+ * nothing is known about the function, return NULL or leave "monotonic"
+ * as MONOTONICFUNC_NONE.
+ *
+ * Functions whose result is the same for all rows of a partition may
+ * report MONOTONICFUNC_BOTH.
+ */
+typedef enum MonotonicFunction
+{
+	MONOTONICFUNC_NONE = 0,
+	MONOTONICFUNC_INCREASING = (1 << 0),
+	MONOTONICFUNC_DECREASING = (1 << 1),
+	MONOTONICFUNC_BOTH = MONOTONICFUNC_INCREASING | MONOTONICFUNC_DECREASING
+} MonotonicFunction;
+
+typedef struct SupportRequestWFuncMonotonic
+{
+	NodeTag		type;
+
+	/* Input fields: */
+	WindowFunc *window_func;	/* window function we are inquiring about */
+	struct WindowClause *window_clause; /* the window function's window */
+
+	/* Output fields: */
+	MonotonicFunction monotonic;
+} SupportRequestWFuncMonotonic;
+
 #endif							/* SUPPORTNODES_H */
@@ -0,0 +1,16 @@
+CREATE EXTENSION test_hashjoin_perf;
+
+--
+-- test_hashjoin_perf() throws an error if a join returns the wrong number
+-- of rows.  The timings vary, so don't show them.
+--
+SELECT group_size, nbuckets
+  FROM test_hashjoin_perf(70000, 100000, '{0,1,16}', 1);
+SELECT group_size, nbuckets
+  FROM test_hashjoin_perf(1000, 5000, '{0,3,16,1024}', 1);
+
+-- the settings are restored
+SHOW hashjoin_prefetch_min_buckets;
+SHOW hashjoin_prefetch_group_size;
+
+SELECT * FROM test_hashjoin_perf(1000, 10);
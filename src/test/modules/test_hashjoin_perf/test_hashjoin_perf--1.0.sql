@@ -0,0 +1,88 @@
+/* src/test/modules/test_hashjoin_perf/test_hashjoin_perf--1.0.sql */
+
+-- complain if script is sourced in psql, rather than via CREATE EXTENSION
+\echo Use "CREATE EXTENSION test_hashjoin_perf" to load this file. \quit
+
+--
+-- Join outer_rows rows to a hash table of inner_rows rows, nloops times for
+-- each of group_sizes, and return the fastest run in nanoseconds per outer
+-- row.  A group size of 0 means that the buckets are not prefetched.
+--
+CREATE FUNCTION test_hashjoin_perf(inner_rows integer,
+    outer_rows integer,
+    group_sizes integer[] DEFAULT '{0,4,8,16,32}',
+    nloops integer DEFAULT 3,
+    OUT group_size integer,
+    OUT nbuckets integer,
+    OUT ns_per_outer_row float8)
+RETURNS SETOF record STRICT
+LANGUAGE plpgsql
+-- a single-batch, non-parallel hash join, with the settings of the test
+-- restored on exit
+SET enable_mergejoin = off
+SET enable_nestloop = off
+SET max_parallel_workers_per_gather = 0
+SET jit = off
+SET work_mem = '1GB'
+SET hashjoin_prefetch_min_buckets = 65536
+SET hashjoin_prefetch_group_size = 16
+AS $$
+DECLARE
+  plan jsonb;
+  starttime timestamptz;
+  elapsed float8;
+  nmatched bigint;
+BEGIN
+  IF inner_rows < 1 OR outer_rows < inner_rows OR nloops < 1 THEN
+    RAISE EXCEPTION 'need 0 < inner_rows <= outer_rows and 0 < nloops';
+  END IF;
+
+  -- each outer row has exactly one join partner, in a random bucket
+  CREATE TEMP TABLE hjperf_inner AS
+    SELECT g AS id FROM generate_series(1, inner_rows) g;
+  CREATE TEMP TABLE hjperf_outer AS
+    SELECT g % inner_rows + 1 AS id FROM generate_series(1, outer_rows) g;
+  ANALYZE hjperf_inner;
+  ANALYZE hjperf_outer;
+
+  EXECUTE 'EXPLAIN (ANALYZE, TIMING OFF, COSTS OFF, FORMAT JSON)
+           SELECT count(*) FROM hjperf_outer o JOIN hjperf_inner i USING (id)'
+    INTO plan;
+  IF jsonb_path_query_first(plan,
+       '$.** ? (@."Node Type" == "Hash").Plans[0]."Relation Name"') #>> '{}'
+     IS DISTINCT FROM 'hjperf_inner' THEN
+    RAISE EXCEPTION 'hash table is not built on the inner rows';
+  END IF;
+  nbuckets := jsonb_path_query_first(plan,
+                '$.** ? (@."Node Type" == "Hash")."Hash Buckets"')::integer;
+
+  FOREACH group_size IN ARRAY group_sizes LOOP
+    IF group_size = 0 THEN
+      PERFORM set_config('hashjoin_prefetch_min_buckets', '2147483647', true);
+    ELSE
+      PERFORM set_config('hashjoin_prefetch_min_buckets', '0', true);
+      PERFORM set_config('hashjoin_prefetch_group_size', group_size::text,
+                         true);
+    END IF;
+
+    ns_per_outer_row := NULL;
+    FOR run IN 1..nloops LOOP
+      starttime := clock_timestamp();
+      SELECT count(*) INTO nmatched
+        FROM hjperf_outer o JOIN hjperf_inner i USING (id);
+      elapsed := extract(epoch FROM clock_timestamp() - starttime);
+      IF nmatched <> outer_rows THEN
+        RAISE EXCEPTION 'join returned % rows instead of %',
+          nmatched, outer_rows;
+      END IF;
+      ns_per_outer_row := least(ns_per_outer_row,
+                                elapsed * 1e9 / outer_rows);
+    END LOOP;
+
+    RETURN NEXT;
+  END LOOP;
+
+  DROP TABLE hjperf_inner;
+  DROP TABLE hjperf_outer;
+END
+$$;
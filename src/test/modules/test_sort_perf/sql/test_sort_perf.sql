@@ -0,0 +1,17 @@
+CREATE EXTENSION test_sort_perf;
+
+--
+-- test_sort_perf() throws an error if any sort gets its input wrong.  The
+-- timings vary, so don't show them.
+--
+-- radix sort
+SELECT specialized, descending FROM test_sort_perf('int4', 5000, 1);
+SELECT specialized, descending FROM test_sort_perf('int8', 5000, 1);
+-- inlined quicksort
+SELECT specialized, descending FROM test_sort_perf('int4', 500, 1, 0.5);
+SELECT specialized, descending FROM test_sort_perf('int8', 500, 1, 0.5);
+-- no NULLs, or nothing but NULLs
+SELECT count(*) FROM test_sort_perf('int8', 3000, 1, 0);
+SELECT count(*) FROM test_sort_perf('int4', 3000, 1, 1);
+
+SELECT * FROM test_sort_perf('text', 10);
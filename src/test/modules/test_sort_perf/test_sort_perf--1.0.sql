@@ -0,0 +1,14 @@
+/* src/test/modules/test_sort_perf/test_sort_perf--1.0.sql */
+
+-- complain if script is sourced in psql, rather than via CREATE EXTENSION
+\echo Use "CREATE EXTENSION test_sort_perf" to load this file. \quit
+
+CREATE FUNCTION test_sort_perf(typ regtype,
+    ntuples integer,
+    nloops integer DEFAULT 3,
+    null_frac float8 DEFAULT 0.02,
+    OUT specialized boolean,
+    OUT descending boolean,
+    OUT ns_per_tuple float8)
+RETURNS SETOF record STRICT
+AS 'MODULE_PATHNAME' LANGUAGE C;
@@ -0,0 +1,213 @@
+/*--------------------------------------------------------------------------
+ *
+ * test_sort_perf.c
+ *		Compare the integer sort routines of tuplesort.c with the generic
+ *		ones.
+ *
+ * Copyright (c) 2020, PostgreSQL Global Development Group
+ *
+ * IDENTIFICATION
+ *		src/test/modules/test_sort_perf/test_sort_perf.c
+ *
+ * -------------------------------------------------------------------------
+ */
+#include "postgres.h"
+
+#include "catalog/pg_type.h"
+#include "fmgr.h"
+#include "funcapi.h"
+#include "miscadmin.h"
+#include "portability/instr_time.h"
+#include "utils/builtins.h"
+#include "utils/guc.h"
+#include "utils/tuplesort.h"
+#include "utils/typcache.h"
+
+PG_MODULE_MAGIC;
+
+PG_FUNCTION_INFO_V1(test_sort_perf);
+
+#define DATUM_GET_KEY(typid, d) \
+	((typid) == INT4OID ? (int64) DatumGetInt32(d) : DatumGetInt64(d))
+
+static double sort_datums(Oid typid, Oid sortop, bool descending,
+						  Datum *values, bool *isnull, int ntuples);
+
+/*
+ * SQL-callable entry point.
+ *
+ * Generates "ntuples" random values of type int4 or int8, a fraction
+ * "null_frac" of which is NULL, and sorts them "nloops" times each way
+ * through tuplesort_performsort(), with and without the specialized integer
+ * sort routines.  Returns the fastest of the loops, in nanoseconds per
+ * tuple, for each combination.  Throws an error if any of the sorts gets it
+ * wrong.
+ */
+Datum
+test_sort_perf(PG_FUNCTION_ARGS)
+{
+	Oid			typid = PG_GETARG_OID(0);
+	int32		ntuples = PG_GETARG_INT32(1);
+	int32		nloops = PG_GETARG_INT32(2);
+	float8		null_frac = PG_GETARG_FLOAT8(3);
+	ReturnSetInfo *rsinfo = (ReturnSetInfo *) fcinfo->resultinfo;
+	TupleDesc	tupdesc;
+	Tuplestorestate *tupstore;
+	MemoryContext oldcontext;
+	TypeCacheEntry *typentry;
+	unsigned short xseed[3] = {0x330E, 0xABCD, 0x1234};
+	Datum	   *values;
+	bool	   *isnull;
+	int			i;
+
+	if (typid != INT4OID && typid != INT8OID)
+		ereport(ERROR,
+				(errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+				 errmsg("type %s is not supported", format_type_be(typid))));
+	if (ntuples < 1 || nloops < 1)
+		ereport(ERROR,
+				(errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+				 errmsg("ntuples and nloops must be positive")));
+	if (null_frac < 0.0 || null_frac > 1.0)
+		ereport(ERROR,
+				(errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+				 errmsg("null_frac must be between 0 and 1")));
+
+	/* check to see if caller supports us returning a tuplestore */
+	if (rsinfo == NULL || !IsA(rsinfo, ReturnSetInfo))
+		ereport(ERROR,
+				(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+				 errmsg("set-valued function called in context that cannot accept a set")));
+	if (!(rsinfo->allowedModes & SFRM_Materialize))
+		ereport(ERROR,
+				(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+				 errmsg("materialize mode required, but it is not allowed in this context")));
+	if (get_call_result_type(fcinfo, NULL, &tupdesc) != TYPEFUNC_COMPOSITE)
+		elog(ERROR, "return type must be a row type");
+
+	oldcontext = MemoryContextSwitchTo(rsinfo->econtext->ecxt_per_query_memory);
+	tupstore = tuplestore_begin_heap(true, false, work_mem);
+	rsinfo->returnMode = SFRM_Materialize;
+	rsinfo->setResult = tupstore;
+	rsinfo->setDesc = tupdesc;
+	MemoryContextSwitchTo(oldcontext);
+
+	typentry = lookup_type_cache(typid, TYPECACHE_LT_OPR | TYPECACHE_GT_OPR);
+
+	/* use a fixed seed, so that all runs sort the same values */
+	values = (Datum *) palloc(ntuples * sizeof(Datum));
+	isnull = (bool *) palloc(ntuples * sizeof(bool));
+	for (i = 0; i < ntuples; i++)
+	{
+		isnull[i] = pg_erand48(xseed) < null_frac;
+		if (typid == INT4OID)
+			values[i] = Int32GetDatum((int32) pg_jrand48(xseed));
+		else
+			values[i] = Int64GetDatum(((int64) pg_jrand48(xseed) << 32) ^
+									  (uint32) pg_jrand48(xseed));
+	}
+
+	for (i = 0; i < 4; i++)
+	{
+		bool		specialized = (i & 1) != 0;
+		bool		descending = (i & 2) != 0;
+		Oid			sortop = descending ? typentry->gt_opr : typentry->lt_opr;
+		int			save_nestlevel;
+		double		best = 0;
+		Datum		result[3];
+		bool		nulls[3] = {false, false, false};
+
+		save_nestlevel = NewGUCNestLevel();
+		(void) set_config_option("optimize_integer_sort",
+								 specialized ? "on" : "off",
+								 PGC_USERSET, PGC_S_SESSION,
+								 GUC_ACTION_SAVE, true, 0, false);
+
+		for (int loop = 0; loop < nloops; loop++)
+		{
+			double		elapsed;
+
+			elapsed = sort_datums(typid, sortop, descending,
+								  values, isnull, ntuples);
+			if (loop == 0 || elapsed < best)
+				best = elapsed;
+		}
+
+		AtEOXact_GUC(true, save_nestlevel);
+
+		result[0] = BoolGetDatum(specialized);
+		result[1] = BoolGetDatum(descending);
+		result[2] = Float8GetDatum(best * 1e9 / ntuples);
+		tuplestore_putvalues(tupstore, tupdesc, result, nulls);
+	}
+
+	return (Datum) 0;
+}
+
+/*
+ * Sort the values, with NULLs placed as by default in SQL, and check the
+ * result.  Returns the time tuplesort_performsort() took, in seconds.
+ */
+static double
+sort_datums(Oid typid, Oid sortop, bool descending,
+			Datum *values, bool *isnull, int ntuples)
+{
+	Tuplesortstate *sortstate;
+	instr_time	starttime;
+	instr_time	duration;
+	uint64		checksum = 0;
+	int			nnulls = 0;
+	int64		prev = 0;
+	bool		have_prev = false;
+	int			i;
+
+	/* make sure that the sort is done in memory */
+	sortstate = tuplesort_begin_datum(typid, sortop, InvalidOid, descending,
+									  MAX_KILOBYTES, NULL, false);
+
+	for (i = 0; i < ntuples; i++)
+	{
+		tuplesort_putdatum(sortstate, values[i], isnull[i]);
+		if (isnull[i])
+			nnulls++;
+		else
+			checksum += (uint64) DATUM_GET_KEY(typid, values[i]);
+	}
+
+	INSTR_TIME_SET_CURRENT(starttime);
+	tuplesort_performsort(sortstate);
+	INSTR_TIME_SET_CURRENT(duration);
+	INSTR_TIME_SUBTRACT(duration, starttime);
+
+	for (i = 0; i < ntuples; i++)
+	{
+		Datum		val;
+		bool		null;
+		int64		key;
+
+		if (!tuplesort_getdatum(sortstate, true, &val, &null, NULL))
+			elog(ERROR, "sort returned %d tuples instead of %d", i, ntuples);
+
+		if (null)
+		{
+			/* NULLs sort first when descending, last otherwise */
+			if (descending ? i >= nnulls : i < ntuples - nnulls)
+				elog(ERROR, "NULL at wrong position %d", i);
+			continue;
+		}
+
+		key = DATUM_GET_KEY(typid, val);
+		if (have_prev && (descending ? prev < key : prev > key))
+			elog(ERROR, "values out of order at position %d", i);
+		prev = key;
+		have_prev = true;
+		checksum -= (uint64) key;
+	}
+
+	if (checksum != 0)
+		elog(ERROR, "sorted values differ from the input");
+
+	tuplesort_end(sortstate);
+
+	return INSTR_TIME_GET_DOUBLE(duration);
+}
@@ -128,7 +128,8 @@ SELECT sum2(q1,q2) FROM int8_tbl;
 -- this should work
 select ten, sum(distinct four) from onek a
 group by ten
-having exists (select 1 from onek b where sum(distinct a.four) = b.four);
+having exists (select 1 from onek b where sum(distinct a.four) = b.four)
+order by ten;
 
 -- this should fail because subquery has an agg of its own in WHERE
 select ten, sum(distinct four) from onek a
@@ -608,11 +609,13 @@ select min(unique1) filter (where unique1 > 100) from tenk1;
 select sum(1/ten) filter (where ten > 0) from tenk1;
 
 select ten, sum(distinct four) filter (where four::text ~ '123') from onek a
-group by ten;
+group by ten
+order by ten;
 
 select ten, sum(distinct four) filter (where four > 10) from onek a
 group by ten
-having exists (select 1 from onek b where sum(distinct a.four) = b.four);
+having exists (select 1 from onek b where sum(distinct a.four) = b.four)
+order by ten;
 
 select max(foo COLLATE "C") filter (where (bar collate "POSIX") > '0')
 from (values ('a', 'b')) AS v(foo,bar);
@@ -1098,6 +1101,12 @@ select (g/2)::numeric as c1, array_agg(g::numeric) as c2, count(*) as c3
   from generate_series(0, 1999) g
   group by g/2;
 
+create table agg_group_5 as
+select g%1000 as c1, count(distinct g%7) as c2, sum(distinct g%11) as c3,
+       avg(distinct g%13) as c4
+  from generate_series(0, 19999) g
+  group by g%1000;
+
 -- Produce results with hash aggregation
 
 set enable_hashagg = true;
@@ -1138,6 +1147,18 @@ select (g/2)::numeric as c1, array_agg(g::numeric) as c2, count(*) as c3
   from generate_series(0, 1999) g
   group by g/2;
 
+explain (costs off)
+select g%1000 as c1, count(distinct g%7) as c2, sum(distinct g%11) as c3,
+       avg(distinct g%13) as c4
+  from generate_series(0, 19999) g
+  group by g%1000;
+
+create table agg_hash_5 as
+select g%1000 as c1, count(distinct g%7) as c2, sum(distinct g%11) as c3,
+       avg(distinct g%13) as c4
+  from generate_series(0, 19999) g
+  group by g%1000;
+
 set enable_sort = true;
 set work_mem to default;
 
@@ -1159,11 +1180,64 @@ set work_mem to default;
   union all
 (select * from agg_group_4 except select * from agg_hash_4);
 
+(select * from agg_hash_5 except select * from agg_group_5)
+  union all
+(select * from agg_group_5 except select * from agg_hash_5);
+
 drop table agg_group_1;
 drop table agg_group_2;
 drop table agg_group_3;
 drop table agg_group_4;
+drop table agg_group_5;
 drop table agg_hash_1;
 drop table agg_hash_2;
 drop table agg_hash_3;
 drop table agg_hash_4;
+drop table agg_hash_5;
+
+--
+-- Test batched scan/filter/aggregate execution
+--
+create temp table batch_agg as
+  select case when g % 10 = 0 then null else g end as a,
+         g % 7 as b, (g % 13)::text as c, g::int8 * 1000 as d,
+         case when g % 17 = 0 then 'NaN'::float8 else g / 4.0 end as e,
+         date '2000-01-01' + g as f, (g % 100)::int2 as h,
+         timestamp '2000-01-01' + g * interval '1 hour' as t,
+         (timestamp '2000-01-01' + g * interval '1 hour')::timestamptz as tz
+  from generate_series(1, 5000) g;
+-- use an odd batch size, so that batches end in the middle of a page
+set executor_batch_size = 7;
+select count(*), count(a), sum(a), min(a), max(a)
+  from batch_agg where a > 100 and 4 <> b;
+select count(*) from batch_agg where a < 1000 and c = '5';
+select b, count(*), sum(a) from batch_agg
+  where a <= 300 and b > 1 group by b order by b;
+select count(*) from batch_agg where a % 3 = 0 and b = 2 and a < 2000;
+select count(*) from batch_agg
+  where a < 200 and b = (select max(b) from batch_agg);
+select count(*) from batch_agg where a > 4990;
+-- rows rejected by the batch qual are counted as filtered
+explain (analyze, costs off, summary off, timing off)
+  select count(*) from batch_agg where a > 4990;
+select count(*) from batch_agg where a > 5000;
+select count(*) from batch_agg;
+select count(*) from batch_agg where d >= 2500000 and e < 1000;
+select count(*) from batch_agg where e > 1200;
+select count(*) from batch_agg where e >= 1250;
+select count(*) from batch_agg where e <> 10;
+select count(*) from batch_agg where e <= 2.5 or e = 5;
+select count(*) from batch_agg where e = 'NaN';
+select count(*) from batch_agg where f between '2005-01-01' and '2006-01-01';
+select count(*) from batch_agg where 50 > h and a >= 1000::int8;
+select count(*) from batch_agg where 4000000 < d and h <= 2::int8;
+select count(*) from batch_agg where b::int8 = 3 and h = 7;
+select count(*) from batch_agg where t < '2000-01-03 00:00';
+select count(*) from batch_agg where t <> '2000-01-01 05:00';
+select count(*) from batch_agg where t >= '2000-06-01';
+select count(*) from batch_agg where tz > '2000-01-02 00:00';
+reset executor_batch_size;
+select count(*), count(a), sum(a), min(a), max(a)
+  from batch_agg where a > 100 and 4 <> b;
+select count(*) from batch_agg where e > 1200;
+drop table batch_agg;
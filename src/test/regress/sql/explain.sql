@@ -69,6 +69,16 @@ select true as "OK"
 select explain_filter_to_json('explain (settings, format json) select * from int8_tbl i8') #> '{0,Settings,plan_cache_mode}';
 rollback;
 
+--
+-- Test display of subexpressions shared by the qual and the target list
+--
+explain (verbose, costs off)
+select lower(f1), length(lower(f1)) from text_tbl where lower(f1) <> 'doh!';
+select lower(f1), length(lower(f1)) from text_tbl where lower(f1) <> 'doh!';
+-- only the outermost of nested common subexpressions is shared
+explain (verbose, costs off)
+select upper(lower(f1)) from text_tbl where upper(lower(f1)) like 'H%';
+
 --
 -- Test production of per-worker data
 --
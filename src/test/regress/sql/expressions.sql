@@ -65,3 +65,102 @@ select count(*) from date_tbl
   where f1 not between symmetric '1997-01-01' and '1998-01-01';
 select count(*) from date_tbl
   where f1 not between symmetric '1997-01-01' and '1998-01-01';
+
+--
+-- Tests for operators that the expression interpreter evaluates itself,
+-- rather than calling their functions
+--
+
+create temp table builtin_ops (id int, i2 int2, i4 int4, i8 int8, f8 float8,
+  b bool, d date, ts timestamp, tz timestamptz);
+insert into builtin_ops values
+  (1, 1, 1, 1, 1.5, false, '2000-01-01', '2000-01-01 00:00:00',
+   '2000-01-01 00:00:00+00'),
+  (2, -1, 2, 5000000000, 'NaN', true, '1999-12-31', '1999-12-31 23:59:59.5',
+   '1999-12-31 16:00:00-08'),
+  (3, null, null, null, null, null, null, null, null);
+
+-- comparisons, including NULLs and NaNs
+select a.id, b.id, a.i4 = b.i4 as eq, a.i4 <> b.i4 as ne, a.i4 < b.i4 as lt,
+       a.i4 <= b.i4 as le, a.i4 > b.i4 as gt, a.i4 >= b.i4 as ge
+from builtin_ops a, builtin_ops b order by a.id, b.id;
+select a.id, b.id, a.i8 = b.i8 as eq, a.i8 <> b.i8 as ne, a.i8 < b.i8 as lt,
+       a.i8 <= b.i8 as le, a.i8 > b.i8 as gt, a.i8 >= b.i8 as ge
+from builtin_ops a, builtin_ops b order by a.id, b.id;
+select a.id, b.id, a.f8 = b.f8 as eq, a.f8 <> b.f8 as ne, a.f8 < b.f8 as lt,
+       a.f8 <= b.f8 as le, a.f8 > b.f8 as gt, a.f8 >= b.f8 as ge
+from builtin_ops a, builtin_ops b order by a.id, b.id;
+select a.id, b.id, a.b = b.b as eq, a.b <> b.b as ne, a.b < b.b as lt,
+       a.b <= b.b as le, a.b > b.b as gt, a.b >= b.b as ge
+from builtin_ops a, builtin_ops b order by a.id, b.id;
+select a.id, b.id, a.ts = b.ts as eq, a.ts <> b.ts as ne, a.ts < b.ts as lt,
+       a.ts <= b.ts as le, a.ts > b.ts as gt, a.ts >= b.ts as ge
+from builtin_ops a, builtin_ops b order by a.id, b.id;
+select a.id, b.id, a.i2 = b.i2 as int2eq, a.i2 < b.i4 as int24lt,
+       a.i4 >= b.i2 as int42ge, a.d > b.d as dategt, a.tz = b.tz as tzeq,
+       a.tz <> b.tz as tzne
+from builtin_ops a, builtin_ops b order by a.id, b.id;
+select id from builtin_ops where f8 > 1e300;
+select id from builtin_ops where f8 = 'NaN';
+select id from builtin_ops where ts < '2000-01-01';
+
+-- arithmetic
+select id, i4 + 1 as i4pl, i4 - 3 as i4mi, i4 * -2 as i4mul,
+       i8 + i8 as i8pl, i8 - 7::int8 as i8mi, i8 * 3::int8 as i8mul
+from builtin_ops order by id;
+select id, f8 + 1 as f8pl, f8 - 0.5::float8 as f8mi, f8 * 2 as f8mul,
+       f8 / 4 as f8div
+from builtin_ops order by id;
+
+-- on overflow, the operator's function is called to report it
+select i4 + 2147483647 from builtin_ops where id = 2;
+select i4 - (-2147483647) from builtin_ops where id = 2;
+select i4 * 1073741824 from builtin_ops where id = 2;
+select i8 + 9223372036854775807 from builtin_ops where id = 2;
+select i8 - (-9223372036854775807) from builtin_ops where id = 2;
+select i8 * 2000000000::int8 from builtin_ops where id = 2;
+select f8 * 1.5e308::float8 from builtin_ops where id = 1;
+select f8 / 0::float8 from builtin_ops where id = 1;
+
+drop table builtin_ops;
+
+--
+-- Tests for fetching a few attributes of wide tuples
+--
+-- When at most half of the attributes up to the last referenced one are
+-- used, only those are extracted from the tuple.
+do $$
+begin
+  execute 'create temp table wide_tab (' ||
+    (select string_agg(format('c%s %s', i,
+                              case when i in (25, 35) then 'text' else 'int' end),
+                       ', ' order by i)
+     from generate_series(1, 40) i) || ')';
+end $$;
+insert into wide_tab
+select r.*
+from generate_series(1, 4) g,
+     jsonb_populate_record(null::wide_tab,
+       (select jsonb_object_agg('c' || i,
+                 case when g = 4 and i in (10, 25, 33) then null
+                      when i in (25, 35) then to_jsonb(repeat(chr(96 + g), i))
+                      else to_jsonb(i * g) end)
+        from generate_series(1, 40) i)) r;
+
+-- the offsets of the leading fixed-width attributes are cached, so the
+-- attributes in between are skipped unless one of them is NULL
+select c3, c20 from wide_tab order by c3;
+
+-- varlenas and NULLs in the gaps have to be walked
+select c1, c33, length(c35) as len35, c40 from wide_tab where c38 > 0
+order by c1;
+select c2, c25 from wide_tab where c30 >= 60 order by c2;
+
+-- attributes missing from the older tuples take their default
+alter table wide_tab add column c41 int default 41,
+  add column c42 text default 'forty-two';
+insert into wide_tab (c1, c40, c41) values (5, 200, 0);
+select c1, c40, c41, c42 from wide_tab order by c1;
+select c2, c42 from wide_tab where c41 = 41 order by c2;
+
+drop table wide_tab;
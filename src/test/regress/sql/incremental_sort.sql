@@ -0,0 +1,45 @@
+--
+-- Test incremental sort
+--
+-- When we have to sort the entire table, incremental sort will
+-- be slower than plain sort, so it should not be used.
+explain (costs off)
+select * from (select * from tenk1 order by four) t order by four, ten;
+-- When there is a LIMIT clause, incremental sort is beneficial because
+-- it only has to sort some of the groups, and not the entire table.
+explain (costs off)
+select * from (select * from tenk1 order by four) t order by four, ten
+limit 1;
+-- Groups smaller than the minimum batch size are sorted together, while
+-- runs of equal presorted keys are never split between batches.
+create table incsort_t (a int, b int);
+insert into incsort_t select i / 10, (i * 7) % 13 from generate_series(1, 100) i;
+insert into incsort_t select 10, (i * 7) % 13 from generate_series(1, 60) i;
+insert into incsort_t select 11, (i * 5) % 11 from generate_series(1, 40) i;
+analyze incsort_t;
+set enable_sort = off;
+explain (costs off)
+select * from (select * from incsort_t order by a) s order by a, b;
+select * from (select * from incsort_t order by a) s order by a, b limit 25;
+select * from (select * from incsort_t order by a) s order by a, b offset 150 limit 15;
+-- verify the ordering of the complete output
+select count(*) as out_of_order from
+  (select a, b, lag(a) over w as pa, lag(b) over w as pb
+   from (select * from (select * from incsort_t order by a) s order by a, b) x
+   window w as ()) y
+where (pa, pb) > (a, b);
+select count(*) from (select * from (select * from incsort_t order by a) s order by a, b) x;
+-- An index providing the leading key can feed an incremental sort.
+create table incsort_orders (customer_id int, created_at int);
+insert into incsort_orders
+  select i % 100, (i * 37) % 997 from generate_series(1, 10000) i;
+create index on incsort_orders (customer_id);
+analyze incsort_orders;
+explain (costs off)
+select * from incsort_orders order by customer_id, created_at limit 12;
+select * from incsort_orders order by customer_id, created_at limit 12;
+select * from incsort_orders where customer_id > 97
+order by customer_id, created_at offset 95 limit 10;
+reset enable_sort;
+drop table incsort_t;
+drop table incsort_orders;
@@ -2153,3 +2153,81 @@ where exists (select 1 from j3
       and t1.unique1 < 1;
 
 drop table j3;
+
+--
+-- merge join against an inner index scan that can skip ahead
+--
+-- (without a seqscan, the inner index scan is the cheapest sorted input)
+set enable_hashjoin = off;
+set enable_nestloop = off;
+set enable_seqscan = off;
+
+explain (costs off)
+select v.x, t.unique2
+from (values (5000), (5), (9999), (500)) v(x)
+  join tenk1 t on t.unique1 = v.x
+order by v.x;
+
+select v.x, t.unique2
+from (values (5000), (5), (9999), (500)) v(x)
+  join tenk1 t on t.unique1 = v.x
+order by v.x;
+
+explain (costs off)
+select v.x, t.unique2
+from (values (5000), (5), (null), (10001), (9999), (500)) v(x)
+  left join tenk1 t on t.unique1 = v.x
+order by v.x;
+
+select v.x, t.unique2
+from (values (5000), (5), (null), (10001), (9999), (500)) v(x)
+  left join tenk1 t on t.unique1 = v.x
+order by v.x;
+
+explain (costs off)
+select v.a, v.b, t.unique2
+from (values (1, 9001), (1, 5000), (998, 998), (998, 9998)) v(a, b)
+  join tenk1 t on t.thousand = v.a and t.tenthous = v.b
+order by v.a, v.b;
+
+select v.a, v.b, t.unique2
+from (values (1, 9001), (1, 5000), (998, 998), (998, 9998)) v(a, b)
+  join tenk1 t on t.thousand = v.a and t.tenthous = v.b
+order by v.a, v.b;
+
+reset enable_hashjoin;
+reset enable_nestloop;
+reset enable_seqscan;
+
+--
+-- nestloop with batched outer rows
+--
+set enable_batched_nestloop = on;
+set enable_hashjoin = off;
+set enable_mergejoin = off;
+
+explain (costs off)
+select count(*), sum(t2.unique2)
+from onek t1 join tenk1 t2 on t2.unique1 = t1.unique2
+where t1.ten = 3;
+select count(*), sum(t2.unique2)
+from onek t1 join tenk1 t2 on t2.unique1 = t1.unique2
+where t1.ten = 3;
+
+select count(*), count(t2.unique1), sum(t2.ten)
+from tenk1 t1 left join onek t2 on t2.unique1 = t1.unique2
+where t1.hundred = 42;
+
+-- the outer scan projects (for the whole-row Var), and the join evaluates
+-- non-key outer columns from the batched copies of its tuples
+explain (costs off)
+select count(t1.*), sum(t1.ten), sum(t1.thousand + coalesce(t2.ten, 0))
+from tenk1 t1 left join onek t2 on t2.unique1 = t1.unique2
+where t1.hundred = 42 and t1.four <> coalesce(t2.four, -1);
+select count(t1.*), sum(t1.ten), sum(t1.thousand + coalesce(t2.ten, 0))
+from tenk1 t1 left join onek t2 on t2.unique1 = t1.unique2
+where t1.hundred = 42 and t1.four <> coalesce(t2.four, -1);
+
+reset enable_batched_nestloop;
+reset enable_hashjoin;
+reset enable_mergejoin;
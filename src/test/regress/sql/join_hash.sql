@@ -181,6 +181,8 @@ select original > 1 as initially_multibatch, final > original as increased_batch
 $$
   select count(*) from simple r join simple s using (id);
 $$);
+-- parallel full multi-batch hash join
+select count(*) from simple r full outer join simple s using (id);
 rollback to settings;
 
 -- The "bad" case: during execution we need to increase number of
@@ -418,7 +420,16 @@ explain (costs off)
 select  count(*) from simple r full outer join simple s using (id);
 rollback to settings;
 
--- parallelism not possible with parallel-oblivious outer hash join
+-- parallelism not possible with parallel-oblivious full hash join
+savepoint settings;
+set local enable_parallel_hash = off;
+set local max_parallel_workers_per_gather = 2;
+explain (costs off)
+     select  count(*) from simple r full outer join simple s using (id);
+select  count(*) from simple r full outer join simple s using (id);
+rollback to settings;
+
+-- parallelism is possible with parallel-aware full hash join
 savepoint settings;
 set local max_parallel_workers_per_gather = 2;
 explain (costs off)
@@ -436,7 +447,16 @@ explain (costs off)
 select  count(*) from simple r full outer join simple s on (r.id = 0 - s.id);
 rollback to settings;
 
--- parallelism not possible with parallel-oblivious outer hash join
+-- parallelism not possible with parallel-oblivious full hash join
+savepoint settings;
+set local enable_parallel_hash = off;
+set local max_parallel_workers_per_gather = 2;
+explain (costs off)
+     select  count(*) from simple r full outer join simple s on (r.id = 0 - s.id);
+select  count(*) from simple r full outer join simple s on (r.id = 0 - s.id);
+rollback to settings;
+
+-- parallelism is possible with parallel-aware full hash join
 savepoint settings;
 set local max_parallel_workers_per_gather = 2;
 explain (costs off)
@@ -538,3 +558,98 @@ WHERE
     AND hjtest_1.a <> hjtest_2.b;
 
 ROLLBACK;
+
+-- Test the runtime filter that a hash join supplies to its outer scan
+create temp table hjrf_fact as
+  select g as id, g % 1000 as dim_id from generate_series(1, 10000) g;
+create temp table hjrf_dim as
+  select g as id from generate_series(100, 1000, 100) g;
+analyze hjrf_fact;
+analyze hjrf_dim;
+
+create function explain_hjrf(query text) returns setof text
+language plpgsql as
+$$
+declare
+    ln text;
+begin
+    for ln in
+        execute format('explain (analyze, costs off, summary off, timing off) %s',
+            query)
+    loop
+        ln := regexp_replace(ln, 'Memory Usage: \d+', 'Memory Usage: N');
+        return next ln;
+    end loop;
+end;
+$$;
+
+select explain_hjrf('select count(*) from hjrf_fact f join hjrf_dim d on f.dim_id = d.id');
+select count(*) from hjrf_fact f join hjrf_dim d on f.dim_id = d.id;
+-- unmatched outer rows must not be filtered out of a left join
+select count(*) from hjrf_fact f left join hjrf_dim d on f.dim_id = d.id;
+
+drop function explain_hjrf(text);
+drop table hjrf_fact;
+drop table hjrf_dim;
+
+-- Probe hash tables large enough for outer tuples to be fetched in groups,
+-- with their buckets prefetched
+begin;
+set local min_parallel_table_scan_size = 0;
+set local parallel_setup_cost = 0;
+set local enable_mergejoin = off;
+set local enable_nestloop = off;
+create table hjp_outer as
+  select g as id, g % 7 as t from generate_series(1, 100000) g;
+create table hjp_inner as
+  select g * 2 as id from generate_series(1, 80000) g;
+alter table hjp_outer set (parallel_workers = 2);
+alter table hjp_inner set (parallel_workers = 2);
+analyze hjp_outer;
+analyze hjp_inner;
+-- Was the hash table big enough for outer tuples to be probed in groups?
+-- See hashjoin_prefetch_min_buckets.
+create function hjp_grouped(query text) returns bool language plpgsql as
+$$
+declare
+  whole_plan jsonb;
+begin
+  execute 'explain (analyze, format ''json'') ' || query into whole_plan;
+  return jsonb_path_query_first(whole_plan,
+           '$.** ? (@."Node Type" == "Hash")."Hash Buckets"')::int >=
+         current_setting('hashjoin_prefetch_min_buckets')::int;
+end;
+$$;
+-- single batch
+savepoint settings;
+set local max_parallel_workers_per_gather = 0;
+set local work_mem = '64MB';
+select count(*), sum(t) from hjp_outer o join hjp_inner i using (id);
+select count(*), count(o.id), count(i.id)
+  from hjp_outer o full join hjp_inner i using (id);
+select hjp_grouped('select count(*) from hjp_outer o join hjp_inner i using (id)');
+rollback to settings;
+-- multiple batches
+savepoint settings;
+set local max_parallel_workers_per_gather = 0;
+set local work_mem = '4MB';
+select count(*), sum(t) from hjp_outer o join hjp_inner i using (id);
+select count(*), count(o.id), count(i.id)
+  from hjp_outer o full join hjp_inner i using (id);
+select hjp_grouped('select count(*) from hjp_outer o join hjp_inner i using (id)');
+rollback to settings;
+-- Parallel Hash, single and multiple batches
+savepoint settings;
+set local max_parallel_workers_per_gather = 2;
+set local enable_parallel_hash = on;
+set local work_mem = '64MB';
+select count(*), sum(t) from hjp_outer o join hjp_inner i using (id);
+select count(*), count(o.id), count(i.id)
+  from hjp_outer o full join hjp_inner i using (id);
+select hjp_grouped('select count(*) from hjp_outer o join hjp_inner i using (id)');
+set local work_mem = '1MB';
+select count(*), sum(t) from hjp_outer o join hjp_inner i using (id);
+select count(*), count(o.id), count(i.id)
+  from hjp_outer o full join hjp_inner i using (id);
+rollback to settings;
+rollback;
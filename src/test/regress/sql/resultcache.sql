@@ -0,0 +1,66 @@
+--
+-- Test Result Cache
+--
+-- Perform an EXPLAIN ANALYZE of a query, hiding the numbers that depend on
+-- the machine: memory usage, heap fetches and, if requested, the exact cache
+-- hit, miss and eviction counts.
+create function explain_resultcache(query text, hide_hitmiss bool) returns setof text
+language plpgsql as
+$$
+declare
+    ln text;
+begin
+    for ln in
+        execute format('explain (analyze, costs off, summary off, timing off) %s',
+            query)
+    loop
+        if hide_hitmiss = true then
+            ln := regexp_replace(ln, 'Hits: 0', 'Hits: Zero');
+            ln := regexp_replace(ln, 'Hits: \d+', 'Hits: N');
+            ln := regexp_replace(ln, 'Misses: 0', 'Misses: Zero');
+            ln := regexp_replace(ln, 'Misses: \d+', 'Misses: N');
+            ln := regexp_replace(ln, 'Evictions: 0', 'Evictions: Zero');
+            ln := regexp_replace(ln, 'Evictions: \d+', 'Evictions: N');
+            ln := regexp_replace(ln, 'loops=\d+', 'loops=N');
+        end if;
+        ln := regexp_replace(ln, 'Memory Usage: \d+', 'Memory Usage: N');
+        ln := regexp_replace(ln, 'Heap Fetches: \d+', 'Heap Fetches: N');
+        return next ln;
+    end loop;
+end;
+$$;
+-- Ensure we get a result cache on the inner side of the nested loop
+SET enable_resultcache TO on;
+SET enable_hashjoin TO off;
+SET enable_bitmapscan TO off;
+SELECT explain_resultcache('
+SELECT COUNT(*),AVG(t1.unique1) FROM tenk1 t1
+INNER JOIN tenk1 t2 ON t1.unique1 = t2.twenty
+WHERE t2.unique1 < 1000;', false);
+-- And check we get the same result with and without the cache
+SELECT COUNT(*),AVG(t1.unique1) FROM tenk1 t1
+INNER JOIN tenk1 t2 ON t1.unique1 = t2.twenty
+WHERE t2.unique1 < 1000;
+SET enable_resultcache TO off;
+SELECT COUNT(*),AVG(t1.unique1) FROM tenk1 t1
+INNER JOIN tenk1 t2 ON t1.unique1 = t2.twenty
+WHERE t2.unique1 < 1000;
+SET enable_resultcache TO on;
+-- Reduce work_mem so that we see some cache evictions.  The number of
+-- entries that fit at once depends on the machine, so hide the counts.
+SET work_mem TO '64kB';
+SET enable_mergejoin TO off;
+SELECT explain_resultcache('
+SELECT COUNT(*),AVG(t1.unique1) FROM tenk1 t1
+INNER JOIN tenk1 t2 ON t1.unique1 = t2.thousand
+WHERE t2.unique1 < 1200;', true);
+-- Evictions must not change the result
+SELECT COUNT(*),AVG(t1.unique1) FROM tenk1 t1
+INNER JOIN tenk1 t2 ON t1.unique1 = t2.thousand
+WHERE t2.unique1 < 1200;
+RESET enable_mergejoin;
+RESET work_mem;
+RESET enable_bitmapscan;
+RESET enable_hashjoin;
+RESET enable_resultcache;
+DROP FUNCTION explain_resultcache(text, bool);
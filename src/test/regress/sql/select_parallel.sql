@@ -94,6 +94,19 @@ select length(stringu1) from tenk1 group by length(stringu1);
 explain (costs off)
 	select stringu1, count(*) from tenk1 group by stringu1 order by stringu1;
 
+-- test parallel hash aggregation, using an aggregate that can't be
+-- partially aggregated
+explain (costs off)
+	select four, cardinality(array_agg(ten)) from tenk1 group by four;
+select four, cardinality(array_agg(ten)) from tenk1 group by four
+	order by four;
+-- make the partitions spill
+set work_mem = '64kB';
+select count(*), sum(n) from
+  (select unique1 % 1000, cardinality(array_agg(ten)) n
+   from tenk1 group by 1) ss;
+reset work_mem;
+
 -- test that parallel plan for aggregates is not selected when
 -- target list contains parallel restricted clause.
 explain (costs off)
@@ -328,6 +341,34 @@ explain (costs off)
 
 select fivethous from tenk1 order by fivethous limit 4;
 
+-- gather merge below a WindowAgg, to sort the window input in parallel
+explain (costs off)
+  select ten, unique1, sum(unique1) over (partition by ten order by unique1)
+  from tenk1 order by ten, unique1 limit 5;
+
+select ten, unique1, sum(unique1) over (partition by ten order by unique1)
+  from tenk1 order by ten, unique1 limit 5;
+
+-- redistribute the rows among the workers by the partition key, to compute
+-- the window functions in parallel
+explain (costs off)
+  select ten, unique1, sum(unique1) over (partition by ten) from tenk1;
+
+select ten, count(*), min(s), max(s), max(rn)
+  from (select ten, sum(unique1) over (partition by ten) s,
+               row_number() over (partition by ten order by unique1) rn
+        from tenk1) ss
+  group by ten order by ten;
+
+-- the same with no workers, so that the leader returns all rows itself
+set max_parallel_workers = 0;
+select ten, count(*), min(s), max(s), max(rn)
+  from (select ten, sum(unique1) over (partition by ten) s,
+               row_number() over (partition by ten order by unique1) rn
+        from tenk1) ss
+  group by ten order by ten;
+reset max_parallel_workers;
+
 -- gather merge test with 0 worker
 set max_parallel_workers = 0;
 explain (costs off)
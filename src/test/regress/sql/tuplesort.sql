@@ -296,3 +296,69 @@ EXPLAIN (COSTS OFF) :qry;
 :qry;
 
 COMMIT;
+
+-- Test the sort routines specialized for integer keys, and the radix sort
+-- used for larger single-key sorts.  Each query counts the adjacent pairs of
+-- output rows that are in the wrong order.
+CREATE TEMP TABLE int_sort AS
+    SELECT (g.i * 7919) % 10007 - 5000 AS i4,
+           ((g.i * 104729) % 20011 - 10000)::int8 * 100000007 AS i8,
+           timestamp '2000-01-01' + ((g.i * 7919) % 10007) * interval '1 hour' AS ts
+    FROM generate_series(1, 20000) g(i);
+INSERT INTO int_sort VALUES (NULL, NULL, NULL), (NULL, NULL, NULL);
+
+WITH s AS (SELECT i4, row_number() OVER () AS rn
+           FROM (SELECT i4 FROM int_sort ORDER BY i4) o)
+SELECT count(*) FROM s a JOIN s b ON b.rn = a.rn + 1
+WHERE a.i4 > b.i4 OR (a.i4 IS NULL AND b.i4 IS NOT NULL);
+
+WITH s AS (SELECT i4, row_number() OVER () AS rn
+           FROM (SELECT i4 FROM int_sort ORDER BY i4 DESC) o)
+SELECT count(*) FROM s a JOIN s b ON b.rn = a.rn + 1
+WHERE a.i4 < b.i4 OR (a.i4 IS NOT NULL AND b.i4 IS NULL);
+
+WITH s AS (SELECT i8, row_number() OVER () AS rn
+           FROM (SELECT i8 FROM int_sort ORDER BY i8 NULLS FIRST) o)
+SELECT count(*) FROM s a JOIN s b ON b.rn = a.rn + 1
+WHERE a.i8 > b.i8 OR (a.i8 IS NOT NULL AND b.i8 IS NULL);
+
+WITH s AS (SELECT i8, row_number() OVER () AS rn
+           FROM (SELECT i8 FROM int_sort ORDER BY i8 DESC NULLS LAST) o)
+SELECT count(*) FROM s a JOIN s b ON b.rn = a.rn + 1
+WHERE a.i8 < b.i8 OR (a.i8 IS NULL AND b.i8 IS NOT NULL);
+
+WITH s AS (SELECT ts, row_number() OVER () AS rn
+           FROM (SELECT ts FROM int_sort ORDER BY ts) o)
+SELECT count(*) FROM s a JOIN s b ON b.rn = a.rn + 1
+WHERE a.ts > b.ts OR (a.ts IS NULL AND b.ts IS NOT NULL);
+
+WITH s AS (SELECT i4, i8, row_number() OVER () AS rn
+           FROM (SELECT i4, i8 FROM int_sort ORDER BY i4, i8 DESC) o)
+SELECT count(*) FROM s a JOIN s b ON b.rn = a.rn + 1
+WHERE a.i4 > b.i4 OR (a.i4 = b.i4 AND a.i8 < b.i8);
+
+DROP TABLE int_sort;
+
+-- Late materialization: a LIMITed sort of wide rows carries only the sort
+-- keys and the ctid through the sort, and refetches the other columns.
+CREATE TEMP TABLE wide_sort AS
+    SELECT g AS id, (g * 37) % 101 AS k, g % 7 AS grp,
+           repeat(md5(g::text), 10) AS pad
+    FROM generate_series(1, 2000) g;
+ANALYZE wide_sort;
+
+EXPLAIN (COSTS OFF)
+SELECT id, k, grp, pad FROM wide_sort ORDER BY k, id LIMIT 5;
+
+SELECT id, k, grp, md5(pad)
+FROM (SELECT id, k, grp, pad FROM wide_sort ORDER BY k, id LIMIT 5) s;
+
+SELECT id, k, grp, md5(pad)
+FROM (SELECT id, k, grp, pad FROM wide_sort ORDER BY k DESC, id LIMIT 3) s;
+
+SET enable_late_materialization = off;
+EXPLAIN (COSTS OFF)
+SELECT id, k, grp, pad FROM wide_sort ORDER BY k, id LIMIT 5;
+RESET enable_late_materialization;
+
+DROP TABLE wide_sort;
@@ -892,6 +892,93 @@ SELECT * FROM
    FROM empsalary) emp
 WHERE depname = 'sales';
 
+-- Test run conditions for monotonic window functions
+EXPLAIN (COSTS OFF)
+SELECT * FROM
+  (SELECT empno,
+          row_number() OVER (ORDER BY empno) rn
+   FROM empsalary) emp
+WHERE rn < 3;
+
+SELECT * FROM
+  (SELECT empno,
+          row_number() OVER (ORDER BY empno) rn
+   FROM empsalary) emp
+WHERE rn < 3;
+
+-- with PARTITION BY, only the rest of the current partition is skipped
+EXPLAIN (COSTS OFF)
+SELECT * FROM
+  (SELECT empno, depname, salary,
+          rank() OVER (PARTITION BY depname ORDER BY salary DESC) r
+   FROM empsalary) emp
+WHERE r <= 2;
+
+SELECT * FROM
+  (SELECT empno, depname, salary,
+          rank() OVER (PARTITION BY depname ORDER BY salary DESC) r
+   FROM empsalary) emp
+WHERE r <= 2
+ORDER BY depname, r, empno;
+
+-- an equality qual on an increasing function stops once it is exceeded
+EXPLAIN (COSTS OFF)
+SELECT * FROM
+  (SELECT empno, salary,
+          dense_rank() OVER (ORDER BY salary DESC) dr
+   FROM empsalary) emp
+WHERE dr = 2;
+
+SELECT * FROM
+  (SELECT empno, salary,
+          dense_rank() OVER (ORDER BY salary DESC) dr
+   FROM empsalary) emp
+WHERE dr = 2
+ORDER BY empno;
+
+-- count(*) decreases when the frame always ends at the end of the partition
+EXPLAIN (COSTS OFF)
+SELECT * FROM
+  (SELECT empno, salary,
+          count(*) OVER (ORDER BY salary DESC, empno
+                         ROWS BETWEEN CURRENT ROW AND UNBOUNDED FOLLOWING) c
+   FROM empsalary) emp
+WHERE c >= 8;
+
+SELECT * FROM
+  (SELECT empno, salary,
+          count(*) OVER (ORDER BY salary DESC, empno
+                         ROWS BETWEEN CURRENT ROW AND UNBOUNDED FOLLOWING) c
+   FROM empsalary) emp
+WHERE c >= 8;
+
+-- without ORDER BY, count(*) is the same for the whole partition
+SELECT * FROM
+  (SELECT empno, depname,
+          count(*) OVER (PARTITION BY depname) c
+   FROM empsalary) emp
+WHERE c = 5
+ORDER BY empno;
+
+-- excluding rows from the frame makes count(*) non-monotonic
+EXPLAIN (COSTS OFF)
+SELECT * FROM
+  (SELECT empno, salary,
+          count(*) OVER (ORDER BY salary
+                         ROWS BETWEEN UNBOUNDED PRECEDING AND UNBOUNDED FOLLOWING
+                         EXCLUDE GROUP) c
+   FROM empsalary) emp
+WHERE c = 9;
+
+SELECT * FROM
+  (SELECT empno, salary,
+          count(*) OVER (ORDER BY salary
+                         ROWS BETWEEN UNBOUNDED PRECEDING AND UNBOUNDED FOLLOWING
+                         EXCLUDE GROUP) c
+   FROM empsalary) emp
+WHERE c = 9
+ORDER BY empno;
+
 -- Test Sort node collapsing
 EXPLAIN (COSTS OFF)
 SELECT * FROM
@@ -1258,6 +1345,31 @@ SELECT i, b, bool_and(b) OVER w, bool_or(b) OVER w
   FROM (VALUES (1,true), (2,true), (3,false), (4,false), (5,true)) v(i,b)
   WINDOW w AS (ORDER BY i ROWS BETWEEN CURRENT ROW AND 1 FOLLOWING);
 
+-- aggregates without an inverse transition function but with a combine
+-- function are computed from a segment tree of partial states when the
+-- frame head moves
+SELECT p, i, v, max(v) OVER w, min(v) OVER w, bit_or(v) OVER w,
+       max(v::text) OVER w, avg(v::float8) OVER w
+  FROM (VALUES (1,1,5), (2,1,3), (3,1,NULL), (4,1,8), (5,1,1),
+               (6,2,NULL), (7,2,NULL), (8,2,2), (9,2,6), (10,2,4)) t(i,p,v)
+  WINDOW w AS (PARTITION BY p ORDER BY i ROWS BETWEEN 2 PRECEDING AND 1 FOLLOWING);
+
+SELECT i, max(i) OVER w, min(i) OVER w, bool_and(i % 2 = 0) OVER w
+  FROM (VALUES (1), (2), (3), (7), (8), (12), (13), (14), (20)) t(i)
+  WINDOW w AS (ORDER BY i RANGE BETWEEN 2 FOLLOWING AND 5 FOLLOWING);
+
+-- enough rows to span several blocks of the segment tree
+SELECT count(*) AS total,
+       count(*) FILTER (WHERE mx = -greatest(i - 1100, 1)) AS max_ok,
+       count(*) FILTER (WHERE mn = greatest(i - 1100, 1)) AS min_ok,
+       count(*) FILTER (WHERE t = lpad(least(i + 200, 3000)::text, 4, '0')) AS text_ok,
+       count(*) FILTER (WHERE b = (i - 1100 > 1500 OR i + 200 < 1500)) AS bool_ok
+  FROM (SELECT i, max(-i) OVER w AS mx, min(i) OVER w AS mn,
+               max(lpad(i::text, 4, '0')) OVER w AS t,
+               bool_and(i <> 1500) OVER w AS b
+          FROM generate_series(1, 3000) i
+          WINDOW w AS (ORDER BY i ROWS BETWEEN 1100 PRECEDING AND 200 FOLLOWING)) s;
+
 -- Tests for problems with failure to walk or mutate expressions
 -- within window frame clauses.
 